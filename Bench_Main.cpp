@@ -0,0 +1,749 @@
+#include <benchmark/benchmark.h>
+#include "raylib.h"
+#include "Collision.hpp"
+#include "BodyStorage.hpp"
+#include "Broadphase.hpp"
+#include "Integration.hpp"
+#include "MortonOrder.hpp"
+#include "Narrowphase.hpp"
+#include "PhysicsWorld.hpp"
+#include "Simd.hpp"
+#include "TraceRecorder.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <numbers>
+#include <string>
+#include <vector>
+
+// Headless performance harness. Every benchmark builds its scene before timing, so only the measured
+// phase is inside the loop. Results are written as JSON (see main) to track regressions between releases.
+
+namespace
+{
+    // Fraction of the world box volume filled by balls, kept constant so pair density doesn't change with scale
+    constexpr float GBallVolumeFraction = 0.1f;
+
+    PE::SSimulationParameters MakeBenchmarkParameters ( int NumberOfBalls, PE::EBroadphaseType BroadphaseType = PE::EBroadphaseType::SpatialHashGrid )
+    {
+        PE::SSimulationParameters Parameters;
+        Parameters . NumberOfBalls = NumberOfBalls;
+        Parameters . BroadphaseType = BroadphaseType;
+        PE::SBallGenerationParameters & Generation = Parameters . BallGenerationParameters;
+        const float MeanRadius = 0.5f * ( Generation . MinRadius + Generation . MaxRadius );
+        const float BallVolume = 4.f / 3.f * std::numbers::pi_v<float> * MeanRadius * MeanRadius * MeanRadius;
+        const float HalfExtent = 0.5f * std::cbrt ( static_cast<float> ( NumberOfBalls ) * BallVolume / GBallVolumeFraction );
+        Parameters . WorldBoxMin = { -HalfExtent, -HalfExtent, -HalfExtent };
+        Parameters . WorldBoxMax = { HalfExtent, HalfExtent, HalfExtent };
+        const float SpawnExtent = HalfExtent - Generation . MaxRadius;
+        Generation . MinLocation = { -SpawnExtent, -SpawnExtent, -SpawnExtent };
+        Generation . MaxLocation = { SpawnExtent, SpawnExtent, SpawnExtent };
+        return Parameters;
+    }
+
+    // Exposes the individual phases of a step
+    class CBenchmarkWorld : public PE::CPhysicsWorld
+    {
+        public:
+        using PE::CPhysicsWorld::CPhysicsWorld;
+        using PE::CPhysicsWorld::IntegrateForces;
+        using PE::CPhysicsWorld::ResolveCollisions;
+    };
+
+    // Counters shared by the step benchmarks. ns/step is the inverted rate of 1e-9 per iteration.
+    void SetStepCounters ( benchmark::State & State, int NumberOfBodies, double PairTests, double Contacts )
+    {
+        State . counters [ "ns/step" ] = benchmark::Counter ( 1e-9, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert );
+        State . counters [ "pair_tests/step" ] = benchmark::Counter ( PairTests, benchmark::Counter::kAvgIterations );
+        State . counters [ "contacts/step" ] = benchmark::Counter ( Contacts, benchmark::Counter::kAvgIterations );
+        State . counters [ "bodies/s" ] = benchmark::Counter ( NumberOfBodies, benchmark::Counter::kIsIterationInvariantRate );
+    }
+
+    // Broadphase pairs of a freshly generated scene, their sphere-sphere subset, and every ball against every world plane
+    struct SPairScene
+    {
+        CBenchmarkWorld World;
+        std::vector<PE::SBroadphasePair> Pairs;
+        std::vector<PE::SBroadphasePair> SpherePairs;
+        std::vector<PE::SBroadphasePair> BoxPairs;
+        std::array<int, 6> Walls {};
+
+        explicit SPairScene ( int NumberOfBalls ) : World ( MakeBenchmarkParameters ( NumberOfBalls ) )
+        {
+            World . Restart ();
+            const PE::CBodyStorage & Bodies = World . GetBodies ();
+            std::unique_ptr<PE::CBroadphase> Broadphase = PE::CreateBroadphase ( World . GetSimulationParameters () );
+            Broadphase -> Update ( Bodies );
+            Broadphase -> FindPairs ( Pairs );
+            for ( const PE::SBroadphasePair & Pair : Pairs )
+            {
+                if ( Bodies . Shapes [ Pair . BodyA ] . Type == EShapeType::Sphere && Bodies . Shapes [ Pair . BodyB ] . Type == EShapeType::Sphere )
+                {
+                    SpherePairs . push_back ( Pair );
+                }
+            }
+            // Freshly spawned balls rarely touch the walls, so test them all like the brute-force loop would
+            std::vector<int> Planes;
+            for ( int i = 0; i < Bodies . Size (); i++ )
+            {
+                if ( Bodies . Shapes [ i ] . Type == EShapeType::Box )
+                {
+                    Planes . push_back ( i );
+                }
+            }
+            std::copy ( Planes . begin (), Planes . end (), Walls . begin () );
+            for ( int Ball = 0; Ball < Bodies . Size (); Ball++ )
+            {
+                for ( int Plane : Planes )
+                {
+                    if ( Bodies . Shapes [ Ball ] . Type == EShapeType::Sphere )
+                    {
+                        BoxPairs . push_back ( { std::min ( Ball, Plane ), std::max ( Ball, Plane ) } );
+                    }
+                }
+            }
+        }
+    };
+
+    void ScaleArguments ( benchmark::internal::Benchmark * Benchmark )
+    {
+        Benchmark -> RangeMultiplier ( 10 ) -> Range ( 100, 1000000 ) -> Unit ( benchmark::kMicrosecond );
+    }
+
+    void ScaleAndSimdArguments ( benchmark::internal::Benchmark * Benchmark )
+    {
+        Benchmark -> ArgNames ( { "balls", "simd" } ) -> Unit ( benchmark::kMicrosecond );
+        for ( int NumberOfBalls = 100; NumberOfBalls <= 1000000; NumberOfBalls *= 10 )
+        {
+            for ( PE::ESimdLevel Level : { PE::ESimdLevel::Scalar, PE::ESimdLevel::SSE2, PE::ESimdLevel::AVX2 } )
+            {
+                Benchmark -> Args ( { NumberOfBalls, static_cast<int> ( Level ) } );
+            }
+        }
+    }
+
+    // Balls dropped into the benchmark box and stepped until they rest on the floor, built once and shared
+    constexpr int GSettledPileBalls = 1000;
+
+    const std::vector<PE::SPhysicsBody> & GetSettledPile ()
+    {
+        static const std::vector<PE::SPhysicsBody> Pile = []
+        {
+            PE::SSimulationParameters Parameters = MakeBenchmarkParameters ( GSettledPileBalls );
+            Parameters . NumberOfSteps = 8;
+            PE::CPhysicsWorld World ( Parameters );
+            World . Restart ();
+            for ( int Step = 0; Step < 900; Step++ )
+            {
+                World . Step ( World . GetFixedDeltaTime () );
+            }
+            return World . GetBodies () . ExportBodies ();
+        } ();
+        return Pile;
+    }
+
+    // Balls dropped from rest onto a wide floor, mostly one layer of small islands, stepped until every island sleeps.
+    // A deep pile rarely sleeps as a whole, one rocking ball keeps its island awake.
+    CBenchmarkWorld & GetSleepingFloor ()
+    {
+        static CBenchmarkWorld World = []
+        {
+            PE::SSimulationParameters Parameters;
+            Parameters . NumberOfBalls = GSettledPileBalls;
+            Parameters . WorldBoxMin = { -30.f, -5.f, -30.f };
+            Parameters . WorldBoxMax = { 30.f, 5.f, 30.f };
+            PE::SBallGenerationParameters & Generation = Parameters . BallGenerationParameters;
+            Generation . MinLocation = { -29.f, -4.f, -29.f };
+            Generation . MaxLocation = { 29.f, 4.f, 29.f };
+            Generation . MinLinearVelocity = Generation . MaxLinearVelocity = { 0.f, 0.f, 0.f };
+            Generation . MinAngularVelocity = Generation . MaxAngularVelocity = { 0.f, 0.f, 0.f };
+            CBenchmarkWorld SleepingWorld ( Parameters );
+            SleepingWorld . Restart ();
+            for ( int Step = 0; Step < 6000 && ( Step < 60 || SleepingWorld . GetNumberOfAwakeBodies () > 0 ); Step++ )
+            {
+                SleepingWorld . Step ( SleepingWorld . GetFixedDeltaTime () );
+            }
+            return SleepingWorld;
+        } ();
+        return World;
+    }
+
+    // Skip SIMD levels the CPU can't run instead of silently measuring a lower one
+    bool SkipUnsupportedLevel ( benchmark::State & State, PE::ESimdLevel Level )
+    {
+        if ( PE::Simd::ResolveLevel ( Level ) != Level )
+        {
+            State . SkipWithError ( "SIMD level not supported by this CPU" );
+            return true;
+        }
+        State . SetLabel ( PE::Simd::GetLevelName ( Level ) );
+        return false;
+    }
+}
+
+// Whole fixed step: integration, broadphase, narrowphase and solver
+static void BM_WorldStep ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    CBenchmarkWorld World ( MakeBenchmarkParameters ( NumberOfBalls ) );
+    World . Restart ();
+    double PairTests = 0.0;
+    double Contacts = 0.0;
+    for ( auto _ : State )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        PairTests += World . GetNumberOfPairTests ();
+        Contacts += World . GetNumberOfContacts ();
+    }
+    SetStepCounters ( State, World . GetBodies () . Size (), PairTests, Contacts );
+}
+BENCHMARK ( BM_WorldStep ) -> Apply ( ScaleArguments );
+
+static void BM_WorldStepAABBTree ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    CBenchmarkWorld World ( MakeBenchmarkParameters ( NumberOfBalls, PE::EBroadphaseType::DynamicAABBTree ) );
+    World . Restart ();
+    double PairTests = 0.0;
+    double Contacts = 0.0;
+    for ( auto _ : State )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        PairTests += World . GetNumberOfPairTests ();
+        Contacts += World . GetNumberOfContacts ();
+    }
+    SetStepCounters ( State, World . GetBodies () . Size (), PairTests, Contacts );
+}
+BENCHMARK ( BM_WorldStepAABBTree ) -> Apply ( ScaleArguments );
+
+// Whole step with a trace recording running, against traced 0 for the cost of leaving the recorder on.
+// The flush thread writes to a temporary file meanwhile, events/step and dropped show what it had to keep up with.
+static void BM_WorldStepTraced ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    const bool IsTraced = State . range ( 1 ) != 0;
+    CBenchmarkWorld World ( MakeBenchmarkParameters ( NumberOfBalls ) );
+    World . Restart ();
+    PE::CTraceRecorder & Recorder = PE::CTraceRecorder::Get ();
+    const std::string Path = ( std::filesystem::temp_directory_path () / "PhysicsEngineBenchTrace.json" ) . string ();
+    if ( IsTraced && ! Recorder . Start ( Path ) )
+    {
+        State . SkipWithError ( "trace recording unavailable" );
+        return;
+    }
+    double PairTests = 0.0;
+    double Contacts = 0.0;
+    for ( auto _ : State )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        PairTests += World . GetNumberOfPairTests ();
+        Contacts += World . GetNumberOfContacts ();
+    }
+    SetStepCounters ( State, World . GetBodies () . Size (), PairTests, Contacts );
+    if ( IsTraced )
+    {
+        Recorder . Stop ();
+        std::filesystem::remove ( Path );
+        State . counters [ "events/step" ] = benchmark::Counter ( static_cast<double> ( Recorder . GetNumberOfWrittenEvents () ), benchmark::Counter::kAvgIterations );
+        State . counters [ "dropped" ] = static_cast<double> ( Recorder . GetNumberOfDroppedEvents () );
+    }
+}
+BENCHMARK ( BM_WorldStepTraced ) -> ArgNames ( { "balls", "traced" } ) -> ArgsProduct ( { { 1000, 100000 }, { 0, 1 } } ) -> Unit ( benchmark::kMillisecond );
+
+// Whole step with the bodies in generation (random) order and sorted along the Morton curve, automatic sorting off.
+// contact_index_distance is the mean |BodyA - BodyB| of the contacts: how far apart in memory the solver reads a pair.
+// Run under `perf stat -e cache-misses` for the hardware count.
+static void BM_BodyOrder ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    const bool IsSorted = State . range ( 1 ) != 0;
+    PE::SSimulationParameters Parameters = MakeBenchmarkParameters ( NumberOfBalls );
+    Parameters . BodyOrderCheckInterval = 0;
+    CBenchmarkWorld World ( Parameters );
+    World . Restart ();
+    if ( IsSorted )
+    {
+        World . SortBodies ();
+    }
+    double PairTests = 0.0;
+    double Contacts = 0.0;
+    double IndexDistance = 0.0;
+    for ( auto _ : State )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        PairTests += World . GetNumberOfPairTests ();
+        Contacts += World . GetNumberOfContacts ();
+        for ( const PE::SContact & Contact : World . GetContacts () )
+        {
+            IndexDistance += std::abs ( Contact . BodyA - Contact . BodyB );
+        }
+    }
+    SetStepCounters ( State, World . GetBodies () . Size (), PairTests, Contacts );
+    State . counters [ "contact_index_distance" ] = benchmark::Counter ( Contacts > 0.0 ? IndexDistance / Contacts : 0.0 );
+    PE::CMortonOrder Order;
+    State . counters [ "disorder" ] = Order . Measure ( World . GetBodies () );
+}
+BENCHMARK ( BM_BodyOrder ) -> ArgNames ( { "balls", "sorted" } ) -> ArgsProduct ( { { 100000, 1000000 }, { 0, 1 } } ) -> Unit ( benchmark::kMillisecond );
+
+// Cost of one sort: Morton codes, radix sort, permuting the body streams and remapping the broadphase
+static void BM_SortBodies ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    CBenchmarkWorld World ( MakeBenchmarkParameters ( NumberOfBalls ) );
+    World . Restart ();
+    for ( auto _ : State )
+    {
+        World . SortBodies ();
+    }
+    State . counters [ "bodies/s" ] = benchmark::Counter ( World . GetBodies () . Size (), benchmark::Counter::kIsIterationInvariantRate );
+}
+BENCHMARK ( BM_SortBodies ) -> Apply ( ScaleArguments );
+
+// Projectile churn on a warm pool: every iteration despawns the oldest projectiles and fires as many new ones,
+// without stepping, so only adding and removing bodies (storage and broadphase) is measured
+static void BM_SpawnDespawn ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    const bool IsAABBTree = State . range ( 1 ) != 0;
+    constexpr int NumberOfProjectiles = 4096;
+    constexpr int ProjectilesPerIteration = 256;
+    CBenchmarkWorld World ( MakeBenchmarkParameters ( NumberOfBalls, IsAABBTree ? PE::EBroadphaseType::DynamicAABBTree : PE::EBroadphaseType::SpatialHashGrid ) );
+    World . Restart ();
+    // Projectiles spread over the world box, so the tree sees distinct leaves
+    const BoundingBox & WorldBox = World . GetWorldBox ();
+    const auto MakeProjectile = [ & ] ( int Shot )
+    {
+        PE::SPhysicsBody Projectile;
+        Projectile . Shape . Type = EShapeType::Sphere;
+        Projectile . Shape . Sphere . Radius = 0.1f;
+        const float Extent = WorldBox . max . x - WorldBox . min . x;
+        Projectile . Position = { WorldBox . min . x + std::fmod ( Shot * 0.618034f, 1.f ) * Extent,
+                                  WorldBox . min . y + std::fmod ( Shot * 0.754878f, 1.f ) * Extent,
+                                  WorldBox . min . z + std::fmod ( Shot * 0.569840f, 1.f ) * Extent };
+        return Projectile;
+    };
+    std::vector<int> Projectiles ( NumberOfProjectiles );
+    int Shot = 0;
+    for ( int & Handle : Projectiles )
+    {
+        Handle = World . AddBody ( MakeProjectile ( Shot++ ) );
+    }
+    World . Step ( World . GetFixedDeltaTime () );
+    size_t Oldest = 0;
+    for ( auto _ : State )
+    {
+        for ( int i = 0; i < ProjectilesPerIteration; i++ )
+        {
+            World . RemoveBody ( Projectiles [ Oldest ] );
+            Projectiles [ Oldest ] = World . AddBody ( MakeProjectile ( Shot++ ) );
+            Oldest = ( Oldest + 1 ) % Projectiles . size ();
+        }
+    }
+    State . counters [ "bodies/s" ] = benchmark::Counter ( 2 * ProjectilesPerIteration, benchmark::Counter::kIsIterationInvariantRate );
+}
+BENCHMARK ( BM_SpawnDespawn ) -> ArgNames ( { "balls", "type" } ) -> ArgsProduct ( { { 10000, 100000 }, { 0, 1 } } ) -> Unit ( benchmark::kMicrosecond );
+
+// Restart of a world of generated balls, the spawn chunks run on 1-16 threads. Wall time, like the other thread scans.
+static void BM_SpawnBalls ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    PE::SSimulationParameters Parameters = MakeBenchmarkParameters ( NumberOfBalls );
+    Parameters . NumberOfThreads = static_cast<int> ( State . range ( 1 ) );
+    CBenchmarkWorld World ( Parameters );
+    for ( auto _ : State )
+    {
+        World . Restart ();
+        benchmark::ClobberMemory ();
+    }
+    State . counters [ "bodies/s" ] = benchmark::Counter ( NumberOfBalls, benchmark::Counter::kIsIterationInvariantRate );
+}
+BENCHMARK ( BM_SpawnBalls ) -> ArgNames ( { "balls", "threads" } ) -> ArgsProduct ( { { 100000, 1000000 }, { 1, 4, 16 } } ) -> UseRealTime () -> Unit ( benchmark::kMillisecond );
+
+// Closest hits of a batch of random rays through a settled-in scene, cast on the job system
+static void BM_RayCastBatch ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    const bool IsAABBTree = State . range ( 1 ) != 0;
+    constexpr int NumberOfRays = 4096;
+    CBenchmarkWorld World ( MakeBenchmarkParameters ( NumberOfBalls, IsAABBTree ? PE::EBroadphaseType::DynamicAABBTree : PE::EBroadphaseType::SpatialHashGrid ) );
+    World . Restart ();
+    World . Step ( World . GetFixedDeltaTime () );
+    const BoundingBox & WorldBox = World . GetWorldBox ();
+    const float Extent = WorldBox . max . x - WorldBox . min . x;
+    std::vector<PE::SRay> Rays ( NumberOfRays );
+    for ( int i = 0; i < NumberOfRays; i++ )
+    {
+        Rays [ i ] . Origin = { WorldBox . min . x + std::fmod ( i * 0.618034f, 1.f ) * Extent,
+                                WorldBox . min . y + std::fmod ( i * 0.754878f, 1.f ) * Extent,
+                                WorldBox . min . z + std::fmod ( i * 0.569840f, 1.f ) * Extent };
+        Rays [ i ] . Direction = { std::fmod ( i * 0.465571f, 1.f ) - 0.5f, std::fmod ( i * 0.819172f, 1.f ) - 0.5f, std::fmod ( i * 0.337236f, 1.f ) - 0.5f };
+    }
+    std::vector<PE::SRayHit> Hits ( NumberOfRays );
+    const PE::CSceneQuery Query = World . GetSceneQuery ();
+    for ( auto _ : State )
+    {
+        Query . RayCast ( Rays, Hits, World . GetJobSystem () );
+        benchmark::DoNotOptimize ( Hits . data () );
+    }
+    State . counters [ "rays/s" ] = benchmark::Counter ( NumberOfRays, benchmark::Counter::kIsIterationInvariantRate );
+}
+BENCHMARK ( BM_RayCastBatch ) -> ArgNames ( { "balls", "type" } ) -> ArgsProduct ( { { 10000, 100000 }, { 0, 1 } } ) -> UseRealTime () -> Unit ( benchmark::kMicrosecond );
+
+static void BM_IntegrateForces ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    const PE::ESimdLevel Level = static_cast<PE::ESimdLevel> ( State . range ( 1 ) );
+    if ( SkipUnsupportedLevel ( State, Level ) )
+    {
+        return;
+    }
+    PE::SSimulationParameters Parameters = MakeBenchmarkParameters ( NumberOfBalls );
+    Parameters . SimdLevel = Level;
+    CBenchmarkWorld World ( Parameters );
+    World . Restart ();
+    for ( auto _ : State )
+    {
+        World . IntegrateForces ( World . GetFixedDeltaTime () );
+        benchmark::ClobberMemory ();
+    }
+    SetStepCounters ( State, World . GetBodies () . Size (), 0.0, 0.0 );
+}
+BENCHMARK ( BM_IntegrateForces ) -> Apply ( ScaleAndSimdArguments );
+
+// Broadphase update plus all solver iterations of one step
+static void BM_ResolveCollisions ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    CBenchmarkWorld World ( MakeBenchmarkParameters ( NumberOfBalls ) );
+    World . Restart ();
+    double PairTests = 0.0;
+    double Contacts = 0.0;
+    for ( auto _ : State )
+    {
+        World . ResolveCollisions ( World . GetFixedDeltaTime () );
+        PairTests += World . GetNumberOfPairTests ();
+        Contacts += World . GetNumberOfContacts ();
+    }
+    SetStepCounters ( State, World . GetBodies () . Size (), PairTests, Contacts );
+}
+BENCHMARK ( BM_ResolveCollisions ) -> Apply ( ScaleArguments );
+
+static void BM_Broadphase ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    const PE::EBroadphaseType Type = static_cast<PE::EBroadphaseType> ( State . range ( 1 ) );
+    CBenchmarkWorld World ( MakeBenchmarkParameters ( NumberOfBalls, Type ) );
+    World . Restart ();
+    std::unique_ptr<PE::CBroadphase> Broadphase = PE::CreateBroadphase ( World . GetSimulationParameters () );
+    std::vector<PE::SBroadphasePair> Pairs;
+    double PairTests = 0.0;
+    for ( auto _ : State )
+    {
+        Broadphase -> Update ( World . GetBodies () );
+        Pairs . clear ();
+        Broadphase -> FindPairs ( Pairs );
+        PairTests += static_cast<double> ( Pairs . size () );
+    }
+    State . SetLabel ( Type == PE::EBroadphaseType::SpatialHashGrid ? "SpatialHashGrid" : "DynamicAABBTree" );
+    SetStepCounters ( State, World . GetBodies () . Size (), PairTests, 0.0 );
+}
+BENCHMARK ( BM_Broadphase ) -> ArgNames ( { "balls", "type" } ) -> ArgsProduct ( { benchmark::CreateRange ( 100, 1000000, 10 ), { 0, 1 } } ) -> Unit ( benchmark::kMicrosecond );
+
+// Narrowphase: one TestSphereSphere call per candidate pair
+static void BM_TestSphereSphere ( benchmark::State & State )
+{
+    const SPairScene Scene ( static_cast<int> ( State . range ( 0 ) ) );
+    const PE::CBodyStorage & Bodies = Scene . World . GetBodies ();
+    double Contacts = 0.0;
+    for ( auto _ : State )
+    {
+        for ( const PE::SBroadphasePair & Pair : Scene . SpherePairs )
+        {
+            const PE::Collision::SHitResult Hit = PE::Collision::TestSphereSphere ( Bodies . Positions . Get ( Pair . BodyA ), Bodies . Radii [ Pair . BodyA ],
+                                                                                    Bodies . Positions . Get ( Pair . BodyB ), Bodies . Radii [ Pair . BodyB ] );
+            benchmark::DoNotOptimize ( Hit );
+            Contacts += Hit . IsHit ? 1.0 : 0.0;
+        }
+    }
+    State . SetItemsProcessed ( State . iterations () * static_cast<int64_t> ( Scene . SpherePairs . size () ) );
+    SetStepCounters ( State, Bodies . Size (), static_cast<double> ( Scene . SpherePairs . size () * State . iterations () ), Contacts );
+}
+BENCHMARK ( BM_TestSphereSphere ) -> Apply ( ScaleArguments );
+
+// Narrowphase: batched sphere-sphere kernel writing a compact contact buffer
+static void BM_TestSphereSpherePairs ( benchmark::State & State )
+{
+    const PE::ESimdLevel Level = static_cast<PE::ESimdLevel> ( State . range ( 1 ) );
+    if ( SkipUnsupportedLevel ( State, Level ) )
+    {
+        return;
+    }
+    const SPairScene Scene ( static_cast<int> ( State . range ( 0 ) ) );
+    const PE::CBodyStorage & Bodies = Scene . World . GetBodies ();
+    const int NumberOfPairs = static_cast<int> ( Scene . SpherePairs . size () );
+    std::vector<PE::SContact> Contacts ( NumberOfPairs );
+    double NumberOfContacts = 0.0;
+    for ( auto _ : State )
+    {
+        NumberOfContacts += PE::Collision::TestSphereSpherePairs ( Bodies, Scene . SpherePairs . data (), NumberOfPairs, Contacts . data (), Level );
+        benchmark::ClobberMemory ();
+    }
+    State . SetItemsProcessed ( State . iterations () * NumberOfPairs );
+    SetStepCounters ( State, Bodies . Size (), static_cast<double> ( NumberOfPairs ) * State . iterations (), NumberOfContacts );
+}
+BENCHMARK ( BM_TestSphereSpherePairs ) -> Apply ( ScaleAndSimdArguments );
+
+// Narrowphase: sphere-box TestCollision of every ball against every world plane
+static void BM_TestSphereBox ( benchmark::State & State )
+{
+    const SPairScene Scene ( static_cast<int> ( State . range ( 0 ) ) );
+    const PE::CBodyStorage & Bodies = Scene . World . GetBodies ();
+    double Contacts = 0.0;
+    for ( auto _ : State )
+    {
+        for ( const PE::SBroadphasePair & Pair : Scene . BoxPairs )
+        {
+            const PE::Collision::SHitResult Hit = PE::Collision::TestCollision ( Bodies . Shapes [ Pair . BodyA ], Bodies . Positions . Get ( Pair . BodyA ),
+                                                                                 Bodies . Shapes [ Pair . BodyB ], Bodies . Positions . Get ( Pair . BodyB ) );
+            benchmark::DoNotOptimize ( Hit );
+            Contacts += Hit . IsHit ? 1.0 : 0.0;
+        }
+    }
+    State . SetItemsProcessed ( State . iterations () * static_cast<int64_t> ( Scene . BoxPairs . size () ) );
+    SetStepCounters ( State, Bodies . Size (), static_cast<double> ( Scene . BoxPairs . size () * State . iterations () ), Contacts );
+}
+BENCHMARK ( BM_TestSphereBox ) -> Apply ( ScaleArguments );
+
+// World boundary stage: every ball against the walls of the world box in one pass, the replacement for BM_TestSphereBox
+static void BM_TestSpheresInsideBox ( benchmark::State & State )
+{
+    const PE::ESimdLevel Level = static_cast<PE::ESimdLevel> ( State . range ( 1 ) );
+    if ( SkipUnsupportedLevel ( State, Level ) )
+    {
+        return;
+    }
+    const SPairScene Scene ( static_cast<int> ( State . range ( 0 ) ) );
+    const PE::CBodyStorage & Bodies = Scene . World . GetBodies ();
+    std::vector<PE::SContact> Contacts;
+    double NumberOfContacts = 0.0;
+    for ( auto _ : State )
+    {
+        NumberOfContacts += PE::Collision::TestSpheresInsideBox ( Bodies, 0, Bodies . Size (), Scene . World . GetWorldBox (), Scene . Walls, Contacts, Level );
+        benchmark::ClobberMemory ();
+    }
+    State . SetItemsProcessed ( State . iterations () * Bodies . Size () );
+    SetStepCounters ( State, Bodies . Size (), 0.0, NumberOfContacts );
+}
+BENCHMARK ( BM_TestSpheresInsideBox ) -> Apply ( ScaleAndSimdArguments );
+
+// Narrowphase: full contact generation (batched spheres + scalar boxes + merge) over the broadphase pairs
+static void BM_GenerateContacts ( benchmark::State & State )
+{
+    const SPairScene Scene ( static_cast<int> ( State . range ( 0 ) ) );
+    PE::CNarrowphase Narrowphase;
+    std::vector<PE::SContact> Contacts;
+    double NumberOfContacts = 0.0;
+    for ( auto _ : State )
+    {
+        Narrowphase . GenerateContacts ( Scene . World . GetBodies (), Scene . Pairs, Contacts );
+        NumberOfContacts += static_cast<double> ( Contacts . size () );
+    }
+    SetStepCounters ( State, Scene . World . GetBodies () . Size (), static_cast<double> ( Scene . Pairs . size () ) * State . iterations (), NumberOfContacts );
+}
+BENCHMARK ( BM_GenerateContacts ) -> Apply ( ScaleArguments );
+
+// Narrowphase: contact generation over sphere-sphere and sphere-box pairs interleaved in one sorted list
+static void BM_GenerateMixedContacts ( benchmark::State & State )
+{
+    const SPairScene Scene ( static_cast<int> ( State . range ( 0 ) ) );
+    std::vector<PE::SBroadphasePair> Pairs = Scene . Pairs;
+    Pairs . insert ( Pairs . end (), Scene . BoxPairs . begin (), Scene . BoxPairs . end () );
+    std::sort ( Pairs . begin (), Pairs . end (), [] ( const PE::SBroadphasePair & A, const PE::SBroadphasePair & B )
+    {
+        return A . BodyA != B . BodyA ? A . BodyA < B . BodyA : A . BodyB < B . BodyB;
+    } );
+    PE::CNarrowphase Narrowphase;
+    std::vector<PE::SContact> Contacts;
+    double NumberOfContacts = 0.0;
+    for ( auto _ : State )
+    {
+        Narrowphase . GenerateContacts ( Scene . World . GetBodies (), Pairs, Contacts );
+        NumberOfContacts += static_cast<double> ( Contacts . size () );
+    }
+    State . SetItemsProcessed ( State . iterations () * static_cast<int64_t> ( Pairs . size () ) );
+    SetStepCounters ( State, Scene . World . GetBodies () . Size (), static_cast<double> ( Pairs . size () ) * State . iterations (), NumberOfContacts );
+}
+BENCHMARK ( BM_GenerateMixedContacts ) -> Apply ( ScaleArguments );
+
+// Solver convergence on a resting pile: compare warm started runs with fewer iterations against cold runs with more.
+// Lower penetration and kinetic energy mean a better converged (quieter) pile.
+static void BM_SettledPile ( benchmark::State & State )
+{
+    PE::SSimulationParameters Parameters = MakeBenchmarkParameters ( GSettledPileBalls );
+    Parameters . NumberOfSteps = static_cast<int> ( State . range ( 0 ) );
+    Parameters . WarmStarting = State . range ( 1 ) != 0;
+    Parameters . AllowSleeping = false;
+    CBenchmarkWorld World ( Parameters );
+    for ( const PE::SPhysicsBody & Body : GetSettledPile () )
+    {
+        World . AddBody ( Body );
+    }
+    // Fill the contact cache and let the pile adapt to the iteration count before measuring
+    for ( int Step = 0; Step < 60; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+    }
+    const PE::CBodyStorage & Bodies = World . GetBodies ();
+    double PairTests = 0.0;
+    double Contacts = 0.0;
+    double WarmStartedContacts = 0.0;
+    double MaxPenetration = 0.0;
+    double KineticEnergy = 0.0;
+    for ( auto _ : State )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        PairTests += World . GetNumberOfPairTests ();
+        Contacts += World . GetNumberOfContacts ();
+        WarmStartedContacts += World . GetNumberOfWarmStartedContacts ();
+        float StepMaxPenetration = 0.f;
+        for ( const PE::SContact & Contact : World . GetContacts () )
+        {
+            StepMaxPenetration = std::max ( StepMaxPenetration, Contact . Penetration );
+        }
+        MaxPenetration += StepMaxPenetration;
+        for ( int i = 0; i < Bodies . Size (); i++ )
+        {
+            const Vector3 Velocity = Bodies . LinearVelocities . Get ( i );
+            KineticEnergy += 0.5 * Bodies . Masses [ i ] * ( Velocity . x * Velocity . x + Velocity . y * Velocity . y + Velocity . z * Velocity . z );
+        }
+    }
+    State . SetLabel ( Parameters . WarmStarting ? "warm" : "cold" );
+    SetStepCounters ( State, Bodies . Size (), PairTests, Contacts );
+    State . counters [ "warm_started/step" ] = benchmark::Counter ( WarmStartedContacts, benchmark::Counter::kAvgIterations );
+    State . counters [ "max_penetration" ] = benchmark::Counter ( MaxPenetration, benchmark::Counter::kAvgIterations );
+    State . counters [ "kinetic_energy" ] = benchmark::Counter ( KineticEnergy, benchmark::Counter::kAvgIterations );
+}
+BENCHMARK ( BM_SettledPile ) -> ArgNames ( { "iterations", "warm" } ) -> ArgsProduct ( { { 1, 2, 4, 8 }, { 0, 1 } } ) -> Unit ( benchmark::kMicrosecond );
+
+// Whole step on the resting floor with sleeping off and on: once the islands sleep, the cost follows the awake bodies
+static void BM_SettledWorldStep ( benchmark::State & State )
+{
+    const bool AllowSleeping = State . range ( 0 ) != 0;
+    CBenchmarkWorld & SleepingWorld = GetSleepingFloor ();
+    // The sleeping variant keeps stepping the settled world, the other one starts from the same bodies, all awake
+    std::unique_ptr<CBenchmarkWorld> AwakeWorld;
+    if ( ! AllowSleeping )
+    {
+        PE::SSimulationParameters Parameters = SleepingWorld . GetSimulationParameters ();
+        Parameters . AllowSleeping = false;
+        AwakeWorld = std::make_unique<CBenchmarkWorld> ( Parameters );
+        for ( const PE::SPhysicsBody & Body : SleepingWorld . GetBodies () . ExportBodies () )
+        {
+            AwakeWorld -> AddBody ( Body );
+        }
+    }
+    CBenchmarkWorld & World = AllowSleeping ? SleepingWorld : *AwakeWorld;
+    double PairTests = 0.0;
+    double Contacts = 0.0;
+    double AwakeBodies = 0.0;
+    for ( auto _ : State )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        PairTests += World . GetNumberOfPairTests ();
+        Contacts += World . GetNumberOfContacts ();
+        AwakeBodies += World . GetNumberOfAwakeBodies ();
+    }
+    SetStepCounters ( State, World . GetBodies () . Size (), PairTests, Contacts );
+    State . counters [ "awake_bodies" ] = benchmark::Counter ( AwakeBodies, benchmark::Counter::kAvgIterations );
+}
+BENCHMARK ( BM_SettledWorldStep ) -> ArgNames ( { "sleeping" } ) -> Arg ( 0 ) -> Arg ( 1 ) -> Unit ( benchmark::kMicrosecond );
+
+// Whole step with the islands solved on 1-16 threads. Wall time, the workers don't show up in the main thread's CPU time.
+// Only the broadphase update and pair finding stay single-threaded, so they bound the speedup.
+static void BM_IslandSolverThreads ( benchmark::State & State )
+{
+    const int NumberOfBalls = static_cast<int> ( State . range ( 0 ) );
+    PE::SSimulationParameters Parameters = MakeBenchmarkParameters ( NumberOfBalls );
+    Parameters . NumberOfThreads = static_cast<int> ( State . range ( 1 ) );
+    Parameters . AllowSleeping = false;
+    CBenchmarkWorld World ( Parameters );
+    World . Restart ();
+    // Let the first collisions happen so the contact graph has islands of all sizes
+    for ( int Step = 0; Step < 30; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+    }
+    double PairTests = 0.0;
+    double Contacts = 0.0;
+    double Islands = 0.0;
+    for ( auto _ : State )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        PairTests += World . GetNumberOfPairTests ();
+        Contacts += World . GetNumberOfContacts ();
+        Islands += World . GetNumberOfIslands ();
+    }
+    SetStepCounters ( State, World . GetBodies () . Size (), PairTests, Contacts );
+    State . counters [ "islands/step" ] = benchmark::Counter ( Islands, benchmark::Counter::kAvgIterations );
+}
+BENCHMARK ( BM_IslandSolverThreads ) -> ArgNames ( { "balls", "threads" } ) -> ArgsProduct ( { { 10000, 100000 }, { 1, 2, 4, 8, 16 } } ) -> UseRealTime () -> Unit ( benchmark::kMillisecond );
+
+// The settled pile is one large island: the island solver can't split it, the graph-colored solver spreads each color over the threads
+static void BM_SettledPileSolverThreads ( benchmark::State & State )
+{
+    PE::SSimulationParameters Parameters = MakeBenchmarkParameters ( GSettledPileBalls );
+    Parameters . SolverType = static_cast<PE::ESolverType> ( State . range ( 0 ) );
+    Parameters . NumberOfThreads = static_cast<int> ( State . range ( 1 ) );
+    Parameters . AllowSleeping = false;
+    CBenchmarkWorld World ( Parameters );
+    for ( const PE::SPhysicsBody & Body : GetSettledPile () )
+    {
+        World . AddBody ( Body );
+    }
+    double PairTests = 0.0;
+    double Contacts = 0.0;
+    double Islands = 0.0;
+    double Colors = 0.0;
+    for ( auto _ : State )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        PairTests += World . GetNumberOfPairTests ();
+        Contacts += World . GetNumberOfContacts ();
+        Islands += World . GetNumberOfIslands ();
+        Colors += World . GetNumberOfColors ();
+    }
+    SetStepCounters ( State, World . GetBodies () . Size (), PairTests, Contacts );
+    State . counters [ "islands/step" ] = benchmark::Counter ( Islands, benchmark::Counter::kAvgIterations );
+    State . counters [ "colors/step" ] = benchmark::Counter ( Colors, benchmark::Counter::kAvgIterations );
+}
+BENCHMARK ( BM_SettledPileSolverThreads ) -> ArgNames ( { "solver", "threads" } ) -> ArgsProduct ( { { 0, 1 }, { 1, 2, 4, 8, 16 } } ) -> UseRealTime () -> Unit ( benchmark::kMicrosecond );
+
+// Console output for humans, and JSON to PhysicsEngineBench.json unless --benchmark_out is given
+int main ( int argc, char ** argv )
+{
+    std::vector<char *> Arguments ( argv, argv + argc );
+    bool HasOutput = false;
+    for ( int i = 1; i < argc; i++ )
+    {
+        HasOutput = HasOutput || std::strncmp ( argv [ i ], "--benchmark_out=", 16 ) == 0;
+    }
+    std::string OutArgument = "--benchmark_out=PhysicsEngineBench.json";
+    std::string FormatArgument = "--benchmark_out_format=json";
+    if ( ! HasOutput )
+    {
+        Arguments . push_back ( OutArgument . data () );
+        Arguments . push_back ( FormatArgument . data () );
+    }
+    int NumberOfArguments = static_cast<int> ( Arguments . size () );
+    benchmark::Initialize ( &NumberOfArguments, Arguments . data () );
+    if ( benchmark::ReportUnrecognizedArguments ( NumberOfArguments, Arguments . data () ) )
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks ();
+    benchmark::Shutdown ();
+    return 0;
+}
@@ -6,7 +6,7 @@ int main(void)
     PE::CScene Scene { PE::SSceneParameters {} };
     while (!WindowShouldClose() )  
     {
-        Scene . Update( GetFrameTime() );
+        Scene . Update();
         BeginDrawing();
             Scene . Draw(); 
         EndDrawing();
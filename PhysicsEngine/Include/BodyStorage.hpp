@@ -0,0 +1,249 @@
+#pragma once
+#include "raylib.h"
+#include "PhysicsBody.hpp"
+#include "Shape.hpp"
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Per-body state bits stored in CBodyStorage.
+     */
+    enum class EBodyFlags : uint8_t
+    {
+        None = 0,
+        Static = 1 << 0,
+        Sleeping = 1 << 1, // Skipped by integration, never paired with other sleeping or static bodies
+        WorldBoundary = 1 << 2, // Static wall of the world box, collided analytically and kept out of the broadphase
+    };
+
+    /**
+     * @brief Surface and damping properties shared by many bodies.
+     */
+    struct SMaterial
+    {
+        float Restitution = 0.5f;
+        float Friction = 0.5f;
+        float LinearDamping = 0.98f;
+        float AngularDamping = 0.98f;
+
+        bool operator== ( const SMaterial & Other ) const = default;
+    };
+
+    /**
+     * @brief Coefficients of a contact between two materials, combined once when a material is added.
+     */
+    struct SMaterialPair
+    {
+        float Restitution = 0.f; // min of both
+        float Friction = 0.f; // min of both, never negative
+    };
+
+    /**
+     * @brief Structure-of-arrays Vector3 stream: one contiguous array per component.
+     */
+    struct SVector3Stream
+    {
+        std::vector<float> X;
+        std::vector<float> Y;
+        std::vector<float> Z;
+
+        Vector3 Get ( int Index ) const { return { X [ Index ], Y [ Index ], Z [ Index ] }; }
+        void Set ( int Index, const Vector3 & Value ) { X [ Index ] = Value . x; Y [ Index ] = Value . y; Z [ Index ] = Value . z; }
+        void PushBack ( const Vector3 & Value ) { X . push_back ( Value . x ); Y . push_back ( Value . y ); Z . push_back ( Value . z ); }
+        void PopBack () { X . pop_back(); Y . pop_back(); Z . pop_back(); }
+        void Reserve ( size_t Size ) { X . reserve ( Size ); Y . reserve ( Size ); Z . reserve ( Size ); }
+        void Clear () { X . clear(); Y . clear(); Z . clear(); }
+    };
+
+    /**
+     * @brief Structure-of-arrays Quaternion stream: one contiguous array per component.
+     */
+    struct SQuaternionStream
+    {
+        std::vector<float> X;
+        std::vector<float> Y;
+        std::vector<float> Z;
+        std::vector<float> W;
+
+        Quaternion Get ( int Index ) const { return { X [ Index ], Y [ Index ], Z [ Index ], W [ Index ] }; }
+        void Set ( int Index, const Quaternion & Value ) { X [ Index ] = Value . x; Y [ Index ] = Value . y; Z [ Index ] = Value . z; W [ Index ] = Value . w; }
+        void PushBack ( const Quaternion & Value ) { X . push_back ( Value . x ); Y . push_back ( Value . y ); Z . push_back ( Value . z ); W . push_back ( Value . w ); }
+        void PopBack () { X . pop_back(); Y . pop_back(); Z . pop_back(); W . pop_back(); }
+        void Reserve ( size_t Size ) { X . reserve ( Size ); Y . reserve ( Size ); Z . reserve ( Size ); W . reserve ( Size ); }
+        void Clear () { X . clear(); Y . clear(); Z . clear(); W . clear(); }
+    };
+
+    /**
+     * @brief Structure-of-arrays storage of all physics bodies.
+     *
+     * Hot loops (integration, collision, drawing) address bodies by dense index and touch only the
+     * arrays they need. Bodies are identified from outside by a stable handle (SPhysicsBody::Id)
+     * that is mapped to the dense index through an indirection table.
+     * SPhysicsBody is used only to import and export a whole body.
+     *
+     * A handle packs a slot of the indirection table (low GHandleSlotBits) with the slot's generation.
+     * Removing a body moves the last body into its dense index (swap and pop) and frees the slot with a
+     * bumped generation, so the arrays stay dense and the old handle stops resolving. Freed slots are reused
+     * first, oldest first, so a slot comes back only after every other free one did: once the arrays have
+     * grown to the peak body count, adding and removing bodies allocates nothing. A slot whose generation
+     * ran out is retired for good instead of wrapping, so a stale handle never resolves to a later body.
+     */
+    class CBodyStorage
+    {
+        public:
+
+        static constexpr int GHandleSlotBits = 22; // Up to 4M bodies at once
+        static constexpr int GHandleSlotMask = ( 1 << GHandleSlotBits ) - 1;
+        static constexpr int GMaxHandleSlots = 1 << GHandleSlotBits;
+        static constexpr int GHandleGenerationMask = ( 1 << ( 31 - GHandleSlotBits ) ) - 1; // Handles stay positive, a slot lives 512 bodies
+        static constexpr int GMaxMaterials = 1 << 12; // The pair table holds GMaxMaterials^2 entries, 128 MB at the limit
+
+        /**
+         * Import a body. Returns its handle, which is also written to the stored body's Id. O(1).
+         * Returns -1 and adds nothing when every handle slot is taken or retired, or its material doesn't fit (AddMaterial).
+         */
+        int Add ( const SPhysicsBody & Body );
+
+        /**
+         * Append NumberOfBodies copies of Template, for bulk spawns that overwrite them with WriteBody afterwards.
+         * @return dense index of the first appended body, -1 (and nothing appended) when Add would fail or there are not enough handles left
+         */
+        int Append ( int NumberOfBodies, const SPhysicsBody & Template );
+
+        /**
+         * Overwrite the body at a dense index, keeping its handle, with a material already in the table.
+         * Touches only that index (and, when the body was sleeping, its island's ring): writes to different
+         * awake bodies may run concurrently.
+         */
+        void WriteBody ( int Index, const SPhysicsBody & Body, uint16_t MaterialIndex );
+
+        /**
+         * Remove a body, O(1). The last body moves into its dense index, every other index stays.
+         * @return false when the handle doesn't resolve (already removed or never added)
+         */
+        bool Remove ( int Handle );
+
+        /** Remove all bodies and materials. */
+        void Clear ();
+
+        /** Reserve capacity for a given number of bodies. */
+        void Reserve ( int NumberOfBodies );
+
+        int Size () const { return static_cast<int> ( m_Ids . size() ); }
+
+        /** Dense index of a handle, or -1 when the handle is unknown. */
+        int GetIndex ( int Handle ) const;
+
+        /** Handle (SPhysicsBody::Id) of the body at a dense index. */
+        int GetHandle ( int Index ) const { return m_Ids [ Index ]; }
+
+        /** Slot of the indirection table a handle refers to, smaller than GetNumberOfHandleSlots for every live handle. */
+        static int GetHandleSlot ( int Handle ) { return Handle & GHandleSlotMask; }
+        int GetNumberOfHandleSlots () const { return static_cast<int> ( m_HandleSlots . size() ); }
+
+        /** Export the body at a dense index. */
+        SPhysicsBody GetBody ( int Index ) const;
+
+        /**
+         * Overwrite the body at a dense index, keeping its handle and its WorldBoundary flag.
+         * @return false (and nothing written) when the body's material doesn't fit (AddMaterial)
+         */
+        bool SetBody ( int Index, const SPhysicsBody & Body );
+
+        /**
+         * Move the bodies to a new dense order, handles keep pointing at their bodies.
+         * @param NewToOld for every new dense index the body's current index, a permutation of [0, Size())
+         */
+        void Permute ( std::span<const int> NewToOld );
+
+        /** Export all bodies in dense order. */
+        std::vector<SPhysicsBody> ExportBodies () const;
+
+        /**
+         * Put the bodies to sleep as one island. They are linked in a ring by handle, so waking any of them
+         * reaches the others without a scan, and moving or removing bodies keeps the ring intact.
+         */
+        void PutIslandToSleep ( std::span<const int> Indices, int SleepIsland );
+
+        /**
+         * Wake the body at Index and the rest of its sleeping island, O(island size), allocation free.
+         * @return number of bodies woken, 0 when the body wasn't sleeping
+         */
+        int WakeIsland ( int Index );
+
+        /** Find or add a material, returns its index. O(1) on average, -1 when GMaxMaterials others are stored already. */
+        int AddMaterial ( const SMaterial & Material );
+
+        const SMaterial & GetMaterial ( int MaterialIndex ) const { return m_Materials [ MaterialIndex ]; }
+        int GetNumberOfMaterials () const { return static_cast<int> ( m_Materials . size() ); }
+
+        /** Combined coefficients of a contact between two materials, a table lookup. */
+        const SMaterialPair & GetMaterialPair ( int MaterialA, int MaterialB ) const { return m_MaterialPairs [ MaterialA * m_MaterialPairStride + MaterialB ]; }
+
+        bool IsStatic ( int Index ) const { return ( Flags [ Index ] & static_cast<uint8_t> ( EBodyFlags::Static ) ) != 0; }
+        bool IsSleeping ( int Index ) const { return ( Flags [ Index ] & static_cast<uint8_t> ( EBodyFlags::Sleeping ) ) != 0; }
+        bool IsWorldBoundary ( int Index ) const { return ( Flags [ Index ] & static_cast<uint8_t> ( EBodyFlags::WorldBoundary ) ) != 0; }
+        /** Dynamic and awake, the only bodies that move and get solved. */
+        bool IsAwake ( int Index ) const { return ( Flags [ Index ] & GPassiveFlags ) == 0; }
+
+        /** Static and sleeping bodies don't move; pairs of two such bodies are never tested. */
+        static constexpr uint8_t GPassiveFlags = static_cast<uint8_t> ( EBodyFlags::Static ) | static_cast<uint8_t> ( EBodyFlags::Sleeping );
+
+        // Component streams, indexed by dense body index
+        std::vector<SShape> Shapes;
+        SVector3Stream Positions;
+        SVector3Stream LinearVelocities;
+        SVector3Stream AngularVelocities;
+        SQuaternionStream Rotations;
+        std::vector<float> Masses;
+        std::vector<float> InvMasses;
+        std::vector<float> InvInertias; // Cached 1 / I of the shape, 0 for static bodies
+        std::vector<float> Radii; // Sphere radius, 0 for other shapes
+        std::vector<uint16_t> MaterialIndices;
+        std::vector<uint8_t> Flags; // EBodyFlags bits
+        std::vector<float> SleepTimes; // How long the body has been below the sleep velocity thresholds
+        std::vector<int> SleepIslands; // Island the body fell asleep with, -1 when awake
+        std::vector<int> SleepNext; // Handle of the next body in the ring of its sleeping island, -1 when awake
+        std::vector<int> SleepPrevious; // Handle of the previous body in that ring, -1 when awake
+
+        private:
+
+        struct SHandleSlot
+        {
+            int Index = -1; // Dense index of the body, -1 while the slot is free
+            int Generation = 0; // Past GHandleGenerationMask once retired, no handle matches it then
+            int NextFree = -1; // Next slot of the free list
+        };
+
+        /** Hashes the values SMaterial compares, +0 and -0 alike. */
+        struct SMaterialHash
+        {
+            size_t operator() ( const SMaterial & Material ) const;
+        };
+
+        /** Take the oldest free handle slot (or a new one) for the body at Index, returns its handle. */
+        int AllocateHandle ( int Index );
+        /** Whether AllocateHandle can hand out NumberOfHandles more handles. */
+        bool HasFreeHandles ( int NumberOfHandles ) const;
+        /** Copy every component of the body at From over the one at To. */
+        void MoveBody ( int From, int To );
+        void CombineMaterials ( int MaterialA, int MaterialB );
+        /** Take the body at Index out of its sleeping island's ring, if it is in one. */
+        void UnlinkFromSleepIsland ( int Index );
+
+        std::vector<int> m_Ids;
+        std::vector<SHandleSlot> m_HandleSlots;
+        int m_FirstFreeHandleSlot = -1; // Free slots are reused first in, first out
+        int m_LastFreeHandleSlot = -1;
+        int m_NumberOfFreeHandleSlots = 0;
+        std::vector<SMaterial> m_Materials;
+        std::unordered_map<SMaterial, uint16_t, SMaterialHash> m_MaterialIndices;
+        std::vector<SMaterialPair> m_MaterialPairs; // m_MaterialPairStride x m_MaterialPairStride, symmetric
+        int m_MaterialPairStride = 0; // Grows by doubling so adding a material only fills its row and column
+    };
+} // namespace PE
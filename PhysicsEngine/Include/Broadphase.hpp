@@ -0,0 +1,109 @@
+#pragma once
+#include "Parameters.hpp"
+#include "BodyStorage.hpp"
+#include <memory>
+#include <span>
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Candidate pair of bodies emitted by a broadphase.
+     *
+     * Indices are dense indices into the CBodyStorage the broadphase was updated from. BodyA is always
+     * smaller than BodyB, so pairs come out in the same orientation as the brute-force j < k loop.
+     */
+    struct SBroadphasePair
+    {
+        int BodyA = 0;
+        int BodyB = 0;
+    };
+
+    /**
+     * @brief Receives the bodies a broadphase box query finds.
+     */
+    class CBroadphaseBoxCallback
+    {
+        public:
+        virtual ~CBroadphaseBoxCallback() = default;
+
+        /** Called once for every body (dense index) whose bounds overlap the box, in no particular order. */
+        virtual void ReportBody ( int Index ) = 0;
+    };
+
+    /**
+     * @brief Receives the bodies a broadphase ray query finds.
+     */
+    class CBroadphaseRayCallback
+    {
+        public:
+        virtual ~CBroadphaseRayCallback() = default;
+
+        /**
+         * Called once for every body (dense index) whose bounds the ray touches within its current length.
+         * @return new length of the ray: unchanged to go on, a hit distance to skip the bodies behind it, negative to stop
+         */
+        virtual float ReportBody ( int Index ) = 0;
+    };
+
+    /**
+     * @brief Common interface of the broadphase structures.
+     *
+     * A broadphase is updated once per simulation step from the body storage and then reports
+     * conservative candidate pairs. Pairs of two passive bodies (static or sleeping, see
+     * CBodyStorage::GPassiveFlags) are never reported.
+     */
+    class CBroadphase
+    {
+        public:
+        virtual ~CBroadphase() = default;
+
+        /** Bring the structure up to date with the current body positions. */
+        virtual void Update ( const CBodyStorage & Bodies ) = 0;
+
+        /** Append candidate pairs (sorted by BodyA, then BodyB) whose bounds overlap. */
+        virtual void FindPairs ( std::vector<SBroadphasePair> & OutPairs ) const = 0;
+
+        /** Drop all bodies, the next Update starts from scratch. */
+        virtual void Clear () = 0;
+
+        /**
+         * The bodies were moved to a new dense order (CBodyStorage::Permute), carry the per-body state over.
+         * Update runs before pairs are found again.
+         */
+        virtual void RemapBodies ( std::span<const int> NewToOld ) = 0;
+
+        /**
+         * The body at Index is about to be removed (CBodyStorage::Remove), which moves the last body into Index:
+         * drop its state and carry the last body's over. Update runs before pairs are found again.
+         */
+        virtual void RemoveBody ( const CBodyStorage & Bodies, int Index ) = 0;
+
+        /**
+         * Report the bodies whose bounds overlap Box, as they were at the last Update.
+         * World boundary bodies are never in a broadphase and never reported.
+         */
+        virtual void QueryBox ( const BoundingBox & Box, CBroadphaseBoxCallback & Callback ) const = 0;
+
+        /**
+         * Report the bodies whose bounds the ray from Origin along the unit Direction touches within MaxDistance,
+         * as they were at the last Update. Safe to call from several threads at once, like QueryBox.
+         */
+        virtual void QueryRay ( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, CBroadphaseRayCallback & Callback ) const = 0;
+    };
+
+    /**
+     * @brief Create the broadphase selected by the simulation parameters.
+     * @param SimulationParameters broadphase type, margin and ball size used to configure the structure
+     * @return configured broadphase instance
+     */
+    std::unique_ptr<CBroadphase> CreateBroadphase ( const SSimulationParameters & SimulationParameters );
+
+    /**
+     * @brief Sort a range of candidate pairs by BodyA, then BodyB.
+     * @param Begin first pair of the range
+     * @param End one past the last pair of the range
+     */
+    void SortPairs ( std::vector<SBroadphasePair>::iterator Begin, std::vector<SBroadphasePair>::iterator End );
+} // namespace PE
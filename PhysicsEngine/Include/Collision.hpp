@@ -2,6 +2,8 @@
 #include "Shape.hpp"
 #include "PhysicsBody.hpp"
 #include "raylib.h"
+#include <array>
+#include <utility>
 
 
 namespace PE
@@ -23,23 +25,207 @@ namespace Collision
         bool IsHit = false; 
     };
     
+    /**
+     * @brief Result of a swept (continuous) test: when during the motion the shapes first touch.
+     */
+    struct SSweepResult
+    {
+        float TimeOfImpact = 1.f; // Fraction of the motion, in [0, 1]
+        bool IsHit = false;
+    };
+
+    /**
+     * @brief Result of a ray cast against a shape.
+     */
+    struct SRayResult
+    {
+        float Distance = 0.f; // Along the unit direction, 0 when the ray starts inside the shape
+        Vector3 Normal { 0.f, 0.f, 0.f }; // Outward surface normal at the hit, against the ray when it starts inside
+        bool IsHit = false;
+    };
+
+    constexpr int GNumberOfShapeTypes = static_cast<int> ( EShapeType::Count );
+
+    /**
+     * A pair of shapes is tested in one order only, the shape later in EShapeType as A (a sphere before a box).
+     * Kernels produce their normal from B toward A in that order, so nothing flips it afterwards.
+     */
+    constexpr bool IsCanonicalPair ( EShapeType TypeA, EShapeType TypeB )
+    {
+        return TypeA >= TypeB;
+    }
+
+    /** Index of an unordered pair of shape types in [ 0, GNumberOfPairTypes ), the same for both orders. */
+    constexpr int GetPairType ( EShapeType TypeA, EShapeType TypeB )
+    {
+        const int High = static_cast<int> ( IsCanonicalPair ( TypeA, TypeB ) ? TypeA : TypeB );
+        const int Low = static_cast<int> ( IsCanonicalPair ( TypeA, TypeB ) ? TypeB : TypeA );
+        return High * ( High + 1 ) / 2 + Low;
+    }
+
+    constexpr int GNumberOfPairTypes = GNumberOfShapeTypes * ( GNumberOfShapeTypes + 1 ) / 2;
+
+    /** Canonical shape types (A, B) of a pair type, the inverse of GetPairType. */
+    constexpr std::pair<EShapeType, EShapeType> GetPairShapeTypes ( int PairType )
+    {
+        int High = 0;
+        while ( ( High + 1 ) * ( High + 2 ) / 2 <= PairType )
+        {
+            High++;
+        }
+        return { static_cast<EShapeType> ( High ), static_cast<EShapeType> ( PairType - High * ( High + 1 ) / 2 ) };
+    }
+
+    /**
+     * @brief Contact test of one canonical pair of shape types (see IsCanonicalPair).
+     *
+     * Every canonical pair specializes Test ( ShapeA, PositionA, ShapeB, PositionB, Margin ) with the same
+     * contract as TestCollision. There is no general case: a new shape adds one specialization per shape it
+     * can touch, with itself as A, and the dispatch tables of TestCollision and CNarrowphase pick them up.
+     */
+    template <EShapeType TypeA, EShapeType TypeB>
+    struct SPairTest;
+
+    template <>
+    struct SPairTest<EShapeType::Sphere, EShapeType::Sphere>
+    {
+        static SHitResult Test ( const SShape & ShapeA, const Vector3 & PositionA, const SShape & ShapeB, const Vector3 & PositionB, float Margin );
+    };
+
+    template <>
+    struct SPairTest<EShapeType::Sphere, EShapeType::Box>
+    {
+        static SHitResult Test ( const SShape & ShapeA, const Vector3 & PositionA, const SShape & ShapeB, const Vector3 & PositionB, float Margin );
+    };
+
+    template <>
+    struct SPairTest<EShapeType::Box, EShapeType::Box>
+    {
+        static SHitResult Test ( const SShape & ShapeA, const Vector3 & PositionA, const SShape & ShapeB, const Vector3 & PositionB, float Margin );
+    };
+
+    /**
+     * @brief One entry per pair type, built at compile time from the SPairTest specializations.
+     * @param MakeEntry callable template, MakeEntry.template operator()<TypeA, TypeB>() gives the entry of a canonical pair
+     */
+    template <typename TEntry, typename TMakeEntry>
+    constexpr std::array<TEntry, GNumberOfPairTypes> MakePairTable ( TMakeEntry MakeEntry )
+    {
+        return [ & ] <int... PairTypes> ( std::integer_sequence<int, PairTypes...> )
+        {
+            return std::array<TEntry, GNumberOfPairTypes> {
+                MakeEntry . template operator()<GetPairShapeTypes ( PairTypes ) . first, GetPairShapeTypes ( PairTypes ) . second>()...
+            };
+        } ( std::make_integer_sequence<int, GNumberOfPairTypes> {} );
+    }
+
+    /**
+     * @brief Queries of one shape type that involve no second body.
+     *
+     * Every shape type specializes GetBoundingBox, RayCast, OverlapsSphere, OverlapsBox and SweepSphere (a moving
+     * sphere against the shape at rest), with the contracts of the dispatching functions of the same name below.
+     */
+    template <EShapeType Type>
+    struct SShapeTraits;
+
+    template <>
+    struct SShapeTraits<EShapeType::Sphere>
+    {
+        static BoundingBox GetBoundingBox ( const SShape & Shape, const Vector3 & Position );
+        static SRayResult RayCast ( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, const SShape & Shape, const Vector3 & Position );
+        static bool OverlapsSphere ( const SShape & Shape, const Vector3 & Position, const Vector3 & Center, float Radius );
+        static bool OverlapsBox ( const SShape & Shape, const Vector3 & Position, const BoundingBox & Box );
+        static SSweepResult SweepSphere ( const Vector3 & Start, const Vector3 & Motion, float Radius, const SShape & Shape, const Vector3 & Position );
+    };
+
+    template <>
+    struct SShapeTraits<EShapeType::Box>
+    {
+        static BoundingBox GetBoundingBox ( const SShape & Shape, const Vector3 & Position );
+        static SRayResult RayCast ( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, const SShape & Shape, const Vector3 & Position );
+        static bool OverlapsSphere ( const SShape & Shape, const Vector3 & Position, const Vector3 & Center, float Radius );
+        static bool OverlapsBox ( const SShape & Shape, const Vector3 & Position, const BoundingBox & Box );
+        static SSweepResult SweepSphere ( const Vector3 & Start, const Vector3 & Motion, float Radius, const SShape & Shape, const Vector3 & Position );
+    };
+
+    /**
+     * @brief One entry per shape type, built at compile time like MakePairTable.
+     * @param MakeEntry callable template, MakeEntry.template operator()<Type>() gives the entry of a shape type
+     */
+    template <typename TEntry, typename TMakeEntry>
+    constexpr std::array<TEntry, GNumberOfShapeTypes> MakeShapeTable ( TMakeEntry MakeEntry )
+    {
+        return [ & ] <int... Types> ( std::integer_sequence<int, Types...> )
+        {
+            return std::array<TEntry, GNumberOfShapeTypes> { MakeEntry . template operator()<static_cast<EShapeType> ( Types )>()... };
+        } ( std::make_integer_sequence<int, GNumberOfShapeTypes> {} );
+    }
+
+    /**
+     * @brief Compute the world-space axis-aligned bounding box of a physics body.
+     * @param Body physics body
+     * @return bounding box enclosing the body's shape at its current position
+     */
+    BoundingBox GetBoundingBox ( const SPhysicsBody & Body );
+
+    /**
+     * @brief Compute the world-space axis-aligned bounding box of a shape placed at a position.
+     * @param Shape shape of the body
+     * @param Position world-space position of the shape center
+     * @return bounding box enclosing the shape
+     */
+    BoundingBox GetBoundingBox ( const SShape & Shape, const Vector3 & Position );
+
+    /** Whether a shape placed at a position touches or overlaps a sphere. */
+    bool OverlapsSphere ( const SShape & Shape, const Vector3 & Position, const Vector3 & Center, float Radius );
+
+    /** Whether a shape placed at a position touches or overlaps an axis-aligned box. */
+    bool OverlapsBox ( const SShape & Shape, const Vector3 & Position, const BoundingBox & Box );
+
+    /**
+     * @brief First time a moving sphere touches a shape at rest, same conventions as SweepSphereSphere / SweepSphereBox.
+     * @param Motion displacement of the sphere relative to the shape
+     */
+    SSweepResult SweepSphere ( const Vector3 & Start, const Vector3 & Motion, float Radius, const SShape & Shape, const Vector3 & Position );
+
     /**
      * @brief Generic collision test between two physics bodies.
      * @param BodyA first physics body
      * @param BodyB second physics body
-     * Supports sphere-sphere and sphere-box pairs. Returns SHitResult with
+     * Dispatches to the SPairTest of the two shape types. Returns SHitResult with
      * contact information when a collision is detected.
      */
     SHitResult TestCollision ( const SPhysicsBody & BodyA, const SPhysicsBody & BodyB ); 
 
+    /**
+     * @brief Generic collision test between two shapes placed at given positions.
+     * @param ShapeA shape of the first body
+     * @param PositionA world-space position of the first body
+     * @param ShapeB shape of the second body
+     * @param PositionB world-space position of the second body
+     * @param Margin pairs separated by up to Margin are reported too, with a negative Penetration
+     * Same dispatch and normal convention as the SPhysicsBody overload.
+     */
+    SHitResult TestCollision ( const SShape & ShapeA, const Vector3 & PositionA, const SShape & ShapeB, const Vector3 & PositionB, float Margin = 0.f ); 
+
+    /**
+     * @brief Test collision between two axis-aligned boxes.
+     * @param BoxA first box, the normal points from BoxB toward it along the axis of least penetration
+     * @param BoxB second box
+     * @param Margin boxes separated by up to Margin are reported too, with a negative Penetration
+     * @return SHitResult with the contact point in the middle of the overlap
+     */
+    SHitResult TestBoxBox ( const BoundingBox & BoxA, const BoundingBox & BoxB, float Margin = 0.f );
+
     /**
      * @brief Test collision between a sphere and an axis-aligned bounding box.
      * @param SphereCenter center of the sphere in world coordinates
      * @param SphereRadius radius of the sphere
      * @param Box axis-aligned bounding box to test against
+     * @param Margin a sphere separated from the box by up to Margin is reported too, with a negative Penetration
      * @return SHitResult containing contact information when a collision occurs
      */
-    SHitResult TestSphereBox ( const Vector3 SphereCenter, float SphereRadius, const BoundingBox & Box );
+    SHitResult TestSphereBox ( const Vector3 SphereCenter, float SphereRadius, const BoundingBox & Box, float Margin = 0.f );
 
     /**
      * @brief Test collision between two spheres.
@@ -47,8 +233,49 @@ namespace Collision
      * @param SphereRadiusA radius of the first sphere
      * @param SphereCenterB center of the second sphere in world coordinates
      * @param SphereRadiusB radius of the second sphere
+     * @param Margin spheres separated by up to Margin are reported too, with a negative Penetration
      * @return SHitResult containing contact information when a collision occurs
      */
-    SHitResult TestSphereSphere ( const Vector3 & SphereCenterA, float SphereRadiusA, const Vector3 & SphereCenterB, float SphereRadiusB );
+    SHitResult TestSphereSphere ( const Vector3 & SphereCenterA, float SphereRadiusA, const Vector3 & SphereCenterB, float SphereRadiusB, float Margin = 0.f );
+
+    /**
+     * @brief First time two linearly moving spheres touch.
+     * @param StartA center of the first sphere at the start of the motion
+     * @param MotionA displacement of the first sphere over the motion
+     * Spheres that already overlap at the start, or move apart, are no hit: the regular contact handles them.
+     */
+    SSweepResult SweepSphereSphere ( const Vector3 & StartA, const Vector3 & MotionA, float RadiusA,
+                                     const Vector3 & StartB, const Vector3 & MotionB, float RadiusB );
+
+    /**
+     * @brief First time a moving sphere touches an axis-aligned box.
+     * Near an edge or corner the impact comes up to a small fraction of the radius early, never late. A sphere
+     * that already touches the box at the start, or doesn't move toward it, is no hit.
+     */
+    SSweepResult SweepSphereBox ( const Vector3 & Start, const Vector3 & Motion, float Radius, const BoundingBox & Box );
+
+    /**
+     * @brief First time a moving sphere inside an axis-aligned box touches one of its walls from inside.
+     * Walls the sphere already reaches at the start are skipped, like resting on the floor.
+     */
+    SSweepResult SweepSphereInsideBox ( const Vector3 & Start, const Vector3 & Motion, float Radius, const BoundingBox & Box );
+
+    /**
+     * @brief First point where a ray meets a sphere.
+     * @param Origin start of the ray
+     * @param Direction unit direction of the ray
+     * @param MaxDistance hits farther along the ray are no hit
+     */
+    SRayResult RayCastSphere ( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, const Vector3 & Center, float Radius );
+
+    /**
+     * @brief First point where a ray meets an axis-aligned box, same conventions as RayCastSphere.
+     */
+    SRayResult RayCastBox ( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, const BoundingBox & Box );
+
+    /**
+     * @brief Ray cast against a shape placed at a position, dispatching to the SShapeTraits of its type.
+     */
+    SRayResult RayCast ( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, const SShape & Shape, const Vector3 & Position );
 } // namespace Collision
 } // namespace PE
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include "raylib.h"
+
+
+namespace PE
+{
+    /**
+     * @brief Contact between two bodies produced by the narrowphase.
+     *
+     * Body indices are dense CBodyStorage indices. Only touching pairs produce a contact, so the
+     * contact buffer is compact and the solver never sees rejected pairs.
+     * The narrowphase fills the geometry, Solver::PrepareContacts fills the cached solver terms and
+     * the solver accumulates the impulses, which CContactCache carries over to the next step.
+     */
+    struct SContact
+    {
+        int BodyA = 0;
+        int BodyB = 0;
+        Vector3 ContactPoint { 0.f, 0.f, 0.f };
+        Vector3 Normal { 0.f, 0.f, 0.f }; // Points from B toward A
+        float Penetration = 0.f;
+
+        // Cached solver terms, constant over all solver iterations of a step
+        Vector3 OffsetA { 0.f, 0.f, 0.f }; // ContactPoint - PositionA
+        Vector3 OffsetB { 0.f, 0.f, 0.f }; // ContactPoint - PositionB
+        Vector3 OffsetACrossNormal { 0.f, 0.f, 0.f };
+        Vector3 OffsetBCrossNormal { 0.f, 0.f, 0.f };
+        float NormalMass = 0.f; // Effective mass along the normal, 1 / ( InvMassA + InvMassB + angular terms )
+        float TangentMass = 0.f; // Effective mass along the tangent plane, used for friction
+        float CorrectionMass = 0.f; // 1 / ( InvMassA + InvMassB ), 0 when both bodies are static
+        float BaseSeparation = 0.f; // dot ( PositionA - PositionB, Normal ) when the contact was generated
+        float NormalVelocityTarget = 0.f; // Relative normal velocity the solver drives toward (bounce or speculative approach)
+        float Friction = 0.f;
+
+        // Accumulated over the solver iterations, warm started from the previous step
+        float NormalImpulse = 0.f;
+        Vector3 TangentImpulse { 0.f, 0.f, 0.f }; // Applied to A, the opposite to B
+    };
+} // namespace PE
@@ -0,0 +1,47 @@
+#pragma once
+#include "raylib.h"
+#include "BodyStorage.hpp"
+#include "Contact.hpp"
+#include <cstdint>
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Accumulated contact impulses kept from one step to the next for warm starting.
+     *
+     * Entries are keyed by the pair of body handles (SPhysicsBody::Id), so they survive changes of the
+     * dense storage order. The entry list is sorted by key and looked up with a binary search; it is
+     * rebuilt from the solved contacts at the end of every step, so pairs that stopped touching drop out.
+     */
+    class CContactCache
+    {
+        public:
+
+        /** Copy cached impulses into matching contacts, contacts without a match start from zero. Returns the number of matches. */
+        int Restore ( const CBodyStorage & Bodies, std::vector<SContact> & Contacts ) const;
+
+        /** Replace the cache with the accumulated impulses of the solved contacts. */
+        void Store ( const CBodyStorage & Bodies, const std::vector<SContact> & Contacts );
+
+        void Clear ();
+
+        int GetNumberOfEntries () const { return static_cast<int> ( m_Entries . size() ); }
+
+        private:
+
+        struct SEntry
+        {
+            uint64_t Key = 0;
+            float NormalImpulse = 0.f;
+            Vector3 TangentImpulse { 0.f, 0.f, 0.f }; // Applied to the body with the lower handle
+        };
+
+        // Handles packed with the lower one in the high bits, IsFlipped tells whether BodyA holds the higher handle
+        static uint64_t MakeKey ( int HandleA, int HandleB, bool & IsFlipped );
+
+        std::vector<SEntry> m_Entries;
+        std::vector<SEntry> m_ScratchEntries;
+    };
+} // namespace PE
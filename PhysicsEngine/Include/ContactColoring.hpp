@@ -0,0 +1,55 @@
+#pragma once
+#include "BodyStorage.hpp"
+#include "Contact.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Colors the contact graph so that no two contacts of one color share a dynamic body.
+     *
+     * Greedy coloring in contact list order: every contact takes the lowest color neither of its dynamic
+     * bodies uses yet. Static bodies are only read by the solver and don't constrain the colors, so a floor
+     * touched by every ball doesn't serialize the pile. Contacts with a static body are colored last, after
+     * every other contact of their dynamic body. The contacts of one color can be solved in any order
+     * or concurrently with the same result, colors are solved one after another.
+     * Contacts of a body that already uses all GMaxColors colors go to one extra color solved sequentially.
+     */
+    class CContactColoring
+    {
+        public:
+
+        static constexpr int GMaxColors = 64;
+
+        /** Color the contacts, returns the number of colors (empty colors in between count too). */
+        int Build ( const CBodyStorage & Bodies, std::span<const SContact> Contacts );
+
+        int GetNumberOfColors () const { return static_cast<int> ( m_ColorStarts . size() ) - 1; }
+
+        /** Whether the contacts of a color may share bodies and have to be solved in order. */
+        bool IsSequential ( int Color ) const { return Color == GMaxColors; }
+
+        /** Indices into the contact list of the contacts in a color, in contact list order. */
+        std::span<const int> GetColorContacts ( int Color ) const
+        {
+            return { m_ColorContacts . data() + m_ColorStarts [ Color ], m_ColorContacts . data() + m_ColorStarts [ Color + 1 ] };
+        }
+
+        /** Where the color's contacts start once the contact list is reordered color by color. */
+        int GetColorStart ( int Color ) const { return m_ColorStarts [ Color ]; }
+
+        /** All contact indices, color by color. */
+        std::span<const int> GetOrderedContacts () const { return m_ColorContacts; }
+
+        private:
+
+        std::vector<uint64_t> m_BodyColors; // Bit c is set when the body has a contact of color c
+        std::vector<int> m_ContactColors;
+        std::vector<int> m_ColorStarts { 0 };
+        std::vector<int> m_ColorContacts;
+        std::vector<int> m_Cursors;
+    };
+} // namespace PE
@@ -0,0 +1,48 @@
+#pragma once
+#include "raylib.h"
+#include "BodyStorage.hpp"
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Stops fast spheres at their first impact of a step, so they can't pass through small spheres or thin boxes.
+     *
+     * Runs after integration on the end-of-step positions: integration moved every awake body by its velocity
+     * times the step, so that is the motion swept. Only awake spheres moving further than a fraction of their
+     * radius are swept, against every body whose swept bounds they reach and against the walls of the world box.
+     * A hit moves the sphere back to the time of impact, touching, and keeps its velocity: the narrowphase finds
+     * the contact and the solver resolves it in the same step. The rest of the sphere's motion is dropped.
+     * One thread, a pass over the awake bodies when nothing is fast, O(N log fast) otherwise.
+     */
+    class CContinuousCollision
+    {
+        public:
+
+        /**
+         * Sweep the fast spheres and clamp them to their first impact.
+         * @param MotionThreshold spheres moving more than this times their radius in the step are swept
+         * @param WorldBox inside of the world walls, nullptr when the world has none
+         * @return number of spheres moved back to an impact
+         */
+        int Apply ( CBodyStorage & Bodies, float DeltaTime, float MotionThreshold, const BoundingBox * WorldBox );
+
+        /** Spheres fast enough to be swept in the last Apply. */
+        int GetNumberOfSweptBodies () const { return static_cast<int> ( m_Sweeps . size() ); }
+
+        private:
+
+        struct SSweep
+        {
+            BoundingBox Bounds; // Both ends of the motion, grown by the radius
+            Vector3 Start;
+            Vector3 Motion;
+            float Radius = 0.f;
+            float TimeOfImpact = 1.f;
+            int Body = -1;
+        };
+
+        std::vector<SSweep> m_Sweeps; // Sorted by Bounds . min . x
+    };
+} // namespace PE
@@ -0,0 +1,235 @@
+#pragma once
+#include "raylib.h"
+#include "Broadphase.hpp"
+#include "Math.hpp"
+#include <cstdint>
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Dynamic bounding volume hierarchy of fattened AABBs.
+     *
+     * Leaves store a fat box (tight box grown by a margin) and a user value. Moving a proxy is free
+     * while its tight box stays inside the fat box; otherwise the leaf is removed and reinserted.
+     * Insertion picks the sibling with the smallest surface area growth and the tree is kept
+     * height-balanced with AVL rotations.
+     */
+    class CDynamicAABBTree
+    {
+        public:
+
+        static constexpr int GNullNode = -1;
+
+        /** Insert a leaf with a fat box built from TightBox and Margin. Returns the proxy id. */
+        int CreateProxy ( const BoundingBox & TightBox, float Margin, int UserData );
+
+        /** Remove a leaf created by CreateProxy. */
+        void DestroyProxy ( int Proxy );
+
+        /**
+         * Refit a leaf to a new tight box.
+         * @return true when the tight box left the fat box and the leaf was reinserted
+         */
+        bool MoveProxy ( int Proxy, const BoundingBox & TightBox, float Margin );
+
+        const BoundingBox & GetFatBox ( int Proxy ) const { return m_Nodes [ Proxy ] . Box; }
+        int GetUserData ( int Proxy ) const { return m_Nodes [ Proxy ] . UserData; }
+        void SetUserData ( int Proxy, int UserData ) { m_Nodes [ Proxy ] . UserData = UserData; }
+
+        /** Call Callback ( UserData ) for every leaf whose fat box overlaps Box. */
+        template <typename TCallback>
+        void Query ( const BoundingBox & Box, TCallback && Callback ) const;
+
+        /**
+         * Call Callback ( UserData ) for every leaf whose fat box the ray touches, see PE::Math::RayBoxInterval.
+         * The callback returns the new length of the ray, leaves beyond it are skipped and a negative one stops.
+         * @return length of the ray at the end, negative when the callback stopped it
+         */
+        template <typename TCallback>
+        float RayCast ( const Vector3 & Origin, const Vector3 & InvDirection, float MaxDistance, TCallback && Callback ) const;
+
+        /** Remove every node. */
+        void Clear ();
+
+        int GetHeight () const { return m_Root == GNullNode ? 0 : m_Nodes [ m_Root ] . Height; }
+        int GetNumberOfProxies () const { return m_NumberOfProxies; }
+
+        /** Check parent links, heights and box containment. Used by tests. */
+        bool Validate () const;
+
+        private:
+
+        // DFS stack depth, AVL balancing keeps the height far below this
+        static constexpr int GMaxQueryStack = 256;
+
+        struct SNode
+        {
+            BoundingBox Box {};
+            int Parent = GNullNode;
+            int Child1 = GNullNode;
+            int Child2 = GNullNode;
+            int Height = 0; // Leaf = 0, free node = -1
+            int UserData = -1;
+
+            bool IsLeaf () const { return Child1 == GNullNode; }
+        };
+
+        int AllocateNode ();
+        void FreeNode ( int Node );
+        void InsertLeaf ( int Leaf );
+        void RemoveLeaf ( int Leaf );
+        int Balance ( int Node );
+        void RefitUpwards ( int Node );
+        bool ValidateNode ( int Node ) const;
+
+        std::vector<SNode> m_Nodes;
+        int m_Root = GNullNode;
+        int m_FreeList = GNullNode;
+        int m_NumberOfProxies = 0;
+    };
+
+    /**
+     * @brief Broadphase built on two dynamic AABB trees.
+     *
+     * Dynamic bodies live in one tree and IsStatic bodies in another. Pairs are found by querying
+     * each awake dynamic leaf against both trees, so static-static and sleeping-sleeping pairs are never visited.
+     */
+    class CAABBTreeBroadphase : public CBroadphase
+    {
+        public:
+
+        // Construct broadphase with the margin used to fatten body bounding boxes.
+        explicit CAABBTreeBroadphase ( float Margin = 0.f );
+
+        /** Refit moved bodies and insert the ones added since the last Update. Rebuilds both trees when bodies went missing without RemoveBody. */
+        void Update ( const CBodyStorage & Bodies ) override;
+
+        /** Append candidate pairs (sorted by BodyA, then BodyB) whose fat boxes overlap. */
+        void FindPairs ( std::vector<SBroadphasePair> & OutPairs ) const override;
+
+        void Clear () override;
+
+        /** Move the proxies to the new body indices, the trees keep their shape. */
+        void RemapBodies ( std::span<const int> NewToOld ) override;
+
+        /** Destroy the body's proxy and hand the last body's proxy its index. */
+        void RemoveBody ( const CBodyStorage & Bodies, int Index ) override;
+
+        /** Query both trees by their fat boxes. */
+        void QueryBox ( const BoundingBox & Box, CBroadphaseBoxCallback & Callback ) const override;
+        void QueryRay ( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, CBroadphaseRayCallback & Callback ) const override;
+
+        const CDynamicAABBTree & GetDynamicTree () const { return m_DynamicTree; }
+        const CDynamicAABBTree & GetStaticTree () const { return m_StaticTree; }
+
+        /** Number of leaves reinserted by the last Update. */
+        int GetNumberOfReinsertedProxies () const { return m_NumberOfReinsertedProxies; }
+
+        private:
+
+        /** Insert body Body into its tree (none for world walls) and record its state at Index. */
+        void CreateBodyProxy ( const CBodyStorage & Bodies, int Body, int Index );
+
+        CDynamicAABBTree m_DynamicTree;
+        CDynamicAABBTree m_StaticTree;
+        std::vector<int> m_Proxies;
+        std::vector<uint8_t> m_IsStatic;
+        std::vector<uint8_t> m_IsSleeping;
+        float m_Margin = 0.f;
+        int m_NumberOfReinsertedProxies = 0;
+    };
+
+    template <typename TCallback>
+    void CDynamicAABBTree::Query( const BoundingBox & Box, TCallback && Callback ) const
+    {
+        if ( m_Root == GNullNode )
+        {
+            return;
+        }
+        int Stack [ GMaxQueryStack ];
+        int StackSize = 0;
+        Stack [ StackSize++ ] = m_Root;
+        while ( StackSize > 0 )
+        {
+            const SNode & Node = m_Nodes [ Stack [ --StackSize ] ];
+            const bool Overlaps = Node . Box . min . x <= Box . max . x && Node . Box . max . x >= Box . min . x &&
+                                  Node . Box . min . y <= Box . max . y && Node . Box . max . y >= Box . min . y &&
+                                  Node . Box . min . z <= Box . max . z && Node . Box . max . z >= Box . min . z;
+            if ( ! Overlaps )
+            {
+                continue;
+            }
+            if ( Node . IsLeaf () )
+            {
+                Callback ( Node . UserData );
+            }
+            else
+            {
+                Stack [ StackSize++ ] = Node . Child1;
+                Stack [ StackSize++ ] = Node . Child2;
+            }
+        }
+    }
+
+    template <typename TCallback>
+    float CDynamicAABBTree::RayCast( const Vector3 & Origin, const Vector3 & InvDirection, float MaxDistance, TCallback && Callback ) const
+    {
+        // Nearer child popped first, so hits found early shorten the ray for the far subtrees
+        struct SEntry
+        {
+            int Node;
+            float Enter;
+        };
+        SEntry Stack [ GMaxQueryStack ];
+        int StackSize = 0;
+        float Enter = 0.f;
+        float Exit = 0.f;
+        if ( m_Root == GNullNode || ! PE::Math::RayBoxInterval ( Origin, InvDirection, m_Nodes [ m_Root ] . Box, MaxDistance, Enter, Exit ) )
+        {
+            return MaxDistance;
+        }
+        Stack [ StackSize++ ] = { m_Root, Enter };
+        while ( StackSize > 0 )
+        {
+            const SEntry Entry = Stack [ --StackSize ];
+            // The ray may have been shortened since the node was pushed
+            if ( Entry . Enter > MaxDistance )
+            {
+                continue;
+            }
+            const SNode & Node = m_Nodes [ Entry . Node ];
+            if ( Node . IsLeaf () )
+            {
+                MaxDistance = Callback ( Node . UserData );
+                if ( MaxDistance < 0.f )
+                {
+                    return MaxDistance;
+                }
+                continue;
+            }
+            float Enter1 = 0.f;
+            float Enter2 = 0.f;
+            const bool Hits1 = PE::Math::RayBoxInterval ( Origin, InvDirection, m_Nodes [ Node . Child1 ] . Box, MaxDistance, Enter1, Exit );
+            const bool Hits2 = PE::Math::RayBoxInterval ( Origin, InvDirection, m_Nodes [ Node . Child2 ] . Box, MaxDistance, Enter2, Exit );
+            if ( Hits1 && Hits2 && Enter1 < Enter2 )
+            {
+                Stack [ StackSize++ ] = { Node . Child2, Enter2 };
+                Stack [ StackSize++ ] = { Node . Child1, Enter1 };
+            }
+            else
+            {
+                if ( Hits1 )
+                {
+                    Stack [ StackSize++ ] = { Node . Child1, Enter1 };
+                }
+                if ( Hits2 )
+                {
+                    Stack [ StackSize++ ] = { Node . Child2, Enter2 };
+                }
+            }
+        }
+        return MaxDistance;
+    }
+} // namespace PE
@@ -0,0 +1,50 @@
+#pragma once
+#include "raylib.h"
+#include "BodyStorage.hpp"
+#include "Parameters.hpp"
+#include <span>
+#include <vector>
+
+
+namespace PE
+{
+namespace Integration
+{
+    /**
+     * @brief Integrate velocities, positions and rotations of all awake dynamic bodies over one step.
+     *
+     * Applies gravity and exponential linear/angular damping, then advances position and rotation.
+     * Bodies are processed 8 (AVX2) or 4 (SSE2) at a time, the remainder with the scalar path.
+     * @param Bodies storage to integrate in place
+     * @param DeltaTime step length
+     * @param Gravity gravity acceleration
+     * @param SimdLevel highest instruction set allowed, clamped to what the CPU supports
+     */
+    void Integrate ( CBodyStorage & Bodies, float DeltaTime, const Vector3 & Gravity, ESimdLevel SimdLevel );
+
+    /**
+     * @brief Fill the per-material damping factors of one step, exp ( -Damping * DeltaTime ) for every material.
+     *
+     * The vectors are resized to the number of materials and keep their capacity, reused every step they don't allocate.
+     */
+    void ComputeDampingFactors ( const CBodyStorage & Bodies, float DeltaTime,
+                                 std::vector<float> & OutLinearDampingFactors, std::vector<float> & OutAngularDampingFactors );
+
+    /**
+     * @brief Integrate the bodies in [Begin, End) only, ranges that don't overlap can run concurrently.
+     *
+     * Begin should be a multiple of 8 so the range splits into the same SIMD groups as the whole storage.
+     * The damping factors come from ComputeDampingFactors for the same DeltaTime, shared by all ranges of the step.
+     */
+    void Integrate ( CBodyStorage & Bodies, int Begin, int End, float DeltaTime, const Vector3 & Gravity,
+                     std::span<const float> LinearDampingFactors, std::span<const float> AngularDampingFactors, ESimdLevel SimdLevel );
+
+    /**
+     * @brief Scalar integration of a single body, the reference for the vectorized kernels.
+     * @param LinearDampingFactor exp ( -LinearDamping * DeltaTime ) of the body's material
+     * @param AngularDampingFactor exp ( -AngularDamping * DeltaTime ) of the body's material
+     */
+    void IntegrateBody ( CBodyStorage & Bodies, int Index, float DeltaTime, const Vector3 & DeltaGravity,
+                         float LinearDampingFactor, float AngularDampingFactor );
+} // namespace Integration
+} // namespace PE
@@ -0,0 +1,64 @@
+#pragma once
+#include "BodyStorage.hpp"
+#include "Contact.hpp"
+#include <span>
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Splits awake dynamic bodies into islands connected by contacts.
+     *
+     * Built every step with a union-find over the contact list. Static bodies never join an island,
+     * so balls resting on the same floor stay in separate islands. Islands are numbered in the order of
+     * their lowest body index and list their bodies in ascending index order, so the result only depends
+     * on the bodies and contacts, not on how it is consumed.
+     * Every contact with an awake body belongs to that body's island. No two islands share a dynamic
+     * body, so islands can be solved concurrently.
+     */
+    class CIslandBuilder
+    {
+        public:
+
+        /** Rebuild islands from the awake bodies and the contacts of this step, returns the number of islands. */
+        int Build ( const CBodyStorage & Bodies, const std::vector<SContact> & Contacts );
+
+        int GetNumberOfIslands () const { return static_cast<int> ( m_IslandStarts . size() ) - 1; }
+
+        /** Island of the body at a dense index, -1 for static and sleeping bodies. */
+        int GetIsland ( int Index ) const { return m_BodyIslands [ Index ]; }
+
+        /** Dense indices of the bodies in an island, ascending. */
+        std::span<const int> GetIslandBodies ( int Island ) const
+        {
+            return { m_IslandBodies . data() + m_IslandStarts [ Island ], m_IslandBodies . data() + m_IslandStarts [ Island + 1 ] };
+        }
+
+        /** Indices into the contact list of the contacts in an island, in contact list order. */
+        std::span<const int> GetIslandContacts ( int Island ) const
+        {
+            return { m_IslandContacts . data() + m_IslandContactStarts [ Island ], m_IslandContacts . data() + m_IslandContactStarts [ Island + 1 ] };
+        }
+
+        /** All contact indices, island by island. */
+        std::span<const int> GetOrderedContacts () const { return m_IslandContacts; }
+
+        /** Where the island's contacts start once the contact list is reordered island by island. */
+        int GetIslandContactStart ( int Island ) const { return m_IslandContactStarts [ Island ]; }
+
+        private:
+
+        int Find ( int Index );
+        void Union ( int IndexA, int IndexB );
+        int ContactIsland ( const SContact & Contact ) const;
+
+        std::vector<int> m_Parents;
+        std::vector<int> m_BodyIslands;
+        std::vector<int> m_IslandStarts { 0 };
+        std::vector<int> m_IslandBodies;
+        std::vector<int> m_IslandContactStarts { 0 };
+        std::vector<int> m_IslandContacts;
+        std::vector<int> m_Cursors;
+    };
+} // namespace PE
@@ -0,0 +1,158 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Timing of one job of the last CJobGraph run.
+     *
+     * Times are in milliseconds since the run started. ThreadBusyMs has one entry per thread of the job
+     * system (0 is the thread that called Run), uneven entries show load imbalance.
+     */
+    struct SJobStats
+    {
+        std::string Name;
+        double StartMs = 0.0; // Prerequisites done, tasks queued
+        double EndMs = 0.0; // Last task finished
+        int Count = 0; // Indices the job ran
+        std::vector<double> ThreadBusyMs; // Includes tasks run while a task of this job waited for a nested ParallelFor
+    };
+
+    /**
+     * @brief Jobs and their dependencies, run by CJobSystem::Run.
+     *
+     * A job is a parallel for: Function ( i ) runs for every i in [0, Count) on any thread, in any order.
+     * A job starts once all its prerequisites finished. When the count is only known then (e.g. the number
+     * of pairs found by the previous job), Setup runs first on a single thread and returns it, so setup work
+     * that must not run concurrently can live there too.
+     */
+    class CJobGraph
+    {
+        public:
+
+        /** Add a job with a fixed task count, returns its id. */
+        int AddJob ( std::string Name, int Count, std::function<void ( int )> Function );
+
+        /** Add a job whose task count is returned by Setup once its prerequisites finished, returns its id. */
+        int AddJob ( std::string Name, std::function<int ()> Setup, std::function<void ( int )> Function );
+
+        /** Job doesn't start before Prerequisite finished. */
+        void AddDependency ( int Job, int Prerequisite );
+
+        void Clear ();
+
+        int GetNumberOfJobs () const { return static_cast<int> ( m_Jobs . size() ); }
+
+        /** Timing of the last run, indexed by job id. */
+        std::span<const SJobStats> GetStats () const { return m_Stats; }
+
+        private:
+
+        friend class CJobSystem;
+
+        struct SJob
+        {
+            std::string Name;
+            int Count = 0;
+            std::function<int ()> Setup;
+            std::function<void ( int )> Function;
+            std::vector<int> Dependents;
+            int NumberOfPrerequisites = 0;
+        };
+
+        std::vector<SJob> m_Jobs;
+        std::vector<SJobStats> m_Stats;
+    };
+
+    /**
+     * @brief Work-stealing task scheduler with one deque per thread.
+     *
+     * Jobs are split into index ranges pushed to the deque of the thread that started them. Every thread
+     * pops its own deque from the back (newest, cache-warm work first) and steals from the front of the
+     * others when it runs dry. Threads that wait for a job (Run, ParallelFor, also from inside a task)
+     * keep executing tasks meanwhile, so nested ParallelFor calls never block a worker.
+     * One external thread drives the system at a time and counts as thread 0.
+     * Which thread runs which index varies between runs, submit work whose result doesn't depend on it.
+     */
+    class CJobSystem
+    {
+        public:
+
+        /** NumberOfThreads counts the calling thread, 1 runs everything inline, 0 uses every hardware thread. */
+        explicit CJobSystem ( int NumberOfThreads );
+        ~CJobSystem ();
+
+        CJobSystem ( const CJobSystem & ) = delete;
+        CJobSystem & operator = ( const CJobSystem & ) = delete;
+
+        int GetNumberOfThreads () const { return static_cast<int> ( m_Queues . size() ); }
+
+        /** Thread count a job system constructed with NumberOfThreads ends up with. */
+        static int ResolveNumberOfThreads ( int NumberOfThreads );
+
+        /** Run every job of the graph respecting the dependencies, wait for all of them and record their timing. */
+        void Run ( CJobGraph & Graph );
+
+        /** Run Function ( i ) for every i in [0, Count) and wait, may be called from inside a task. */
+        void ParallelFor ( int Count, const std::function<void ( int )> & Function );
+
+        private:
+
+        struct SRun;
+
+        // State of one job while it runs
+        struct SJobRun
+        {
+            const std::function<void ( int )> * Function = nullptr;
+            std::atomic<int> RemainingIndices { 0 };
+            std::atomic<int> RemainingPrerequisites { 0 };
+            std::atomic<int> * Completion = nullptr; // Decremented as the very last access to the job
+            SRun * Run = nullptr; // Graph run the job belongs to, nullptr for ParallelFor
+            int JobIndex = 0;
+            int64_t StartNs = 0;
+            int64_t EndNs = 0;
+            int Count = 0;
+            std::vector<int64_t> ThreadBusyNs; // Empty for ParallelFor
+        };
+
+        struct STask
+        {
+            SJobRun * Job = nullptr;
+            int Begin = 0;
+            int End = 0;
+        };
+
+        struct SQueue
+        {
+            std::mutex Mutex;
+            std::deque<STask> Tasks;
+        };
+
+        void WorkerLoop ( int ThreadIndex );
+        int GetThreadIndex () const;
+        void LaunchJob ( int ThreadIndex, SJobRun & Job, int Count );
+        void StartGraphJob ( int ThreadIndex, SRun & Run, int JobIndex );
+        void FinishJob ( int ThreadIndex, SJobRun & Job );
+        bool TryRunTask ( int ThreadIndex );
+        void WaitFor ( int ThreadIndex, const std::atomic<int> & Counter ); // Runs tasks until Counter is 0
+        static int64_t NowNs ();
+
+        std::vector<std::unique_ptr<SQueue>> m_Queues; // One per thread, 0 belongs to the external thread
+        std::vector<std::thread> m_Workers;
+        std::atomic<int> m_NumberOfQueuedTasks { 0 };
+        std::mutex m_SleepMutex;
+        std::condition_variable m_SleepCondition;
+        bool m_IsStopping = false;
+    };
+} // namespace PE
@@ -1,3 +1,4 @@
+#pragma once
 #include "raylib.h"
 
 namespace PE
@@ -36,6 +37,34 @@ namespace Math
      */
     Vector3 BoxSize ( const BoundingBox & Box );
 
+    /**
+     * @brief Test whether two axis-aligned bounding boxes overlap (touching counts as overlap).
+     * @param BoxA first bounding box
+     * @param BoxB second bounding box
+     * @return true when the boxes intersect
+     */
+    bool BoxesOverlap ( const BoundingBox & BoxA, const BoundingBox & BoxB );
+
+    /**
+     * @brief Grow a bounding box by a margin on every side.
+     * @param Box axis-aligned bounding box
+     * @param Margin distance added to each face
+     * @return expanded bounding box
+     */
+    BoundingBox ExpandBox ( const BoundingBox & Box, float Margin );
+
+    /**
+     * @brief Distances along a ray where it enters and leaves a bounding box (slab test).
+     * @param Origin start of the ray
+     * @param InvDirection component-wise inverse of the ray direction, infinite for components that are zero
+     * @param Box axis-aligned bounding box
+     * @param MaxDistance the ray ends there, in multiples of the direction
+     * @param OutEnter distance where the ray enters the box, 0 when it starts inside
+     * @param OutExit distance where it leaves the box, at most MaxDistance
+     * @return true when the ray meets the box between 0 and MaxDistance
+     */
+    bool RayBoxInterval ( const Vector3 & Origin, const Vector3 & InvDirection, const BoundingBox & Box, float MaxDistance, float & OutEnter, float & OutExit );
+
     /**
      * @brief Linearly interpolate between two colors.
      * @param C1 start color
@@ -0,0 +1,50 @@
+#pragma once
+#include "raylib.h"
+#include "BodyStorage.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Orders bodies along a 3D Morton (Z-order) curve so neighbours in space are neighbours in memory.
+     *
+     * Positions are quantized to GBitsPerAxis bits per axis inside the bounds of all bodies and their bits
+     * interleaved into one code. Sorting by the code keeps bodies of one region in a short index range, so
+     * the broadphase, narrowphase and solver read the body streams mostly sequentially.
+     */
+    class CMortonOrder
+    {
+        public:
+
+        static constexpr int GBitsPerAxis = 10;
+        // Radix sort digit, three passes cover the 30 bit code
+        static constexpr int GRadixBits = 10;
+
+        /**
+         * Code the current body positions.
+         * @return fraction of neighbouring body pairs (i, i + 1) whose codes are descending: 0 when sorted, about 0.5 for a random order
+         */
+        float Measure ( const CBodyStorage & Bodies );
+
+        /** Stable radix sort of the measured codes, returns the current dense index of every body in Morton order. */
+        std::span<const int> Sort ();
+
+        /** Codes of the last Measure, indexed by dense body index. */
+        std::span<const uint32_t> GetCodes () const { return m_Codes; }
+
+        /** Interleave the lowest GBitsPerAxis bits of the three cell coordinates, x in the lowest bit. */
+        static uint32_t Encode ( uint32_t X, uint32_t Y, uint32_t Z );
+
+        private:
+
+        std::vector<uint32_t> m_Codes;
+        std::vector<uint32_t> m_SortedCodes;
+        std::vector<uint32_t> m_ScratchCodes;
+        std::vector<int> m_Order;
+        std::vector<int> m_ScratchOrder;
+        std::vector<int> m_DigitStarts;
+    };
+} // namespace PE
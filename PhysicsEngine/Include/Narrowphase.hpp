@@ -0,0 +1,87 @@
+#pragma once
+#include "Broadphase.hpp"
+#include "BodyStorage.hpp"
+#include "Collision.hpp"
+#include "Contact.hpp"
+#include "Parameters.hpp"
+#include "raylib.h"
+#include <array>
+#include <span>
+#include <vector>
+
+
+namespace PE
+{
+namespace Collision
+{
+    /**
+     * @brief Test many sphere-sphere candidate pairs at once and write only the hits.
+     *
+     * Pairs are tested 8 (AVX2) or 4 (SSE2) at a time; a group with no hit costs one compare and a
+     * lane mask. The produced contacts match TestSphereSphere exactly and keep the pair order.
+     * @param Bodies body storage the pair indices refer to (every pair must be sphere-sphere)
+     * @param Pairs candidate pairs
+     * @param NumberOfPairs number of candidate pairs
+     * @param OutContacts buffer with room for at least NumberOfPairs contacts
+     * @param SimdLevel highest instruction set allowed, clamped to what the CPU supports
+     * @param Margin pairs separated by up to Margin produce a contact too, with a negative penetration
+     * @return number of contacts written
+     */
+    int TestSphereSpherePairs ( const CBodyStorage & Bodies, const SBroadphasePair * Pairs, int NumberOfPairs,
+                                SContact * OutContacts, ESimdLevel SimdLevel, float Margin = 0.f );
+
+    /**
+     * @brief Test the awake dynamic spheres in [Begin, End) against the walls of an axis-aligned box they live in.
+     *
+     * One pass compares 8 (AVX2) or 4 (SSE2) spheres at a time with the distance to their nearest wall; only
+     * the few that reach a wall get contacts, one per touched wall. The walls are half-spaces: the normal
+     * always points into the box, so a sphere that tunneled out is pushed back in. Contacts have the sphere
+     * as BodyA and the wall body as BodyB.
+     * @param Walls dense indices of the static wall bodies, in the order -X, +X, -Y, +Y, -Z, +Z; -1 for a missing wall, which gets no contacts
+     * @param OutContacts replaced with the contacts, sorted by BodyA, then BodyB
+     * @param Margin spheres up to Margin away from a wall get a contact too, with a negative penetration
+     * @return number of contacts written
+     */
+    int TestSpheresInsideBox ( const CBodyStorage & Bodies, int Begin, int End, const BoundingBox & Box, const std::array<int, 6> & Walls,
+                               std::vector<SContact> & OutContacts, ESimdLevel SimdLevel, float Margin = 0.f );
+} // namespace Collision
+
+    /**
+     * @brief Turns broadphase pairs into a compact contact list.
+     *
+     * Pairs are grouped by pair type, put in canonical order (Collision::IsCanonicalPair) and every group
+     * runs through the kernel of its pair type: sphere-sphere through the batched TestSphereSpherePairs, the
+     * others through their Collision::SPairTest in a loop of their own. A contact keeps the canonical order,
+     * so a sphere touching a box is BodyA whatever their indices. Keeps scratch buffers between calls so
+     * steady-state steps don't allocate.
+     */
+    class CNarrowphase
+    {
+        public:
+
+        explicit CNarrowphase ( ESimdLevel SimdLevel = ESimdLevel::AVX2 ) : m_SimdLevel ( SimdLevel ) {}
+
+        void SetSimdLevel ( ESimdLevel SimdLevel ) { m_SimdLevel = SimdLevel; }
+
+        /** Pairs closer than Margin get a speculative contact with a negative penetration. */
+        void SetContactMargin ( float Margin ) { m_ContactMargin = Margin; }
+
+        /**
+         * Replace OutContacts with the contacts of all touching (or closer than the contact margin) pairs, in the
+         * order of their pairs: sorted by the lower body index, then the higher one.
+         */
+        void GenerateContacts ( const CBodyStorage & Bodies, std::span<const SBroadphasePair> Pairs, std::vector<SContact> & OutContacts );
+        void GenerateContacts ( const CBodyStorage & Bodies, const std::vector<SBroadphasePair> & Pairs, std::vector<SContact> & OutContacts )
+        {
+            GenerateContacts ( Bodies, std::span<const SBroadphasePair> ( Pairs ), OutContacts );
+        }
+
+        private:
+
+        ESimdLevel m_SimdLevel = ESimdLevel::AVX2;
+        float m_ContactMargin = 0.f;
+        std::array<std::vector<SBroadphasePair>, Collision::GNumberOfPairTypes> m_TypePairs; // Canonical pairs of every pair type
+        std::array<std::vector<SContact>, Collision::GNumberOfPairTypes> m_TypeContacts; // Sized to the largest group so far, the kernel's count is valid
+        std::vector<SContact> m_MergedContacts;
+    };
+} // namespace PE
@@ -5,6 +5,44 @@
 
 namespace PE 
 {
+/**
+ * @brief Acceleration structure used to find candidate collision pairs.
+ */
+    enum class EBroadphaseType : short
+    {
+        SpatialHashGrid, // Uniform grid, best when bodies have similar sizes
+        DynamicAABBTree, // Fattened AABB trees (dynamic + static), handles mixed sizes and large static bodies
+    };
+
+/**
+ * @brief Order in which the contact solver visits contacts.
+ */
+    enum class ESolverType : short
+    {
+        Sequential,   // Island by island, contacts in generation order, islands spread over the threads
+        GraphColored, // Color by color, contacts of one color share no dynamic body and are spread over the threads
+    };
+
+/**
+ * @brief Instruction set used by the vectorized kernels, ordered from lowest to highest.
+ */
+    enum class ESimdLevel : short
+    {
+        Scalar, // raymath, one body at a time
+        SSE2,   // 4 bodies per instruction
+        AVX2,   // 8 bodies per instruction
+    };
+
+/**
+ * @brief Where spawned balls are placed inside the spawn box (SBallGenerationParameters::MinLocation - MaxLocation).
+ */
+    enum class ESpawnPattern : short
+    {
+        RandomBox, // Uniformly random centers, balls may overlap
+        Lattice,   // Cubic grid with a gap of half a radius, layers fill the box from the bottom up
+        Pile,      // Balls at rest packed for MaxRadius, every layer sits in the pockets of the one below
+    };
+
 /**
  * @brief Window configuration parameters.
  */
@@ -42,6 +80,7 @@ struct SWindowParameters
         float MinRadius = 0.5f; 
         float MaxRadius = 1.f; 
         float MassToRadius = 10.f; // Mass = Radius * MassToRadius 
+        ESpawnPattern Pattern = ESpawnPattern::RandomBox; // Grid patterns are spaced for MaxRadius and go on above MaxLocation . y when the box is full
     };
     
 /**
@@ -50,10 +89,29 @@ struct SWindowParameters
     struct SSimulationParameters 
     {
         int SimulationFrequency = 120; 
-        int NumberOfSteps = 8;
+        int MaxStepsPerUpdate = 8; // Fixed steps one Update may run, time left over is dropped (the simulation slows down), 0 = no cap
+        float UpdateBudgetMs = 12.f; // Wall time one Update may spend stepping, another step only starts when its predicted time still fits, 0 = no budget
+        int NumberOfSteps = 2; // Solver iterations per step, warm starting keeps 1-2 stable
         int NumberOfBalls = 30;
         int RandomSeed = 1337;
         float Slop = 0.0005f;
+        float MaxPositionCorrection = 0.2f; // Largest penetration one contact resolves per step
+        float RestitutionVelocityThreshold = 0.5f; // Slower impacts don't bounce, so resting contacts stay at rest
+        bool WarmStarting = true; // Start the solver from the impulses of the previous step
+        int NumberOfThreads = 1; // Job system threads running the step, the calling one included, 0 uses every hardware thread
+        ESolverType SolverType = ESolverType::Sequential; // GraphColored also parallelizes a single large island
+        bool AllowSleeping = true;
+        float SleepLinearVelocity = 0.05f; // A whole island slower than both thresholds for TimeToSleep seconds falls asleep
+        float SleepAngularVelocity = 0.1f;
+        float TimeToSleep = 0.5f;
+        float BroadphaseMargin = 0.05f; // Added to every body bounding box so solver corrections don't miss new contacts
+        float ContactMargin = 0.02f; // Pairs closer than this get a speculative contact, keep it below BroadphaseMargin
+        bool ContinuousCollision = true; // Sweep fast spheres and stop them at their first impact, so they can't tunnel at low frequencies
+        float ContinuousCollisionThreshold = 0.25f; // Spheres moving more than this times their radius in a step are swept
+        EBroadphaseType BroadphaseType = EBroadphaseType::SpatialHashGrid;
+        int BodyOrderCheckInterval = 60; // Steps between checks of the body order along the Morton curve, 0 never reorders
+        float BodyOrderDisorderThreshold = 0.1f; // Bodies are re-sorted when more neighbours than this are out of order, 0 sorts on every check
+        ESimdLevel SimdLevel = ESimdLevel::AVX2; // Highest level allowed, clamped to what the CPU supports at runtime
         float Gravity = 9.81f;
         float BallsRestitution = 0.3f;
         float BallFriction = 0.2f;
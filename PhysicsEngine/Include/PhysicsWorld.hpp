@@ -0,0 +1,235 @@
+#pragma once
+#include "raylib.h"
+#include "Parameters.hpp"
+#include "PhysicsBody.hpp"
+#include "BodyStorage.hpp"
+#include "Broadphase.hpp"
+#include "Narrowphase.hpp"
+#include "Contact.hpp"
+#include "ContactCache.hpp"
+#include "ContactColoring.hpp"
+#include "ContinuousCollision.hpp"
+#include "Island.hpp"
+#include "JobSystem.hpp"
+#include "MortonOrder.hpp"
+#include "Profiling.hpp"
+#include "SceneQuery.hpp"
+#include "TraceRecorder.hpp"
+#include <vector>
+#include <array>
+#include <memory>
+
+
+namespace PE
+{
+    /**
+     * @brief Headless physics simulation: bodies, integration, collision detection and the solver.
+     *
+     * Uses raylib only for its math types, never for windowing, input or timing, so it runs on
+     * machines without a display and can be driven by tests, benchmarks or a viewer.
+     */
+    class CPhysicsWorld
+    {
+        public:
+
+        // Islands and colors are handed to the solver threads in batches of about this many contacts
+        static constexpr int GContactsPerBatch = 64;
+        // Bodies integrated or tested against the world box per task, a multiple of the SIMD width
+        static constexpr int GBodiesPerTask = 1024;
+        // Broadphase pairs tested per narrowphase task
+        static constexpr int GPairsPerNarrowphaseTask = 1024;
+
+        // Construct world with given simulation parameters. The world starts empty.
+        explicit CPhysicsWorld ( const SSimulationParameters & SimulationParameters = {} );
+
+        /** Set simulation parameters (gravity, damping, world bounds, etc.). Bodies are kept. */
+        void SetSimulationParameters ( const SSimulationParameters & SimulationParameters );
+        const SSimulationParameters & GetSimulationParameters () const { return m_SimulationParameters; }
+
+        /**
+         * Add a body, returns its stable handle. O(1), allocation free once the storage grew to the peak body count.
+         * Returns -1 when the storage has no handle left (CBodyStorage::GMaxHandleSlots).
+         */
+        int AddBody ( const SPhysicsBody & Body );
+
+        /**
+         * Remove a body between steps, allocation free. O(1), plus the size of its island when it was sleeping: the
+         * island wakes. The last body takes its dense index, handles of all other bodies stay valid and the removed
+         * handle stops resolving. A removed world wall stops colliding, the other walls keep working.
+         * @return false when the handle doesn't resolve
+         */
+        bool RemoveBody ( int Handle );
+
+        /**
+         * Append generated balls in parallel, O(NumberOfBalls / threads), between steps.
+         * Balls come from a counter-based generator keyed by RandomSeed and numbered since the last SetSimulationParameters:
+         * the result depends neither on the number of threads nor on how the balls are split into spawn calls.
+         * @return dense index of the first ball, the rest follow it; -1 and nothing spawned when the storage has too few handles left
+         */
+        int SpawnBalls ( int NumberOfBalls, const SBallGenerationParameters & BallGenerationParameters );
+
+        /** Remove all bodies and reset the time accumulator. */
+        void Clear ();
+
+        /**
+         * Clear and regenerate random balls and the six world walls from the simulation parameters.
+         * The walls are static bodies flagged WorldBoundary: the boundary stage collides them with the spheres analytically.
+         */
+        void Restart ();
+
+        /**
+         * Advance by DeltaTime of real time, running as many fixed steps as fit into the accumulated time.
+         * At most MaxStepsPerUpdate steps run, and a step after the first only starts when the measured step time says
+         * it ends within UpdateBudgetMs. Whole steps that didn't run are dropped rather than carried into the next
+         * frame, so a world too slow for real time runs in slow motion instead of spiralling into ever longer frames.
+         * @return number of fixed steps run
+         */
+        int Update ( float DeltaTime );
+
+        /**
+         * Run one fixed step as a job graph on the job system: integration, broadphase update, pair finding,
+         * narrowphase, solver, then putting resting islands to sleep.
+         */
+        void Step ( float DeltaTime );
+
+        /** Wake a body and every body that fell asleep in the same island, O(island size). */
+        void WakeBody ( int Handle );
+
+        /**
+         * Ray casts and overlap queries against the bodies as they are now, valid until the world changes.
+         * Updates the broadphase first when bodies were added, removed, written or stepped since it last ran (a step moves
+         * them after its own broadphase update), so one query view per frame serves any number of queries cheaply.
+         */
+        CSceneQuery GetSceneQuery ();
+
+        /** Sort the bodies along the Morton curve now. Handles stay valid, dense indices change. */
+        void SortBodies ();
+
+        const CBodyStorage & GetBodies () const { return m_Bodies; }
+        /** Bodies written through this are seen by the next scene query (see GetSceneQuery). */
+        CBodyStorage & GetBodies () { m_IsBroadphaseCurrent = false; return m_Bodies; }
+        const BoundingBox & GetWorldBox () const { return m_WorldBox; }
+        float GetFixedDeltaTime () const { return m_FixedDeltaTime; }
+        /** Real time passed to Update that is not simulated yet, below one fixed step. */
+        float GetTimeAccumulator () const { return m_TimeAccumulator; }
+        /** Dynamic spheres in the world, spawned or added. */
+        int GetNumberOfBalls () const { return m_NumberOfBalls; }
+        int GetNumberOfPairTests () const { return m_NumberOfPairTests; }
+        int GetNumberOfContacts () const { return m_NumberOfContacts; }
+        /** Contacts generated in the last step, with their cached solver terms. */
+        const std::vector<SContact> & GetContacts () const { return m_Contacts; }
+        /** Contacts of the last step that started from cached impulses. */
+        int GetNumberOfWarmStartedContacts () const { return m_NumberOfWarmStartedContacts; }
+        /** Dynamic bodies that were awake at the end of the last step. */
+        int GetNumberOfAwakeBodies () const { return m_NumberOfAwakeBodies; }
+        /** Islands solved in the last step. */
+        int GetNumberOfIslands () const { return m_Islands . GetNumberOfIslands (); }
+        /** Contact colors of the last step, 0 unless SolverType is GraphColored. */
+        int GetNumberOfColors () const { return m_NumberOfColors; }
+        int GetNumberOfThreads () const { return m_JobSystem -> GetNumberOfThreads (); }
+        /** The job system running the step, host applications may run their own graphs on it between steps. */
+        CJobSystem & GetJobSystem () { return *m_JobSystem; }
+        /** Fraction of neighbouring bodies out of Morton order at the last check (see SSimulationParameters::BodyOrderCheckInterval). */
+        float GetBodyDisorder () const { return m_BodyDisorder; }
+        /** Times the bodies were sorted since the last Clear. */
+        int GetNumberOfBodySorts () const { return m_NumberOfBodySorts; }
+        /** Update calls that hit MaxStepsPerUpdate or UpdateBudgetMs and dropped steps, since the last Clear. */
+        int GetNumberOfOverruns () const { return m_NumberOfOverruns; }
+        /** Fixed steps dropped by those overruns, the simulation ran this much behind real time. */
+        int GetNumberOfDroppedSteps () const { return m_NumberOfDroppedSteps; }
+        /** Fast spheres moved back to their first impact in the last step (see SSimulationParameters::ContinuousCollision). */
+        int GetNumberOfClampedBodies () const { return m_NumberOfClampedBodies; }
+        /** Timing of every job of the last step. */
+        std::span<const SJobStats> GetStepJobStats () const { return m_StepGraph . GetStats (); }
+        /** Rolling per-frame phase times and counters, all zero when profiling is compiled out (PE_ENABLE_PROFILING). */
+        SPhysicsStats GetStats () const;
+
+        protected:
+
+        void IntegrateForces ( float DeltaTime );
+        /** Stop the spheres that moved fast in this step's integration at their first impact, when enabled. */
+        void SweepFastBodies ( float DeltaTime );
+        /** Generate contacts once, group them by island (or color), then run the iterative solver on the groups in parallel. */
+        void ResolveCollisions ( float DeltaTime );
+        /**
+         * Resolve the wall handles to dense indices, -1 for a removed wall, and the box the remaining walls bound: the
+         * side of a removed wall is pushed out of reach. false when the world has no wall left (bodies added by hand).
+         */
+        bool GetBoundary ( std::array<int, 6> & OutWalls, BoundingBox & OutBox ) const;
+        /** Dynamic spheres count as balls, whether spawned or added. */
+        bool IsBall ( int Index ) const;
+        /** Wake touched islands, group the generated contacts and solve them. */
+        void SolveContacts ( float DeltaTime );
+        /** Every BodyOrderCheckInterval steps measure the body order and sort the bodies when it got too scattered. */
+        void UpdateBodyOrder ();
+        /** Rebuild m_StepGraph for one step of DeltaTime. */
+        void BuildStepGraph ( float DeltaTime );
+        /** Prepare, warm start and solve the contacts of one island. */
+        void SolveIsland ( int Island, float DeltaTime );
+        /** Solve every island in parallel, each one sequentially. */
+        void SolveIslands ( float DeltaTime );
+        /** Solve all contacts color by color, each color in parallel. */
+        void SolveColors ( float DeltaTime );
+        /** Reorder m_Contacts to the given contact indices. */
+        void ReorderContacts ( std::span<const int> Order );
+        /** Advance sleep timers and put islands that rested long enough to sleep. */
+        void UpdateSleeping ( float DeltaTime );
+        /** Wake sleeping islands touched by an awake body in this step's contacts, walking only their bodies. */
+        void WakeTouchedIslands ();
+
+        CBodyStorage m_Bodies;
+        std::unique_ptr<CBroadphase> m_Broadphase;
+        std::vector<SBroadphasePair> m_BroadphasePairs;
+        CNarrowphase m_Narrowphase;
+        std::vector<SContact> m_Contacts;
+        CContactCache m_ContactCache;
+        CIslandBuilder m_Islands;
+        CContactColoring m_Coloring;
+        CContinuousCollision m_ContinuousCollision;
+        std::vector<SContact> m_ReorderedContacts; // Scratch for reordering m_Contacts by island or color
+        std::vector<int> m_SolverIslands; // Islands with contacts, in island order
+        std::vector<int> m_IslandBatchStarts; // Ranges of m_SolverIslands handed to one thread at a time
+        std::unique_ptr<CJobSystem> m_JobSystem;
+        CJobGraph m_StepGraph;
+        std::vector<EProfilePhase> m_StepJobPhases; // Phase every job of m_StepGraph is counted in
+        std::vector<CNarrowphase> m_NarrowphaseTasks; // One per narrowphase task, each with its own scratch
+        std::vector<std::vector<SContact>> m_TaskContacts; // Contacts of each narrowphase task, concatenated in order
+        std::vector<float> m_LinearDampingFactors; // Per material, filled once per step by the integrate stage
+        std::vector<float> m_AngularDampingFactors;
+        std::vector<SContact> m_BoundaryContacts; // Sphere-wall contacts of the boundary stage
+        std::vector<std::vector<SContact>> m_BoundaryTaskContacts;
+        std::array<int, 6> m_WallHandles { -1, -1, -1, -1, -1, -1 }; // -X, +X, -Y, +Y, -Z, +Z
+        CMortonOrder m_BodyOrder;
+        BoundingBox m_WorldBox;
+        SSimulationParameters m_SimulationParameters;
+
+        private:
+        std::array<SPhysicsBody, 6> BoundingBoxToPlanes ( const BoundingBox & Box ) const;
+        /** Permute the bodies to the order of the codes m_BodyOrder measured last. */
+        void SortMeasuredBodies ();
+#if PE_ENABLE_PROFILING
+        /** Add the job times and counters of the step that just ran to the current frame. */
+        void RecordStepProfile ( double StepMs );
+        CProfiler m_Profiler;
+        bool m_IsUpdating = false; // Steps run by Update end the frame together
+#endif
+        int64_t m_NumberOfSpawnedBalls = 0; // Since the last SetSimulationParameters, numbers the random sequence of the next spawn
+        bool m_IsBroadphaseCurrent = false; // Updated from the bodies as they are now, scene queries may use it as it is
+        float m_TimeAccumulator = 0.f;
+        double m_StepMsEstimate = 0.0; // Moving average of the step wall time, predicts whether the next step fits the budget
+        int m_NumberOfOverruns = 0;
+        int m_NumberOfDroppedSteps = 0;
+        float m_FixedDeltaTime = 0.f;
+        int m_NumberOfBalls = 0;
+        int m_NumberOfPairTests = 0;
+        int m_NumberOfContacts = 0;
+        int m_NumberOfClampedBodies = 0;
+        int m_NumberOfWarmStartedContacts = 0;
+        int m_NumberOfAwakeBodies = 0;
+        int m_NumberOfColors = 0;
+        int m_NextSleepIsland = 0;
+        int m_StepsUntilOrderCheck = 0; // The first step checks, generated balls come in random order
+        int m_NumberOfBodySorts = 0;
+        float m_BodyDisorder = 0.f;
+    };
+} // namespace PE
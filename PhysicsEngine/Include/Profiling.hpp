@@ -0,0 +1,121 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Set by the PE_ENABLE_PROFILING CMake option. At 0 the world neither reads the clock nor keeps any samples.
+#ifndef PE_ENABLE_PROFILING
+#define PE_ENABLE_PROFILING 1
+#endif
+
+
+namespace PE
+{
+    /**
+     * @brief Parts of a step timed by the profiler.
+     */
+    enum class EProfilePhase : uint8_t
+    {
+        BodyOrder, // Morton order check and sort
+        Integrate,
+        ContinuousCollision, // Sweeping the fast spheres
+        WorldBoundary,
+        Broadphase, // Update and pair finding
+        Narrowphase,
+        Solve, // Grouping, warm starting and the solver iterations
+        Sleeping,
+        Step, // The whole step, the phases above included
+        Count,
+    };
+
+    const char * GetProfilePhaseName ( EProfilePhase Phase );
+
+    /**
+     * @brief Summary of the samples in a rolling window.
+     */
+    struct SRollingStatistic
+    {
+        double Last = 0.0;
+        double Min = 0.0;
+        double Avg = 0.0;
+        double Max = 0.0;
+        double P99 = 0.0; // Nearest rank, the largest sample for fewer than 100 samples
+        int NumberOfSamples = 0;
+    };
+
+    /**
+     * @brief Fixed size window over the latest samples of one value.
+     */
+    class CRollingWindow
+    {
+        public:
+
+        static constexpr int GSize = 240;
+
+        void Add ( double Sample );
+        SRollingStatistic Compute () const;
+        void Clear ();
+
+        private:
+
+        std::array<double, GSize> m_Samples {};
+        int m_Next = 0;
+        int m_NumberOfSamples = 0;
+    };
+
+    /**
+     * @brief Per-frame engine statistics over the last CRollingWindow::GSize frames.
+     *
+     * A frame is one CPhysicsWorld::Update call that ran at least one step, or one Step called directly.
+     * Values are summed over the substeps of the frame. Phase times are wall times in milliseconds.
+     * Everything stays zero when profiling is compiled out.
+     */
+    struct SPhysicsStats
+    {
+        std::array<SRollingStatistic, static_cast<size_t> ( EProfilePhase::Count )> PhaseMs;
+        SRollingStatistic PairTests; // Broadphase pairs handed to the narrowphase
+        SRollingStatistic Contacts; // Pairs and wall contacts that hit
+        SRollingStatistic SolverIterations;
+        SRollingStatistic Substeps;
+
+        const SRollingStatistic & GetPhaseMs ( EProfilePhase Phase ) const { return PhaseMs [ static_cast<size_t> ( Phase ) ]; }
+    };
+
+    /**
+     * @brief Accumulates the phase times and counters of a frame and keeps the rolling windows.
+     */
+    class CProfiler
+    {
+        public:
+
+        void AddPhaseTime ( EProfilePhase Phase, double Ms ) { m_FramePhaseMs [ static_cast<size_t> ( Phase ) ] += Ms; }
+
+        /** Count one substep of the current frame. */
+        void AddStep ( int PairTests, int Contacts, int SolverIterations );
+
+        /** Push the current frame into the windows, frames without a step are dropped. */
+        void EndFrame ();
+
+        SPhysicsStats GetStats () const;
+        void Clear ();
+
+        /** Monotonic high-resolution clock in milliseconds. */
+        static double NowMs ();
+
+        private:
+
+        void ResetFrame ();
+
+        std::array<double, static_cast<size_t> ( EProfilePhase::Count )> m_FramePhaseMs {};
+        int m_FramePairTests = 0;
+        int m_FrameContacts = 0;
+        int m_FrameSolverIterations = 0;
+        int m_FrameSubsteps = 0;
+
+        std::array<CRollingWindow, static_cast<size_t> ( EProfilePhase::Count )> m_PhaseWindows;
+        CRollingWindow m_PairTests;
+        CRollingWindow m_Contacts;
+        CRollingWindow m_SolverIterations;
+        CRollingWindow m_Substeps;
+    };
+} // namespace PE
@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+
+namespace PE
+{
+    /**
+     * @brief Philox4x32-10 counter-based random number generator (Salmon et al., Random123).
+     *
+     * A block of four random words is a pure function of a 128-bit counter and a 64-bit key: there is no
+     * state to advance, so any thread can draw the numbers of any body directly and the result doesn't
+     * depend on who draws what in which order.
+     */
+    class CPhilox4x32
+    {
+        public:
+
+        using SBlock = std::array<uint32_t, 4>;
+
+        explicit CPhilox4x32 ( uint64_t Key )
+            : m_Key { static_cast<uint32_t> ( Key ), static_cast<uint32_t> ( Key >> 32 ) }
+        {
+        }
+
+        /** The four words of block Counter. */
+        SBlock operator () ( const SBlock & Counter ) const
+        {
+            SBlock Block = Counter;
+            std::array<uint32_t, 2> Key = m_Key;
+            for ( int Round = 0; Round < GNumberOfRounds; Round++ )
+            {
+                const uint64_t Product0 = static_cast<uint64_t> ( GMultiplier0 ) * Block [ 0 ];
+                const uint64_t Product1 = static_cast<uint64_t> ( GMultiplier1 ) * Block [ 2 ];
+                Block = { static_cast<uint32_t> ( Product1 >> 32 ) ^ Block [ 1 ] ^ Key [ 0 ], static_cast<uint32_t> ( Product1 ),
+                          static_cast<uint32_t> ( Product0 >> 32 ) ^ Block [ 3 ] ^ Key [ 1 ], static_cast<uint32_t> ( Product0 ) };
+                Key [ 0 ] += GWeyl0;
+                Key [ 1 ] += GWeyl1;
+            }
+            return Block;
+        }
+
+        /** Block Block of stream Stream, e.g. the Block-th four numbers of body Stream. */
+        SBlock operator () ( uint64_t Stream, uint32_t Block ) const
+        {
+            return ( *this ) ( { static_cast<uint32_t> ( Stream ), static_cast<uint32_t> ( Stream >> 32 ), Block, 0u } );
+        }
+
+        /** Uniform float in [0, 1) from the top 24 bits of a word. */
+        static float ToUnitFloat ( uint32_t Word ) { return static_cast<float> ( Word >> 8 ) * ( 1.f / 16777216.f ); }
+
+        /** Uniform float in [Min, Max) from a word. */
+        static float ToRange ( uint32_t Word, float Min, float Max ) { return Min + ( Max - Min ) * ToUnitFloat ( Word ); }
+
+        private:
+
+        static constexpr int GNumberOfRounds = 10;
+        static constexpr uint32_t GMultiplier0 = 0xD2511F53u;
+        static constexpr uint32_t GMultiplier1 = 0xCD9E8D57u;
+        static constexpr uint32_t GWeyl0 = 0x9E3779B9u;
+        static constexpr uint32_t GWeyl1 = 0xBB67AE85u;
+
+        std::array<uint32_t, 2> m_Key;
+    };
+} // namespace PE
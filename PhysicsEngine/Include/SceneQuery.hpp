@@ -0,0 +1,90 @@
+#pragma once
+#include "raylib.h"
+#include "BodyStorage.hpp"
+#include "Broadphase.hpp"
+#include "JobSystem.hpp"
+#include <array>
+#include <limits>
+#include <span>
+
+
+namespace PE
+{
+    /**
+     * @brief Ray of a scene query.
+     */
+    struct SRay
+    {
+        Vector3 Origin { 0.f, 0.f, 0.f };
+        Vector3 Direction { 0.f, 0.f, 1.f }; // Normalized by the query, a zero direction hits nothing
+        float MaxDistance = std::numeric_limits<float>::max();
+    };
+
+    /**
+     * @brief Where a ray meets a body.
+     */
+    struct SRayHit
+    {
+        int Handle = -1; // -1 when the ray hit nothing
+        float Distance = 0.f; // From the origin, 0 when the ray starts inside the body
+        Vector3 Point { 0.f, 0.f, 0.f };
+        Vector3 Normal { 0.f, 0.f, 0.f }; // Outward surface normal at Point, against the ray when it starts inside
+    };
+
+    /**
+     * @brief Ray casts and overlap queries against the bodies, accelerated by the broadphase.
+     *
+     * A view of the world as it was when the view was made (CPhysicsWorld::GetSceneQuery), valid until bodies are
+     * added, removed, moved or stepped. Every query is const and allocation free, results go into buffers of the
+     * caller, and any number of threads may query at once. Candidates from the broadphase are tested with their
+     * exact shapes, the world boundary walls (never in the broadphase) directly.
+     */
+    class CSceneQuery
+    {
+        public:
+
+        // Rays of a batch cast per job system task
+        static constexpr int GRaysPerTask = 64;
+        static constexpr int GMaxBoundaryBodies = 6;
+
+        /**
+         * @param BoundaryBodies dense indices of the world boundary bodies, at most GMaxBoundaryBodies
+         * @param Broadphase updated from Bodies in their current state
+         */
+        CSceneQuery ( const CBodyStorage & Bodies, const CBroadphase & Broadphase, std::span<const int> BoundaryBodies );
+
+        /** Closest body the ray hits, false with OutHit . Handle = -1 when it hits none. */
+        bool RayCast ( const SRay & Ray, SRayHit & OutHit ) const;
+
+        /** Closest hits of a batch of rays on the job system, OutHits [ i ] for Rays [ i ] (at least as many). */
+        void RayCast ( std::span<const SRay> Rays, std::span<SRayHit> OutHits, CJobSystem & JobSystem ) const;
+
+        /**
+         * Every body the ray hits, nearest first. When OutHits is too small the nearest ones are kept.
+         * @return number of hits written
+         */
+        int RayCastAll ( const SRay & Ray, std::span<SRayHit> OutHits ) const;
+
+        /**
+         * Handles of the bodies overlapping a sphere, in no particular order.
+         * @return number of overlapping bodies, only the first OutHandles . size() of them are written
+         */
+        int OverlapSphere ( const Vector3 & Center, float Radius, std::span<int> OutHandles ) const;
+
+        /** Handles of the bodies overlapping an axis-aligned box, same conventions as OverlapSphere. */
+        int OverlapBox ( const BoundingBox & Box, std::span<int> OutHandles ) const;
+
+        private:
+
+        /** Normalize the ray direction, false for a zero direction. */
+        static bool PrepareRay ( const SRay & Ray, Vector3 & OutDirection );
+        /** Hand the boundary bodies, which are in no broadphase, to a query callback. Returns the ray's reach after them. */
+        float ReportBoundary ( CBroadphaseRayCallback & Callback, float Reach ) const;
+        void ReportBoundary ( CBroadphaseBoxCallback & Callback ) const;
+
+        const CBodyStorage & m_Bodies;
+        const CBroadphase & m_Broadphase;
+        std::array<int, GMaxBoundaryBodies> m_BoundaryBodies {};
+        int m_NumberOfBoundaryBodies = 0;
+    };
+} // namespace PE
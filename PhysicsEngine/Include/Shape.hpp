@@ -8,6 +8,7 @@ enum class EShapeType : short
 {
     Box,
     Sphere,
+    Count, // Number of shape types, not a shape
 };
 
 /**
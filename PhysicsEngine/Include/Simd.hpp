@@ -0,0 +1,29 @@
+#pragma once
+#include "Parameters.hpp"
+
+
+namespace PE
+{
+namespace Simd
+{
+    /**
+     * @brief Highest SIMD level the running CPU (and operating system) supports.
+     *
+     * Detected once on first call with cpuid, so the same binary picks AVX2 kernels on
+     * capable machines and falls back to SSE2 or scalar code elsewhere.
+     */
+    ESimdLevel GetSupportedLevel ();
+
+    /**
+     * @brief Clamp a requested SIMD level to the supported one.
+     * @param Requested highest level the caller allows
+     * @return min ( Requested, GetSupportedLevel() )
+     */
+    ESimdLevel ResolveLevel ( ESimdLevel Requested );
+
+    /**
+     * @brief Human readable name of a SIMD level.
+     */
+    const char * GetLevelName ( ESimdLevel Level );
+} // namespace Simd
+} // namespace PE
@@ -0,0 +1,150 @@
+#pragma once
+#include "raylib.h"
+#include "PhysicsWorld.hpp"
+#include "Profiling.hpp"
+#include "Shape.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Lock-free triple buffer handing the latest value from one writer thread to one reader thread.
+     *
+     * The writer fills its own buffer and publishes it by swapping it with the shared middle one, the reader
+     * swaps the middle one into its own buffer when something new was published. Neither side ever waits,
+     * the writer may publish many times between two reads and the reader only sees the latest.
+     */
+    template <typename T>
+    class CTripleBuffer
+    {
+        public:
+
+        /** Buffer the writer fills, contents are whatever it held two publishes ago. */
+        T & GetWriteBuffer () { return m_Buffers [ m_WriteIndex ]; }
+
+        void Publish ()
+        {
+            m_WriteIndex = m_Middle . exchange ( static_cast<uint8_t> ( m_WriteIndex | GFreshBit ), std::memory_order_acq_rel ) & GIndexMask;
+        }
+
+        /** Latest published buffer, the same one again until the writer publishes a newer one. */
+        const T & AcquireLatest ()
+        {
+            if ( m_Middle . load ( std::memory_order_relaxed ) & GFreshBit )
+            {
+                m_ReadIndex = m_Middle . exchange ( m_ReadIndex, std::memory_order_acq_rel ) & GIndexMask;
+            }
+            return m_Buffers [ m_ReadIndex ];
+        }
+
+        private:
+
+        static constexpr uint8_t GIndexMask = 3;
+        static constexpr uint8_t GFreshBit = 4; // The middle buffer was published and not read yet
+
+        std::array<T, 3> m_Buffers;
+        uint8_t m_WriteIndex = 0;
+        uint8_t m_ReadIndex = 1;
+        std::atomic<uint8_t> m_Middle { 2 };
+    };
+
+    /**
+     * @brief What a renderer needs of the world after a step: body poses of the last two published states and display counters.
+     *
+     * Body streams are indexed by handle slot (CBodyStorage::GetHandleSlot), so the renderer keeps finding its bodies
+     * when the world re-sorts or removes them. Handles tells which body holds a slot, FindSlot resolves a handle.
+     */
+    struct SRenderSnapshot
+    {
+        std::vector<int> Handles; // Handle of the body in every slot, -1 for free slots
+        std::vector<Vector3> Positions;
+        std::vector<Quaternion> Rotations;
+        std::vector<Vector3> PreviousPositions; // Published the time before, equal to the current ones after a restart or for new bodies
+        std::vector<Quaternion> PreviousRotations;
+        std::vector<SShape> Shapes;
+        std::vector<uint8_t> Flags; // EBodyFlags bits
+
+        int64_t StepIndex = 0; // Steps the simulation thread ran so far, 0 before the first one
+        int StepsSincePrevious = 0; // Steps between the previous and the current poses
+        float FixedDeltaTime = 0.f;
+        float TimeAccumulator = 0.f; // Real time the world had not simulated yet when this was published
+        double PublishMs = 0.0; // CProfiler::NowMs at publishing
+
+        int NumberOfBalls = 0;
+        int NumberOfPairTests = 0;
+        int NumberOfAwakeBodies = 0;
+        int NumberOfOverruns = 0;
+        int NumberOfDroppedSteps = 0;
+        std::vector<SJobStats> StepJobStats;
+        SPhysicsStats Stats;
+
+        int GetNumberOfSlots () const { return static_cast<int> ( Handles . size() ); }
+
+        /** Slot of a body, -1 when the handle had no body at publishing (removed, or added later). */
+        int FindSlot ( int Handle ) const;
+
+        /**
+         * Blend factor between the previous and the current poses for a frame drawn at NowMs.
+         * The pose drawn lags real time by one fixed step, 1 is the current pose.
+         */
+        float GetInterpolation ( double NowMs ) const;
+
+        /** Pose of the body in a slot at Interpolation (see GetInterpolation). */
+        Vector3 GetPosition ( int Slot, float Interpolation ) const;
+        Quaternion GetRotation ( int Slot, float Interpolation ) const;
+    };
+
+    /**
+     * @brief Steps a world in real time on its own thread and publishes a render snapshot after every update.
+     *
+     * The world belongs to the simulation thread while it runs: other threads read the snapshots only and call
+     * Stop before touching the world (restart, new parameters, adding bodies). The thread sleeps until the next
+     * fixed step is due, so an update usually runs exactly one step.
+     */
+    class CSimulationThread
+    {
+        public:
+
+        explicit CSimulationThread ( CPhysicsWorld & World );
+        ~CSimulationThread ();
+
+        CSimulationThread ( const CSimulationThread & ) = delete;
+        CSimulationThread & operator = ( const CSimulationThread & ) = delete;
+
+        /** Start stepping the world, the first snapshot has no previous poses to blend from. */
+        void Start ();
+        /** Stop stepping and wait for the thread, the world may be used again once this returns. */
+        void Stop ();
+        bool IsRunning () const { return m_Thread . joinable(); }
+
+        /** A paused thread doesn't step and forgets the real time that passed meanwhile. */
+        void SetPaused ( bool IsPaused ) { m_IsPaused . store ( IsPaused, std::memory_order_relaxed ); }
+        bool IsPaused () const { return m_IsPaused . load ( std::memory_order_relaxed ); }
+
+        /** Publish the current state of the world without stepping it, only while the thread is stopped. */
+        void PublishSnapshot ();
+
+        /** Latest snapshot, for one reader thread. Empty until the first publish. */
+        const SRenderSnapshot & AcquireSnapshot () { return m_Snapshots . AcquireLatest(); }
+
+        private:
+
+        void Run ();
+        void WriteSnapshot ( int NumberOfSteps );
+
+        CPhysicsWorld & m_World;
+        CTripleBuffer<SRenderSnapshot> m_Snapshots;
+        std::vector<int> m_PublishedHandles; // Bodies and poses of the last publish, the previous ones of the next
+        std::vector<Vector3> m_PublishedPositions;
+        std::vector<Quaternion> m_PublishedRotations;
+        int64_t m_StepIndex = 0;
+        std::thread m_Thread;
+        std::atomic<bool> m_IsStopping { false };
+        std::atomic<bool> m_IsPaused { false };
+    };
+} // namespace PE
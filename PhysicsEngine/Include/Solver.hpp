@@ -0,0 +1,53 @@
+#pragma once
+#include "BodyStorage.hpp"
+#include "Contact.hpp"
+#include "Parameters.hpp"
+#include <span>
+
+
+namespace PE
+{
+namespace Solver
+{
+    /**
+     * @brief Fill the cached solver terms of freshly generated contacts.
+     *
+     * Computes lever arms, r x n, normal and tangent effective masses, the separation at generation
+     * time, the friction coefficient and the normal velocity target, so solver iterations only read them.
+     * Touching contacts approaching faster than RestitutionVelocityThreshold aim for a bounce, speculative
+     * contacts (negative penetration) allow the approach velocity that just closes the gap in DeltaTime.
+     * @param Bodies body storage the contacts refer to
+     * @param Contacts contacts produced by the narrowphase in this step
+     * @param SimulationParameters restitution threshold
+     * @param DeltaTime step length
+     */
+    void PrepareContacts ( const CBodyStorage & Bodies, std::span<SContact> Contacts, const SSimulationParameters & SimulationParameters, float DeltaTime );
+
+    /**
+     * @brief Apply the accumulated impulses the contacts start with (restored by CContactCache).
+     */
+    void WarmStart ( CBodyStorage & Bodies, std::span<SContact> Contacts );
+
+    /**
+     * @brief One sequential impulse iteration on a single contact.
+     *
+     * Pushes the bodies apart by the current penetration (minus Slop), then updates the accumulated
+     * normal impulse (kept non-negative) and the accumulated friction impulse (clamped to the Coulomb
+     * cone) and applies their change. The current penetration is the generated one corrected by how far
+     * earlier iterations moved the bodies along the normal.
+     * @param Bodies body storage to update in place
+     * @param Contact prepared contact, its accumulated impulses are updated
+     * @param Slop allowed penetration that is not corrected
+     * @param MaxCorrection largest penetration resolved by this contact in one step
+     */
+    void SolveContact ( CBodyStorage & Bodies, SContact & Contact, float Slop, float MaxCorrection );
+
+    /**
+     * @brief Run SimulationParameters.NumberOfSteps Gauss-Seidel sweeps over all contacts in list order.
+     *
+     * Static bodies are only read, so contact lists that share nothing but static bodies (islands)
+     * can be solved on different threads.
+     */
+    void SolveContacts ( CBodyStorage & Bodies, std::span<SContact> Contacts, const SSimulationParameters & SimulationParameters );
+} // namespace Solver
+} // namespace PE
@@ -0,0 +1,98 @@
+#pragma once
+#include "raylib.h"
+#include "Broadphase.hpp"
+#include <cstdint>
+#include <vector>
+
+
+namespace PE
+{
+    /**
+     * @brief Uniform spatial hash grid broadphase.
+     *
+     * Bodies are binned into cubic cells by their (margin-expanded) bounding box. Cell coordinates are
+     * hashed into a bucket table that is rebuilt with a counting sort, so a rebuild is linear in the
+     * number of bodies. Only bodies sharing a cell are paired, and every pair is reported exactly once
+     * from the cell holding the minimum corner of the two boxes' intersection.
+     *
+     * Bodies whose box covers more than GMaxCellsPerBody cells (e.g. the world planes) are kept out of
+     * the grid and tested against every other body directly.
+     */
+    class CSpatialHashGrid : public CBroadphase
+    {
+        public:
+
+        /** Maximum number of cells a body may occupy before it is treated as oversized. */
+        static constexpr int GMaxCellsPerBody = 8;
+
+        // Construct grid with a given cell edge length and bounding box margin.
+        explicit CSpatialHashGrid ( float CellSize = 1.f, float Margin = 0.f );
+
+        /** Set the cell edge length. Takes effect on the next Build. */
+        void SetCellSize ( float CellSize );
+
+        /** Set the margin added to each body bounding box. Takes effect on the next Build. */
+        void SetMargin ( float Margin );
+
+        float GetCellSize () const { return m_CellSize; }
+
+        /** Rebuild the grid from the current body positions. */
+        void Update ( const CBodyStorage & Bodies ) override;
+
+        /** Append candidate pairs (sorted by BodyA, then BodyB) whose bounding boxes share a cell. */
+        void FindPairs ( std::vector<SBroadphasePair> & OutPairs ) const override;
+
+        void Clear () override;
+
+        /** Nothing to carry over, every Update rebuilds the grid. */
+        void RemapBodies ( std::span<const int> ) override {}
+        void RemoveBody ( const CBodyStorage &, int ) override {}
+
+        /** Visit the cells the box covers, or every entry when that is fewer, then the oversized bodies. */
+        void QueryBox ( const BoundingBox & Box, CBroadphaseBoxCallback & Callback ) const override;
+
+        /** Walk the cells along the ray in order (3D DDA), then test the oversized bodies. */
+        void QueryRay ( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, CBroadphaseRayCallback & Callback ) const override;
+
+        /** Number of bodies stored in the grid cells (excludes oversized bodies). */
+        int GetNumberOfGridBodies () const { return m_NumberOfGridBodies; }
+
+        /** Number of bodies tested against everything instead of being binned. */
+        int GetNumberOfOversizedBodies () const { return static_cast<int> ( m_OversizedBodies . size() ); }
+
+        private:
+
+        struct SCellEntry
+        {
+            uint64_t CellKey = 0;
+            int BodyIndex = 0;
+        };
+
+        struct SCellCoord
+        {
+            int X = 0;
+            int Y = 0;
+            int Z = 0;
+        };
+
+        SCellCoord ToCell ( const Vector3 & Location ) const;
+        static uint64_t PackCell ( const SCellCoord & Cell );
+        uint32_t BucketOf ( uint64_t CellKey ) const;
+        /** Whether a cell lies in the range of cells a body's bounds were binned into. */
+        bool IsInBodyCells ( const SCellCoord & Cell, int Body ) const;
+
+        std::vector<BoundingBox> m_Bounds;
+        std::vector<uint8_t> m_IsPassive; // Static or sleeping, passive-passive pairs are skipped
+        std::vector<uint8_t> m_IsOversized;
+        std::vector<SCellEntry> m_Entries;
+        std::vector<SCellEntry> m_ScratchEntries;
+        std::vector<uint32_t> m_BucketStarts;
+        std::vector<int> m_OversizedBodies;
+        BoundingBox m_GridBounds {}; // Union of the bounds of the bodies in the cells, queries skip the cells outside
+        float m_CellSize = 1.f;
+        float m_InvCellSize = 1.f;
+        float m_Margin = 0.f;
+        uint32_t m_BucketShift = 63;
+        int m_NumberOfGridBodies = 0;
+    };
+} // namespace PE
@@ -0,0 +1,40 @@
+#pragma once
+#include "raylib.h"
+#include "BodyStorage.hpp"
+#include "JobSystem.hpp"
+#include "Parameters.hpp"
+#include "PhysicsBody.hpp"
+#include <cstdint>
+
+
+namespace PE
+{
+namespace Spawn
+{
+    // Balls written per spawn task
+    constexpr int GBallsPerTask = 4096;
+
+    /**
+     * @brief Center of the Number-th ball in the generation pattern (fixed patterns only, see ESpawnPattern).
+     */
+    Vector3 GetPatternPosition ( const SBallGenerationParameters & Generation, int64_t Number );
+
+    /**
+     * @brief One ball of a deterministic spawn sequence.
+     *
+     * Radius, random position and velocities are drawn from Philox blocks keyed by Seed and counted by
+     * SequenceNumber, so the ball is a pure function of the arguments. Material comes from Template.
+     * @param SequenceNumber place of the ball among every ball spawned with this seed, also its place in a fixed pattern
+     */
+    SPhysicsBody MakeBall ( const SBallGenerationParameters & Generation, const SPhysicsBody & Template, uint64_t Seed, int64_t SequenceNumber );
+
+    /**
+     * @brief Append NumberOfBalls balls to the storage, written in parallel chunks of GBallsPerTask.
+     *
+     * Ball i is MakeBall ( ..., FirstSequenceNumber + i ): bit-identical for any number of threads.
+     * @return dense index of the first ball, -1 when the storage has too few handles left
+     */
+    int SpawnBalls ( CBodyStorage & Bodies, CJobSystem & JobSystem, int NumberOfBalls, const SBallGenerationParameters & Generation,
+                     const SPhysicsBody & Template, uint64_t Seed, int64_t FirstSequenceNumber );
+} // namespace Spawn
+} // namespace PE
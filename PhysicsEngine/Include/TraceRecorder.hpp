@@ -0,0 +1,178 @@
+#pragma once
+#include "Profiling.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+namespace PE
+{
+    /**
+     * @brief One complete event of the timeline: a named span on a thread with up to two integer arguments.
+     *
+     * Name and argument names are written out by the flush thread long after the scope ended, they must
+     * outlive the recording (string literals) and need no JSON escaping.
+     */
+    struct STraceEvent
+    {
+        const char * Name = nullptr;
+        const char * ArgNames [ 2 ] = { nullptr, nullptr };
+        int64_t ArgValues [ 2 ] = { 0, 0 };
+        int64_t StartNs = 0;
+        int64_t DurationNs = 0;
+        uint32_t ThreadId = 0;
+    };
+
+    /**
+     * @brief Bounded lock-free queue of trace events, any thread pushes and a single thread pops.
+     *
+     * Every slot carries a sequence number telling whether it is free for the push of that round or holds
+     * an event ready to pop, so producers only contend on the write index. A full ring rejects the push
+     * instead of waiting: recording never blocks a simulation thread.
+     */
+    class CTraceRing
+    {
+        public:
+
+        /** Capacity is rounded up to a power of two. */
+        explicit CTraceRing ( int Capacity );
+
+        bool TryPush ( const STraceEvent & Event );
+        /** Only ever called from one thread at a time. */
+        bool TryPop ( STraceEvent & OutEvent );
+
+        int GetCapacity () const { return static_cast<int> ( m_Mask + 1 ); }
+
+        private:
+
+        struct SSlot
+        {
+            std::atomic<uint64_t> Sequence { 0 };
+            STraceEvent Event;
+        };
+
+        std::unique_ptr<SSlot[]> m_Slots;
+        uint64_t m_Mask = 0;
+        alignas ( 64 ) std::atomic<uint64_t> m_WriteIndex { 0 };
+        alignas ( 64 ) uint64_t m_ReadIndex = 0;
+    };
+
+    /**
+     * @brief Process-wide recorder writing trace scopes as Chrome trace-event JSON (chrome://tracing, Perfetto).
+     *
+     * Off by default. While recording, every CTraceScope pushes one event into a lock-free ring and a
+     * background thread drains the ring into the file every GFlushIntervalMs. Events that don't fit
+     * into the ring are dropped and counted. Start and Stop may be called while other threads record, only a
+     * Start asking for a larger capacity than any before must not race with a scope.
+     */
+    class CTraceRecorder
+    {
+        public:
+
+        static constexpr int GDefaultCapacity = 1 << 16;
+        static constexpr int GFlushIntervalMs = 20;
+
+        static CTraceRecorder & Get ();
+
+        ~CTraceRecorder ();
+        CTraceRecorder ( const CTraceRecorder & ) = delete;
+        CTraceRecorder & operator = ( const CTraceRecorder & ) = delete;
+
+        /** Open Path and start recording, false when already recording, the file can't be opened or profiling is compiled out. */
+        bool Start ( const std::string & Path, int Capacity = GDefaultCapacity );
+
+        /** Stop recording, write the remaining events and close the file. */
+        void Stop ();
+
+        static bool IsRecording () { return s_IsRecording . load ( std::memory_order_acquire ); }
+
+        /** Stamp the calling thread's id on the event and queue it, dropped when the ring is full. */
+        void Record ( STraceEvent & Event );
+
+        /** Events written to the file, and events dropped on a full ring, since the last Start. */
+        int64_t GetNumberOfWrittenEvents () const { return m_NumberOfWrittenEvents . load ( std::memory_order_relaxed ); }
+        int64_t GetNumberOfDroppedEvents () const { return m_NumberOfDroppedEvents . load ( std::memory_order_relaxed ); }
+
+        /** Monotonic clock in nanoseconds. */
+        static int64_t NowNs ();
+
+        private:
+
+        CTraceRecorder () = default;
+        void FlushLoop ();
+        /** Write every event in the ring, flush thread (or Stop once it joined) only. */
+        void Drain ();
+
+        static inline std::atomic<bool> s_IsRecording { false };
+
+        std::unique_ptr<CTraceRing> m_Ring; // Kept after Stop, a scope that began before may still push
+        std::FILE * m_File = nullptr;
+        std::thread m_FlushThread;
+        std::mutex m_FlushMutex;
+        std::condition_variable m_FlushCondition;
+        bool m_IsStopping = false;
+        int64_t m_StartNs = 0;
+        std::atomic<int64_t> m_NumberOfWrittenEvents { 0 };
+        std::atomic<int64_t> m_NumberOfDroppedEvents { 0 };
+    };
+
+    /**
+     * @brief Times the enclosing scope as one trace event when a recording runs.
+     *
+     * Costs one atomic load when not recording and nothing at all when profiling is compiled out.
+     * Name and argument names must be string literals (see STraceEvent).
+     */
+    class CTraceScope
+    {
+        public:
+
+        explicit CTraceScope ( [[maybe_unused]] const char * Name )
+        {
+#if PE_ENABLE_PROFILING
+            if ( CTraceRecorder::IsRecording() )
+            {
+                m_Event . Name = Name;
+                m_Event . StartNs = CTraceRecorder::NowNs();
+            }
+#endif
+        }
+
+        ~CTraceScope ()
+        {
+#if PE_ENABLE_PROFILING
+            if ( m_Event . Name )
+            {
+                m_Event . DurationNs = CTraceRecorder::NowNs() - m_Event . StartNs;
+                CTraceRecorder::Get() . Record ( m_Event );
+            }
+#endif
+        }
+
+        CTraceScope ( const CTraceScope & ) = delete;
+        CTraceScope & operator = ( const CTraceScope & ) = delete;
+
+        /** Attach a count to the event, the first two stick and later ones are ignored. */
+        void AddArg ( [[maybe_unused]] const char * ArgName, [[maybe_unused]] int64_t Value )
+        {
+#if PE_ENABLE_PROFILING
+            if ( m_Event . Name && m_NumberOfArgs < 2 )
+            {
+                m_Event . ArgNames [ m_NumberOfArgs ] = ArgName;
+                m_Event . ArgValues [ m_NumberOfArgs++ ] = Value;
+            }
+#endif
+        }
+
+        private:
+
+#if PE_ENABLE_PROFILING
+        STraceEvent m_Event;
+        int m_NumberOfArgs = 0;
+#endif
+    };
+} // namespace PE
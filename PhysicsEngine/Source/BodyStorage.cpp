@@ -0,0 +1,462 @@
+#include "BodyStorage.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace PE
+{
+namespace
+{
+    template <typename T>
+    void PermuteArray( std::vector<T> & Array, std::span<const int> NewToOld )
+    {
+        std::vector<T> Permuted ( Array . size() );
+        for ( size_t i = 0; i < NewToOld . size(); i++ )
+        {
+            Permuted [ i ] = Array [ NewToOld [ i ] ];
+        }
+        Array . swap ( Permuted );
+    }
+
+    void PermuteStream( SVector3Stream & Stream, std::span<const int> NewToOld )
+    {
+        PermuteArray ( Stream . X, NewToOld );
+        PermuteArray ( Stream . Y, NewToOld );
+        PermuteArray ( Stream . Z, NewToOld );
+    }
+} // namespace
+
+    int CBodyStorage::Add( const SPhysicsBody & Body )
+    {
+        if ( ! HasFreeHandles ( 1 ) )
+        {
+            return -1;
+        }
+        const int MaterialIndex = AddMaterial ( { Body . Restitution, Body . Friction, Body . LinearDamping, Body . AngularDamping } );
+        if ( MaterialIndex < 0 )
+        {
+            return -1;
+        }
+        const int Index = Size();
+        const int Handle = AllocateHandle ( Index );
+        m_Ids . push_back ( Handle );
+
+        Shapes . push_back ( Body . Shape );
+        Positions . PushBack ( Body . Position );
+        LinearVelocities . PushBack ( Body . LinearVelocity );
+        AngularVelocities . PushBack ( Body . AngularVelocity );
+        Rotations . PushBack ( Body . Rotation );
+        Masses . push_back ( 0.f );
+        InvMasses . push_back ( 0.f );
+        InvInertias . push_back ( 0.f );
+        Radii . push_back ( 0.f );
+        MaterialIndices . push_back ( 0 );
+        Flags . push_back ( 0 );
+        SleepTimes . push_back ( 0.f );
+        SleepIslands . push_back ( -1 );
+        SleepNext . push_back ( -1 );
+        SleepPrevious . push_back ( -1 );
+        WriteBody ( Index, Body, static_cast<uint16_t> ( MaterialIndex ) );
+        return Handle;
+    }
+
+    int CBodyStorage::Append( int NumberOfBodies, const SPhysicsBody & Template )
+    {
+        const int FirstIndex = Size();
+        if ( NumberOfBodies <= 0 )
+        {
+            return FirstIndex;
+        }
+        if ( ! HasFreeHandles ( NumberOfBodies ) )
+        {
+            return -1;
+        }
+        // Write the template once through the regular path, then copy its stored form
+        if ( Add ( Template ) < 0 )
+        {
+            return -1;
+        }
+        const size_t NewSize = static_cast<size_t> ( FirstIndex + NumberOfBodies );
+        Shapes . resize ( NewSize, Shapes [ FirstIndex ] );
+        Positions . X . resize ( NewSize, Positions . X [ FirstIndex ] );
+        Positions . Y . resize ( NewSize, Positions . Y [ FirstIndex ] );
+        Positions . Z . resize ( NewSize, Positions . Z [ FirstIndex ] );
+        LinearVelocities . X . resize ( NewSize, LinearVelocities . X [ FirstIndex ] );
+        LinearVelocities . Y . resize ( NewSize, LinearVelocities . Y [ FirstIndex ] );
+        LinearVelocities . Z . resize ( NewSize, LinearVelocities . Z [ FirstIndex ] );
+        AngularVelocities . X . resize ( NewSize, AngularVelocities . X [ FirstIndex ] );
+        AngularVelocities . Y . resize ( NewSize, AngularVelocities . Y [ FirstIndex ] );
+        AngularVelocities . Z . resize ( NewSize, AngularVelocities . Z [ FirstIndex ] );
+        Rotations . X . resize ( NewSize, Rotations . X [ FirstIndex ] );
+        Rotations . Y . resize ( NewSize, Rotations . Y [ FirstIndex ] );
+        Rotations . Z . resize ( NewSize, Rotations . Z [ FirstIndex ] );
+        Rotations . W . resize ( NewSize, Rotations . W [ FirstIndex ] );
+        Masses . resize ( NewSize, Masses [ FirstIndex ] );
+        InvMasses . resize ( NewSize, InvMasses [ FirstIndex ] );
+        InvInertias . resize ( NewSize, InvInertias [ FirstIndex ] );
+        Radii . resize ( NewSize, Radii [ FirstIndex ] );
+        MaterialIndices . resize ( NewSize, MaterialIndices [ FirstIndex ] );
+        Flags . resize ( NewSize, Flags [ FirstIndex ] );
+        SleepTimes . resize ( NewSize, SleepTimes [ FirstIndex ] );
+        SleepIslands . resize ( NewSize, SleepIslands [ FirstIndex ] );
+        SleepNext . resize ( NewSize, SleepNext [ FirstIndex ] );
+        SleepPrevious . resize ( NewSize, SleepPrevious [ FirstIndex ] );
+        m_Ids . reserve ( NewSize );
+        for ( int Index = FirstIndex + 1; Index < static_cast<int> ( NewSize ); Index++ )
+        {
+            m_Ids . push_back ( AllocateHandle ( Index ) );
+        }
+        return FirstIndex;
+    }
+
+    int CBodyStorage::AllocateHandle( int Index )
+    {
+        int Slot = 0;
+        if ( m_NumberOfFreeHandleSlots > 0 )
+        {
+            Slot = m_FirstFreeHandleSlot;
+            m_FirstFreeHandleSlot = m_HandleSlots [ Slot ] . NextFree;
+            m_LastFreeHandleSlot = m_FirstFreeHandleSlot < 0 ? -1 : m_LastFreeHandleSlot;
+            m_HandleSlots [ Slot ] . NextFree = -1;
+            m_NumberOfFreeHandleSlots--;
+        }
+        else
+        {
+            Slot = static_cast<int> ( m_HandleSlots . size() );
+            m_HandleSlots . push_back ( {} );
+        }
+        m_HandleSlots [ Slot ] . Index = Index;
+        return ( m_HandleSlots [ Slot ] . Generation << GHandleSlotBits ) | Slot;
+    }
+
+    bool CBodyStorage::HasFreeHandles( int NumberOfHandles ) const
+    {
+        const int64_t NumberOfNewSlots = GMaxHandleSlots - static_cast<int64_t> ( m_HandleSlots . size() );
+        return m_NumberOfFreeHandleSlots + NumberOfNewSlots >= NumberOfHandles;
+    }
+
+    bool CBodyStorage::Remove( int Handle )
+    {
+        const int Index = GetIndex ( Handle );
+        if ( Index < 0 )
+        {
+            return false;
+        }
+        UnlinkFromSleepIsland ( Index );
+        const int Last = Size() - 1;
+        if ( Index != Last )
+        {
+            MoveBody ( Last, Index );
+            m_HandleSlots [ GetHandleSlot ( m_Ids [ Index ] ) ] . Index = Index;
+        }
+        Shapes . pop_back();
+        Positions . PopBack();
+        LinearVelocities . PopBack();
+        AngularVelocities . PopBack();
+        Rotations . PopBack();
+        Masses . pop_back();
+        InvMasses . pop_back();
+        InvInertias . pop_back();
+        Radii . pop_back();
+        MaterialIndices . pop_back();
+        Flags . pop_back();
+        SleepTimes . pop_back();
+        SleepIslands . pop_back();
+        SleepNext . pop_back();
+        SleepPrevious . pop_back();
+        m_Ids . pop_back();
+
+        const int SlotIndex = GetHandleSlot ( Handle );
+        SHandleSlot & Slot = m_HandleSlots [ SlotIndex ];
+        Slot . Index = -1;
+        Slot . Generation++;
+        if ( Slot . Generation > GHandleGenerationMask )
+        {
+            return true; // Retired, another generation would wrap to handles given out before
+        }
+        if ( m_LastFreeHandleSlot < 0 )
+        {
+            m_FirstFreeHandleSlot = SlotIndex;
+        }
+        else
+        {
+            m_HandleSlots [ m_LastFreeHandleSlot ] . NextFree = SlotIndex;
+        }
+        m_LastFreeHandleSlot = SlotIndex;
+        m_NumberOfFreeHandleSlots++;
+        return true;
+    }
+
+    void CBodyStorage::Clear()
+    {
+        Shapes . clear();
+        Positions . Clear();
+        LinearVelocities . Clear();
+        AngularVelocities . Clear();
+        Rotations . Clear();
+        Masses . clear();
+        InvMasses . clear();
+        InvInertias . clear();
+        Radii . clear();
+        MaterialIndices . clear();
+        Flags . clear();
+        SleepTimes . clear();
+        SleepIslands . clear();
+        SleepNext . clear();
+        SleepPrevious . clear();
+        m_Ids . clear();
+        m_HandleSlots . clear();
+        m_FirstFreeHandleSlot = -1;
+        m_LastFreeHandleSlot = -1;
+        m_NumberOfFreeHandleSlots = 0;
+        m_Materials . clear();
+        m_MaterialIndices . clear();
+        m_MaterialPairs . clear();
+        m_MaterialPairStride = 0;
+    }
+
+    void CBodyStorage::Reserve( int NumberOfBodies )
+    {
+        Shapes . reserve ( NumberOfBodies );
+        Positions . Reserve ( NumberOfBodies );
+        LinearVelocities . Reserve ( NumberOfBodies );
+        AngularVelocities . Reserve ( NumberOfBodies );
+        Rotations . Reserve ( NumberOfBodies );
+        Masses . reserve ( NumberOfBodies );
+        InvMasses . reserve ( NumberOfBodies );
+        InvInertias . reserve ( NumberOfBodies );
+        Radii . reserve ( NumberOfBodies );
+        MaterialIndices . reserve ( NumberOfBodies );
+        Flags . reserve ( NumberOfBodies );
+        SleepTimes . reserve ( NumberOfBodies );
+        SleepIslands . reserve ( NumberOfBodies );
+        SleepNext . reserve ( NumberOfBodies );
+        SleepPrevious . reserve ( NumberOfBodies );
+        m_Ids . reserve ( NumberOfBodies );
+        m_HandleSlots . reserve ( NumberOfBodies );
+    }
+
+    int CBodyStorage::GetIndex( int Handle ) const
+    {
+        const int Slot = GetHandleSlot ( Handle );
+        if ( Handle < 0 || Slot >= static_cast<int> ( m_HandleSlots . size() ) || m_HandleSlots [ Slot ] . Generation != Handle >> GHandleSlotBits )
+        {
+            return -1;
+        }
+        return m_HandleSlots [ Slot ] . Index;
+    }
+
+    SPhysicsBody CBodyStorage::GetBody( int Index ) const
+    {
+        const SMaterial & Material = m_Materials [ MaterialIndices [ Index ] ];
+        SPhysicsBody OutBody;
+        OutBody . Shape = Shapes [ Index ];
+        OutBody . Rotation = Rotations . Get ( Index );
+        OutBody . Position = Positions . Get ( Index );
+        OutBody . LinearVelocity = LinearVelocities . Get ( Index );
+        OutBody . AngularVelocity = AngularVelocities . Get ( Index );
+        OutBody . Mass = Masses [ Index ];
+        OutBody . InvMass = InvMasses [ Index ];
+        OutBody . Restitution = Material . Restitution;
+        OutBody . Friction = Material . Friction;
+        OutBody . AngularDamping = Material . AngularDamping;
+        OutBody . LinearDamping = Material . LinearDamping;
+        OutBody . Id = m_Ids [ Index ];
+        OutBody . IsStatic = IsStatic ( Index );
+        return OutBody;
+    }
+
+    bool CBodyStorage::SetBody( int Index, const SPhysicsBody & Body )
+    {
+        const int MaterialIndex = AddMaterial ( { Body . Restitution, Body . Friction, Body . LinearDamping, Body . AngularDamping } );
+        if ( MaterialIndex < 0 )
+        {
+            return false;
+        }
+        WriteBody ( Index, Body, static_cast<uint16_t> ( MaterialIndex ) );
+        return true;
+    }
+
+    void CBodyStorage::Permute( std::span<const int> NewToOld )
+    {
+        PermuteArray ( Shapes, NewToOld );
+        PermuteStream ( Positions, NewToOld );
+        PermuteStream ( LinearVelocities, NewToOld );
+        PermuteStream ( AngularVelocities, NewToOld );
+        PermuteArray ( Rotations . X, NewToOld );
+        PermuteArray ( Rotations . Y, NewToOld );
+        PermuteArray ( Rotations . Z, NewToOld );
+        PermuteArray ( Rotations . W, NewToOld );
+        PermuteArray ( Masses, NewToOld );
+        PermuteArray ( InvMasses, NewToOld );
+        PermuteArray ( InvInertias, NewToOld );
+        PermuteArray ( Radii, NewToOld );
+        PermuteArray ( MaterialIndices, NewToOld );
+        PermuteArray ( Flags, NewToOld );
+        PermuteArray ( SleepTimes, NewToOld );
+        PermuteArray ( SleepIslands, NewToOld );
+        PermuteArray ( SleepNext, NewToOld );
+        PermuteArray ( SleepPrevious, NewToOld );
+        PermuteArray ( m_Ids, NewToOld );
+        for ( int i = 0; i < Size(); i++ )
+        {
+            m_HandleSlots [ GetHandleSlot ( m_Ids [ i ] ) ] . Index = i;
+        }
+    }
+
+    std::vector<SPhysicsBody> CBodyStorage::ExportBodies() const
+    {
+        std::vector<SPhysicsBody> OutBodies;
+        OutBodies . reserve ( Size() );
+        for ( int i = 0; i < Size(); i++ )
+        {
+            OutBodies . push_back ( GetBody ( i ) );
+        }
+        return OutBodies;
+    }
+
+    int CBodyStorage::AddMaterial( const SMaterial & Material )
+    {
+        static_assert ( GMaxMaterials <= UINT16_MAX + 1, "Material indices are stored in 16 bits" );
+        const auto Existing = m_MaterialIndices . find ( Material );
+        if ( Existing != m_MaterialIndices . end() )
+        {
+            return Existing -> second;
+        }
+        if ( GetNumberOfMaterials() >= GMaxMaterials )
+        {
+            return -1;
+        }
+        m_MaterialIndices . emplace ( Material, static_cast<uint16_t> ( m_Materials . size() ) );
+        m_Materials . push_back ( Material );
+        const int NewMaterial = GetNumberOfMaterials() - 1;
+        if ( NewMaterial >= m_MaterialPairStride )
+        {
+            // Recombine every pair into the wider table
+            m_MaterialPairStride = std::max ( 8, m_MaterialPairStride * 2 );
+            m_MaterialPairs . assign ( static_cast<size_t> ( m_MaterialPairStride ) * m_MaterialPairStride, SMaterialPair {} );
+            for ( int MaterialA = 0; MaterialA < NewMaterial; MaterialA++ )
+            {
+                for ( int MaterialB = 0; MaterialB < NewMaterial; MaterialB++ )
+                {
+                    CombineMaterials ( MaterialA, MaterialB );
+                }
+            }
+        }
+        for ( int Other = 0; Other <= NewMaterial; Other++ )
+        {
+            CombineMaterials ( NewMaterial, Other );
+            CombineMaterials ( Other, NewMaterial );
+        }
+        return NewMaterial;
+    }
+
+    size_t CBodyStorage::SMaterialHash::operator()( const SMaterial & Material ) const
+    {
+        // Adding zero turns -0 into +0, which compare equal
+        size_t Hash = 0;
+        for ( const float Value : { Material . Restitution, Material . Friction, Material . LinearDamping, Material . AngularDamping } )
+        {
+            Hash = ( Hash ^ std::bit_cast<uint32_t> ( Value + 0.f ) ) * 0x100000001b3ull;
+        }
+        return Hash;
+    }
+
+    void CBodyStorage::CombineMaterials( int MaterialA, int MaterialB )
+    {
+        const SMaterial & A = m_Materials [ MaterialA ];
+        const SMaterial & B = m_Materials [ MaterialB ];
+        SMaterialPair & Pair = m_MaterialPairs [ MaterialA * m_MaterialPairStride + MaterialB ];
+        Pair . Restitution = std::fmin ( A . Restitution, B . Restitution );
+        Pair . Friction = std::fmax ( 0.f, std::fmin ( A . Friction, B . Friction ) );
+    }
+
+    void CBodyStorage::MoveBody( int From, int To )
+    {
+        Shapes [ To ] = Shapes [ From ];
+        Positions . Set ( To, Positions . Get ( From ) );
+        LinearVelocities . Set ( To, LinearVelocities . Get ( From ) );
+        AngularVelocities . Set ( To, AngularVelocities . Get ( From ) );
+        Rotations . Set ( To, Rotations . Get ( From ) );
+        Masses [ To ] = Masses [ From ];
+        InvMasses [ To ] = InvMasses [ From ];
+        InvInertias [ To ] = InvInertias [ From ];
+        Radii [ To ] = Radii [ From ];
+        MaterialIndices [ To ] = MaterialIndices [ From ];
+        Flags [ To ] = Flags [ From ];
+        SleepTimes [ To ] = SleepTimes [ From ];
+        SleepIslands [ To ] = SleepIslands [ From ];
+        SleepNext [ To ] = SleepNext [ From ];
+        SleepPrevious [ To ] = SleepPrevious [ From ];
+        m_Ids [ To ] = m_Ids [ From ];
+    }
+
+    void CBodyStorage::WriteBody( int Index, const SPhysicsBody & Body, uint16_t MaterialIndex )
+    {
+        Shapes [ Index ] = Body . Shape;
+        Positions . Set ( Index, Body . Position );
+        LinearVelocities . Set ( Index, Body . LinearVelocity );
+        AngularVelocities . Set ( Index, Body . AngularVelocity );
+        Rotations . Set ( Index, Body . Rotation );
+        Masses [ Index ] = Body . Mass;
+        InvMasses [ Index ] = Body . IsStatic ? 0.f : Body . InvMass;
+        const float Inertia = Body . Shape . GetMomentOfInertia ( Body . Mass );
+        InvInertias [ Index ] = ( Body . IsStatic || Inertia <= 0.f ) ? 0.f : 1.f / Inertia;
+        Radii [ Index ] = Body . Shape . Type == EShapeType::Sphere ? Body . Shape . Sphere . Radius : 0.f;
+        MaterialIndices [ Index ] = MaterialIndex;
+        // Written bodies start awake, a world wall stays one
+        Flags [ Index ] = ( Flags [ Index ] & static_cast<uint8_t> ( EBodyFlags::WorldBoundary ) ) | ( Body . IsStatic ? static_cast<uint8_t> ( EBodyFlags::Static ) : 0 );
+        SleepTimes [ Index ] = 0.f;
+        SleepIslands [ Index ] = -1;
+        UnlinkFromSleepIsland ( Index );
+    }
+
+    void CBodyStorage::PutIslandToSleep( std::span<const int> Indices, int SleepIsland )
+    {
+        for ( size_t i = 0; i < Indices . size(); i++ )
+        {
+            const int Index = Indices [ i ];
+            Flags [ Index ] |= static_cast<uint8_t> ( EBodyFlags::Sleeping );
+            SleepIslands [ Index ] = SleepIsland;
+            SleepNext [ Index ] = m_Ids [ Indices [ ( i + 1 ) % Indices . size() ] ];
+            SleepPrevious [ Index ] = m_Ids [ Indices [ ( i + Indices . size() - 1 ) % Indices . size() ] ];
+        }
+    }
+
+    int CBodyStorage::WakeIsland( int Index )
+    {
+        if ( ! IsSleeping ( Index ) )
+        {
+            return 0;
+        }
+        // Sleeping bodies flagged by hand have no ring, they wake alone
+        const int First = m_Ids [ Index ];
+        int NumberOfWokenBodies = 0;
+        int Current = Index;
+        while ( Current >= 0 )
+        {
+            const int Next = SleepNext [ Current ];
+            Flags [ Current ] &= ~static_cast<uint8_t> ( EBodyFlags::Sleeping );
+            SleepTimes [ Current ] = 0.f;
+            SleepIslands [ Current ] = -1;
+            SleepNext [ Current ] = -1;
+            SleepPrevious [ Current ] = -1;
+            NumberOfWokenBodies++;
+            Current = Next < 0 || Next == First ? -1 : GetIndex ( Next );
+        }
+        return NumberOfWokenBodies;
+    }
+
+    void CBodyStorage::UnlinkFromSleepIsland( int Index )
+    {
+        const int Next = SleepNext [ Index ];
+        const int Previous = SleepPrevious [ Index ];
+        if ( Next >= 0 && Next != m_Ids [ Index ] )
+        {
+            SleepPrevious [ GetIndex ( Next ) ] = Previous;
+            SleepNext [ GetIndex ( Previous ) ] = Next;
+        }
+        SleepNext [ Index ] = -1;
+        SleepPrevious [ Index ] = -1;
+    }
+} // namespace PE
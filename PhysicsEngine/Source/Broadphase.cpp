@@ -0,0 +1,30 @@
+#include "Broadphase.hpp"
+#include "DynamicAABBTree.hpp"
+#include "SpatialHashGrid.hpp"
+#include <algorithm>
+
+namespace PE
+{
+    std::unique_ptr<CBroadphase> CreateBroadphase( const SSimulationParameters & SimulationParameters )
+    {
+        const float Margin = SimulationParameters . BroadphaseMargin;
+        switch ( SimulationParameters . BroadphaseType )
+        {
+            case EBroadphaseType::DynamicAABBTree:
+                return std::make_unique<CAABBTreeBroadphase> ( Margin );
+
+            case EBroadphaseType::SpatialHashGrid:
+            default:
+                // A cell fits the largest ball, so every ball lands in at most 2x2x2 cells
+                return std::make_unique<CSpatialHashGrid> ( 2.f * ( SimulationParameters . BallGenerationParameters . MaxRadius + Margin ), Margin );
+        }
+    }
+
+    void SortPairs( std::vector<SBroadphasePair>::iterator Begin, std::vector<SBroadphasePair>::iterator End )
+    {
+        std::sort ( Begin, End, [] ( const SBroadphasePair & Lhs, const SBroadphasePair & Rhs )
+        {
+            return Lhs . BodyA != Rhs . BodyA ? Lhs . BodyA < Rhs . BodyA : Lhs . BodyB < Rhs . BodyB;
+        } );
+    }
+} // namespace PE
@@ -1,50 +1,193 @@
 #include "Collision.hpp"
 #include "Math.hpp"
 #include "raymath.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
 
 namespace PE 
 {
 namespace Collision 
 {
+namespace
+{
+    // Sweeps that enter a box near an edge or corner close the remaining gap in a few steps, down to a fraction of the radius
+    constexpr int GSweepRefinements = 8;
+    constexpr float GSweepTolerance = 1e-3f;
+} // namespace
+
+    BoundingBox GetBoundingBox ( const SPhysicsBody & Body )
+    {
+        return GetBoundingBox ( Body . Shape, Body . Position );
+    }
+
+    BoundingBox GetBoundingBox ( const SShape & Shape, const Vector3 & Position )
+    {
+        using FGetBoundingBox = BoundingBox (*) ( const SShape &, const Vector3 & );
+        static constexpr std::array<FGetBoundingBox, GNumberOfShapeTypes> GGetBoundingBox = MakeShapeTable<FGetBoundingBox> (
+            [] <EShapeType Type> () -> FGetBoundingBox { return &SShapeTraits<Type>::GetBoundingBox; } );
+        return GGetBoundingBox [ static_cast<int> ( Shape . Type ) ] ( Shape, Position );
+    }
+
+    bool OverlapsSphere( const SShape & Shape, const Vector3 & Position, const Vector3 & Center, float Radius )
+    {
+        using FOverlapsSphere = bool (*) ( const SShape &, const Vector3 &, const Vector3 &, float );
+        static constexpr std::array<FOverlapsSphere, GNumberOfShapeTypes> GOverlapsSphere = MakeShapeTable<FOverlapsSphere> (
+            [] <EShapeType Type> () -> FOverlapsSphere { return &SShapeTraits<Type>::OverlapsSphere; } );
+        return GOverlapsSphere [ static_cast<int> ( Shape . Type ) ] ( Shape, Position, Center, Radius );
+    }
+
+    bool OverlapsBox( const SShape & Shape, const Vector3 & Position, const BoundingBox & Box )
+    {
+        using FOverlapsBox = bool (*) ( const SShape &, const Vector3 &, const BoundingBox & );
+        static constexpr std::array<FOverlapsBox, GNumberOfShapeTypes> GOverlapsBox = MakeShapeTable<FOverlapsBox> (
+            [] <EShapeType Type> () -> FOverlapsBox { return &SShapeTraits<Type>::OverlapsBox; } );
+        return GOverlapsBox [ static_cast<int> ( Shape . Type ) ] ( Shape, Position, Box );
+    }
+
+    SSweepResult SweepSphere( const Vector3 & Start, const Vector3 & Motion, float Radius, const SShape & Shape, const Vector3 & Position )
+    {
+        using FSweepSphere = SSweepResult (*) ( const Vector3 &, const Vector3 &, float, const SShape &, const Vector3 & );
+        static constexpr std::array<FSweepSphere, GNumberOfShapeTypes> GSweepSphere = MakeShapeTable<FSweepSphere> (
+            [] <EShapeType Type> () -> FSweepSphere { return &SShapeTraits<Type>::SweepSphere; } );
+        return GSweepSphere [ static_cast<int> ( Shape . Type ) ] ( Start, Motion, Radius, Shape, Position );
+    }
+
+    BoundingBox SShapeTraits<EShapeType::Sphere>::GetBoundingBox( const SShape & Shape, const Vector3 & Position )
+    {
+        const float Radius = Shape . Sphere . Radius;
+        return { Vector3SubtractValue ( Position, Radius ), Vector3AddValue ( Position, Radius ) };
+    }
+
+    SRayResult SShapeTraits<EShapeType::Sphere>::RayCast( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, const SShape & Shape, const Vector3 & Position )
+    {
+        return RayCastSphere ( Origin, Direction, MaxDistance, Position, Shape . Sphere . Radius );
+    }
+
+    bool SShapeTraits<EShapeType::Sphere>::OverlapsSphere( const SShape & Shape, const Vector3 & Position, const Vector3 & Center, float Radius )
+    {
+        const float RadiiSum = Radius + Shape . Sphere . Radius;
+        return Vector3DistanceSqr ( Center, Position ) <= RadiiSum * RadiiSum;
+    }
+
+    bool SShapeTraits<EShapeType::Sphere>::OverlapsBox( const SShape & Shape, const Vector3 & Position, const BoundingBox & Box )
+    {
+        return Vector3DistanceSqr ( Position, Math::ClosestPointOnBox ( Position, Box ) ) <= Shape . Sphere . Radius * Shape . Sphere . Radius;
+    }
+
+    SSweepResult SShapeTraits<EShapeType::Sphere>::SweepSphere( const Vector3 & Start, const Vector3 & Motion, float Radius, const SShape & Shape, const Vector3 & Position )
+    {
+        return SweepSphereSphere ( Start, Motion, Radius, Position, { 0.f, 0.f, 0.f }, Shape . Sphere . Radius );
+    }
+
+    BoundingBox SShapeTraits<EShapeType::Box>::GetBoundingBox( const SShape & Shape, const Vector3 & Position )
+    {
+        return { Vector3Subtract ( Position, Shape . Box . HalfSize ), Vector3Add ( Position, Shape . Box . HalfSize ) };
+    }
+
+    SRayResult SShapeTraits<EShapeType::Box>::RayCast( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, const SShape & Shape, const Vector3 & Position )
+    {
+        return RayCastBox ( Origin, Direction, MaxDistance, GetBoundingBox ( Shape, Position ) );
+    }
+
+    bool SShapeTraits<EShapeType::Box>::OverlapsSphere( const SShape & Shape, const Vector3 & Position, const Vector3 & Center, float Radius )
+    {
+        return Vector3DistanceSqr ( Center, Math::ClosestPointOnBox ( Center, GetBoundingBox ( Shape, Position ) ) ) <= Radius * Radius;
+    }
+
+    bool SShapeTraits<EShapeType::Box>::OverlapsBox( const SShape & Shape, const Vector3 & Position, const BoundingBox & Box )
+    {
+        return Math::BoxesOverlap ( GetBoundingBox ( Shape, Position ), Box );
+    }
+
+    SSweepResult SShapeTraits<EShapeType::Box>::SweepSphere( const Vector3 & Start, const Vector3 & Motion, float Radius, const SShape & Shape, const Vector3 & Position )
+    {
+        return SweepSphereBox ( Start, Motion, Radius, GetBoundingBox ( Shape, Position ) );
+    }
+
     SHitResult TestCollision(const SPhysicsBody &BodyA, const SPhysicsBody &BodyB)
     {
-        if ( BodyA . Shape . Type == EShapeType::Sphere && BodyB . Shape . Type == EShapeType::Sphere )
-        {
-            return TestSphereSphere ( BodyA . Position, BodyA . Shape . Sphere . Radius, 
-                                     BodyB . Position, BodyB . Shape . Sphere . Radius ); 
-        }
-        else if ( BodyA . Shape . Type == EShapeType::Box && BodyB . Shape . Type == EShapeType::Sphere )
-        {
-            const BoundingBox Box = { 
-                Vector3Subtract ( BodyA . Position, BodyA . Shape . Box . HalfSize ), 
-                Vector3Add    ( BodyA . Position, BodyA . Shape . Box . HalfSize ) }; 
-            SHitResult HitResult = TestSphereBox ( BodyB . Position, BodyB . Shape . Sphere . Radius, Box ); 
-            // Invert normal to point from B to A
-            HitResult.Normal = Vector3Negate ( HitResult . Normal );
-            return HitResult; 
-        }
-        else if ( BodyA . Shape . Type == EShapeType::Sphere && BodyB . Shape . Type == EShapeType::Box )
+        return TestCollision ( BodyA . Shape, BodyA . Position, BodyB . Shape, BodyB . Position );
+    }
+
+    SHitResult TestCollision(const SShape &ShapeA, const Vector3 &PositionA, const SShape &ShapeB, const Vector3 &PositionB, float Margin)
+    {
+        using FPairTest = SHitResult (*) ( const SShape &, const Vector3 &, const SShape &, const Vector3 &, float );
+        static constexpr std::array<FPairTest, GNumberOfPairTypes> GPairTests = MakePairTable<FPairTest> (
+            [] <EShapeType TypeA, EShapeType TypeB> () -> FPairTest { return &SPairTest<TypeA, TypeB>::Test; } );
+
+        const FPairTest Test = GPairTests [ GetPairType ( ShapeA . Type, ShapeB . Type ) ];
+        if ( IsCanonicalPair ( ShapeA . Type, ShapeB . Type ) )
         {
-            const BoundingBox Box = { 
-                Vector3Subtract ( BodyB . Position, BodyB . Shape . Box . HalfSize ), 
-                Vector3Add    ( BodyB . Position, BodyB . Shape . Box . HalfSize ) }; 
-            return TestSphereBox ( BodyA . Position, BodyA . Shape . Sphere . Radius, Box );
+            return Test ( ShapeA, PositionA, ShapeB, PositionB, Margin );
         }
-        else 
+        // Asked in the other order, the kernel's normal points toward B
+        SHitResult HitResult = Test ( ShapeB, PositionB, ShapeA, PositionA, Margin );
+        HitResult . Normal = Vector3Negate ( HitResult . Normal );
+        return HitResult;
+    }
+
+    SHitResult SPairTest<EShapeType::Sphere, EShapeType::Sphere>::Test( const SShape & ShapeA, const Vector3 & PositionA, const SShape & ShapeB, const Vector3 & PositionB, float Margin )
+    {
+        return TestSphereSphere ( PositionA, ShapeA . Sphere . Radius, PositionB, ShapeB . Sphere . Radius, Margin );
+    }
+
+    SHitResult SPairTest<EShapeType::Sphere, EShapeType::Box>::Test( const SShape & ShapeA, const Vector3 & PositionA, const SShape & ShapeB, const Vector3 & PositionB, float Margin )
+    {
+        const BoundingBox Box { Vector3Subtract ( PositionB, ShapeB . Box . HalfSize ), Vector3Add ( PositionB, ShapeB . Box . HalfSize ) };
+        return TestSphereBox ( PositionA, ShapeA . Sphere . Radius, Box, Margin );
+    }
+
+    SHitResult SPairTest<EShapeType::Box, EShapeType::Box>::Test( const SShape & ShapeA, const Vector3 & PositionA, const SShape & ShapeB, const Vector3 & PositionB, float Margin )
+    {
+        const BoundingBox BoxA { Vector3Subtract ( PositionA, ShapeA . Box . HalfSize ), Vector3Add ( PositionA, ShapeA . Box . HalfSize ) };
+        const BoundingBox BoxB { Vector3Subtract ( PositionB, ShapeB . Box . HalfSize ), Vector3Add ( PositionB, ShapeB . Box . HalfSize ) };
+        return TestBoxBox ( BoxA, BoxB, Margin );
+    }
+
+    SHitResult TestBoxBox( const BoundingBox & BoxA, const BoundingBox & BoxB, float Margin )
+    {
+        // Separating axis test over the three world axes, the contact goes along the axis of least overlap
+        SHitResult OutHitResult;
+        const float MinsA [ 3 ] = { BoxA . min . x, BoxA . min . y, BoxA . min . z };
+        const float MaxsA [ 3 ] = { BoxA . max . x, BoxA . max . y, BoxA . max . z };
+        const float MinsB [ 3 ] = { BoxB . min . x, BoxB . min . y, BoxB . min . z };
+        const float MaxsB [ 3 ] = { BoxB . max . x, BoxB . max . y, BoxB . max . z };
+        float Middle [ 3 ];
+        float Penetration = 0.f;
+        int ContactAxis = -1;
+        float Sign = 1.f;
+        for ( int Axis = 0; Axis < 3; Axis++ )
         {
-            // Box-Box not implemented
-            SHitResult OutHitResult; 
-            OutHitResult.IsHit = false; 
-            return OutHitResult; 
+            const float Overlap = std::min ( MaxsA [ Axis ], MaxsB [ Axis ] ) - std::max ( MinsA [ Axis ], MinsB [ Axis ] );
+            if ( Overlap < -Margin )
+            {
+                return OutHitResult;
+            }
+            Middle [ Axis ] = ( std::max ( MinsA [ Axis ], MinsB [ Axis ] ) + std::min ( MaxsA [ Axis ], MaxsB [ Axis ] ) ) * 0.5f;
+            // Pushing A out toward the side its center lies on
+            const float CenterOffset = ( MinsA [ Axis ] + MaxsA [ Axis ] ) - ( MinsB [ Axis ] + MaxsB [ Axis ] );
+            if ( ContactAxis < 0 || Overlap < Penetration )
+            {
+                Penetration = Overlap;
+                ContactAxis = Axis;
+                Sign = CenterOffset < 0.f ? -1.f : 1.f;
+            }
         }
+        OutHitResult . IsHit = true;
+        OutHitResult . Penetration = Penetration;
+        OutHitResult . Normal = { ContactAxis == 0 ? Sign : 0.f, ContactAxis == 1 ? Sign : 0.f, ContactAxis == 2 ? Sign : 0.f };
+        OutHitResult . ContactPoint = { Middle [ 0 ], Middle [ 1 ], Middle [ 2 ] };
+        return OutHitResult;
     }
 
-    SHitResult TestSphereBox( const Vector3 SphereCenter, float SphereRadius, const BoundingBox & Box )
+    SHitResult TestSphereBox( const Vector3 SphereCenter, float SphereRadius, const BoundingBox & Box, float Margin )
     {
         SHitResult OutHitResult; 
         const Vector3 ClosestOnBox = PE::Math::ClosestPointOnBox( SphereCenter, Box );
         const float DistanceSquared = Vector3DistanceSqr( SphereCenter, ClosestOnBox );
-        const float RadiusSquared = SphereRadius * SphereRadius;
+        const float RadiusSquared = ( SphereRadius + Margin ) * ( SphereRadius + Margin );
         // No overlap (treat exact touching as a hit — only strictly greater means no collision)
         if ( DistanceSquared > RadiusSquared )
         {
@@ -91,14 +234,14 @@ namespace Collision
         return OutHitResult;
     }
 
-    SHitResult TestSphereSphere(const Vector3 &SphereCenterA, float SphereRadiusA, const Vector3 &SphereCenterB, float SphereRadiusB)
+    SHitResult TestSphereSphere(const Vector3 &SphereCenterA, float SphereRadiusA, const Vector3 &SphereCenterB, float SphereRadiusB, float Margin)
     {
    
         SHitResult OutHitResult; 
         const Vector3 Direction = Vector3Subtract( SphereCenterA, SphereCenterB );
         const float   DistanceSquared = Vector3DistanceSqr ( SphereCenterB, SphereCenterA );
         const float   RadiiSum = SphereRadiusA + SphereRadiusB;
-        const float   RadiiSumSquared = RadiiSum * RadiiSum;
+        const float   RadiiSumSquared = ( RadiiSum + Margin ) * ( RadiiSum + Margin );
 
         // No overlap (treat exact touching as a hit)
         if ( DistanceSquared > RadiiSumSquared)
@@ -128,5 +271,222 @@ namespace Collision
         return OutHitResult; 
     }
 
+    SSweepResult SweepSphereSphere( const Vector3 & StartA, const Vector3 & MotionA, float RadiusA,
+                                    const Vector3 & StartB, const Vector3 & MotionB, float RadiusB )
+    {
+        // | Offset + t * Motion | = RadiiSum, the smaller root of a * t^2 + 2 * b * t + c = 0
+        SSweepResult OutResult;
+        const Vector3 Offset = Vector3Subtract ( StartA, StartB );
+        const Vector3 Motion = Vector3Subtract ( MotionA, MotionB );
+        const float RadiiSum = RadiusA + RadiusB;
+        const float c = Vector3DotProduct ( Offset, Offset ) - RadiiSum * RadiiSum;
+        const float b = Vector3DotProduct ( Offset, Motion );
+        const float a = Vector3DotProduct ( Motion, Motion );
+        if ( c <= 0.f || b >= 0.f || a < PE::Math::GSmallNumber )
+        {
+            return OutResult;
+        }
+        const float Discriminant = b * b - a * c;
+        if ( Discriminant < 0.f )
+        {
+            return OutResult;
+        }
+        const float Time = ( -b - sqrtf ( Discriminant ) ) / a;
+        if ( Time > 1.f )
+        {
+            return OutResult;
+        }
+        OutResult . TimeOfImpact = std::max ( Time, 0.f );
+        OutResult . IsHit = true;
+        return OutResult;
+    }
+
+    SSweepResult SweepSphereBox( const Vector3 & Start, const Vector3 & Motion, float Radius, const BoundingBox & Box )
+    {
+        // Ray of the center against the box grown by the radius, slab by slab
+        SSweepResult OutResult;
+        const Vector3 ClosestOnBox = PE::Math::ClosestPointOnBox ( Start, Box );
+        if ( Vector3DistanceSqr ( Start, ClosestOnBox ) <= Radius * Radius )
+        {
+            return OutResult;
+        }
+        // The distance to a convex box only grows along a motion that doesn't start toward it
+        if ( Vector3DotProduct ( Motion, Vector3Subtract ( Start, ClosestOnBox ) ) >= 0.f )
+        {
+            return OutResult;
+        }
+        const float Starts [ 3 ] = { Start . x, Start . y, Start . z };
+        const float Motions [ 3 ] = { Motion . x, Motion . y, Motion . z };
+        const float Mins [ 3 ] = { Box . min . x - Radius, Box . min . y - Radius, Box . min . z - Radius };
+        const float Maxs [ 3 ] = { Box . max . x + Radius, Box . max . y + Radius, Box . max . z + Radius };
+        float Enter = 0.f;
+        float Exit = 1.f;
+        for ( int Axis = 0; Axis < 3; Axis++ )
+        {
+            if ( std::fabs ( Motions [ Axis ] ) < PE::Math::GSmallNumber )
+            {
+                if ( Starts [ Axis ] < Mins [ Axis ] || Starts [ Axis ] > Maxs [ Axis ] )
+                {
+                    return OutResult;
+                }
+                continue;
+            }
+            const float InverseMotion = 1.f / Motions [ Axis ];
+            float Near = ( Mins [ Axis ] - Starts [ Axis ] ) * InverseMotion;
+            float Far = ( Maxs [ Axis ] - Starts [ Axis ] ) * InverseMotion;
+            if ( Near > Far )
+            {
+                std::swap ( Near, Far );
+            }
+            Enter = std::max ( Enter, Near );
+            Exit = std::min ( Exit, Far );
+            if ( Enter > Exit )
+            {
+                return OutResult;
+            }
+        }
+        // Entering the grown box near an edge or corner may still be short of the rounded shape. Advance by the
+        // remaining gap: the distance to the box never shrinks faster than the motion, so this never overshoots.
+        const float MotionLength = Vector3Length ( Motion );
+        for ( int Iteration = 0; Iteration < GSweepRefinements; Iteration++ )
+        {
+            const Vector3 Center = Vector3Add ( Start, Vector3Scale ( Motion, Enter ) );
+            const float Gap = Vector3Distance ( Center, PE::Math::ClosestPointOnBox ( Center, Box ) ) - Radius;
+            if ( Gap <= GSweepTolerance * Radius )
+            {
+                break;
+            }
+            Enter += Gap / MotionLength;
+            if ( Enter > Exit )
+            {
+                return OutResult;
+            }
+        }
+        OutResult . TimeOfImpact = Enter;
+        OutResult . IsHit = true;
+        return OutResult;
+    }
+
+    SSweepResult SweepSphereInsideBox( const Vector3 & Start, const Vector3 & Motion, float Radius, const BoundingBox & Box )
+    {
+        // The center stays inside the box shrunk by the radius, the earliest wall it crosses wins
+        SSweepResult OutResult;
+        const float Starts [ 3 ] = { Start . x, Start . y, Start . z };
+        const float Motions [ 3 ] = { Motion . x, Motion . y, Motion . z };
+        const float Mins [ 3 ] = { Box . min . x + Radius, Box . min . y + Radius, Box . min . z + Radius };
+        const float Maxs [ 3 ] = { Box . max . x - Radius, Box . max . y - Radius, Box . max . z - Radius };
+        for ( int Axis = 0; Axis < 3; Axis++ )
+        {
+            const float End = Starts [ Axis ] + Motions [ Axis ];
+            float Time = 2.f;
+            if ( End > Maxs [ Axis ] && Starts [ Axis ] < Maxs [ Axis ] )
+            {
+                Time = ( Maxs [ Axis ] - Starts [ Axis ] ) / Motions [ Axis ];
+            }
+            else if ( End < Mins [ Axis ] && Starts [ Axis ] > Mins [ Axis ] )
+            {
+                Time = ( Mins [ Axis ] - Starts [ Axis ] ) / Motions [ Axis ];
+            }
+            if ( Time <= 1.f && ( ! OutResult . IsHit || Time < OutResult . TimeOfImpact ) )
+            {
+                OutResult . TimeOfImpact = Time;
+                OutResult . IsHit = true;
+            }
+        }
+        return OutResult;
+    }
+
+    SRayResult RayCastSphere( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, const Vector3 & Center, float Radius )
+    {
+        // | Offset + t * Direction | = Radius, the smaller root of t^2 + 2 * b * t + c = 0
+        SRayResult OutResult;
+        const Vector3 Offset = Vector3Subtract ( Origin, Center );
+        const float c = Vector3DotProduct ( Offset, Offset ) - Radius * Radius;
+        if ( c <= 0.f )
+        {
+            OutResult . Normal = Vector3Negate ( Direction );
+            OutResult . IsHit = true;
+            return OutResult;
+        }
+        const float b = Vector3DotProduct ( Offset, Direction );
+        const float Discriminant = b * b - c;
+        if ( b >= 0.f || Discriminant < 0.f )
+        {
+            return OutResult;
+        }
+        const float Distance = -b - sqrtf ( Discriminant );
+        if ( Distance > MaxDistance )
+        {
+            return OutResult;
+        }
+        OutResult . Distance = Distance;
+        OutResult . Normal = Vector3Normalize ( Vector3Add ( Offset, Vector3Scale ( Direction, Distance ) ) );
+        OutResult . IsHit = true;
+        return OutResult;
+    }
+
+    SRayResult RayCastBox( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, const BoundingBox & Box )
+    {
+        // Slab by slab, the face of the slab entered last is the one hit
+        SRayResult OutResult;
+        const float Origins [ 3 ] = { Origin . x, Origin . y, Origin . z };
+        const float Directions [ 3 ] = { Direction . x, Direction . y, Direction . z };
+        const float Mins [ 3 ] = { Box . min . x, Box . min . y, Box . min . z };
+        const float Maxs [ 3 ] = { Box . max . x, Box . max . y, Box . max . z };
+        float Enter = 0.f;
+        float Exit = MaxDistance;
+        int EnterAxis = -1;
+        float EnterSide = 0.f;
+        for ( int Axis = 0; Axis < 3; Axis++ )
+        {
+            if ( std::fabs ( Directions [ Axis ] ) < PE::Math::GSmallNumber )
+            {
+                if ( Origins [ Axis ] < Mins [ Axis ] || Origins [ Axis ] > Maxs [ Axis ] )
+                {
+                    return OutResult;
+                }
+                continue;
+            }
+            const float InverseDirection = 1.f / Directions [ Axis ];
+            float Near = ( Mins [ Axis ] - Origins [ Axis ] ) * InverseDirection;
+            float Far = ( Maxs [ Axis ] - Origins [ Axis ] ) * InverseDirection;
+            // Going down an axis the ray enters through the max face
+            float Side = -1.f;
+            if ( InverseDirection < 0.f )
+            {
+                std::swap ( Near, Far );
+                Side = 1.f;
+            }
+            if ( Near > Enter )
+            {
+                Enter = Near;
+                EnterAxis = Axis;
+                EnterSide = Side;
+            }
+            Exit = std::min ( Exit, Far );
+            if ( Enter > Exit )
+            {
+                return OutResult;
+            }
+        }
+        float Normal [ 3 ] = { 0.f, 0.f, 0.f };
+        if ( EnterAxis >= 0 )
+        {
+            Normal [ EnterAxis ] = EnterSide;
+        }
+        OutResult . Distance = Enter;
+        OutResult . Normal = EnterAxis >= 0 ? Vector3 { Normal [ 0 ], Normal [ 1 ], Normal [ 2 ] } : Vector3Negate ( Direction );
+        OutResult . IsHit = true;
+        return OutResult;
+    }
+
+    SRayResult RayCast( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, const SShape & Shape, const Vector3 & Position )
+    {
+        using FRayCast = SRayResult (*) ( const Vector3 &, const Vector3 &, float, const SShape &, const Vector3 & );
+        static constexpr std::array<FRayCast, GNumberOfShapeTypes> GRayCasts = MakeShapeTable<FRayCast> (
+            [] <EShapeType Type> () -> FRayCast { return &SShapeTraits<Type>::RayCast; } );
+        return GRayCasts [ static_cast<int> ( Shape . Type ) ] ( Origin, Direction, MaxDistance, Shape, Position );
+    }
+
 } // namespace Collision
 } // namespace PE
\ No newline at end of file
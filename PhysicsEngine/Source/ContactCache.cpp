@@ -0,0 +1,68 @@
+#include "ContactCache.hpp"
+#include "raymath.h"
+#include <algorithm>
+
+
+namespace PE
+{
+    uint64_t CContactCache::MakeKey( int HandleA, int HandleB, bool & IsFlipped )
+    {
+        IsFlipped = HandleA > HandleB;
+        const uint32_t Low = static_cast<uint32_t> ( IsFlipped ? HandleB : HandleA );
+        const uint32_t High = static_cast<uint32_t> ( IsFlipped ? HandleA : HandleB );
+        return ( static_cast<uint64_t> ( Low ) << 32 ) | High;
+    }
+
+    int CContactCache::Restore( const CBodyStorage & Bodies, std::vector<SContact> & Contacts ) const
+    {
+        int NumberOfMatches = 0;
+        for ( SContact & Contact : Contacts )
+        {
+            bool IsFlipped = false;
+            const uint64_t Key = MakeKey ( Bodies . GetHandle ( Contact . BodyA ), Bodies . GetHandle ( Contact . BodyB ), IsFlipped );
+            const auto It = std::lower_bound ( m_Entries . begin(), m_Entries . end(), Key,
+                                               [] ( const SEntry & Entry, uint64_t Value ) { return Entry . Key < Value; } );
+            if ( It == m_Entries . end() || It -> Key != Key )
+            {
+                Contact . NormalImpulse = 0.f;
+                Contact . TangentImpulse = { 0.f, 0.f, 0.f };
+                continue;
+            }
+            Contact . NormalImpulse = It -> NormalImpulse;
+            Contact . TangentImpulse = IsFlipped ? Vector3Negate ( It -> TangentImpulse ) : It -> TangentImpulse;
+            NumberOfMatches++;
+        }
+        return NumberOfMatches;
+    }
+
+    void CContactCache::Store( const CBodyStorage & Bodies, const std::vector<SContact> & Contacts )
+    {
+        m_ScratchEntries . clear();
+        m_ScratchEntries . reserve ( Contacts . size() );
+        for ( const SContact & Contact : Contacts )
+        {
+            if ( Contact . NormalImpulse <= 0.f )
+            {
+                continue;
+            }
+            bool IsFlipped = false;
+            SEntry Entry;
+            Entry . Key = MakeKey ( Bodies . GetHandle ( Contact . BodyA ), Bodies . GetHandle ( Contact . BodyB ), IsFlipped );
+            Entry . NormalImpulse = Contact . NormalImpulse;
+            Entry . TangentImpulse = IsFlipped ? Vector3Negate ( Contact . TangentImpulse ) : Contact . TangentImpulse;
+            m_ScratchEntries . push_back ( Entry );
+        }
+        // Contacts come sorted by dense index, which matches handle order unless bodies were reordered
+        if ( ! std::is_sorted ( m_ScratchEntries . begin(), m_ScratchEntries . end(), [] ( const SEntry & A, const SEntry & B ) { return A . Key < B . Key; } ) )
+        {
+            std::sort ( m_ScratchEntries . begin(), m_ScratchEntries . end(), [] ( const SEntry & A, const SEntry & B ) { return A . Key < B . Key; } );
+        }
+        m_Entries . swap ( m_ScratchEntries );
+    }
+
+    void CContactCache::Clear()
+    {
+        m_Entries . clear();
+        m_ScratchEntries . clear();
+    }
+} // namespace PE
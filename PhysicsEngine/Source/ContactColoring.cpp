@@ -0,0 +1,60 @@
+#include "ContactColoring.hpp"
+#include <algorithm>
+#include <bit>
+
+
+namespace PE
+{
+    int CContactColoring::Build( const CBodyStorage & Bodies, std::span<const SContact> Contacts )
+    {
+        const int NumberOfContacts = static_cast<int> ( Contacts . size() );
+        m_BodyColors . assign ( Bodies . Size(), 0 );
+        m_ContactColors . resize ( NumberOfContacts );
+        int NumberOfColors = 0;
+        // Contacts with a static body (world planes) are colored after all contacts between dynamic bodies, above every
+        // color their body already uses. Like in the sequential order, the planes get the last word in each iteration,
+        // otherwise later ball-ball corrections push deeply overlapping balls through them.
+        for ( const bool IsStaticPass : { false, true } )
+        {
+            for ( int i = 0; i < NumberOfContacts; i++ )
+            {
+                const int IndexA = Contacts [ i ] . BodyA;
+                const int IndexB = Contacts [ i ] . BodyB;
+                const bool IsDynamicA = ! Bodies . IsStatic ( IndexA );
+                const bool IsDynamicB = ! Bodies . IsStatic ( IndexB );
+                if ( ( IsDynamicA && IsDynamicB ) == IsStaticPass )
+                {
+                    continue;
+                }
+                const uint64_t UsedColors = ( IsDynamicA ? m_BodyColors [ IndexA ] : 0 ) | ( IsDynamicB ? m_BodyColors [ IndexB ] : 0 );
+                const int Color = IsStaticPass ? std::bit_width ( UsedColors ) : std::countr_one ( UsedColors );
+                if ( Color < GMaxColors )
+                {
+                    const uint64_t ColorBit = uint64_t { 1 } << Color;
+                    m_BodyColors [ IndexA ] |= IsDynamicA ? ColorBit : 0;
+                    m_BodyColors [ IndexB ] |= IsDynamicB ? ColorBit : 0;
+                }
+                m_ContactColors [ i ] = Color;
+                NumberOfColors = std::max ( NumberOfColors, Color + 1 );
+            }
+        }
+
+        // Counting sort of the contacts by color, stable so every color keeps the contact list order
+        m_ColorStarts . assign ( NumberOfColors + 1, 0 );
+        for ( const int Color : m_ContactColors )
+        {
+            m_ColorStarts [ Color + 1 ]++;
+        }
+        for ( int Color = 0; Color < NumberOfColors; Color++ )
+        {
+            m_ColorStarts [ Color + 1 ] += m_ColorStarts [ Color ];
+        }
+        m_ColorContacts . resize ( NumberOfContacts );
+        m_Cursors . assign ( m_ColorStarts . begin(), m_ColorStarts . end() - 1 );
+        for ( int i = 0; i < NumberOfContacts; i++ )
+        {
+            m_ColorContacts [ m_Cursors [ m_ContactColors [ i ] ]++ ] = i;
+        }
+        return NumberOfColors;
+    }
+} // namespace PE
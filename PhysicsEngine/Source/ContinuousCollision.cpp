@@ -0,0 +1,107 @@
+#include "ContinuousCollision.hpp"
+#include "Collision.hpp"
+#include "raymath.h"
+#include <algorithm>
+
+namespace PE
+{
+namespace
+{
+    BoundingBox GetSweptBounds ( const BoundingBox & StartBounds, const BoundingBox & EndBounds )
+    {
+        return { .min = Vector3Min ( StartBounds . min, EndBounds . min ), .max = Vector3Max ( StartBounds . max, EndBounds . max ) };
+    }
+
+    bool Overlap ( const BoundingBox & A, const BoundingBox & B )
+    {
+        return A . min . x <= B . max . x && A . max . x >= B . min . x &&
+               A . min . y <= B . max . y && A . max . y >= B . min . y &&
+               A . min . z <= B . max . z && A . max . z >= B . min . z;
+    }
+} // namespace
+
+    int CContinuousCollision::Apply( CBodyStorage & Bodies, float DeltaTime, float MotionThreshold, const BoundingBox * WorldBox )
+    {
+        m_Sweeps . clear();
+        const int NumberOfBodies = Bodies . Size();
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            // Only spheres move fast enough to tunnel, every shape is swept against
+            if ( ! Bodies . IsAwake ( i ) || Bodies . Shapes [ i ] . Type != EShapeType::Sphere )
+            {
+                continue;
+            }
+            const Vector3 Motion = Vector3Scale ( Bodies . LinearVelocities . Get ( i ), DeltaTime );
+            const float Radius = Bodies . Radii [ i ];
+            const float Limit = MotionThreshold * Radius;
+            if ( Vector3LengthSqr ( Motion ) <= Limit * Limit )
+            {
+                continue;
+            }
+            const Vector3 End = Bodies . Positions . Get ( i );
+            const Vector3 Start = Vector3Subtract ( End, Motion );
+            const SShape & Shape = Bodies . Shapes [ i ];
+            m_Sweeps . push_back ( { .Bounds = GetSweptBounds ( Collision::GetBoundingBox ( Shape, Start ), Collision::GetBoundingBox ( Shape, End ) ), .Start = Start, .Motion = Motion,
+                                     .Radius = Radius, .TimeOfImpact = 1.f, .Body = i } );
+        }
+        if ( m_Sweeps . empty() )
+        {
+            return 0;
+        }
+
+        // Sweep and prune along x: a body can only reach sweeps starting less than the widest sweep before it
+        std::sort ( m_Sweeps . begin(), m_Sweeps . end(), [] ( const SSweep & A, const SSweep & B ) { return A . Bounds . min . x < B . Bounds . min . x; } );
+        float MaxWidth = 0.f;
+        for ( const SSweep & Sweep : m_Sweeps )
+        {
+            MaxWidth = std::max ( MaxWidth, Sweep . Bounds . max . x - Sweep . Bounds . min . x );
+        }
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            // The world walls are swept against analytically below
+            if ( Bodies . IsWorldBoundary ( i ) )
+            {
+                continue;
+            }
+            const SShape & Shape = Bodies . Shapes [ i ];
+            const Vector3 End = Bodies . Positions . Get ( i );
+            const Vector3 Motion = Bodies . IsAwake ( i ) ? Vector3Scale ( Bodies . LinearVelocities . Get ( i ), DeltaTime ) : Vector3 { 0.f, 0.f, 0.f };
+            const Vector3 Start = Vector3Subtract ( End, Motion );
+            const BoundingBox Bounds = GetSweptBounds ( Collision::GetBoundingBox ( Shape, Start ), Collision::GetBoundingBox ( Shape, End ) );
+            auto Sweep = std::lower_bound ( m_Sweeps . begin(), m_Sweeps . end(), Bounds . min . x - MaxWidth,
+                                            [] ( const SSweep & Sweep, float X ) { return Sweep . Bounds . min . x < X; } );
+            for ( ; Sweep != m_Sweeps . end() && Sweep -> Bounds . min . x <= Bounds . max . x; ++Sweep )
+            {
+                if ( Sweep -> Body == i || ! Overlap ( Sweep -> Bounds, Bounds ) )
+                {
+                    continue;
+                }
+                // Swept in the frame of the body at its start, the sphere takes the relative motion
+                const Collision::SSweepResult Hit = Collision::SweepSphere ( Sweep -> Start, Vector3Subtract ( Sweep -> Motion, Motion ), Sweep -> Radius, Shape, Start );
+                if ( Hit . IsHit )
+                {
+                    Sweep -> TimeOfImpact = std::min ( Sweep -> TimeOfImpact, Hit . TimeOfImpact );
+                }
+            }
+        }
+
+        int NumberOfClampedBodies = 0;
+        for ( SSweep & Sweep : m_Sweeps )
+        {
+            if ( WorldBox )
+            {
+                const Collision::SSweepResult Hit = Collision::SweepSphereInsideBox ( Sweep . Start, Sweep . Motion, Sweep . Radius, *WorldBox );
+                if ( Hit . IsHit )
+                {
+                    Sweep . TimeOfImpact = std::min ( Sweep . TimeOfImpact, Hit . TimeOfImpact );
+                }
+            }
+            if ( Sweep . TimeOfImpact < 1.f )
+            {
+                Bodies . Positions . Set ( Sweep . Body, Vector3Add ( Sweep . Start, Vector3Scale ( Sweep . Motion, Sweep . TimeOfImpact ) ) );
+                NumberOfClampedBodies++;
+            }
+        }
+        return NumberOfClampedBodies;
+    }
+} // namespace PE
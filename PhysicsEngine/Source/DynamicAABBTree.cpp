@@ -0,0 +1,510 @@
+#include "DynamicAABBTree.hpp"
+#include "Collision.hpp"
+#include "Math.hpp"
+#include "raymath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace PE
+{
+namespace
+{
+    BoundingBox Union ( const BoundingBox & BoxA, const BoundingBox & BoxB )
+    {
+        return { Vector3Min ( BoxA . min, BoxB . min ), Vector3Max ( BoxA . max, BoxB . max ) };
+    }
+
+    float SurfaceArea ( const BoundingBox & Box )
+    {
+        const Vector3 Size = PE::Math::BoxSize ( Box );
+        return 2.f * ( Size . x * Size . y + Size . y * Size . z + Size . z * Size . x );
+    }
+
+    bool Contains ( const BoundingBox & Outer, const BoundingBox & Inner )
+    {
+        return Outer . min . x <= Inner . min . x && Outer . min . y <= Inner . min . y && Outer . min . z <= Inner . min . z &&
+               Outer . max . x >= Inner . max . x && Outer . max . y >= Inner . max . y && Outer . max . z >= Inner . max . z;
+    }
+} // namespace
+
+    int CDynamicAABBTree::AllocateNode()
+    {
+        if ( m_FreeList == GNullNode )
+        {
+            m_Nodes . push_back ( SNode {} );
+            return static_cast<int> ( m_Nodes . size() ) - 1;
+        }
+        const int Node = m_FreeList;
+        m_FreeList = m_Nodes [ Node ] . Parent;
+        m_Nodes [ Node ] = SNode {};
+        return Node;
+    }
+
+    void CDynamicAABBTree::FreeNode( int Node )
+    {
+        m_Nodes [ Node ] . Parent = m_FreeList;
+        m_Nodes [ Node ] . Height = -1;
+        m_FreeList = Node;
+    }
+
+    int CDynamicAABBTree::CreateProxy( const BoundingBox & TightBox, float Margin, int UserData )
+    {
+        const int Proxy = AllocateNode();
+        m_Nodes [ Proxy ] . Box = PE::Math::ExpandBox ( TightBox, Margin );
+        m_Nodes [ Proxy ] . UserData = UserData;
+        m_Nodes [ Proxy ] . Height = 0;
+        InsertLeaf ( Proxy );
+        m_NumberOfProxies++;
+        return Proxy;
+    }
+
+    void CDynamicAABBTree::DestroyProxy( int Proxy )
+    {
+        RemoveLeaf ( Proxy );
+        FreeNode ( Proxy );
+        m_NumberOfProxies--;
+    }
+
+    bool CDynamicAABBTree::MoveProxy( int Proxy, const BoundingBox & TightBox, float Margin )
+    {
+        if ( Contains ( m_Nodes [ Proxy ] . Box, TightBox ) )
+        {
+            return false;
+        }
+        RemoveLeaf ( Proxy );
+        m_Nodes [ Proxy ] . Box = PE::Math::ExpandBox ( TightBox, Margin );
+        InsertLeaf ( Proxy );
+        return true;
+    }
+
+    void CDynamicAABBTree::Clear()
+    {
+        m_Nodes . clear();
+        m_Root = GNullNode;
+        m_FreeList = GNullNode;
+        m_NumberOfProxies = 0;
+    }
+
+    void CDynamicAABBTree::InsertLeaf( int Leaf )
+    {
+        if ( m_Root == GNullNode )
+        {
+            m_Root = Leaf;
+            m_Nodes [ Leaf ] . Parent = GNullNode;
+            return;
+        }
+
+        // Descend towards the sibling with the cheapest surface area growth
+        const BoundingBox LeafBox = m_Nodes [ Leaf ] . Box;
+        int Index = m_Root;
+        while ( ! m_Nodes [ Index ] . IsLeaf () )
+        {
+            const SNode & Node = m_Nodes [ Index ];
+            const float Area = SurfaceArea ( Node . Box );
+            const float CombinedArea = SurfaceArea ( Union ( Node . Box, LeafBox ) );
+
+            // Cost of making a new parent for this node and the leaf
+            const float Cost = 2.f * CombinedArea;
+            // Minimum cost of pushing the leaf further down
+            const float InheritanceCost = 2.f * ( CombinedArea - Area );
+
+            auto ChildCost = [ & ] ( int Child )
+            {
+                const SNode & ChildNode = m_Nodes [ Child ];
+                const float NewArea = SurfaceArea ( Union ( LeafBox, ChildNode . Box ) );
+                return ( ChildNode . IsLeaf () ? NewArea : NewArea - SurfaceArea ( ChildNode . Box ) ) + InheritanceCost;
+            };
+            const float Cost1 = ChildCost ( Node . Child1 );
+            const float Cost2 = ChildCost ( Node . Child2 );
+
+            if ( Cost < Cost1 && Cost < Cost2 )
+            {
+                break;
+            }
+            Index = Cost1 < Cost2 ? Node . Child1 : Node . Child2;
+        }
+
+        // New parent joins the sibling and the leaf
+        const int Sibling = Index;
+        const int OldParent = m_Nodes [ Sibling ] . Parent;
+        const int NewParent = AllocateNode();
+        m_Nodes [ NewParent ] . Parent = OldParent;
+        m_Nodes [ NewParent ] . Box = Union ( LeafBox, m_Nodes [ Sibling ] . Box );
+        m_Nodes [ NewParent ] . Height = m_Nodes [ Sibling ] . Height + 1;
+        m_Nodes [ NewParent ] . Child1 = Sibling;
+        m_Nodes [ NewParent ] . Child2 = Leaf;
+        m_Nodes [ Sibling ] . Parent = NewParent;
+        m_Nodes [ Leaf ] . Parent = NewParent;
+
+        if ( OldParent == GNullNode )
+        {
+            m_Root = NewParent;
+        }
+        else if ( m_Nodes [ OldParent ] . Child1 == Sibling )
+        {
+            m_Nodes [ OldParent ] . Child1 = NewParent;
+        }
+        else
+        {
+            m_Nodes [ OldParent ] . Child2 = NewParent;
+        }
+
+        RefitUpwards ( m_Nodes [ Leaf ] . Parent );
+    }
+
+    void CDynamicAABBTree::RemoveLeaf( int Leaf )
+    {
+        if ( Leaf == m_Root )
+        {
+            m_Root = GNullNode;
+            return;
+        }
+
+        const int Parent = m_Nodes [ Leaf ] . Parent;
+        const int GrandParent = m_Nodes [ Parent ] . Parent;
+        const int Sibling = m_Nodes [ Parent ] . Child1 == Leaf ? m_Nodes [ Parent ] . Child2 : m_Nodes [ Parent ] . Child1;
+
+        if ( GrandParent == GNullNode )
+        {
+            m_Root = Sibling;
+            m_Nodes [ Sibling ] . Parent = GNullNode;
+            FreeNode ( Parent );
+            return;
+        }
+
+        // Sibling takes the parent's place
+        if ( m_Nodes [ GrandParent ] . Child1 == Parent )
+        {
+            m_Nodes [ GrandParent ] . Child1 = Sibling;
+        }
+        else
+        {
+            m_Nodes [ GrandParent ] . Child2 = Sibling;
+        }
+        m_Nodes [ Sibling ] . Parent = GrandParent;
+        FreeNode ( Parent );
+
+        RefitUpwards ( GrandParent );
+    }
+
+    void CDynamicAABBTree::RefitUpwards( int Node )
+    {
+        int Index = Node;
+        while ( Index != GNullNode )
+        {
+            Index = Balance ( Index );
+            SNode & Current = m_Nodes [ Index ];
+            const SNode & Child1 = m_Nodes [ Current . Child1 ];
+            const SNode & Child2 = m_Nodes [ Current . Child2 ];
+            Current . Height = 1 + std::max ( Child1 . Height, Child2 . Height );
+            Current . Box = Union ( Child1 . Box, Child2 . Box );
+            Index = Current . Parent;
+        }
+    }
+
+    int CDynamicAABBTree::Balance( int IndexA )
+    {
+        SNode & A = m_Nodes [ IndexA ];
+        if ( A . IsLeaf () || A . Height < 2 )
+        {
+            return IndexA;
+        }
+
+        const int IndexB = A . Child1;
+        const int IndexC = A . Child2;
+        SNode & B = m_Nodes [ IndexB ];
+        SNode & C = m_Nodes [ IndexC ];
+        const int BalanceFactor = C . Height - B . Height;
+
+        auto ReplaceInParent = [ & ] ( int OldChild, int NewChild, int Parent )
+        {
+            if ( Parent == GNullNode )
+            {
+                m_Root = NewChild;
+            }
+            else if ( m_Nodes [ Parent ] . Child1 == OldChild )
+            {
+                m_Nodes [ Parent ] . Child1 = NewChild;
+            }
+            else
+            {
+                m_Nodes [ Parent ] . Child2 = NewChild;
+            }
+        };
+
+        // Rotate C up
+        if ( BalanceFactor > 1 )
+        {
+            const int IndexF = C . Child1;
+            const int IndexG = C . Child2;
+            SNode & F = m_Nodes [ IndexF ];
+            SNode & G = m_Nodes [ IndexG ];
+
+            C . Child1 = IndexA;
+            C . Parent = A . Parent;
+            A . Parent = IndexC;
+            ReplaceInParent ( IndexA, IndexC, C . Parent );
+
+            if ( F . Height > G . Height )
+            {
+                C . Child2 = IndexF;
+                A . Child2 = IndexG;
+                G . Parent = IndexA;
+                A . Box = Union ( B . Box, G . Box );
+                C . Box = Union ( A . Box, F . Box );
+                A . Height = 1 + std::max ( B . Height, G . Height );
+                C . Height = 1 + std::max ( A . Height, F . Height );
+            }
+            else
+            {
+                C . Child2 = IndexG;
+                A . Child2 = IndexF;
+                F . Parent = IndexA;
+                A . Box = Union ( B . Box, F . Box );
+                C . Box = Union ( A . Box, G . Box );
+                A . Height = 1 + std::max ( B . Height, F . Height );
+                C . Height = 1 + std::max ( A . Height, G . Height );
+            }
+            return IndexC;
+        }
+
+        // Rotate B up
+        if ( BalanceFactor < -1 )
+        {
+            const int IndexD = B . Child1;
+            const int IndexE = B . Child2;
+            SNode & D = m_Nodes [ IndexD ];
+            SNode & E = m_Nodes [ IndexE ];
+
+            B . Child1 = IndexA;
+            B . Parent = A . Parent;
+            A . Parent = IndexB;
+            ReplaceInParent ( IndexA, IndexB, B . Parent );
+
+            if ( D . Height > E . Height )
+            {
+                B . Child2 = IndexD;
+                A . Child1 = IndexE;
+                E . Parent = IndexA;
+                A . Box = Union ( C . Box, E . Box );
+                B . Box = Union ( A . Box, D . Box );
+                A . Height = 1 + std::max ( C . Height, E . Height );
+                B . Height = 1 + std::max ( A . Height, D . Height );
+            }
+            else
+            {
+                B . Child2 = IndexE;
+                A . Child1 = IndexD;
+                D . Parent = IndexA;
+                A . Box = Union ( C . Box, D . Box );
+                B . Box = Union ( A . Box, E . Box );
+                A . Height = 1 + std::max ( C . Height, D . Height );
+                B . Height = 1 + std::max ( A . Height, E . Height );
+            }
+            return IndexB;
+        }
+
+        return IndexA;
+    }
+
+    bool CDynamicAABBTree::Validate() const
+    {
+        if ( m_Root == GNullNode )
+        {
+            return m_NumberOfProxies == 0;
+        }
+        return m_Nodes [ m_Root ] . Parent == GNullNode && ValidateNode ( m_Root );
+    }
+
+    bool CDynamicAABBTree::ValidateNode( int Node ) const
+    {
+        const SNode & Current = m_Nodes [ Node ];
+        if ( Current . IsLeaf () )
+        {
+            return Current . Height == 0;
+        }
+        const SNode & Child1 = m_Nodes [ Current . Child1 ];
+        const SNode & Child2 = m_Nodes [ Current . Child2 ];
+        const bool IsValid = Child1 . Parent == Node && Child2 . Parent == Node &&
+                             Current . Height == 1 + std::max ( Child1 . Height, Child2 . Height ) &&
+                             Contains ( Current . Box, Child1 . Box ) && Contains ( Current . Box, Child2 . Box );
+        return IsValid && ValidateNode ( Current . Child1 ) && ValidateNode ( Current . Child2 );
+    }
+
+    CAABBTreeBroadphase::CAABBTreeBroadphase( float Margin )
+        : m_Margin ( Margin > 0.f ? Margin : 0.f )
+    {
+    }
+
+    void CAABBTreeBroadphase::Update( const CBodyStorage & Bodies )
+    {
+        m_NumberOfReinsertedProxies = 0;
+        const int NumberOfBodies = Bodies . Size();
+        if ( NumberOfBodies < static_cast<int> ( m_Proxies . size() ) )
+        {
+            Clear();
+        }
+        // Bodies added since the last Update are appended at the end of the storage
+        const int NumberOfKnownBodies = static_cast<int> ( m_Proxies . size() );
+        m_Proxies . resize ( NumberOfBodies );
+        m_IsStatic . resize ( NumberOfBodies );
+        m_IsSleeping . resize ( NumberOfBodies );
+        for ( int i = NumberOfKnownBodies; i < NumberOfBodies; i++ )
+        {
+            CreateBodyProxy ( Bodies, i, i );
+        }
+
+        for ( int i = 0; i < NumberOfKnownBodies; i++ )
+        {
+            m_IsSleeping [ i ] = Bodies . IsSleeping ( i ) ? 1 : 0;
+            if ( m_Proxies [ i ] == CDynamicAABBTree::GNullNode )
+            {
+                continue;
+            }
+            const BoundingBox TightBox = PE::Collision::GetBoundingBox ( Bodies . Shapes [ i ], Bodies . Positions . Get ( i ) );
+            const uint8_t IsStatic = Bodies . IsStatic ( i ) ? 1 : 0;
+            if ( IsStatic != m_IsStatic [ i ] )
+            {
+                // Body switched trees
+                ( m_IsStatic [ i ] ? m_StaticTree : m_DynamicTree ) . DestroyProxy ( m_Proxies [ i ] );
+                m_IsStatic [ i ] = IsStatic;
+                m_Proxies [ i ] = ( IsStatic ? m_StaticTree : m_DynamicTree ) . CreateProxy ( TightBox, m_Margin, i );
+                m_NumberOfReinsertedProxies++;
+                continue;
+            }
+            CDynamicAABBTree & Tree = IsStatic ? m_StaticTree : m_DynamicTree;
+            if ( Tree . MoveProxy ( m_Proxies [ i ], TightBox, m_Margin ) )
+            {
+                m_NumberOfReinsertedProxies++;
+            }
+        }
+    }
+
+    void CAABBTreeBroadphase::FindPairs( std::vector<SBroadphasePair> & OutPairs ) const
+    {
+        const size_t FirstPair = OutPairs . size();
+        const int NumberOfBodies = static_cast<int> ( m_Proxies . size() );
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            // Sleeping bodies are only found by the awake bodies touching them
+            if ( m_IsStatic [ i ] || m_IsSleeping [ i ] )
+            {
+                continue;
+            }
+            const BoundingBox & FatBox = m_DynamicTree . GetFatBox ( m_Proxies [ i ] );
+            // Awake-awake pairs are reported from the lower index, awake-sleeping pairs from the awake body
+            m_DynamicTree . Query ( FatBox, [ & ] ( int Other )
+            {
+                if ( Other > i || ( Other != i && m_IsSleeping [ Other ] ) )
+                {
+                    OutPairs . push_back ( { std::min ( i, Other ), std::max ( i, Other ) } );
+                }
+            } );
+            m_StaticTree . Query ( FatBox, [ & ] ( int Other )
+            {
+                OutPairs . push_back ( { std::min ( i, Other ), std::max ( i, Other ) } );
+            } );
+        }
+        SortPairs ( OutPairs . begin() + FirstPair, OutPairs . end() );
+    }
+
+    void CAABBTreeBroadphase::RemapBodies( std::span<const int> NewToOld )
+    {
+        if ( NewToOld . size() != m_Proxies . size() )
+        {
+            // Not built for these bodies, the next Update rebuilds anyway
+            return;
+        }
+        std::vector<int> Proxies ( m_Proxies . size() );
+        std::vector<uint8_t> IsStatic ( m_IsStatic . size() );
+        std::vector<uint8_t> IsSleeping ( m_IsSleeping . size() );
+        for ( size_t i = 0; i < NewToOld . size(); i++ )
+        {
+            const int Old = NewToOld [ i ];
+            Proxies [ i ] = m_Proxies [ Old ];
+            IsStatic [ i ] = m_IsStatic [ Old ];
+            IsSleeping [ i ] = m_IsSleeping [ Old ];
+            if ( Proxies [ i ] != CDynamicAABBTree::GNullNode )
+            {
+                ( IsStatic [ i ] ? m_StaticTree : m_DynamicTree ) . SetUserData ( Proxies [ i ], static_cast<int> ( i ) );
+            }
+        }
+        m_Proxies . swap ( Proxies );
+        m_IsStatic . swap ( IsStatic );
+        m_IsSleeping . swap ( IsSleeping );
+    }
+
+    void CAABBTreeBroadphase::CreateBodyProxy( const CBodyStorage & Bodies, int Body, int Index )
+    {
+        m_IsSleeping [ Index ] = Bodies . IsSleeping ( Body ) ? 1 : 0;
+        m_IsStatic [ Index ] = Bodies . IsStatic ( Body ) ? 1 : 0;
+        if ( Bodies . IsWorldBoundary ( Body ) )
+        {
+            // Collided by the world boundary stage, in neither tree
+            m_Proxies [ Index ] = CDynamicAABBTree::GNullNode;
+            return;
+        }
+        const BoundingBox TightBox = PE::Collision::GetBoundingBox ( Bodies . Shapes [ Body ], Bodies . Positions . Get ( Body ) );
+        CDynamicAABBTree & Tree = m_IsStatic [ Index ] ? m_StaticTree : m_DynamicTree;
+        m_Proxies [ Index ] = Tree . CreateProxy ( TightBox, m_Margin, Index );
+    }
+
+    void CAABBTreeBroadphase::RemoveBody( const CBodyStorage & Bodies, int Index )
+    {
+        const int NumberOfProxies = static_cast<int> ( m_Proxies . size() );
+        if ( Index >= NumberOfProxies )
+        {
+            // Added after the last Update, never got a proxy
+            return;
+        }
+        if ( m_Proxies [ Index ] != CDynamicAABBTree::GNullNode )
+        {
+            ( m_IsStatic [ Index ] ? m_StaticTree : m_DynamicTree ) . DestroyProxy ( m_Proxies [ Index ] );
+        }
+        const int Last = Bodies . Size() - 1;
+        if ( Last >= NumberOfProxies )
+        {
+            // The last body was added after the last Update, it gets its proxy right away at its new index
+            CreateBodyProxy ( Bodies, Last, Index );
+            return;
+        }
+        m_Proxies [ Index ] = m_Proxies [ Last ];
+        m_IsStatic [ Index ] = m_IsStatic [ Last ];
+        m_IsSleeping [ Index ] = m_IsSleeping [ Last ];
+        if ( Index != Last && m_Proxies [ Index ] != CDynamicAABBTree::GNullNode )
+        {
+            ( m_IsStatic [ Index ] ? m_StaticTree : m_DynamicTree ) . SetUserData ( m_Proxies [ Index ], Index );
+        }
+        m_Proxies . pop_back();
+        m_IsStatic . pop_back();
+        m_IsSleeping . pop_back();
+    }
+
+    void CAABBTreeBroadphase::QueryBox( const BoundingBox & Box, CBroadphaseBoxCallback & Callback ) const
+    {
+        const auto Report = [ & ] ( int Index ) { Callback . ReportBody ( Index ); };
+        m_DynamicTree . Query ( Box, Report );
+        m_StaticTree . Query ( Box, Report );
+    }
+
+    void CAABBTreeBroadphase::QueryRay( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, CBroadphaseRayCallback & Callback ) const
+    {
+        const Vector3 InvDirection { 1.f / Direction . x, 1.f / Direction . y, 1.f / Direction . z };
+        const auto Report = [ & ] ( int Index ) { return Callback . ReportBody ( Index ); };
+        const float Reach = m_DynamicTree . RayCast ( Origin, InvDirection, MaxDistance, Report );
+        if ( Reach >= 0.f )
+        {
+            m_StaticTree . RayCast ( Origin, InvDirection, Reach, Report );
+        }
+    }
+
+    void CAABBTreeBroadphase::Clear()
+    {
+        m_DynamicTree . Clear();
+        m_StaticTree . Clear();
+        m_Proxies . clear();
+        m_IsStatic . clear();
+        m_IsSleeping . clear();
+        m_NumberOfReinsertedProxies = 0;
+    }
+} // namespace PE
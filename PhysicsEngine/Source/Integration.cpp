@@ -0,0 +1,130 @@
+#include "Integration.hpp"
+#include "IntegrationKernel.hpp"
+#include "Math.hpp"
+#include "Simd.hpp"
+#include "raymath.h"
+#include <cmath>
+#include <vector>
+
+
+namespace PE
+{
+namespace Integration
+{
+namespace
+{
+    float DampingFactor( float Damping, float DeltaTime )
+    {
+        return Damping > 0.f ? expf( -Damping * DeltaTime ) : 1.f;
+    }
+} // namespace
+
+    void IntegrateBody( CBodyStorage & Bodies, int Index, float DeltaTime, const Vector3 & DeltaGravity,
+                        float LinearDampingFactor, float AngularDampingFactor )
+    {
+        if ( ! Bodies . IsAwake ( Index ) )
+        {
+            return;
+        }
+        // Apply gravity and linear damping (exponential decay) so velocity reduces over time
+        Vector3 LinearVelocity = Vector3Add( Bodies . LinearVelocities . Get ( Index ), DeltaGravity );
+        LinearVelocity = Vector3Scale( LinearVelocity, LinearDampingFactor );
+        Bodies . LinearVelocities . Set ( Index, LinearVelocity );
+
+        // Update position from linear velocity
+        Bodies . Positions . Set ( Index, Vector3Add( Bodies . Positions . Get ( Index ), Vector3Scale( LinearVelocity, DeltaTime ) ) );
+
+        // Update rotation quaternion from angular velocity (axis-angle)
+        const Vector3 AngularVelocity = Bodies . AngularVelocities . Get ( Index );
+        const float Omega = Vector3Length( AngularVelocity );
+        if ( Omega > PE::Math::GKindaSmallNumber )
+        {
+            const Vector3 Axis = Vector3Scale( AngularVelocity, 1.0f / Omega );
+            const float Angle = Omega * DeltaTime;
+            const Quaternion DeltaRotation = QuaternionFromAxisAngle( Axis, Angle );
+            const Quaternion Rotation = QuaternionMultiply( DeltaRotation, Bodies . Rotations . Get ( Index ) );
+            Bodies . Rotations . Set ( Index, QuaternionNormalize( Rotation ) );
+        }
+
+        // Apply angular damping (exponential decay) so spin reduces over time
+        Bodies . AngularVelocities . Set ( Index, Vector3Scale( AngularVelocity, AngularDampingFactor ) );
+    }
+
+    void ComputeDampingFactors( const CBodyStorage & Bodies, float DeltaTime,
+                                std::vector<float> & OutLinearDampingFactors, std::vector<float> & OutAngularDampingFactors )
+    {
+        // Damping factors depend only on the material, so exp() runs once per material instead of once per body
+        const int NumberOfMaterials = Bodies . GetNumberOfMaterials();
+        OutLinearDampingFactors . resize ( NumberOfMaterials );
+        OutAngularDampingFactors . resize ( NumberOfMaterials );
+        for ( int m = 0; m < NumberOfMaterials; m++ )
+        {
+            OutLinearDampingFactors [ m ] = DampingFactor ( Bodies . GetMaterial ( m ) . LinearDamping, DeltaTime );
+            OutAngularDampingFactors [ m ] = DampingFactor ( Bodies . GetMaterial ( m ) . AngularDamping, DeltaTime );
+        }
+    }
+
+    void Integrate( CBodyStorage & Bodies, float DeltaTime, const Vector3 & Gravity, ESimdLevel SimdLevel )
+    {
+        std::vector<float> LinearDampingFactors;
+        std::vector<float> AngularDampingFactors;
+        ComputeDampingFactors ( Bodies, DeltaTime, LinearDampingFactors, AngularDampingFactors );
+        Integrate ( Bodies, 0, Bodies . Size(), DeltaTime, Gravity, LinearDampingFactors, AngularDampingFactors, SimdLevel );
+    }
+
+    void Integrate( CBodyStorage & Bodies, int Begin, int End, float DeltaTime, const Vector3 & Gravity,
+                    std::span<const float> LinearDampingFactors, std::span<const float> AngularDampingFactors, ESimdLevel SimdLevel )
+    {
+        const Vector3 DeltaGravity = Vector3Scale( Gravity, DeltaTime );
+
+        int Processed = Begin;
+        const ESimdLevel Level = Simd::ResolveLevel ( SimdLevel );
+        if ( Level != ESimdLevel::Scalar && End > Begin )
+        {
+            const SIntegrationBatch Batch {
+                .PositionX = Bodies . Positions . X . data(),
+                .PositionY = Bodies . Positions . Y . data(),
+                .PositionZ = Bodies . Positions . Z . data(),
+                .LinearVelocityX = Bodies . LinearVelocities . X . data(),
+                .LinearVelocityY = Bodies . LinearVelocities . Y . data(),
+                .LinearVelocityZ = Bodies . LinearVelocities . Z . data(),
+                .AngularVelocityX = Bodies . AngularVelocities . X . data(),
+                .AngularVelocityY = Bodies . AngularVelocities . Y . data(),
+                .AngularVelocityZ = Bodies . AngularVelocities . Z . data(),
+                .RotationX = Bodies . Rotations . X . data(),
+                .RotationY = Bodies . Rotations . Y . data(),
+                .RotationZ = Bodies . Rotations . Z . data(),
+                .RotationW = Bodies . Rotations . W . data(),
+                .MaterialIndices = Bodies . MaterialIndices . data(),
+                .Flags = Bodies . Flags . data(),
+                .LinearDampingFactors = LinearDampingFactors . data(),
+                .AngularDampingFactors = AngularDampingFactors . data(),
+                .DeltaTime = DeltaTime,
+                .DeltaGravityX = DeltaGravity . x,
+                .DeltaGravityY = DeltaGravity . y,
+                .DeltaGravityZ = DeltaGravity . z,
+                .AngularEpsilon = PE::Math::GKindaSmallNumber,
+                .SkipFlags = CBodyStorage::GPassiveFlags,
+            };
+            if ( Level == ESimdLevel::AVX2 && HasAVX2Kernel() )
+            {
+                const int BatchEnd = End - ( End - Begin ) % 8;
+                IntegrateBatchAVX2 ( Batch, Begin, BatchEnd );
+                Processed = BatchEnd;
+            }
+#if defined(PE_SIMD_SSE2)
+            const int BatchEnd = End - ( End - Processed ) % Simd::SFloat4::Width;
+            IntegrateBatch<Simd::SFloat4> ( Batch, Processed, BatchEnd );
+            Processed = BatchEnd;
+#endif
+        }
+
+        // Scalar remainder (or everything when SIMD is disabled)
+        for ( int i = Processed; i < End; i++ )
+        {
+            const int MaterialIndex = Bodies . MaterialIndices [ i ];
+            IntegrateBody ( Bodies, i, DeltaTime, DeltaGravity, LinearDampingFactors [ MaterialIndex ], AngularDampingFactors [ MaterialIndex ] );
+        }
+    }
+} // namespace Integration
+} // namespace PE
@@ -0,0 +1,30 @@
+// Compiled with AVX2 + FMA enabled (see CMakeLists.txt). Only called after runtime CPU detection.
+#include "IntegrationKernel.hpp"
+
+
+namespace PE
+{
+namespace Integration
+{
+#if defined(PE_SIMD_AVX2)
+    void IntegrateBatchAVX2( const SIntegrationBatch & Batch, int Begin, int End )
+    {
+        IntegrateBatch<Simd::SFloat8> ( Batch, Begin, End );
+    }
+
+    bool HasAVX2Kernel()
+    {
+        return true;
+    }
+#else
+    void IntegrateBatchAVX2( const SIntegrationBatch &, int, int )
+    {
+    }
+
+    bool HasAVX2Kernel()
+    {
+        return false;
+    }
+#endif
+} // namespace Integration
+} // namespace PE
@@ -0,0 +1,128 @@
+#pragma once
+// Internal vectorized integration kernel, shared by the SSE2 and AVX2 translation units.
+#include "SimdMath.hpp"
+#include <cstdint>
+
+
+namespace PE
+{
+namespace Integration
+{
+    /**
+     * @brief Raw views of the CBodyStorage streams touched by integration, plus per-step constants.
+     */
+    struct SIntegrationBatch
+    {
+        float * PositionX = nullptr;
+        float * PositionY = nullptr;
+        float * PositionZ = nullptr;
+        float * LinearVelocityX = nullptr;
+        float * LinearVelocityY = nullptr;
+        float * LinearVelocityZ = nullptr;
+        float * AngularVelocityX = nullptr;
+        float * AngularVelocityY = nullptr;
+        float * AngularVelocityZ = nullptr;
+        float * RotationX = nullptr;
+        float * RotationY = nullptr;
+        float * RotationZ = nullptr;
+        float * RotationW = nullptr;
+        const uint16_t * MaterialIndices = nullptr;
+        const uint8_t * Flags = nullptr;
+        const float * LinearDampingFactors = nullptr; // Per material, exp ( -LinearDamping * DeltaTime )
+        const float * AngularDampingFactors = nullptr; // Per material, exp ( -AngularDamping * DeltaTime )
+        float DeltaTime = 0.f;
+        float DeltaGravityX = 0.f;
+        float DeltaGravityY = 0.f;
+        float DeltaGravityZ = 0.f;
+        float AngularEpsilon = 0.f; // Bodies spinning slower than this keep their rotation
+        uint8_t SkipFlags = 0; // Bodies with any of these flags are left untouched
+    };
+
+    /**
+     * Integrate bodies [ Begin, End ), T::Width bodies at a time. ( End - Begin ) must be a multiple of T::Width.
+     * Mirrors the scalar path: gravity, linear damping, position, axis-angle rotation, angular damping.
+     */
+    template <typename T>
+    void IntegrateBatch ( const SIntegrationBatch & Batch, int Begin, int End )
+    {
+        using V = typename T::Type;
+        const V DeltaTime = T::Set1 ( Batch . DeltaTime );
+        const V HalfDeltaTime = T::Set1 ( Batch . DeltaTime * 0.5f );
+        const V DeltaGravityX = T::Set1 ( Batch . DeltaGravityX );
+        const V DeltaGravityY = T::Set1 ( Batch . DeltaGravityY );
+        const V DeltaGravityZ = T::Set1 ( Batch . DeltaGravityZ );
+        const V Epsilon = T::Set1 ( Batch . AngularEpsilon );
+        const V One = T::Set1 ( 1.f );
+
+        for ( int i = Begin; i < End; i += T::Width )
+        {
+            const V Active = T::FlagsClear ( Batch . Flags + i, Batch . SkipFlags );
+
+            // Linear velocity: gravity, then damping
+            const V LinearDamping = T::Gather ( Batch . LinearDampingFactors, Batch . MaterialIndices + i );
+            const V OldVX = T::Load ( Batch . LinearVelocityX + i );
+            const V OldVY = T::Load ( Batch . LinearVelocityY + i );
+            const V OldVZ = T::Load ( Batch . LinearVelocityZ + i );
+            const V VX = T::Mul ( T::Add ( OldVX, DeltaGravityX ), LinearDamping );
+            const V VY = T::Mul ( T::Add ( OldVY, DeltaGravityY ), LinearDamping );
+            const V VZ = T::Mul ( T::Add ( OldVZ, DeltaGravityZ ), LinearDamping );
+            T::Store ( Batch . LinearVelocityX + i, T::Select ( Active, VX, OldVX ) );
+            T::Store ( Batch . LinearVelocityY + i, T::Select ( Active, VY, OldVY ) );
+            T::Store ( Batch . LinearVelocityZ + i, T::Select ( Active, VZ, OldVZ ) );
+
+            // Position
+            const V OldPX = T::Load ( Batch . PositionX + i );
+            const V OldPY = T::Load ( Batch . PositionY + i );
+            const V OldPZ = T::Load ( Batch . PositionZ + i );
+            T::Store ( Batch . PositionX + i, T::Select ( Active, T::Add ( OldPX, T::Mul ( VX, DeltaTime ) ), OldPX ) );
+            T::Store ( Batch . PositionY + i, T::Select ( Active, T::Add ( OldPY, T::Mul ( VY, DeltaTime ) ), OldPY ) );
+            T::Store ( Batch . PositionZ + i, T::Select ( Active, T::Add ( OldPZ, T::Mul ( VZ, DeltaTime ) ), OldPZ ) );
+
+            // Rotation: DeltaRotation = ( Axis * sin ( Angle / 2 ), cos ( Angle / 2 ) ), Rotation = DeltaRotation * Rotation
+            const V WX = T::Load ( Batch . AngularVelocityX + i );
+            const V WY = T::Load ( Batch . AngularVelocityY + i );
+            const V WZ = T::Load ( Batch . AngularVelocityZ + i );
+            const V Omega = T::Sqrt ( T::Add ( T::Add ( T::Mul ( WX, WX ), T::Mul ( WY, WY ) ), T::Mul ( WZ, WZ ) ) );
+            const V Spinning = T::And ( Active, T::Greater ( Omega, Epsilon ) );
+            if ( T::MoveMask ( Spinning ) != 0 )
+            {
+                V Sin, Cos;
+                Simd::SinCos<T> ( T::Mul ( Omega, HalfDeltaTime ), Sin, Cos );
+                const V SinOverOmega = T::Div ( Sin, T::Max ( Omega, Epsilon ) );
+                const V AX = T::Mul ( WX, SinOverOmega );
+                const V AY = T::Mul ( WY, SinOverOmega );
+                const V AZ = T::Mul ( WZ, SinOverOmega );
+                const V AW = Cos;
+
+                const V BX = T::Load ( Batch . RotationX + i );
+                const V BY = T::Load ( Batch . RotationY + i );
+                const V BZ = T::Load ( Batch . RotationZ + i );
+                const V BW = T::Load ( Batch . RotationW + i );
+                const V QX = T::Sub ( T::Add ( T::Add ( T::Mul ( AX, BW ), T::Mul ( AW, BX ) ), T::Mul ( AY, BZ ) ), T::Mul ( AZ, BY ) );
+                const V QY = T::Sub ( T::Add ( T::Add ( T::Mul ( AY, BW ), T::Mul ( AW, BY ) ), T::Mul ( AZ, BX ) ), T::Mul ( AX, BZ ) );
+                const V QZ = T::Sub ( T::Add ( T::Add ( T::Mul ( AZ, BW ), T::Mul ( AW, BZ ) ), T::Mul ( AX, BY ) ), T::Mul ( AY, BX ) );
+                const V QW = T::Sub ( T::Sub ( T::Sub ( T::Mul ( AW, BW ), T::Mul ( AX, BX ) ), T::Mul ( AY, BY ) ), T::Mul ( AZ, BZ ) );
+
+                const V LengthSquared = T::Add ( T::Add ( T::Mul ( QX, QX ), T::Mul ( QY, QY ) ), T::Add ( T::Mul ( QZ, QZ ), T::Mul ( QW, QW ) ) );
+                const V InvLength = T::Div ( One, T::Sqrt ( LengthSquared ) );
+                T::Store ( Batch . RotationX + i, T::Select ( Spinning, T::Mul ( QX, InvLength ), BX ) );
+                T::Store ( Batch . RotationY + i, T::Select ( Spinning, T::Mul ( QY, InvLength ), BY ) );
+                T::Store ( Batch . RotationZ + i, T::Select ( Spinning, T::Mul ( QZ, InvLength ), BZ ) );
+                T::Store ( Batch . RotationW + i, T::Select ( Spinning, T::Mul ( QW, InvLength ), BW ) );
+            }
+
+            // Angular damping
+            const V AngularDamping = T::Gather ( Batch . AngularDampingFactors, Batch . MaterialIndices + i );
+            T::Store ( Batch . AngularVelocityX + i, T::Select ( Active, T::Mul ( WX, AngularDamping ), WX ) );
+            T::Store ( Batch . AngularVelocityY + i, T::Select ( Active, T::Mul ( WY, AngularDamping ), WY ) );
+            T::Store ( Batch . AngularVelocityZ + i, T::Select ( Active, T::Mul ( WZ, AngularDamping ), WZ ) );
+        }
+    }
+
+    /** AVX2 instantiation of IntegrateBatch, compiled in its own translation unit with AVX2 enabled. */
+    void IntegrateBatchAVX2 ( const SIntegrationBatch & Batch, int Begin, int End );
+
+    /** false when the AVX2 translation unit was built without AVX2 support (non-x86 targets). */
+    bool HasAVX2Kernel ();
+} // namespace Integration
+} // namespace PE
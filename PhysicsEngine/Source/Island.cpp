@@ -0,0 +1,120 @@
+#include "Island.hpp"
+#include <numeric>
+#include <utility>
+
+
+namespace PE
+{
+    int CIslandBuilder::Find( int Index )
+    {
+        // Path halving
+        while ( m_Parents [ Index ] != Index )
+        {
+            m_Parents [ Index ] = m_Parents [ m_Parents [ Index ] ];
+            Index = m_Parents [ Index ];
+        }
+        return Index;
+    }
+
+    void CIslandBuilder::Union( int IndexA, int IndexB )
+    {
+        int RootA = Find ( IndexA );
+        int RootB = Find ( IndexB );
+        if ( RootA == RootB )
+        {
+            return;
+        }
+        // The lower index becomes the root, so every island's root is its first body
+        if ( RootB < RootA )
+        {
+            std::swap ( RootA, RootB );
+        }
+        m_Parents [ RootB ] = RootA;
+    }
+
+    int CIslandBuilder::ContactIsland( const SContact & Contact ) const
+    {
+        const int IslandA = m_BodyIslands [ Contact . BodyA ];
+        return IslandA >= 0 ? IslandA : m_BodyIslands [ Contact . BodyB ];
+    }
+
+    int CIslandBuilder::Build( const CBodyStorage & Bodies, const std::vector<SContact> & Contacts )
+    {
+        const int NumberOfBodies = Bodies . Size();
+        m_Parents . resize ( NumberOfBodies );
+        std::iota ( m_Parents . begin(), m_Parents . end(), 0 );
+        for ( const SContact & Contact : Contacts )
+        {
+            // Static (and sleeping) bodies don't propagate contact, they never merge islands
+            if ( Bodies . IsAwake ( Contact . BodyA ) && Bodies . IsAwake ( Contact . BodyB ) )
+            {
+                Union ( Contact . BodyA, Contact . BodyB );
+            }
+        }
+
+        // Roots are the lowest index of their island, so an ascending pass meets every root first
+        m_BodyIslands . assign ( NumberOfBodies, -1 );
+        m_IslandStarts . assign ( 1, 0 );
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            if ( ! Bodies . IsAwake ( i ) )
+            {
+                continue;
+            }
+            const int Root = Find ( i );
+            if ( Root == i )
+            {
+                m_BodyIslands [ i ] = static_cast<int> ( m_IslandStarts . size() ) - 1;
+                m_IslandStarts . push_back ( 0 );
+            }
+            else
+            {
+                m_BodyIslands [ i ] = m_BodyIslands [ Root ];
+            }
+            m_IslandStarts [ m_BodyIslands [ i ] + 1 ]++;
+        }
+
+        // Counting sort of the bodies by island
+        const int NumberOfIslands = GetNumberOfIslands();
+        for ( int Island = 0; Island < NumberOfIslands; Island++ )
+        {
+            m_IslandStarts [ Island + 1 ] += m_IslandStarts [ Island ];
+        }
+        m_IslandBodies . resize ( m_IslandStarts [ NumberOfIslands ] );
+        m_Cursors . assign ( m_IslandStarts . begin(), m_IslandStarts . end() - 1 );
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            if ( m_BodyIslands [ i ] >= 0 )
+            {
+                m_IslandBodies [ m_Cursors [ m_BodyIslands [ i ] ]++ ] = i;
+            }
+        }
+
+        // Same for the contacts, keyed by the island of their awake body
+        const int NumberOfContacts = static_cast<int> ( Contacts . size() );
+        m_IslandContactStarts . assign ( NumberOfIslands + 1, 0 );
+        for ( const SContact & Contact : Contacts )
+        {
+            const int Island = ContactIsland ( Contact );
+            if ( Island >= 0 )
+            {
+                m_IslandContactStarts [ Island + 1 ]++;
+            }
+        }
+        for ( int Island = 0; Island < NumberOfIslands; Island++ )
+        {
+            m_IslandContactStarts [ Island + 1 ] += m_IslandContactStarts [ Island ];
+        }
+        m_IslandContacts . resize ( m_IslandContactStarts [ NumberOfIslands ] );
+        m_Cursors . assign ( m_IslandContactStarts . begin(), m_IslandContactStarts . end() - 1 );
+        for ( int i = 0; i < NumberOfContacts; i++ )
+        {
+            const int Island = ContactIsland ( Contacts [ i ] );
+            if ( Island >= 0 )
+            {
+                m_IslandContacts [ m_Cursors [ Island ]++ ] = i;
+            }
+        }
+        return NumberOfIslands;
+    }
+} // namespace PE
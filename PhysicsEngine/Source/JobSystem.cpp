@@ -0,0 +1,293 @@
+#include "JobSystem.hpp"
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+
+namespace PE
+{
+namespace
+{
+    // Jobs are cut into this many index ranges per thread, enough to balance uneven tasks by stealing
+    constexpr int GTasksPerThread = 4;
+
+    thread_local const CJobSystem * t_JobSystem = nullptr;
+    thread_local int t_ThreadIndex = 0;
+} // namespace
+
+    struct CJobSystem::SRun
+    {
+        CJobGraph * Graph = nullptr;
+        std::unique_ptr<SJobRun[]> Jobs;
+        std::atomic<int> RemainingJobs { 0 };
+    };
+
+    int CJobGraph::AddJob( std::string Name, int Count, std::function<void ( int )> Function )
+    {
+        m_Jobs . push_back ( { .Name = std::move ( Name ), .Count = Count, .Setup = {}, .Function = std::move ( Function ), .Dependents = {} } );
+        return static_cast<int> ( m_Jobs . size() ) - 1;
+    }
+
+    int CJobGraph::AddJob( std::string Name, std::function<int ()> Setup, std::function<void ( int )> Function )
+    {
+        m_Jobs . push_back ( { .Name = std::move ( Name ), .Count = 0, .Setup = std::move ( Setup ), .Function = std::move ( Function ), .Dependents = {} } );
+        return static_cast<int> ( m_Jobs . size() ) - 1;
+    }
+
+    void CJobGraph::AddDependency( int Job, int Prerequisite )
+    {
+        m_Jobs [ Prerequisite ] . Dependents . push_back ( Job );
+        m_Jobs [ Job ] . NumberOfPrerequisites++;
+    }
+
+    void CJobGraph::Clear()
+    {
+        m_Jobs . clear();
+    }
+
+    int CJobSystem::ResolveNumberOfThreads( int NumberOfThreads )
+    {
+        return NumberOfThreads > 0 ? NumberOfThreads : std::max ( 1, static_cast<int> ( std::thread::hardware_concurrency() ) );
+    }
+
+    CJobSystem::CJobSystem( int NumberOfThreads )
+    {
+        NumberOfThreads = ResolveNumberOfThreads ( NumberOfThreads );
+        for ( int i = 0; i < NumberOfThreads; i++ )
+        {
+            m_Queues . push_back ( std::make_unique<SQueue>() );
+        }
+        m_Workers . reserve ( NumberOfThreads - 1 );
+        for ( int i = 1; i < NumberOfThreads; i++ )
+        {
+            m_Workers . emplace_back ( [ this, i ] { WorkerLoop ( i ); } );
+        }
+    }
+
+    CJobSystem::~CJobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> Lock ( m_SleepMutex );
+            m_IsStopping = true;
+        }
+        m_SleepCondition . notify_all();
+        for ( std::thread & Worker : m_Workers )
+        {
+            Worker . join();
+        }
+    }
+
+    int64_t CJobSystem::NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds> ( std::chrono::steady_clock::now() . time_since_epoch() ) . count();
+    }
+
+    int CJobSystem::GetThreadIndex() const
+    {
+        return t_JobSystem == this ? t_ThreadIndex : 0;
+    }
+
+    void CJobSystem::Run( CJobGraph & Graph )
+    {
+        const int NumberOfJobs = Graph . GetNumberOfJobs();
+        const int NumberOfThreads = GetNumberOfThreads();
+        SRun Run;
+        Run . Graph = &Graph;
+        Run . Jobs = std::make_unique<SJobRun[]> ( NumberOfJobs );
+        Run . RemainingJobs . store ( NumberOfJobs, std::memory_order_relaxed );
+        for ( int j = 0; j < NumberOfJobs; j++ )
+        {
+            SJobRun & Job = Run . Jobs [ j ];
+            Job . Function = &Graph . m_Jobs [ j ] . Function;
+            Job . RemainingPrerequisites . store ( Graph . m_Jobs [ j ] . NumberOfPrerequisites, std::memory_order_relaxed );
+            Job . Completion = &Run . RemainingJobs;
+            Job . Run = &Run;
+            Job . JobIndex = j;
+            Job . ThreadBusyNs . assign ( NumberOfThreads, 0 );
+        }
+
+        const int ThreadIndex = GetThreadIndex();
+        const int64_t StartNs = NowNs();
+        for ( int j = 0; j < NumberOfJobs; j++ )
+        {
+            if ( Graph . m_Jobs [ j ] . NumberOfPrerequisites == 0 )
+            {
+                StartGraphJob ( ThreadIndex, Run, j );
+            }
+        }
+        WaitFor ( ThreadIndex, Run . RemainingJobs );
+
+        Graph . m_Stats . resize ( NumberOfJobs );
+        for ( int j = 0; j < NumberOfJobs; j++ )
+        {
+            const SJobRun & Job = Run . Jobs [ j ];
+            SJobStats & Stats = Graph . m_Stats [ j ];
+            Stats . Name = Graph . m_Jobs [ j ] . Name;
+            Stats . StartMs = static_cast<double> ( Job . StartNs - StartNs ) * 1e-6;
+            Stats . EndMs = static_cast<double> ( Job . EndNs - StartNs ) * 1e-6;
+            Stats . Count = Job . Count;
+            Stats . ThreadBusyMs . resize ( NumberOfThreads );
+            for ( int t = 0; t < NumberOfThreads; t++ )
+            {
+                Stats . ThreadBusyMs [ t ] = static_cast<double> ( Job . ThreadBusyNs [ t ] ) * 1e-6;
+            }
+        }
+    }
+
+    void CJobSystem::ParallelFor( int Count, const std::function<void ( int )> & Function )
+    {
+        if ( m_Workers . empty() || Count <= 1 )
+        {
+            for ( int i = 0; i < Count; i++ )
+            {
+                Function ( i );
+            }
+            return;
+        }
+        std::atomic<int> Pending { 1 };
+        SJobRun Job;
+        Job . Function = &Function;
+        Job . Completion = &Pending;
+        const int ThreadIndex = GetThreadIndex();
+        LaunchJob ( ThreadIndex, Job, Count );
+        WaitFor ( ThreadIndex, Pending );
+    }
+
+    void CJobSystem::StartGraphJob( int ThreadIndex, SRun & Run, int JobIndex )
+    {
+        SJobRun & Job = Run . Jobs [ JobIndex ];
+        const CJobGraph::SJob & Description = Run . Graph -> m_Jobs [ JobIndex ];
+        Job . StartNs = NowNs();
+        LaunchJob ( ThreadIndex, Job, Description . Setup ? Description . Setup() : Description . Count );
+    }
+
+    void CJobSystem::LaunchJob( int ThreadIndex, SJobRun & Job, int Count )
+    {
+        Job . Count = Count;
+        if ( Count <= 0 )
+        {
+            FinishJob ( ThreadIndex, Job );
+            return;
+        }
+        Job . RemainingIndices . store ( Count, std::memory_order_relaxed );
+        const int NumberOfTasks = std::min ( Count, GetNumberOfThreads() * GTasksPerThread );
+        {
+            SQueue & Queue = *m_Queues [ ThreadIndex ];
+            std::lock_guard<std::mutex> Lock ( Queue . Mutex );
+            for ( int t = 0; t < NumberOfTasks; t++ )
+            {
+                const int Begin = static_cast<int> ( static_cast<int64_t> ( Count ) * t / NumberOfTasks );
+                const int End = static_cast<int> ( static_cast<int64_t> ( Count ) * ( t + 1 ) / NumberOfTasks );
+                Queue . Tasks . push_back ( { .Job = &Job, .Begin = Begin, .End = End } );
+            }
+        }
+        m_NumberOfQueuedTasks . fetch_add ( NumberOfTasks, std::memory_order_release );
+        if ( ! m_Workers . empty() )
+        {
+            // Taking the mutex orders the push before a worker's check of the predicate, so no wakeup is lost
+            {
+                std::lock_guard<std::mutex> Lock ( m_SleepMutex );
+            }
+            m_SleepCondition . notify_all();
+        }
+    }
+
+    void CJobSystem::FinishJob( int ThreadIndex, SJobRun & Job )
+    {
+        Job . EndNs = NowNs();
+        if ( SRun * Run = Job . Run )
+        {
+            for ( const int Dependent : Run -> Graph -> m_Jobs [ Job . JobIndex ] . Dependents )
+            {
+                if ( Run -> Jobs [ Dependent ] . RemainingPrerequisites . fetch_sub ( 1, std::memory_order_acq_rel ) == 1 )
+                {
+                    StartGraphJob ( ThreadIndex, *Run, Dependent );
+                }
+            }
+        }
+        // The waiter may destroy the job (and the run) as soon as this lands
+        Job . Completion -> fetch_sub ( 1, std::memory_order_acq_rel );
+    }
+
+    bool CJobSystem::TryRunTask( int ThreadIndex )
+    {
+        STask Task;
+        bool IsFound = false;
+        {
+            // Own deque from the back: the newest tasks, likely still in cache
+            SQueue & Queue = *m_Queues [ ThreadIndex ];
+            std::lock_guard<std::mutex> Lock ( Queue . Mutex );
+            if ( ! Queue . Tasks . empty() )
+            {
+                Task = Queue . Tasks . back();
+                Queue . Tasks . pop_back();
+                IsFound = true;
+            }
+        }
+        const int NumberOfThreads = GetNumberOfThreads();
+        for ( int Offset = 1; ! IsFound && Offset < NumberOfThreads; Offset++ )
+        {
+            // Steal the oldest task of another thread
+            SQueue & Queue = *m_Queues [ ( ThreadIndex + Offset ) % NumberOfThreads ];
+            std::lock_guard<std::mutex> Lock ( Queue . Mutex );
+            if ( ! Queue . Tasks . empty() )
+            {
+                Task = Queue . Tasks . front();
+                Queue . Tasks . pop_front();
+                IsFound = true;
+            }
+        }
+        if ( ! IsFound )
+        {
+            return false;
+        }
+        m_NumberOfQueuedTasks . fetch_sub ( 1, std::memory_order_relaxed );
+
+        SJobRun & Job = *Task . Job;
+        const int64_t StartNs = Job . ThreadBusyNs . empty() ? 0 : NowNs();
+        for ( int i = Task . Begin; i < Task . End; i++ )
+        {
+            ( *Job . Function ) ( i );
+        }
+        if ( ! Job . ThreadBusyNs . empty() )
+        {
+            Job . ThreadBusyNs [ ThreadIndex ] += NowNs() - StartNs;
+        }
+        const int NumberOfIndices = Task . End - Task . Begin;
+        if ( Job . RemainingIndices . fetch_sub ( NumberOfIndices, std::memory_order_acq_rel ) == NumberOfIndices )
+        {
+            FinishJob ( ThreadIndex, Job );
+        }
+        return true;
+    }
+
+    void CJobSystem::WaitFor( int ThreadIndex, const std::atomic<int> & Counter )
+    {
+        while ( Counter . load ( std::memory_order_acquire ) != 0 )
+        {
+            if ( ! TryRunTask ( ThreadIndex ) )
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void CJobSystem::WorkerLoop( int ThreadIndex )
+    {
+        t_JobSystem = this;
+        t_ThreadIndex = ThreadIndex;
+        while ( true )
+        {
+            if ( TryRunTask ( ThreadIndex ) )
+            {
+                continue;
+            }
+            std::unique_lock<std::mutex> Lock ( m_SleepMutex );
+            m_SleepCondition . wait ( Lock, [ this ] { return m_IsStopping || m_NumberOfQueuedTasks . load ( std::memory_order_acquire ) > 0; } );
+            if ( m_IsStopping )
+            {
+                return;
+            }
+        }
+    }
+} // namespace PE
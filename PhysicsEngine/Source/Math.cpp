@@ -1,12 +1,14 @@
 #include "Math.hpp"
 #include "raymath.h"
+#include <algorithm>
+#include <cmath>
 
 
 namespace PE
 {
 namespace Math
 {
-    Vector3 PE::Math::ClosestPointOnBox(const Vector3 &PointLocation, const BoundingBox &Box)
+    Vector3 ClosestPointOnBox(const Vector3 &PointLocation, const BoundingBox &Box)
     {
         Vector3 OutPoint; 
         OutPoint.x = Clamp(PointLocation.x, Box.min.x, Box.max.x);
@@ -15,18 +17,65 @@ namespace Math
         return OutPoint;
     }
     
-    Vector3 PE::Math::BoxCenter(const BoundingBox &Box)
+    Vector3 BoxCenter(const BoundingBox &Box)
     {
         return { 0.5f * ( Box.min.x + Box.max.x ), 
                     0.5f * ( Box.min.y + Box.max.y ), 
                     0.5f * ( Box.min.z + Box.max.z ) }; 
     }
     
-    Vector3 PE::Math::BoxSize(const BoundingBox &Box)
+    Vector3 BoxSize(const BoundingBox &Box)
     {
         return Vector3Subtract ( Box . max, Box . min );
     }
 
+    bool BoxesOverlap ( const BoundingBox & BoxA, const BoundingBox & BoxB )
+    {
+        return BoxA . min . x <= BoxB . max . x && BoxA . max . x >= BoxB . min . x &&
+               BoxA . min . y <= BoxB . max . y && BoxA . max . y >= BoxB . min . y &&
+               BoxA . min . z <= BoxB . max . z && BoxA . max . z >= BoxB . min . z;
+    }
+
+    BoundingBox ExpandBox ( const BoundingBox & Box, float Margin )
+    {
+        return { Vector3SubtractValue ( Box . min, Margin ), Vector3AddValue ( Box . max, Margin ) };
+    }
+
+    bool RayBoxInterval ( const Vector3 & Origin, const Vector3 & InvDirection, const BoundingBox & Box, float MaxDistance, float & OutEnter, float & OutExit )
+    {
+        const float Origins [ 3 ] = { Origin . x, Origin . y, Origin . z };
+        const float Inverses [ 3 ] = { InvDirection . x, InvDirection . y, InvDirection . z };
+        const float Mins [ 3 ] = { Box . min . x, Box . min . y, Box . min . z };
+        const float Maxs [ 3 ] = { Box . max . x, Box . max . y, Box . max . z };
+        OutEnter = 0.f;
+        OutExit = MaxDistance;
+        for ( int Axis = 0; Axis < 3; Axis++ )
+        {
+            if ( std::isinf ( Inverses [ Axis ] ) )
+            {
+                // Parallel to the slab, inside it or never
+                if ( Origins [ Axis ] < Mins [ Axis ] || Origins [ Axis ] > Maxs [ Axis ] )
+                {
+                    return false;
+                }
+                continue;
+            }
+            float Near = ( Mins [ Axis ] - Origins [ Axis ] ) * Inverses [ Axis ];
+            float Far = ( Maxs [ Axis ] - Origins [ Axis ] ) * Inverses [ Axis ];
+            if ( Near > Far )
+            {
+                std::swap ( Near, Far );
+            }
+            OutEnter = std::max ( OutEnter, Near );
+            OutExit = std::min ( OutExit, Far );
+            if ( OutEnter > OutExit )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
     Color ColorLerp(const Color &C1, const Color &C2, float T)
     {
         if (T < 0.0f)
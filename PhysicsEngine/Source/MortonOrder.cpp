@@ -0,0 +1,94 @@
+#include "MortonOrder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace PE
+{
+namespace
+{
+    // Spread the lowest 10 bits so two zero bits follow each of them
+    uint32_t SpreadBits( uint32_t Value )
+    {
+        Value &= 0x3FFu;
+        Value = ( Value | ( Value << 16 ) ) & 0x030000FFu;
+        Value = ( Value | ( Value << 8 ) ) & 0x0300F00Fu;
+        Value = ( Value | ( Value << 4 ) ) & 0x030C30C3u;
+        Value = ( Value | ( Value << 2 ) ) & 0x09249249u;
+        return Value;
+    }
+} // namespace
+
+    uint32_t CMortonOrder::Encode( uint32_t X, uint32_t Y, uint32_t Z )
+    {
+        return SpreadBits ( X ) | ( SpreadBits ( Y ) << 1 ) | ( SpreadBits ( Z ) << 2 );
+    }
+
+    float CMortonOrder::Measure( const CBodyStorage & Bodies )
+    {
+        const int NumberOfBodies = Bodies . Size();
+        m_Codes . resize ( NumberOfBodies );
+        if ( NumberOfBodies == 0 )
+        {
+            return 0.f;
+        }
+
+        // Quantize inside the bounds of the bodies, not the world box, so hand-added bodies anywhere get distinct cells
+        Vector3 Min = Bodies . Positions . Get ( 0 );
+        Vector3 Max = Min;
+        for ( int i = 1; i < NumberOfBodies; i++ )
+        {
+            Min . x = std::fmin ( Min . x, Bodies . Positions . X [ i ] );
+            Min . y = std::fmin ( Min . y, Bodies . Positions . Y [ i ] );
+            Min . z = std::fmin ( Min . z, Bodies . Positions . Z [ i ] );
+            Max . x = std::fmax ( Max . x, Bodies . Positions . X [ i ] );
+            Max . y = std::fmax ( Max . y, Bodies . Positions . Y [ i ] );
+            Max . z = std::fmax ( Max . z, Bodies . Positions . Z [ i ] );
+        }
+        const float MaxCell = static_cast<float> ( ( 1 << GBitsPerAxis ) - 1 );
+        const auto CellScale = [ MaxCell ] ( float Extent ) { return Extent > 0.f ? MaxCell / Extent : 0.f; };
+        const Vector3 Scale = { CellScale ( Max . x - Min . x ), CellScale ( Max . y - Min . y ), CellScale ( Max . z - Min . z ) };
+        const auto ToCell = [ MaxCell ] ( float Value ) { return static_cast<uint32_t> ( std::clamp ( Value, 0.f, MaxCell ) ); };
+
+        int NumberOfDescents = 0;
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            m_Codes [ i ] = Encode ( ToCell ( ( Bodies . Positions . X [ i ] - Min . x ) * Scale . x ),
+                                     ToCell ( ( Bodies . Positions . Y [ i ] - Min . y ) * Scale . y ),
+                                     ToCell ( ( Bodies . Positions . Z [ i ] - Min . z ) * Scale . z ) );
+            NumberOfDescents += ( i > 0 && m_Codes [ i - 1 ] > m_Codes [ i ] ) ? 1 : 0;
+        }
+        return NumberOfBodies > 1 ? static_cast<float> ( NumberOfDescents ) / static_cast<float> ( NumberOfBodies - 1 ) : 0.f;
+    }
+
+    std::span<const int> CMortonOrder::Sort()
+    {
+        // LSD radix sort of ( code, index ), each counting pass is stable so equal codes keep their current order
+        const size_t NumberOfBodies = m_Codes . size();
+        m_SortedCodes . assign ( m_Codes . begin(), m_Codes . end() );
+        m_ScratchCodes . resize ( NumberOfBodies );
+        m_Order . resize ( NumberOfBodies );
+        m_ScratchOrder . resize ( NumberOfBodies );
+        std::iota ( m_Order . begin(), m_Order . end(), 0 );
+
+        constexpr uint32_t DigitMask = ( 1u << GRadixBits ) - 1;
+        for ( int Shift = 0; Shift < 3 * GBitsPerAxis; Shift += GRadixBits )
+        {
+            m_DigitStarts . assign ( DigitMask + 2, 0 );
+            for ( const uint32_t Code : m_SortedCodes )
+            {
+                m_DigitStarts [ ( ( Code >> Shift ) & DigitMask ) + 1 ]++;
+            }
+            std::partial_sum ( m_DigitStarts . begin(), m_DigitStarts . end(), m_DigitStarts . begin() );
+            for ( size_t i = 0; i < NumberOfBodies; i++ )
+            {
+                const int Slot = m_DigitStarts [ ( m_SortedCodes [ i ] >> Shift ) & DigitMask ]++;
+                m_ScratchCodes [ Slot ] = m_SortedCodes [ i ];
+                m_ScratchOrder [ Slot ] = m_Order [ i ];
+            }
+            std::swap ( m_SortedCodes, m_ScratchCodes );
+            std::swap ( m_Order, m_ScratchOrder );
+        }
+        return m_Order;
+    }
+} // namespace PE
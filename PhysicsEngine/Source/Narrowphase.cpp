@@ -0,0 +1,265 @@
+#include "Narrowphase.hpp"
+#include "NarrowphaseKernel.hpp"
+#include "Collision.hpp"
+#include "Simd.hpp"
+#include "raymath.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+
+namespace PE
+{
+namespace Collision
+{
+namespace
+{
+    bool WriteContact( const SHitResult & Hit, const SBroadphasePair & Pair, SContact & OutContact )
+    {
+        if ( ! Hit . IsHit )
+        {
+            return false;
+        }
+        OutContact . BodyA = Pair . BodyA;
+        OutContact . BodyB = Pair . BodyB;
+        OutContact . ContactPoint = Hit . ContactPoint;
+        OutContact . Normal = Hit . Normal;
+        OutContact . Penetration = Hit . Penetration;
+        return true;
+    }
+
+    float & Component( Vector3 & Value, int Axis )
+    {
+        return Axis == 0 ? Value . x : ( Axis == 1 ? Value . y : Value . z );
+    }
+
+    // Contacts of one sphere with every wall it reaches, walls visited in the given order. Wall 2 * Axis is the
+    // minimum side with a normal along +Axis, wall 2 * Axis + 1 the maximum side.
+    void WriteWallContacts( const CBodyStorage & Bodies, int Index, BoundingBox Box, const std::array<int, 6> & WallOrder,
+                            const std::array<int, 6> & Walls, float Margin, std::vector<SContact> & OutContacts )
+    {
+        const Vector3 Center = Bodies . Positions . Get ( Index );
+        const float Radius = Bodies . Radii [ Index ];
+        for ( const int Wall : WallOrder )
+        {
+            if ( Walls [ Wall ] < 0 )
+            {
+                continue;
+            }
+            const int Axis = Wall / 2;
+            const bool IsMaxSide = Wall % 2 == 1;
+            Vector3 ContactPoint = Center;
+            const float CenterOnAxis = Component ( ContactPoint, Axis );
+            const float Plane = IsMaxSide ? Component ( Box . max, Axis ) : Component ( Box . min, Axis );
+            const float Distance = IsMaxSide ? Plane - CenterOnAxis : CenterOnAxis - Plane;
+            if ( Distance > Radius + Margin )
+            {
+                continue;
+            }
+            // Same contact as TestSphereBox against a flat wall box: midpoint between the wall and the sphere surface
+            SContact Contact;
+            Contact . BodyA = Index;
+            Contact . BodyB = Walls [ Wall ];
+            const float Sign = IsMaxSide ? -1.f : 1.f;
+            Component ( Contact . Normal, Axis ) = Sign;
+            Contact . Penetration = Radius - Distance;
+            Component ( ContactPoint, Axis ) = ( Plane + ( CenterOnAxis - Sign * Radius ) ) * 0.5f;
+            Contact . ContactPoint = ContactPoint;
+            OutContacts . push_back ( Contact );
+        }
+    }
+
+    // Contacts of canonical pairs of one pair type, in pair order
+    template <EShapeType TypeA, EShapeType TypeB>
+    int TestPairs( const CBodyStorage & Bodies, std::span<const SBroadphasePair> Pairs, SContact * OutContacts, ESimdLevel, float Margin )
+    {
+        int NumberOfContacts = 0;
+        for ( const SBroadphasePair & Pair : Pairs )
+        {
+            const SHitResult Hit = SPairTest<TypeA, TypeB>::Test ( Bodies . Shapes [ Pair . BodyA ], Bodies . Positions . Get ( Pair . BodyA ),
+                                                                   Bodies . Shapes [ Pair . BodyB ], Bodies . Positions . Get ( Pair . BodyB ), Margin );
+            NumberOfContacts += WriteContact ( Hit, Pair, OutContacts [ NumberOfContacts ] ) ? 1 : 0;
+        }
+        return NumberOfContacts;
+    }
+
+    template <>
+    int TestPairs<EShapeType::Sphere, EShapeType::Sphere>( const CBodyStorage & Bodies, std::span<const SBroadphasePair> Pairs, SContact * OutContacts,
+                                                           ESimdLevel SimdLevel, float Margin )
+    {
+        return TestSphereSpherePairs ( Bodies, Pairs . data(), static_cast<int> ( Pairs . size() ), OutContacts, SimdLevel, Margin );
+    }
+
+    template <>
+    int TestPairs<EShapeType::Sphere, EShapeType::Box>( const CBodyStorage & Bodies, std::span<const SBroadphasePair> Pairs, SContact * OutContacts,
+                                                        ESimdLevel, float Margin )
+    {
+        // Most candidates miss, the distance to the box rejects them before the full test
+        int NumberOfContacts = 0;
+        for ( const SBroadphasePair & Pair : Pairs )
+        {
+            const Vector3 Center = Bodies . Positions . Get ( Pair . BodyA );
+            const float Radius = Bodies . Radii [ Pair . BodyA ];
+            const Vector3 BoxCenter = Bodies . Positions . Get ( Pair . BodyB );
+            const Vector3 HalfSize = Bodies . Shapes [ Pair . BodyB ] . Box . HalfSize;
+            const BoundingBox Box { Vector3Subtract ( BoxCenter, HalfSize ), Vector3Add ( BoxCenter, HalfSize ) };
+            const float Reach = Radius + Margin;
+            if ( Vector3DistanceSqr ( Center, Math::ClosestPointOnBox ( Center, Box ) ) > Reach * Reach )
+            {
+                continue;
+            }
+            const SHitResult Hit = TestSphereBox ( Center, Radius, Box, Margin );
+            NumberOfContacts += WriteContact ( Hit, Pair, OutContacts [ NumberOfContacts ] ) ? 1 : 0;
+        }
+        return NumberOfContacts;
+    }
+
+    // Kernels may put the higher index first, the pair order doesn't depend on it
+    bool IsInPairOrder( const SContact & A, const SContact & B )
+    {
+        return std::minmax ( A . BodyA, A . BodyB ) < std::minmax ( B . BodyA, B . BodyB );
+    }
+} // namespace
+
+    int TestSphereSpherePairs( const CBodyStorage & Bodies, const SBroadphasePair * Pairs, int NumberOfPairs,
+                               SContact * OutContacts, ESimdLevel SimdLevel, float Margin )
+    {
+        const SSphereBatch Batch {
+            .PositionX = Bodies . Positions . X . data(),
+            .PositionY = Bodies . Positions . Y . data(),
+            .PositionZ = Bodies . Positions . Z . data(),
+            .Radii = Bodies . Radii . data(),
+        };
+        int NumberOfContacts = 0;
+        int Processed = 0;
+        const ESimdLevel Level = Simd::ResolveLevel ( SimdLevel );
+        if ( Level == ESimdLevel::AVX2 && HasSphereSphereAVX2Kernel() )
+        {
+            NumberOfContacts += TestSphereSphereBatchAVX2 ( Batch, Pairs, NumberOfPairs, OutContacts, Margin );
+            Processed = NumberOfPairs - NumberOfPairs % 8;
+        }
+#if defined(PE_SIMD_SSE2)
+        if ( Level != ESimdLevel::Scalar )
+        {
+            const int Remaining = NumberOfPairs - Processed;
+            NumberOfContacts += TestSphereSphereBatch<Simd::SFloat4> ( Batch, Pairs + Processed, Remaining, OutContacts + NumberOfContacts, Margin );
+            Processed += Remaining - Remaining % Simd::SFloat4::Width;
+        }
+#endif
+
+        // Scalar remainder (or everything when SIMD is disabled)
+        for ( int i = Processed; i < NumberOfPairs; i++ )
+        {
+            const int IndexA = Pairs [ i ] . BodyA;
+            const int IndexB = Pairs [ i ] . BodyB;
+            const SHitResult Hit = TestSphereSphere ( Bodies . Positions . Get ( IndexA ), Bodies . Radii [ IndexA ],
+                                                      Bodies . Positions . Get ( IndexB ), Bodies . Radii [ IndexB ], Margin );
+            NumberOfContacts += WriteContact ( Hit, Pairs [ i ], OutContacts [ NumberOfContacts ] ) ? 1 : 0;
+        }
+        return NumberOfContacts;
+    }
+
+    int TestSpheresInsideBox( const CBodyStorage & Bodies, int Begin, int End, const BoundingBox & Box, const std::array<int, 6> & Walls,
+                              std::vector<SContact> & OutContacts, ESimdLevel SimdLevel, float Margin )
+    {
+        // Visiting the walls by ascending body index keeps the contacts sorted by BodyB within a sphere
+        std::array<int, 6> WallOrder { 0, 1, 2, 3, 4, 5 };
+        std::sort ( WallOrder . begin(), WallOrder . end(), [ & ] ( int A, int B ) { return Walls [ A ] < Walls [ B ]; } );
+
+        const SBoxBatch Batch {
+            .PositionX = Bodies . Positions . X . data(),
+            .PositionY = Bodies . Positions . Y . data(),
+            .PositionZ = Bodies . Positions . Z . data(),
+            .Radii = Bodies . Radii . data(),
+            .Flags = Bodies . Flags . data(),
+            .SkipFlags = CBodyStorage::GPassiveFlags,
+            .Min = Box . min,
+            .Max = Box . max,
+            .Margin = Margin,
+        };
+        const ESimdLevel Level = Simd::ResolveLevel ( SimdLevel );
+        OutContacts . clear();
+        // Blocks bound the candidate buffer, most spheres are nowhere near a wall
+        constexpr int GBlockSize = 256;
+        int Candidates [ GBlockSize ];
+        for ( int BlockBegin = Begin; BlockBegin < End; BlockBegin += GBlockSize )
+        {
+            const int BlockEnd = std::min ( BlockBegin + GBlockSize, End );
+            int NumberOfCandidates = 0;
+            int Processed = BlockBegin;
+            if ( Level == ESimdLevel::AVX2 && HasSphereSphereAVX2Kernel() )
+            {
+                const int BatchEnd = BlockEnd - ( BlockEnd - Processed ) % 8;
+                NumberOfCandidates += FindSpheresReachingBoxBatchAVX2 ( Batch, Processed, BatchEnd, Candidates );
+                Processed = BatchEnd;
+            }
+#if defined(PE_SIMD_SSE2)
+            if ( Level != ESimdLevel::Scalar )
+            {
+                const int BatchEnd = BlockEnd - ( BlockEnd - Processed ) % Simd::SFloat4::Width;
+                NumberOfCandidates += FindSpheresReachingBoxBatch<Simd::SFloat4> ( Batch, Processed, BatchEnd, Candidates + NumberOfCandidates );
+                Processed = BatchEnd;
+            }
+#endif
+            // Scalar remainder (or everything when SIMD is disabled), the wall test below sorts them out
+            for ( int i = Processed; i < BlockEnd; i++ )
+            {
+                if ( Bodies . IsAwake ( i ) && Bodies . Radii [ i ] > 0.f )
+                {
+                    Candidates [ NumberOfCandidates++ ] = i;
+                }
+            }
+            for ( int c = 0; c < NumberOfCandidates; c++ )
+            {
+                WriteWallContacts ( Bodies, Candidates [ c ], Box, WallOrder, Walls, Margin, OutContacts );
+            }
+        }
+        return static_cast<int> ( OutContacts . size() );
+    }
+} // namespace Collision
+
+    void CNarrowphase::GenerateContacts( const CBodyStorage & Bodies, std::span<const SBroadphasePair> Pairs, std::vector<SContact> & OutContacts )
+    {
+        using FTestPairs = int (*) ( const CBodyStorage &, std::span<const SBroadphasePair>, SContact *, ESimdLevel, float );
+        static constexpr std::array<FTestPairs, Collision::GNumberOfPairTypes> GPairKernels = Collision::MakePairTable<FTestPairs> (
+            [] <EShapeType TypeA, EShapeType TypeB> () -> FTestPairs { return &Collision::TestPairs<TypeA, TypeB>; } );
+
+        for ( std::vector<SBroadphasePair> & TypePairs : m_TypePairs )
+        {
+            TypePairs . clear();
+        }
+        for ( const SBroadphasePair & Pair : Pairs )
+        {
+            const EShapeType TypeA = Bodies . Shapes [ Pair . BodyA ] . Type;
+            const EShapeType TypeB = Bodies . Shapes [ Pair . BodyB ] . Type;
+            m_TypePairs [ Collision::GetPairType ( TypeA, TypeB ) ] . push_back ( Collision::IsCanonicalPair ( TypeA, TypeB ) ? Pair : SBroadphasePair { Pair . BodyB, Pair . BodyA } );
+        }
+
+        // Every group inherits the pair order, merge them back into one list
+        OutContacts . clear();
+        for ( int PairType = 0; PairType < Collision::GNumberOfPairTypes; PairType++ )
+        {
+            // Only ever grown, shrinking and growing again would construct every contact anew each step
+            std::vector<SContact> & TypeContacts = m_TypeContacts [ PairType ];
+            if ( TypeContacts . size() < m_TypePairs [ PairType ] . size() )
+            {
+                TypeContacts . resize ( m_TypePairs [ PairType ] . size() );
+            }
+            const int NumberOfContacts = GPairKernels [ PairType ] ( Bodies, m_TypePairs [ PairType ], TypeContacts . data(), m_SimdLevel, m_ContactMargin );
+            const std::span<const SContact> Contacts ( TypeContacts . data(), NumberOfContacts );
+            if ( Contacts . empty() )
+            {
+                continue;
+            }
+            if ( OutContacts . empty() )
+            {
+                OutContacts . assign ( Contacts . begin(), Contacts . end() );
+                continue;
+            }
+            m_MergedContacts . clear();
+            std::merge ( OutContacts . begin(), OutContacts . end(), Contacts . begin(), Contacts . end(),
+                         std::back_inserter ( m_MergedContacts ), Collision::IsInPairOrder );
+            OutContacts . swap ( m_MergedContacts );
+        }
+    }
+} // namespace PE
@@ -0,0 +1,41 @@
+// Compiled with AVX2 enabled (see CMakeLists.txt). Only called after runtime CPU detection.
+#include "NarrowphaseKernel.hpp"
+
+
+namespace PE
+{
+namespace Collision
+{
+#if defined(PE_SIMD_AVX2)
+    int TestSphereSphereBatchAVX2( const SSphereBatch & Batch, const SBroadphasePair * Pairs, int NumberOfPairs, SContact * OutContacts, float Margin )
+    {
+        return TestSphereSphereBatch<Simd::SFloat8> ( Batch, Pairs, NumberOfPairs, OutContacts, Margin );
+    }
+
+    int FindSpheresReachingBoxBatchAVX2( const SBoxBatch & Batch, int Begin, int End, int * OutIndices )
+    {
+        return FindSpheresReachingBoxBatch<Simd::SFloat8> ( Batch, Begin, End, OutIndices );
+    }
+
+    bool HasSphereSphereAVX2Kernel()
+    {
+        return true;
+    }
+#else
+    int TestSphereSphereBatchAVX2( const SSphereBatch &, const SBroadphasePair *, int, SContact *, float )
+    {
+        return 0;
+    }
+
+    int FindSpheresReachingBoxBatchAVX2( const SBoxBatch &, int, int, int * )
+    {
+        return 0;
+    }
+
+    bool HasSphereSphereAVX2Kernel()
+    {
+        return false;
+    }
+#endif
+} // namespace Collision
+} // namespace PE
@@ -0,0 +1,181 @@
+#pragma once
+// Internal vectorized sphere-sphere narrowphase, shared by the SSE2 and AVX2 translation units.
+#include "SimdMath.hpp"
+#include "Broadphase.hpp"
+#include "Contact.hpp"
+#include "Math.hpp"
+#include "raylib.h"
+#include <bit>
+#include <cstdint>
+
+
+namespace PE
+{
+namespace Collision
+{
+    /**
+     * @brief Raw views of the CBodyStorage streams read by the sphere-sphere kernel.
+     */
+    struct SSphereBatch
+    {
+        const float * PositionX = nullptr;
+        const float * PositionY = nullptr;
+        const float * PositionZ = nullptr;
+        const float * Radii = nullptr;
+    };
+
+    /**
+     * Test pairs [ 0, NumberOfPairs - NumberOfPairs % T::Width ), T::Width pairs at a time, and write the hits
+     * to OutContacts in pair order. Uses the same operation order as TestSphereSphere, so results are identical.
+     * Pairs separated by up to Margin are written too, with a negative penetration.
+     * @return number of contacts written
+     */
+    template <typename T>
+    int TestSphereSphereBatch ( const SSphereBatch & Batch, const SBroadphasePair * Pairs, int NumberOfPairs, SContact * OutContacts, float Margin )
+    {
+        using V = typename T::Type;
+        const int End = NumberOfPairs - NumberOfPairs % T::Width;
+        const V SmallNumber = T::Set1 ( PE::Math::GSmallNumber );
+        const V Half = T::Set1 ( 0.5f );
+        const V One = T::Set1 ( 1.f );
+        const V MarginV = T::Set1 ( Margin );
+        int NumberOfContacts = 0;
+
+        alignas ( 32 ) int IndexA [ T::Width ];
+        alignas ( 32 ) int IndexB [ T::Width ];
+        alignas ( 32 ) float Lanes [ 8 ] [ T::Width ];
+        for ( int i = 0; i < End; i += T::Width )
+        {
+            for ( int Lane = 0; Lane < T::Width; Lane++ )
+            {
+                IndexA [ Lane ] = Pairs [ i + Lane ] . BodyA;
+                IndexB [ Lane ] = Pairs [ i + Lane ] . BodyB;
+            }
+            const V AX = T::Gather ( Batch . PositionX, IndexA );
+            const V AY = T::Gather ( Batch . PositionY, IndexA );
+            const V AZ = T::Gather ( Batch . PositionZ, IndexA );
+            const V BX = T::Gather ( Batch . PositionX, IndexB );
+            const V BY = T::Gather ( Batch . PositionY, IndexB );
+            const V BZ = T::Gather ( Batch . PositionZ, IndexB );
+            const V DX = T::Sub ( AX, BX );
+            const V DY = T::Sub ( AY, BY );
+            const V DZ = T::Sub ( AZ, BZ );
+            const V DistanceSquared = T::Add ( T::Add ( T::Mul ( DX, DX ), T::Mul ( DY, DY ) ), T::Mul ( DZ, DZ ) );
+            const V RadiusA = T::Gather ( Batch . Radii, IndexA );
+            const V RadiiSum = T::Add ( RadiusA, T::Gather ( Batch . Radii, IndexB ) );
+
+            // Touching counts as a hit
+            const V HitDistance = T::Add ( RadiiSum, MarginV );
+            int HitMask = T::MoveMask ( T::LessEqual ( DistanceSquared, T::Mul ( HitDistance, HitDistance ) ) );
+            if ( HitMask == 0 )
+            {
+                continue;
+            }
+
+            const V Distance = T::Sqrt ( DistanceSquared );
+            const V InvDistance = T::Div ( One, Distance );
+            const V NX = T::Mul ( DX, InvDistance );
+            const V NY = T::Mul ( DY, InvDistance );
+            const V NZ = T::Mul ( DZ, InvDistance );
+            const V Penetration = T::Sub ( RadiiSum, Distance );
+            // Contact point = midpoint between surface points along the normal
+            const V Offset = T::Sub ( RadiusA, T::Mul ( Half, Penetration ) );
+            T::Store ( Lanes [ 0 ], NX );
+            T::Store ( Lanes [ 1 ], NY );
+            T::Store ( Lanes [ 2 ], NZ );
+            T::Store ( Lanes [ 3 ], Penetration );
+            T::Store ( Lanes [ 4 ], T::Add ( BX, T::Mul ( NX, Offset ) ) );
+            T::Store ( Lanes [ 5 ], T::Add ( BY, T::Mul ( NY, Offset ) ) );
+            T::Store ( Lanes [ 6 ], T::Add ( BZ, T::Mul ( NZ, Offset ) ) );
+            T::Store ( Lanes [ 7 ], RadiiSum );
+            const int Coincident = T::MoveMask ( T::Greater ( SmallNumber, Distance ) );
+
+            while ( HitMask != 0 )
+            {
+                const int Lane = std::countr_zero ( static_cast<unsigned> ( HitMask ) );
+                HitMask &= HitMask - 1;
+                SContact & Contact = OutContacts [ NumberOfContacts++ ];
+                Contact . BodyA = IndexA [ Lane ];
+                Contact . BodyB = IndexB [ Lane ];
+                if ( Coincident & ( 1 << Lane ) )
+                {
+                    // Centers are the same, same fallback as TestSphereSphere
+                    Contact . Normal = { 1.f, 0.f, 0.f };
+                    Contact . Penetration = Lanes [ 7 ] [ Lane ];
+                    Contact . ContactPoint = { Batch . PositionX [ IndexA [ Lane ] ], Batch . PositionY [ IndexA [ Lane ] ], Batch . PositionZ [ IndexA [ Lane ] ] };
+                    continue;
+                }
+                Contact . Normal = { Lanes [ 0 ] [ Lane ], Lanes [ 1 ] [ Lane ], Lanes [ 2 ] [ Lane ] };
+                Contact . Penetration = Lanes [ 3 ] [ Lane ];
+                Contact . ContactPoint = { Lanes [ 4 ] [ Lane ], Lanes [ 5 ] [ Lane ], Lanes [ 6 ] [ Lane ] };
+            }
+        }
+        return NumberOfContacts;
+    }
+
+    /**
+     * @brief Raw views of the CBodyStorage streams and the box read by the sphere-in-box kernel.
+     */
+    struct SBoxBatch
+    {
+        const float * PositionX = nullptr;
+        const float * PositionY = nullptr;
+        const float * PositionZ = nullptr;
+        const float * Radii = nullptr;
+        const uint8_t * Flags = nullptr;
+        uint8_t SkipFlags = 0;
+        Vector3 Min { 0.f, 0.f, 0.f };
+        Vector3 Max { 0.f, 0.f, 0.f };
+        float Margin = 0.f;
+    };
+
+    /**
+     * Write the indices in [ Begin, End ) of the spheres that reach a wall of the box, T::Width bodies at a time.
+     * ( End - Begin ) must be a multiple of T::Width. Bodies with a skip flag and non-spheres (radius 0) never qualify.
+     * Only the distance to the nearest wall is compared, the caller works out which walls are touched.
+     * @return number of indices written
+     */
+    template <typename T>
+    int FindSpheresReachingBoxBatch ( const SBoxBatch & Batch, int Begin, int End, int * OutIndices )
+    {
+        using V = typename T::Type;
+        const V MinX = T::Set1 ( Batch . Min . x );
+        const V MinY = T::Set1 ( Batch . Min . y );
+        const V MinZ = T::Set1 ( Batch . Min . z );
+        const V MaxX = T::Set1 ( Batch . Max . x );
+        const V MaxY = T::Set1 ( Batch . Max . y );
+        const V MaxZ = T::Set1 ( Batch . Max . z );
+        const V MarginV = T::Set1 ( Batch . Margin );
+        const V Zero = T::Set1 ( 0.f );
+        int NumberOfIndices = 0;
+        for ( int i = Begin; i < End; i += T::Width )
+        {
+            const V X = T::Load ( Batch . PositionX + i );
+            const V Y = T::Load ( Batch . PositionY + i );
+            const V Z = T::Load ( Batch . PositionZ + i );
+            const V Radius = T::Load ( Batch . Radii + i );
+            const V NearestX = T::Min ( T::Sub ( X, MinX ), T::Sub ( MaxX, X ) );
+            const V NearestY = T::Min ( T::Sub ( Y, MinY ), T::Sub ( MaxY, Y ) );
+            const V NearestZ = T::Min ( T::Sub ( Z, MinZ ), T::Sub ( MaxZ, Z ) );
+            const V Nearest = T::Min ( T::Min ( NearestX, NearestY ), NearestZ );
+            const V Reaches = T::And ( T::LessEqual ( Nearest, T::Add ( Radius, MarginV ) ), T::Greater ( Radius, Zero ) );
+            int HitMask = T::MoveMask ( T::And ( Reaches, T::FlagsClear ( Batch . Flags + i, Batch . SkipFlags ) ) );
+            while ( HitMask != 0 )
+            {
+                OutIndices [ NumberOfIndices++ ] = i + std::countr_zero ( static_cast<unsigned> ( HitMask ) );
+                HitMask &= HitMask - 1;
+            }
+        }
+        return NumberOfIndices;
+    }
+
+    /** AVX2 instantiation of TestSphereSphereBatch, compiled in its own translation unit with AVX2 enabled. */
+    int TestSphereSphereBatchAVX2 ( const SSphereBatch & Batch, const SBroadphasePair * Pairs, int NumberOfPairs, SContact * OutContacts, float Margin );
+
+    /** AVX2 instantiation of FindSpheresReachingBoxBatch. */
+    int FindSpheresReachingBoxBatchAVX2 ( const SBoxBatch & Batch, int Begin, int End, int * OutIndices );
+
+    /** false when the AVX2 translation unit was built without AVX2 support (non-x86 targets). */
+    bool HasSphereSphereAVX2Kernel ();
+} // namespace Collision
+} // namespace PE
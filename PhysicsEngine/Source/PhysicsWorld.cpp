@@ -0,0 +1,800 @@
+#include "PhysicsWorld.hpp"
+#include "Integration.hpp"
+#include "Solver.hpp"
+#include "Spawn.hpp"
+#include "raymath.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace PE
+{
+namespace
+{
+    // Weight of the latest step in the step time estimate, high enough to follow a growing scene within a few frames
+    constexpr double GStepEstimateWeight = 0.25;
+} // namespace
+
+    CPhysicsWorld::CPhysicsWorld( const SSimulationParameters & SimulationParameters )
+    {
+        SetSimulationParameters ( SimulationParameters );
+    }
+
+    void CPhysicsWorld::SetSimulationParameters( const SSimulationParameters & SimulationParameters )
+    {
+        m_SimulationParameters = SimulationParameters;
+        m_NumberOfSpawnedBalls = 0;
+        m_WorldBox = { .min = SimulationParameters . WorldBoxMin, .max = SimulationParameters . WorldBoxMax };
+        m_FixedDeltaTime = 1.f / static_cast<float> ( SimulationParameters . SimulationFrequency );
+        m_Broadphase = CreateBroadphase ( SimulationParameters );
+        m_IsBroadphaseCurrent = false;
+        m_Narrowphase . SetSimdLevel ( SimulationParameters . SimdLevel );
+        m_Narrowphase . SetContactMargin ( SimulationParameters . ContactMargin );
+        m_ContactCache . Clear();
+        if ( ! m_JobSystem || m_JobSystem -> GetNumberOfThreads() != CJobSystem::ResolveNumberOfThreads ( SimulationParameters . NumberOfThreads ) )
+        {
+            m_JobSystem = std::make_unique<CJobSystem> ( SimulationParameters . NumberOfThreads );
+        }
+        if ( ! SimulationParameters . AllowSleeping )
+        {
+            for ( int i = 0; i < m_Bodies . Size(); i++ )
+            {
+                m_NumberOfAwakeBodies += m_Bodies . WakeIsland ( i );
+            }
+        }
+    }
+
+    int CPhysicsWorld::AddBody( const SPhysicsBody & Body )
+    {
+        const int Handle = m_Bodies . Add ( Body );
+        if ( Handle < 0 )
+        {
+            return -1;
+        }
+        // Added bodies start awake
+        m_NumberOfAwakeBodies += Body . IsStatic ? 0 : 1;
+        m_NumberOfBalls += IsBall ( m_Bodies . GetIndex ( Handle ) ) ? 1 : 0;
+        m_IsBroadphaseCurrent = false;
+        return Handle;
+    }
+
+    int CPhysicsWorld::SpawnBalls( int NumberOfBalls, const SBallGenerationParameters & BallGenerationParameters )
+    {
+        SPhysicsBody Template;
+        Template . Restitution = m_SimulationParameters . BallsRestitution;
+        Template . Friction = m_SimulationParameters . BallFriction;
+        Template . AngularDamping = m_SimulationParameters . AngularDamping;
+        Template . LinearDamping = m_SimulationParameters . LinearDamping;
+        const int FirstIndex = Spawn::SpawnBalls ( m_Bodies, *m_JobSystem, NumberOfBalls, BallGenerationParameters, Template,
+                                                   m_SimulationParameters . RandomSeed, m_NumberOfSpawnedBalls );
+        if ( FirstIndex < 0 )
+        {
+            return -1;
+        }
+        m_NumberOfSpawnedBalls += NumberOfBalls;
+        m_IsBroadphaseCurrent = false;
+        m_NumberOfBalls += NumberOfBalls;
+        m_NumberOfAwakeBodies += NumberOfBalls;
+        return FirstIndex;
+    }
+
+    bool CPhysicsWorld::RemoveBody( int Handle )
+    {
+        const int Index = m_Bodies . GetIndex ( Handle );
+        if ( Index < 0 )
+        {
+            return false;
+        }
+        // Bodies resting on it would hang in the air
+        m_NumberOfAwakeBodies += m_Bodies . WakeIsland ( Index );
+        m_NumberOfAwakeBodies -= m_Bodies . IsAwake ( Index ) ? 1 : 0;
+        m_NumberOfBalls -= IsBall ( Index ) ? 1 : 0;
+        for ( int & WallHandle : m_WallHandles )
+        {
+            WallHandle = WallHandle == Handle ? -1 : WallHandle;
+        }
+        if ( m_Broadphase )
+        {
+            m_Broadphase -> RemoveBody ( m_Bodies, Index );
+        }
+        m_Bodies . Remove ( Handle );
+        m_IsBroadphaseCurrent = false;
+        // Found by dense index, the last body moved
+        m_BroadphasePairs . clear();
+        m_Contacts . clear();
+        return true;
+    }
+
+    void CPhysicsWorld::Clear()
+    {
+        m_Bodies . Clear();
+        m_IsBroadphaseCurrent = false;
+        m_TimeAccumulator = 0.f;
+        m_StepMsEstimate = 0.0;
+        m_NumberOfOverruns = 0;
+        m_NumberOfDroppedSteps = 0;
+        m_NumberOfBalls = 0;
+        m_NumberOfPairTests = 0;
+        m_NumberOfContacts = 0;
+        m_NumberOfClampedBodies = 0;
+        m_BroadphasePairs . clear();
+        m_Contacts . clear();
+        m_ContactCache . Clear();
+        m_NumberOfWarmStartedContacts = 0;
+        m_NumberOfAwakeBodies = 0;
+        m_NextSleepIsland = 0;
+        m_StepsUntilOrderCheck = 0;
+        m_NumberOfBodySorts = 0;
+        m_BodyDisorder = 0.f;
+        m_WallHandles . fill ( -1 );
+#if PE_ENABLE_PROFILING
+        m_Profiler . Clear();
+#endif
+        if ( m_Broadphase )
+        {
+            m_Broadphase -> Clear();
+        }
+    }
+
+    void CPhysicsWorld::Restart()
+    {
+        Clear();
+        m_WorldBox = { .min = m_SimulationParameters . WorldBoxMin, .max = m_SimulationParameters . WorldBoxMax };
+        std::array<SPhysicsBody, 6> WorldPlanes = BoundingBoxToPlanes ( m_WorldBox );
+        m_Bodies . Reserve ( m_SimulationParameters . NumberOfBalls + static_cast<int> ( WorldPlanes . size() ) );
+        SpawnBalls ( m_SimulationParameters . NumberOfBalls, m_SimulationParameters . BallGenerationParameters );
+        for ( size_t Wall = 0; Wall < WorldPlanes . size(); Wall++ )
+        {
+            m_WallHandles [ Wall ] = m_Bodies . Add ( WorldPlanes [ Wall ] );
+            m_Bodies . Flags [ m_Bodies . GetIndex ( m_WallHandles [ Wall ] ) ] |= static_cast<uint8_t> ( EBodyFlags::WorldBoundary );
+        }
+    }
+
+    CSceneQuery CPhysicsWorld::GetSceneQuery()
+    {
+        if ( ! m_IsBroadphaseCurrent )
+        {
+            CTraceScope Trace ( "SceneQuery::UpdateBroadphase" );
+            m_Broadphase -> Update ( m_Bodies );
+            m_IsBroadphaseCurrent = true;
+        }
+        // Walls removed by hand are skipped, the rest still stay out of the broadphase
+        std::array<int, 6> Walls;
+        int NumberOfWalls = 0;
+        for ( const int WallHandle : m_WallHandles )
+        {
+            const int Index = WallHandle < 0 ? -1 : m_Bodies . GetIndex ( WallHandle );
+            if ( Index >= 0 )
+            {
+                Walls [ NumberOfWalls++ ] = Index;
+            }
+        }
+        return CSceneQuery ( m_Bodies, *m_Broadphase, std::span<const int> ( Walls . data(), NumberOfWalls ) );
+    }
+
+    bool CPhysicsWorld::GetBoundary( std::array<int, 6> & OutWalls, BoundingBox & OutBox ) const
+    {
+        // A removed wall's side moves out of reach, the spheres leave the box through it
+        constexpr float Far = std::numeric_limits<float>::max();
+        OutBox = m_WorldBox;
+        bool HasWalls = false;
+        for ( size_t Wall = 0; Wall < OutWalls . size(); Wall++ )
+        {
+            OutWalls [ Wall ] = m_WallHandles [ Wall ] < 0 ? -1 : m_Bodies . GetIndex ( m_WallHandles [ Wall ] );
+            HasWalls |= OutWalls [ Wall ] >= 0;
+            if ( OutWalls [ Wall ] < 0 )
+            {
+                Vector3 & Side = Wall % 2 == 1 ? OutBox . max : OutBox . min;
+                const size_t Axis = Wall / 2;
+                ( Axis == 0 ? Side . x : ( Axis == 1 ? Side . y : Side . z ) ) = Wall % 2 == 1 ? Far : -Far;
+            }
+        }
+        return HasWalls;
+    }
+
+    bool CPhysicsWorld::IsBall( int Index ) const
+    {
+        return ! m_Bodies . IsStatic ( Index ) && m_Bodies . Shapes [ Index ] . Type == EShapeType::Sphere;
+    }
+
+    int CPhysicsWorld::Update( float DeltaTime )
+    {
+        CTraceScope Trace ( "World::Update" );
+        int NumberOfSteps = 0;
+        m_TimeAccumulator += DeltaTime;
+        const int MaxSteps = m_SimulationParameters . MaxStepsPerUpdate;
+        const double BudgetMs = m_SimulationParameters . UpdateBudgetMs;
+        const double UpdateStartMs = BudgetMs > 0.0 ? CProfiler::NowMs() : 0.0;
+        double StepStartMs = UpdateStartMs;
+#if PE_ENABLE_PROFILING
+        m_IsUpdating = true;
+#endif
+        while ( m_TimeAccumulator >= m_FixedDeltaTime )
+        {
+            // The first step always runs, so the simulation keeps moving however slow a step gets
+            if ( NumberOfSteps > 0 && ( ( MaxSteps > 0 && NumberOfSteps >= MaxSteps ) ||
+                                        ( BudgetMs > 0.0 && StepStartMs - UpdateStartMs + m_StepMsEstimate > BudgetMs ) ) )
+            {
+                break;
+            }
+            Step ( m_FixedDeltaTime );
+            m_TimeAccumulator -= m_FixedDeltaTime;
+            NumberOfSteps++;
+            if ( BudgetMs > 0.0 )
+            {
+                const double StepEndMs = CProfiler::NowMs();
+                const double StepMs = StepEndMs - StepStartMs;
+                m_StepMsEstimate = m_StepMsEstimate > 0.0 ? m_StepMsEstimate + GStepEstimateWeight * ( StepMs - m_StepMsEstimate ) : StepMs;
+                StepStartMs = StepEndMs;
+            }
+        }
+        int DroppedSteps = 0;
+        if ( m_TimeAccumulator >= m_FixedDeltaTime )
+        {
+            // Carrying the backlog over would make the next frame even longer, keep only the fraction of a step
+            DroppedSteps = static_cast<int> ( m_TimeAccumulator / m_FixedDeltaTime );
+            m_TimeAccumulator -= static_cast<float> ( DroppedSteps ) * m_FixedDeltaTime;
+            m_NumberOfOverruns++;
+            m_NumberOfDroppedSteps += DroppedSteps;
+        }
+        Trace . AddArg ( "steps", NumberOfSteps );
+        Trace . AddArg ( "dropped_steps", DroppedSteps );
+#if PE_ENABLE_PROFILING
+        m_IsUpdating = false;
+        m_Profiler . EndFrame();
+#endif
+        return NumberOfSteps;
+    }
+
+    void CPhysicsWorld::Step( float DeltaTime )
+    {
+        CTraceScope Trace ( "Step" );
+#if PE_ENABLE_PROFILING
+        const double StepStartMs = CProfiler::NowMs();
+#endif
+        // The solver moves bodies after the broadphase update
+        m_IsBroadphaseCurrent = false;
+        UpdateBodyOrder();
+#if PE_ENABLE_PROFILING
+        m_Profiler . AddPhaseTime ( EProfilePhase::BodyOrder, CProfiler::NowMs() - StepStartMs );
+#endif
+        BuildStepGraph ( DeltaTime );
+        m_JobSystem -> Run ( m_StepGraph );
+        Trace . AddArg ( "bodies", m_Bodies . Size() );
+        Trace . AddArg ( "contacts", m_NumberOfContacts );
+#if PE_ENABLE_PROFILING
+        RecordStepProfile ( CProfiler::NowMs() - StepStartMs );
+#endif
+    }
+
+    SPhysicsStats CPhysicsWorld::GetStats() const
+    {
+#if PE_ENABLE_PROFILING
+        return m_Profiler . GetStats();
+#else
+        return {};
+#endif
+    }
+
+#if PE_ENABLE_PROFILING
+    void CPhysicsWorld::RecordStepProfile( double StepMs )
+    {
+        // Wall time of the jobs, so a phase spread over the threads counts once
+        const std::span<const SJobStats> Jobs = m_StepGraph . GetStats();
+        for ( size_t Job = 0; Job < Jobs . size(); Job++ )
+        {
+            m_Profiler . AddPhaseTime ( m_StepJobPhases [ Job ], Jobs [ Job ] . EndMs - Jobs [ Job ] . StartMs );
+        }
+        m_Profiler . AddPhaseTime ( EProfilePhase::Step, StepMs );
+        m_Profiler . AddStep ( m_NumberOfPairTests, m_NumberOfContacts, m_SimulationParameters . NumberOfSteps );
+        if ( ! m_IsUpdating )
+        {
+            m_Profiler . EndFrame();
+        }
+    }
+#endif
+
+    void CPhysicsWorld::UpdateBodyOrder()
+    {
+        if ( m_SimulationParameters . BodyOrderCheckInterval <= 0 || --m_StepsUntilOrderCheck > 0 )
+        {
+            return;
+        }
+        m_StepsUntilOrderCheck = m_SimulationParameters . BodyOrderCheckInterval;
+        CTraceScope Trace ( "BodyOrder" );
+        Trace . AddArg ( "bodies", m_Bodies . Size() );
+        m_BodyDisorder = m_BodyOrder . Measure ( m_Bodies );
+        if ( m_BodyDisorder > m_SimulationParameters . BodyOrderDisorderThreshold || m_SimulationParameters . BodyOrderDisorderThreshold <= 0.f )
+        {
+            SortMeasuredBodies();
+        }
+    }
+
+    void CPhysicsWorld::SortBodies()
+    {
+        m_BodyOrder . Measure ( m_Bodies );
+        SortMeasuredBodies();
+    }
+
+    void CPhysicsWorld::SortMeasuredBodies()
+    {
+        // Everything else indexed by body either lives in the storage, is keyed by handle (contact cache, walls)
+        // or is rebuilt every step (contacts, islands, colors). The previous step's contacts would point at
+        // the wrong bodies, they are dropped.
+        const std::span<const int> NewToOld = m_BodyOrder . Sort();
+        m_Bodies . Permute ( NewToOld );
+        m_IsBroadphaseCurrent = false;
+        if ( m_Broadphase )
+        {
+            m_Broadphase -> RemapBodies ( NewToOld );
+        }
+        m_BroadphasePairs . clear();
+        m_Contacts . clear();
+        m_BodyDisorder = 0.f;
+        m_NumberOfBodySorts++;
+    }
+
+    void CPhysicsWorld::BuildStepGraph( float DeltaTime )
+    {
+        // Rebuilt every step, the jobs capture this and the step length. The stages mostly depend on each other in a chain
+        // (the boundary stage runs beside the broadphase), the parallelism is within them: body ranges, pair ranges, then
+        // islands or colors inside the solve job.
+        m_StepGraph . Clear();
+        m_StepJobPhases . clear();
+        const auto InPhase = [ this ] ( int Job, EProfilePhase Phase )
+        {
+            m_StepJobPhases . resize ( std::max<size_t> ( m_StepJobPhases . size(), Job + 1 ) );
+            m_StepJobPhases [ Job ] = Phase;
+            return Job;
+        };
+        const int NumberOfBodies = m_Bodies . Size();
+        const int NumberOfBodyTasks = ( NumberOfBodies + GBodiesPerTask - 1 ) / GBodiesPerTask;
+        const int Integrate = InPhase ( m_StepGraph . AddJob ( "Integrate", [ this, DeltaTime, NumberOfBodyTasks ]
+        {
+            // Once per step, every task reads the same per-material tables
+            Integration::ComputeDampingFactors ( m_Bodies, DeltaTime, m_LinearDampingFactors, m_AngularDampingFactors );
+            return NumberOfBodyTasks;
+        }, [ this, DeltaTime, NumberOfBodies ] ( int Task )
+        {
+            const Vector3 Gravity = { 0.f, -m_SimulationParameters . Gravity, 0.f };
+            const int Begin = Task * GBodiesPerTask;
+            const int End = std::min ( Begin + GBodiesPerTask, NumberOfBodies );
+            CTraceScope Trace ( "Integrate" );
+            Trace . AddArg ( "bodies", End - Begin );
+            Integration::Integrate ( m_Bodies, Begin, End, DeltaTime, Gravity, m_LinearDampingFactors, m_AngularDampingFactors,
+                                     m_SimulationParameters . SimdLevel );
+        } ), EProfilePhase::Integrate );
+        const int ContinuousCollision = InPhase ( m_StepGraph . AddJob ( "ContinuousCollision", m_SimulationParameters . ContinuousCollision ? 1 : 0, [ this, DeltaTime ] ( int )
+        {
+            CTraceScope Trace ( "ContinuousCollision" );
+            SweepFastBodies ( DeltaTime );
+            Trace . AddArg ( "swept", m_ContinuousCollision . GetNumberOfSweptBodies() );
+            Trace . AddArg ( "clamped", m_NumberOfClampedBodies );
+        } ), EProfilePhase::ContinuousCollision );
+        // The walls never reach the broadphase, the spheres are tested against the world box alongside it
+        std::array<int, 6> Walls;
+        BoundingBox BoundaryBox;
+        const bool HasWalls = GetBoundary ( Walls, BoundaryBox );
+        m_BoundaryTaskContacts . resize ( std::max ( m_BoundaryTaskContacts . size(), static_cast<size_t> ( NumberOfBodyTasks ) ) );
+        const int WorldBoundary = InPhase ( m_StepGraph . AddJob ( "WorldBoundary", HasWalls ? NumberOfBodyTasks : 0, [ this, NumberOfBodies, Walls, BoundaryBox ] ( int Task )
+        {
+            const int Begin = Task * GBodiesPerTask;
+            const int End = std::min ( Begin + GBodiesPerTask, NumberOfBodies );
+            CTraceScope Trace ( "WorldBoundary" );
+            Trace . AddArg ( "bodies", End - Begin );
+            Collision::TestSpheresInsideBox ( m_Bodies, Begin, End, BoundaryBox, Walls,
+                                              m_BoundaryTaskContacts [ Task ], m_SimulationParameters . SimdLevel, m_SimulationParameters . ContactMargin );
+            Trace . AddArg ( "contacts", static_cast<int64_t> ( m_BoundaryTaskContacts [ Task ] . size() ) );
+        } ), EProfilePhase::WorldBoundary );
+        const int BroadphaseUpdate = InPhase ( m_StepGraph . AddJob ( "BroadphaseUpdate", 1, [ this ] ( int )
+        {
+            CTraceScope Trace ( "BroadphaseUpdate" );
+            Trace . AddArg ( "bodies", m_Bodies . Size() );
+            m_Broadphase -> Update ( m_Bodies );
+        } ), EProfilePhase::Broadphase );
+        const int FindPairs = InPhase ( m_StepGraph . AddJob ( "FindPairs", 1, [ this ] ( int )
+        {
+            CTraceScope Trace ( "FindPairs" );
+            m_BroadphasePairs . clear();
+            m_Broadphase -> FindPairs ( m_BroadphasePairs );
+            Trace . AddArg ( "pairs", static_cast<int64_t> ( m_BroadphasePairs . size() ) );
+        } ), EProfilePhase::Broadphase );
+        const int Narrowphase = InPhase ( m_StepGraph . AddJob ( "Narrowphase", [ this ]
+        {
+            const int NumberOfTasks = static_cast<int> ( ( m_BroadphasePairs . size() + GPairsPerNarrowphaseTask - 1 ) / GPairsPerNarrowphaseTask );
+            if ( static_cast<int> ( m_NarrowphaseTasks . size() ) < NumberOfTasks )
+            {
+                m_NarrowphaseTasks . resize ( NumberOfTasks );
+                m_TaskContacts . resize ( NumberOfTasks );
+            }
+            for ( int Task = 0; Task < NumberOfTasks; Task++ )
+            {
+                m_NarrowphaseTasks [ Task ] . SetSimdLevel ( m_SimulationParameters . SimdLevel );
+                m_NarrowphaseTasks [ Task ] . SetContactMargin ( m_SimulationParameters . ContactMargin );
+            }
+            return NumberOfTasks;
+        }, [ this ] ( int Task )
+        {
+            const std::span<const SBroadphasePair> Pairs ( m_BroadphasePairs );
+            const size_t Begin = static_cast<size_t> ( Task ) * GPairsPerNarrowphaseTask;
+            const std::span<const SBroadphasePair> TaskPairs = Pairs . subspan ( Begin, std::min<size_t> ( GPairsPerNarrowphaseTask, Pairs . size() - Begin ) );
+            CTraceScope Trace ( "Narrowphase" );
+            Trace . AddArg ( "pairs", static_cast<int64_t> ( TaskPairs . size() ) );
+            m_NarrowphaseTasks [ Task ] . GenerateContacts ( m_Bodies, TaskPairs, m_TaskContacts [ Task ] );
+            Trace . AddArg ( "contacts", static_cast<int64_t> ( m_TaskContacts [ Task ] . size() ) );
+        } ), EProfilePhase::Narrowphase );
+        const int Solve = InPhase ( m_StepGraph . AddJob ( "Solve", 1, [ this, DeltaTime, HasWalls, NumberOfBodyTasks ] ( int )
+        {
+            // Pairs and bodies come sorted, so the task outputs concatenate to the same sorted lists a single call produces
+            CTraceScope Trace ( "Solve" );
+            m_Contacts . clear();
+            const size_t NumberOfTasks = ( m_BroadphasePairs . size() + GPairsPerNarrowphaseTask - 1 ) / GPairsPerNarrowphaseTask;
+            for ( size_t Task = 0; Task < NumberOfTasks; Task++ )
+            {
+                m_Contacts . insert ( m_Contacts . end(), m_TaskContacts [ Task ] . begin(), m_TaskContacts [ Task ] . end() );
+            }
+            // Wall contacts go last, so every island solves them after its sphere contacts whatever the body order
+            for ( int Task = 0; HasWalls && Task < NumberOfBodyTasks; Task++ )
+            {
+                m_Contacts . insert ( m_Contacts . end(), m_BoundaryTaskContacts [ Task ] . begin(), m_BoundaryTaskContacts [ Task ] . end() );
+            }
+            Trace . AddArg ( "contacts", static_cast<int64_t> ( m_Contacts . size() ) );
+            SolveContacts ( DeltaTime );
+            Trace . AddArg ( "islands", m_Islands . GetNumberOfIslands() );
+        } ), EProfilePhase::Solve );
+        const int Sleeping = InPhase ( m_StepGraph . AddJob ( "Sleeping", 1, [ this, DeltaTime ] ( int )
+        {
+            CTraceScope Trace ( "Sleeping" );
+            UpdateSleeping ( DeltaTime );
+            Trace . AddArg ( "awake", m_NumberOfAwakeBodies );
+        } ), EProfilePhase::Sleeping );
+        m_StepGraph . AddDependency ( ContinuousCollision, Integrate );
+        m_StepGraph . AddDependency ( BroadphaseUpdate, ContinuousCollision );
+        m_StepGraph . AddDependency ( WorldBoundary, ContinuousCollision );
+        m_StepGraph . AddDependency ( FindPairs, BroadphaseUpdate );
+        m_StepGraph . AddDependency ( Narrowphase, FindPairs );
+        m_StepGraph . AddDependency ( Solve, Narrowphase );
+        m_StepGraph . AddDependency ( Solve, WorldBoundary );
+        m_StepGraph . AddDependency ( Sleeping, Solve );
+    }
+
+    void CPhysicsWorld::WakeBody( int Handle )
+    {
+        const int Index = m_Bodies . GetIndex ( Handle );
+        if ( Index < 0 )
+        {
+            return;
+        }
+        m_NumberOfAwakeBodies += m_Bodies . WakeIsland ( Index );
+    }
+
+    void CPhysicsWorld::IntegrateForces( float DeltaTime )
+    {
+        const Vector3 Gravity = { 0.f, -m_SimulationParameters . Gravity, 0.f };
+        Integration::ComputeDampingFactors ( m_Bodies, DeltaTime, m_LinearDampingFactors, m_AngularDampingFactors );
+        Integration::Integrate ( m_Bodies, 0, m_Bodies . Size(), DeltaTime, Gravity, m_LinearDampingFactors, m_AngularDampingFactors,
+                                 m_SimulationParameters . SimdLevel );
+    }
+
+    void CPhysicsWorld::SweepFastBodies( float DeltaTime )
+    {
+        m_NumberOfClampedBodies = 0;
+        if ( ! m_SimulationParameters . ContinuousCollision )
+        {
+            return;
+        }
+        std::array<int, 6> Walls;
+        BoundingBox BoundaryBox;
+        m_NumberOfClampedBodies = m_ContinuousCollision . Apply ( m_Bodies, DeltaTime, m_SimulationParameters . ContinuousCollisionThreshold,
+                                                                  GetBoundary ( Walls, BoundaryBox ) ? &BoundaryBox : nullptr );
+    }
+
+    void CPhysicsWorld::ResolveCollisions(float DeltaTime)
+    {
+        // Collision detection runs once per step, solver iterations reuse the contact list
+        SweepFastBodies ( DeltaTime );
+        m_Broadphase -> Update ( m_Bodies );
+        m_BroadphasePairs . clear();
+        m_Broadphase -> FindPairs ( m_BroadphasePairs );
+        m_Narrowphase . GenerateContacts ( m_Bodies, m_BroadphasePairs, m_Contacts );
+        std::array<int, 6> Walls;
+        BoundingBox BoundaryBox;
+        if ( GetBoundary ( Walls, BoundaryBox ) )
+        {
+            Collision::TestSpheresInsideBox ( m_Bodies, 0, m_Bodies . Size(), BoundaryBox, Walls, m_BoundaryContacts,
+                                              m_SimulationParameters . SimdLevel, m_SimulationParameters . ContactMargin );
+            m_Contacts . insert ( m_Contacts . end(), m_BoundaryContacts . begin(), m_BoundaryContacts . end() );
+        }
+        SolveContacts ( DeltaTime );
+    }
+
+    void CPhysicsWorld::SolveContacts( float DeltaTime )
+    {
+        WakeTouchedIslands();
+
+        // Islands share no dynamic body, ordering the contacts island by island gives each one a contiguous range.
+        // Within an island (or color) the contacts keep their generation order, so the result doesn't depend on the thread count.
+        m_Islands . Build ( m_Bodies, m_Contacts );
+        const bool IsGraphColored = m_SimulationParameters . SolverType == ESolverType::GraphColored;
+        m_NumberOfColors = IsGraphColored ? m_Coloring . Build ( m_Bodies, m_Contacts ) : 0;
+        ReorderContacts ( IsGraphColored ? m_Coloring . GetOrderedContacts() : m_Islands . GetOrderedContacts() );
+
+        m_NumberOfPairTests = static_cast<int> ( m_BroadphasePairs . size() );
+        m_NumberOfContacts = static_cast<int> ( m_Contacts . size() );
+        m_NumberOfWarmStartedContacts = 0;
+        if ( m_SimulationParameters . WarmStarting )
+        {
+            m_NumberOfWarmStartedContacts = m_ContactCache . Restore ( m_Bodies, m_Contacts );
+        }
+        if ( IsGraphColored )
+        {
+            SolveColors ( DeltaTime );
+        }
+        else
+        {
+            SolveIslands ( DeltaTime );
+        }
+        if ( m_SimulationParameters . WarmStarting )
+        {
+            m_ContactCache . Store ( m_Bodies, m_Contacts );
+        }
+    }
+
+    void CPhysicsWorld::ReorderContacts( std::span<const int> Order )
+    {
+        m_ReorderedContacts . clear();
+        for ( const int ContactIndex : Order )
+        {
+            m_ReorderedContacts . push_back ( m_Contacts [ ContactIndex ] );
+        }
+        std::swap ( m_Contacts, m_ReorderedContacts );
+    }
+
+    void CPhysicsWorld::SolveIslands( float DeltaTime )
+    {
+        // Consecutive islands are batched to about GContactsPerBatch contacts, one batch per task keeps the
+        // scheduling cost low for the many tiny islands. Islands without contacts have nothing to solve.
+        const int NumberOfIslands = m_Islands . GetNumberOfIslands();
+        m_SolverIslands . clear();
+        m_IslandBatchStarts . clear();
+        int ContactsInBatch = GContactsPerBatch;
+        for ( int Island = 0; Island < NumberOfIslands; Island++ )
+        {
+            if ( m_Islands . GetIslandContacts ( Island ) . empty() )
+            {
+                continue;
+            }
+            if ( ContactsInBatch >= GContactsPerBatch )
+            {
+                m_IslandBatchStarts . push_back ( static_cast<int> ( m_SolverIslands . size() ) );
+                ContactsInBatch = 0;
+            }
+            m_SolverIslands . push_back ( Island );
+            ContactsInBatch += static_cast<int> ( m_Islands . GetIslandContacts ( Island ) . size() );
+        }
+        const int NumberOfBatches = static_cast<int> ( m_IslandBatchStarts . size() );
+        m_IslandBatchStarts . push_back ( static_cast<int> ( m_SolverIslands . size() ) );
+        m_JobSystem -> ParallelFor ( NumberOfBatches, [ this, DeltaTime ] ( int Batch )
+        {
+            CTraceScope Trace ( "SolveIslandBatch" );
+            int64_t NumberOfContacts = 0;
+            for ( int i = m_IslandBatchStarts [ Batch ]; i < m_IslandBatchStarts [ Batch + 1 ]; i++ )
+            {
+                SolveIsland ( m_SolverIslands [ i ], DeltaTime );
+                NumberOfContacts += static_cast<int64_t> ( m_Islands . GetIslandContacts ( m_SolverIslands [ i ] ) . size() );
+            }
+            Trace . AddArg ( "islands", m_IslandBatchStarts [ Batch + 1 ] - m_IslandBatchStarts [ Batch ] );
+            Trace . AddArg ( "contacts", NumberOfContacts );
+        } );
+    }
+
+    void CPhysicsWorld::SolveColors( float DeltaTime )
+    {
+        // Runs Function on batches of GContactsPerBatch contacts of a color, in parallel unless the color may share bodies
+        const auto ForEachBatch = [ this ] ( int Color, const auto & Function )
+        {
+            const std::span<SContact> Contacts ( m_Contacts . data() + m_Coloring . GetColorStart ( Color ), m_Coloring . GetColorContacts ( Color ) . size() );
+            if ( m_Coloring . IsSequential ( Color ) )
+            {
+                Function ( Contacts );
+                return;
+            }
+            const int NumberOfBatches = static_cast<int> ( ( Contacts . size() + GContactsPerBatch - 1 ) / GContactsPerBatch );
+            m_JobSystem -> ParallelFor ( NumberOfBatches, [ & ] ( int Batch )
+            {
+                Function ( Contacts . subspan ( Batch * GContactsPerBatch, std::min<size_t> ( GContactsPerBatch, Contacts . size() - Batch * GContactsPerBatch ) ) );
+            } );
+        };
+
+        // Preparing only reads the bodies, every color can go at once
+        const int NumberOfBatches = static_cast<int> ( ( m_Contacts . size() + GContactsPerBatch - 1 ) / GContactsPerBatch );
+        m_JobSystem -> ParallelFor ( NumberOfBatches, [ this, DeltaTime ] ( int Batch )
+        {
+            const std::span<SContact> Contacts ( m_Contacts );
+            Solver::PrepareContacts ( m_Bodies, Contacts . subspan ( Batch * GContactsPerBatch, std::min<size_t> ( GContactsPerBatch, Contacts . size() - Batch * GContactsPerBatch ) ),
+                                      m_SimulationParameters, DeltaTime );
+        } );
+        if ( m_SimulationParameters . WarmStarting )
+        {
+            for ( int Color = 0; Color < m_NumberOfColors; Color++ )
+            {
+                ForEachBatch ( Color, [ this ] ( std::span<SContact> Contacts ) { Solver::WarmStart ( m_Bodies, Contacts ); } );
+            }
+        }
+        const float Slop = m_SimulationParameters . Slop;
+        const float MaxCorrection = m_SimulationParameters . MaxPositionCorrection;
+        for ( int Iteration = 0; Iteration < m_SimulationParameters . NumberOfSteps; Iteration++ )
+        {
+            for ( int Color = 0; Color < m_NumberOfColors; Color++ )
+            {
+                // One event per color pass, per batch would flood the ring with tiny spans
+                CTraceScope Trace ( "SolveColor" );
+                Trace . AddArg ( "color", Color );
+                Trace . AddArg ( "contacts", static_cast<int64_t> ( m_Coloring . GetColorContacts ( Color ) . size() ) );
+                ForEachBatch ( Color, [ this, Slop, MaxCorrection ] ( std::span<SContact> Contacts )
+                {
+                    for ( SContact & Contact : Contacts )
+                    {
+                        Solver::SolveContact ( m_Bodies, Contact, Slop, MaxCorrection );
+                    }
+                } );
+            }
+        }
+    }
+
+    void CPhysicsWorld::SolveIsland( int Island, float DeltaTime )
+    {
+        const std::span<SContact> Contacts ( m_Contacts . data() + m_Islands . GetIslandContactStart ( Island ), m_Islands . GetIslandContacts ( Island ) . size() );
+        Solver::PrepareContacts ( m_Bodies, Contacts, m_SimulationParameters, DeltaTime );
+        if ( m_SimulationParameters . WarmStarting )
+        {
+            Solver::WarmStart ( m_Bodies, Contacts );
+        }
+        Solver::SolveContacts ( m_Bodies, Contacts, m_SimulationParameters );
+    }
+
+    void CPhysicsWorld::WakeTouchedIslands()
+    {
+        // The broadphase never pairs two passive bodies, so a contact with a sleeper always comes from an awake body.
+        // A woken island is awake for its other contacts, each island is walked once.
+        for ( const SContact & Contact : m_Contacts )
+        {
+            m_NumberOfAwakeBodies += m_Bodies . WakeIsland ( Contact . BodyA );
+            m_NumberOfAwakeBodies += m_Bodies . WakeIsland ( Contact . BodyB );
+        }
+    }
+
+    void CPhysicsWorld::UpdateSleeping( float DeltaTime )
+    {
+        m_NumberOfAwakeBodies = 0;
+        const float LinearThresholdSquared = m_SimulationParameters . SleepLinearVelocity * m_SimulationParameters . SleepLinearVelocity;
+        const float AngularThresholdSquared = m_SimulationParameters . SleepAngularVelocity * m_SimulationParameters . SleepAngularVelocity;
+        for ( int i = 0; i < m_Bodies . Size(); i++ )
+        {
+            if ( ! m_Bodies . IsAwake ( i ) )
+            {
+                continue;
+            }
+            m_NumberOfAwakeBodies++;
+            const bool IsResting = Vector3LengthSqr ( m_Bodies . LinearVelocities . Get ( i ) ) < LinearThresholdSquared &&
+                                   Vector3LengthSqr ( m_Bodies . AngularVelocities . Get ( i ) ) < AngularThresholdSquared;
+            m_Bodies . SleepTimes [ i ] = IsResting ? m_Bodies . SleepTimes [ i ] + DeltaTime : 0.f;
+        }
+        if ( ! m_SimulationParameters . AllowSleeping )
+        {
+            return;
+        }
+
+        // An island sleeps only as a whole, once its most recently moving body rested long enough.
+        // The islands built for the solver are still valid, solving doesn't change which bodies are awake.
+        const int NumberOfIslands = m_Islands . GetNumberOfIslands();
+        for ( int Island = 0; Island < NumberOfIslands; Island++ )
+        {
+            const std::span<const int> IslandBodies = m_Islands . GetIslandBodies ( Island );
+            float MinSleepTime = m_SimulationParameters . TimeToSleep;
+            for ( const int Index : IslandBodies )
+            {
+                MinSleepTime = std::fmin ( MinSleepTime, m_Bodies . SleepTimes [ Index ] );
+            }
+            if ( MinSleepTime < m_SimulationParameters . TimeToSleep )
+            {
+                continue;
+            }
+            for ( const int Index : IslandBodies )
+            {
+                m_Bodies . LinearVelocities . Set ( Index, { 0.f, 0.f, 0.f } );
+                m_Bodies . AngularVelocities . Set ( Index, { 0.f, 0.f, 0.f } );
+            }
+            m_Bodies . PutIslandToSleep ( IslandBodies, m_NextSleepIsland );
+            m_NumberOfAwakeBodies -= static_cast<int> ( IslandBodies . size() );
+            m_NextSleepIsland++;
+        }
+    }
+
+    std::array<SPhysicsBody, 6> CPhysicsWorld::BoundingBoxToPlanes(const BoundingBox &Box) const
+    {
+        // Create 6 thin static box bodies representing the world planes (left, right, bottom, top, front, back)
+        std::array<SPhysicsBody, 6> OutPlanes{};
+        const Vector3 min = Box.min;
+        const Vector3 max = Box.max;
+
+        // left (x = min)
+        {
+            Vector3 center = { min.x, 0.5f * (min.y + max.y), 0.5f * (min.z + max.z) };
+            Vector3 half = { 0.f, 0.5f * (max.y - min.y), 0.5f * (max.z - min.z) };
+            OutPlanes[0] = SPhysicsBody{};
+            OutPlanes[0].Position = center;
+            OutPlanes[0].Rotation = QuaternionIdentity();
+            OutPlanes[0].Shape.Type = EShapeType::Box;
+            OutPlanes[0].Shape.Box.HalfSize = half;
+            OutPlanes[0].IsStatic = true;
+            OutPlanes[0].Mass = 0.f; OutPlanes[0].InvMass = 0.f;
+        }
+
+        // right (x = max)
+        {
+            Vector3 center = { max.x, 0.5f * (min.y + max.y), 0.5f * (min.z + max.z) };
+            Vector3 half = { 0.f, 0.5f * (max.y - min.y), 0.5f * (max.z - min.z) };
+            OutPlanes[1] = SPhysicsBody{};
+            OutPlanes[1].Position = center;
+            OutPlanes[1].Rotation = QuaternionIdentity();
+            OutPlanes[1].Shape.Type = EShapeType::Box;
+            OutPlanes[1].Shape.Box.HalfSize = half;
+            OutPlanes[1].IsStatic = true;
+            OutPlanes[1].Mass = 0.f; OutPlanes[1].InvMass = 0.f;
+        }
+
+        // bottom (y = min)
+        {
+            Vector3 center = { 0.5f * (min.x + max.x), min.y, 0.5f * (min.z + max.z) };
+            Vector3 half = { 0.5f * (max.x - min.x), 0.f, 0.5f * (max.z - min.z) };
+            OutPlanes[2] = SPhysicsBody{};
+            OutPlanes[2].Position = center;
+            OutPlanes[2].Rotation = QuaternionIdentity();
+            OutPlanes[2].Shape.Type = EShapeType::Box;
+            OutPlanes[2].Shape.Box.HalfSize = half;
+            OutPlanes[2].IsStatic = true;
+            OutPlanes[2].Mass = 0.f; OutPlanes[2].InvMass = 0.f;
+        }
+
+        // top (y = max)
+        {
+            Vector3 center = { 0.5f * (min.x + max.x), max.y, 0.5f * (min.z + max.z) };
+            Vector3 half = { 0.5f * (max.x - min.x), 0.f, 0.5f * (max.z - min.z) };
+            OutPlanes[3] = SPhysicsBody{};
+            OutPlanes[3].Position = center;
+            OutPlanes[3].Rotation = QuaternionIdentity();
+            OutPlanes[3].Shape.Type = EShapeType::Box;
+            OutPlanes[3].Shape.Box.HalfSize = half;
+            OutPlanes[3].IsStatic = true;
+            OutPlanes[3].Mass = 0.f; OutPlanes[3].InvMass = 0.f;
+        }
+
+        // front (z = min)
+        {
+            Vector3 center = { 0.5f * (min.x + max.x), 0.5f * (min.y + max.y), min.z };
+            Vector3 half = { 0.5f * (max.x - min.x), 0.5f * (max.y - min.y), 0.f };
+            OutPlanes[4] = SPhysicsBody{};
+            OutPlanes[4].Position = center;
+            OutPlanes[4].Rotation = QuaternionIdentity();
+            OutPlanes[4].Shape.Type = EShapeType::Box;
+            OutPlanes[4].Shape.Box.HalfSize = half;
+            OutPlanes[4].IsStatic = true;
+            OutPlanes[4].Mass = 0.f; OutPlanes[4].InvMass = 0.f;
+        }
+
+        // back (z = max)
+        {
+            Vector3 center = { 0.5f * (min.x + max.x), 0.5f * (min.y + max.y), max.z };
+            Vector3 half = { 0.5f * (max.x - min.x), 0.5f * (max.y - min.y), 0.f };
+            OutPlanes[5] = SPhysicsBody{};
+            OutPlanes[5].Position = center;
+            OutPlanes[5].Rotation = QuaternionIdentity();
+            OutPlanes[5].Shape.Type = EShapeType::Box;
+            OutPlanes[5].Shape.Box.HalfSize = half;
+            OutPlanes[5].IsStatic = true;
+            OutPlanes[5].Mass = 0.f; OutPlanes[5].InvMass = 0.f;
+        }
+        return OutPlanes;
+    }
+} // namespace PE
@@ -0,0 +1,128 @@
+#include "Profiling.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace PE
+{
+    const char * GetProfilePhaseName( EProfilePhase Phase )
+    {
+        switch ( Phase )
+        {
+            case EProfilePhase::BodyOrder: return "BodyOrder";
+            case EProfilePhase::Integrate: return "Integrate";
+            case EProfilePhase::ContinuousCollision: return "ContinuousCollision";
+            case EProfilePhase::WorldBoundary: return "WorldBoundary";
+            case EProfilePhase::Broadphase: return "Broadphase";
+            case EProfilePhase::Narrowphase: return "Narrowphase";
+            case EProfilePhase::Solve: return "Solve";
+            case EProfilePhase::Sleeping: return "Sleeping";
+            case EProfilePhase::Step: return "Step";
+            default: return "Unknown";
+        }
+    }
+
+    void CRollingWindow::Add( double Sample )
+    {
+        m_Samples [ m_Next ] = Sample;
+        m_Next = ( m_Next + 1 ) % GSize;
+        m_NumberOfSamples = std::min ( m_NumberOfSamples + 1, GSize );
+    }
+
+    SRollingStatistic CRollingWindow::Compute() const
+    {
+        SRollingStatistic Statistic;
+        Statistic . NumberOfSamples = m_NumberOfSamples;
+        if ( m_NumberOfSamples == 0 )
+        {
+            return Statistic;
+        }
+        // The window is full or filled from slot 0, either way the first m_NumberOfSamples slots hold the samples
+        std::array<double, GSize> Sorted;
+        std::copy_n ( m_Samples . begin(), m_NumberOfSamples, Sorted . begin() );
+        std::sort ( Sorted . begin(), Sorted . begin() + m_NumberOfSamples );
+        double Sum = 0.0;
+        for ( int i = 0; i < m_NumberOfSamples; i++ )
+        {
+            Sum += Sorted [ i ];
+        }
+        Statistic . Last = m_Samples [ ( m_Next + GSize - 1 ) % GSize ];
+        Statistic . Min = Sorted [ 0 ];
+        Statistic . Max = Sorted [ m_NumberOfSamples - 1 ];
+        Statistic . Avg = Sum / m_NumberOfSamples;
+        const int Rank = static_cast<int> ( std::ceil ( 0.99 * m_NumberOfSamples ) );
+        Statistic . P99 = Sorted [ std::max ( Rank, 1 ) - 1 ];
+        return Statistic;
+    }
+
+    void CRollingWindow::Clear()
+    {
+        m_Next = 0;
+        m_NumberOfSamples = 0;
+    }
+
+    void CProfiler::AddStep( int PairTests, int Contacts, int SolverIterations )
+    {
+        m_FramePairTests += PairTests;
+        m_FrameContacts += Contacts;
+        m_FrameSolverIterations += SolverIterations;
+        m_FrameSubsteps++;
+    }
+
+    void CProfiler::EndFrame()
+    {
+        if ( m_FrameSubsteps > 0 )
+        {
+            for ( size_t Phase = 0; Phase < m_PhaseWindows . size(); Phase++ )
+            {
+                m_PhaseWindows [ Phase ] . Add ( m_FramePhaseMs [ Phase ] );
+            }
+            m_PairTests . Add ( m_FramePairTests );
+            m_Contacts . Add ( m_FrameContacts );
+            m_SolverIterations . Add ( m_FrameSolverIterations );
+            m_Substeps . Add ( m_FrameSubsteps );
+        }
+        ResetFrame();
+    }
+
+    void CProfiler::ResetFrame()
+    {
+        m_FramePhaseMs . fill ( 0.0 );
+        m_FramePairTests = 0;
+        m_FrameContacts = 0;
+        m_FrameSolverIterations = 0;
+        m_FrameSubsteps = 0;
+    }
+
+    SPhysicsStats CProfiler::GetStats() const
+    {
+        SPhysicsStats Stats;
+        for ( size_t Phase = 0; Phase < m_PhaseWindows . size(); Phase++ )
+        {
+            Stats . PhaseMs [ Phase ] = m_PhaseWindows [ Phase ] . Compute();
+        }
+        Stats . PairTests = m_PairTests . Compute();
+        Stats . Contacts = m_Contacts . Compute();
+        Stats . SolverIterations = m_SolverIterations . Compute();
+        Stats . Substeps = m_Substeps . Compute();
+        return Stats;
+    }
+
+    void CProfiler::Clear()
+    {
+        ResetFrame();
+        for ( CRollingWindow & Window : m_PhaseWindows )
+        {
+            Window . Clear();
+        }
+        m_PairTests . Clear();
+        m_Contacts . Clear();
+        m_SolverIterations . Clear();
+        m_Substeps . Clear();
+    }
+
+    double CProfiler::NowMs()
+    {
+        return std::chrono::duration<double, std::milli> ( std::chrono::steady_clock::now() . time_since_epoch() ) . count();
+    }
+} // namespace PE
@@ -0,0 +1,230 @@
+#include "SceneQuery.hpp"
+#include "Collision.hpp"
+#include "Math.hpp"
+#include "TraceRecorder.hpp"
+#include "raymath.h"
+#include <algorithm>
+
+namespace PE
+{
+namespace
+{
+    SRayHit MakeHit ( const CBodyStorage & Bodies, int Index, const Vector3 & Origin, const Vector3 & Direction, const Collision::SRayResult & Result )
+    {
+        return { .Handle = Bodies . GetHandle ( Index ), .Distance = Result . Distance,
+                 .Point = Vector3Add ( Origin, Vector3Scale ( Direction, Result . Distance ) ), .Normal = Result . Normal };
+    }
+
+    // Keeps the nearest hit, the ray shrinks to it
+    class CClosestRayCallback : public CBroadphaseRayCallback
+    {
+        public:
+
+        CClosestRayCallback ( const CBodyStorage & Bodies, const Vector3 & Origin, const Vector3 & Direction, float MaxDistance )
+            : m_Bodies ( Bodies ), m_Origin ( Origin ), m_Direction ( Direction ), m_Reach ( MaxDistance )
+        {
+        }
+
+        float ReportBody ( int Index ) override
+        {
+            const Collision::SRayResult Result = Collision::RayCast ( m_Origin, m_Direction, m_Reach, m_Bodies . Shapes [ Index ], m_Bodies . Positions . Get ( Index ) );
+            if ( Result . IsHit && ( Hit . Handle < 0 || Result . Distance < Hit . Distance ) )
+            {
+                Hit = MakeHit ( m_Bodies, Index, m_Origin, m_Direction, Result );
+                m_Reach = Result . Distance;
+            }
+            return m_Reach;
+        }
+
+        SRayHit Hit;
+
+        private:
+
+        const CBodyStorage & m_Bodies;
+        Vector3 m_Origin;
+        Vector3 m_Direction;
+        float m_Reach;
+    };
+
+    // Keeps the nearest hits sorted in the caller's buffer, once it is full the ray shrinks to the farthest kept one
+    class CAllRayCallback : public CBroadphaseRayCallback
+    {
+        public:
+
+        CAllRayCallback ( const CBodyStorage & Bodies, const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, std::span<SRayHit> OutHits )
+            : m_Bodies ( Bodies ), m_Origin ( Origin ), m_Direction ( Direction ), m_Reach ( MaxDistance ), m_Hits ( OutHits )
+        {
+        }
+
+        float ReportBody ( int Index ) override
+        {
+            const Collision::SRayResult Result = Collision::RayCast ( m_Origin, m_Direction, m_Reach, m_Bodies . Shapes [ Index ], m_Bodies . Positions . Get ( Index ) );
+            if ( ! Result . IsHit || m_Hits . empty() )
+            {
+                return m_Reach;
+            }
+            const bool IsFull = NumberOfHits == static_cast<int> ( m_Hits . size() );
+            if ( IsFull && Result . Distance >= m_Hits . back() . Distance )
+            {
+                return m_Reach;
+            }
+            // Insertion sort, the farthest hit drops out of a full buffer
+            int Slot = IsFull ? NumberOfHits - 1 : NumberOfHits++;
+            for ( ; Slot > 0 && m_Hits [ Slot - 1 ] . Distance > Result . Distance; Slot-- )
+            {
+                m_Hits [ Slot ] = m_Hits [ Slot - 1 ];
+            }
+            m_Hits [ Slot ] = MakeHit ( m_Bodies, Index, m_Origin, m_Direction, Result );
+            if ( NumberOfHits == static_cast<int> ( m_Hits . size() ) )
+            {
+                m_Reach = m_Hits . back() . Distance;
+            }
+            return m_Reach;
+        }
+
+        int NumberOfHits = 0;
+
+        private:
+
+        const CBodyStorage & m_Bodies;
+        Vector3 m_Origin;
+        Vector3 m_Direction;
+        float m_Reach;
+        std::span<SRayHit> m_Hits;
+    };
+
+    // Counts the bodies passing the exact test, writes the handles that fit
+    template <typename TTest>
+    class COverlapCallback : public CBroadphaseBoxCallback
+    {
+        public:
+
+        COverlapCallback ( const CBodyStorage & Bodies, TTest Test, std::span<int> OutHandles )
+            : m_Bodies ( Bodies ), m_Test ( Test ), m_Handles ( OutHandles )
+        {
+        }
+
+        void ReportBody ( int Index ) override
+        {
+            if ( ! m_Test ( Index ) )
+            {
+                return;
+            }
+            if ( NumberOfOverlaps < static_cast<int> ( m_Handles . size() ) )
+            {
+                m_Handles [ NumberOfOverlaps ] = m_Bodies . GetHandle ( Index );
+            }
+            NumberOfOverlaps++;
+        }
+
+        int NumberOfOverlaps = 0;
+
+        private:
+
+        const CBodyStorage & m_Bodies;
+        TTest m_Test;
+        std::span<int> m_Handles;
+    };
+} // namespace
+
+    CSceneQuery::CSceneQuery( const CBodyStorage & Bodies, const CBroadphase & Broadphase, std::span<const int> BoundaryBodies )
+        : m_Bodies ( Bodies ), m_Broadphase ( Broadphase )
+    {
+        m_NumberOfBoundaryBodies = static_cast<int> ( std::min ( BoundaryBodies . size(), m_BoundaryBodies . size() ) );
+        std::copy_n ( BoundaryBodies . begin(), m_NumberOfBoundaryBodies, m_BoundaryBodies . begin() );
+    }
+
+    bool CSceneQuery::PrepareRay( const SRay & Ray, Vector3 & OutDirection )
+    {
+        const float Length = Vector3Length ( Ray . Direction );
+        if ( Length < PE::Math::GKindaSmallNumber || Ray . MaxDistance < 0.f )
+        {
+            return false;
+        }
+        OutDirection = Vector3Scale ( Ray . Direction, 1.f / Length );
+        return true;
+    }
+
+    float CSceneQuery::ReportBoundary( CBroadphaseRayCallback & Callback, float Reach ) const
+    {
+        for ( int i = 0; i < m_NumberOfBoundaryBodies && Reach >= 0.f; i++ )
+        {
+            Reach = Callback . ReportBody ( m_BoundaryBodies [ i ] );
+        }
+        return Reach;
+    }
+
+    void CSceneQuery::ReportBoundary( CBroadphaseBoxCallback & Callback ) const
+    {
+        for ( int i = 0; i < m_NumberOfBoundaryBodies; i++ )
+        {
+            Callback . ReportBody ( m_BoundaryBodies [ i ] );
+        }
+    }
+
+    bool CSceneQuery::RayCast( const SRay & Ray, SRayHit & OutHit ) const
+    {
+        OutHit = SRayHit {};
+        Vector3 Direction;
+        if ( ! PrepareRay ( Ray, Direction ) )
+        {
+            return false;
+        }
+        CClosestRayCallback Callback ( m_Bodies, Ray . Origin, Direction, Ray . MaxDistance );
+        m_Broadphase . QueryRay ( Ray . Origin, Direction, ReportBoundary ( Callback, Ray . MaxDistance ), Callback );
+        OutHit = Callback . Hit;
+        return OutHit . Handle >= 0;
+    }
+
+    void CSceneQuery::RayCast( std::span<const SRay> Rays, std::span<SRayHit> OutHits, CJobSystem & JobSystem ) const
+    {
+        CTraceScope Trace ( "SceneQuery::RayCast" );
+        Trace . AddArg ( "rays", static_cast<int64_t> ( Rays . size() ) );
+        const int NumberOfRays = static_cast<int> ( std::min ( Rays . size(), OutHits . size() ) );
+        const int NumberOfTasks = ( NumberOfRays + GRaysPerTask - 1 ) / GRaysPerTask;
+        JobSystem . ParallelFor ( NumberOfTasks, [ & ] ( int Task )
+        {
+            const int End = std::min ( ( Task + 1 ) * GRaysPerTask, NumberOfRays );
+            for ( int i = Task * GRaysPerTask; i < End; i++ )
+            {
+                RayCast ( Rays [ i ], OutHits [ i ] );
+            }
+        } );
+    }
+
+    int CSceneQuery::RayCastAll( const SRay & Ray, std::span<SRayHit> OutHits ) const
+    {
+        Vector3 Direction;
+        if ( ! PrepareRay ( Ray, Direction ) )
+        {
+            return 0;
+        }
+        CAllRayCallback Callback ( m_Bodies, Ray . Origin, Direction, Ray . MaxDistance, OutHits );
+        m_Broadphase . QueryRay ( Ray . Origin, Direction, ReportBoundary ( Callback, Ray . MaxDistance ), Callback );
+        return Callback . NumberOfHits;
+    }
+
+    int CSceneQuery::OverlapSphere( const Vector3 & Center, float Radius, std::span<int> OutHandles ) const
+    {
+        const auto Test = [ this, Center, Radius ] ( int Index )
+        {
+            return Collision::OverlapsSphere ( m_Bodies . Shapes [ Index ], m_Bodies . Positions . Get ( Index ), Center, Radius );
+        };
+        COverlapCallback<decltype ( Test )> Callback ( m_Bodies, Test, OutHandles );
+        ReportBoundary ( Callback );
+        m_Broadphase . QueryBox ( PE::Math::ExpandBox ( { Center, Center }, Radius ), Callback );
+        return Callback . NumberOfOverlaps;
+    }
+
+    int CSceneQuery::OverlapBox( const BoundingBox & Box, std::span<int> OutHandles ) const
+    {
+        const auto Test = [ this, &Box ] ( int Index )
+        {
+            return Collision::OverlapsBox ( m_Bodies . Shapes [ Index ], m_Bodies . Positions . Get ( Index ), Box );
+        };
+        COverlapCallback<decltype ( Test )> Callback ( m_Bodies, Test, OutHandles );
+        ReportBoundary ( Callback );
+        m_Broadphase . QueryBox ( Box, Callback );
+        return Callback . NumberOfOverlaps;
+    }
+} // namespace PE
@@ -0,0 +1,68 @@
+#include "Simd.hpp"
+
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace PE
+{
+namespace Simd
+{
+namespace
+{
+    ESimdLevel DetectLevel ()
+    {
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+        int Registers [ 4 ] = {};
+        __cpuid ( Registers, 1 );
+        const bool HasSSE2 = ( Registers [ 3 ] & ( 1 << 26 ) ) != 0;
+        const bool HasFMA = ( Registers [ 2 ] & ( 1 << 12 ) ) != 0;
+        const bool HasOSXSAVE = ( Registers [ 2 ] & ( 1 << 27 ) ) != 0;
+        const bool HasAVX = ( Registers [ 2 ] & ( 1 << 28 ) ) != 0;
+        __cpuidex ( Registers, 7, 0 );
+        const bool HasAVX2 = ( Registers [ 1 ] & ( 1 << 5 ) ) != 0;
+        // The OS must save the YMM registers on context switches
+        const bool HasYMMState = HasOSXSAVE && ( _xgetbv ( 0 ) & 0x6 ) == 0x6;
+        if ( HasAVX && HasAVX2 && HasFMA && HasYMMState )
+        {
+            return ESimdLevel::AVX2;
+        }
+        return HasSSE2 ? ESimdLevel::SSE2 : ESimdLevel::Scalar;
+#elif ( defined(__GNUC__) || defined(__clang__) ) && ( defined(__x86_64__) || defined(__i386__) )
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports ( "avx2" ) && __builtin_cpu_supports ( "fma" ) )
+        {
+            return ESimdLevel::AVX2;
+        }
+        return __builtin_cpu_supports ( "sse2" ) ? ESimdLevel::SSE2 : ESimdLevel::Scalar;
+#else
+        return ESimdLevel::Scalar;
+#endif
+    }
+} // namespace
+
+    ESimdLevel GetSupportedLevel()
+    {
+        static const ESimdLevel Level = DetectLevel();
+        return Level;
+    }
+
+    ESimdLevel ResolveLevel( ESimdLevel Requested )
+    {
+        const ESimdLevel Supported = GetSupportedLevel();
+        return static_cast<short> ( Requested ) < static_cast<short> ( Supported ) ? Requested : Supported;
+    }
+
+    const char * GetLevelName( ESimdLevel Level )
+    {
+        switch ( Level )
+        {
+            case ESimdLevel::AVX2: return "AVX2";
+            case ESimdLevel::SSE2: return "SSE2";
+            case ESimdLevel::Scalar:
+            default: return "Scalar";
+        }
+    }
+} // namespace Simd
+} // namespace PE
@@ -0,0 +1,152 @@
+#pragma once
+// Internal SIMD wrappers shared by the vectorized kernels.
+// SFloat4 (SSE2) is available in every x86-64 translation unit. SFloat8 (AVX2) only exists in
+// translation units compiled with AVX2 enabled (the *AVX2.cpp files), which are called only after
+// runtime CPU detection. Kernels are written once as templates over these wrappers.
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define PE_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define PE_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+
+
+namespace PE
+{
+namespace Simd
+{
+#if defined(PE_SIMD_SSE2)
+    struct SFloat4
+    {
+        using Type = __m128;
+        static constexpr int Width = 4;
+
+        static Type Load ( const float * Source ) { return _mm_loadu_ps ( Source ); }
+        static void Store ( float * Destination, Type Value ) { _mm_storeu_ps ( Destination, Value ); }
+        static Type Set1 ( float Value ) { return _mm_set1_ps ( Value ); }
+        static Type Add ( Type A, Type B ) { return _mm_add_ps ( A, B ); }
+        static Type Sub ( Type A, Type B ) { return _mm_sub_ps ( A, B ); }
+        static Type Mul ( Type A, Type B ) { return _mm_mul_ps ( A, B ); }
+        static Type Div ( Type A, Type B ) { return _mm_div_ps ( A, B ); }
+        static Type Sqrt ( Type A ) { return _mm_sqrt_ps ( A ); }
+        static Type Min ( Type A, Type B ) { return _mm_min_ps ( A, B ); }
+        static Type Max ( Type A, Type B ) { return _mm_max_ps ( A, B ); }
+        static Type Greater ( Type A, Type B ) { return _mm_cmpgt_ps ( A, B ); }
+        static Type LessEqual ( Type A, Type B ) { return _mm_cmple_ps ( A, B ); }
+        static Type And ( Type A, Type B ) { return _mm_and_ps ( A, B ); }
+        static Type Or ( Type A, Type B ) { return _mm_or_ps ( A, B ); }
+        static Type Select ( Type Mask, Type IfTrue, Type IfFalse ) { return _mm_or_ps ( _mm_and_ps ( Mask, IfTrue ), _mm_andnot_ps ( Mask, IfFalse ) ); }
+        static Type Round ( Type A ) { return _mm_cvtepi32_ps ( _mm_cvtps_epi32 ( A ) ); }
+        static int MoveMask ( Type Mask ) { return _mm_movemask_ps ( Mask ); }
+
+        static Type Gather ( const float * Table, const uint16_t * Indices )
+        {
+            return _mm_setr_ps ( Table [ Indices [ 0 ] ], Table [ Indices [ 1 ] ], Table [ Indices [ 2 ] ], Table [ Indices [ 3 ] ] );
+        }
+
+        static Type Gather ( const float * Table, const int * Indices )
+        {
+            return _mm_setr_ps ( Table [ Indices [ 0 ] ], Table [ Indices [ 1 ] ], Table [ Indices [ 2 ] ], Table [ Indices [ 3 ] ] );
+        }
+
+        // All-ones lanes where ( Flags & FlagMask ) == 0
+        static Type FlagsClear ( const uint8_t * Flags, uint8_t FlagMask )
+        {
+            const __m128i Values = _mm_setr_epi32 ( Flags [ 0 ], Flags [ 1 ], Flags [ 2 ], Flags [ 3 ] );
+            const __m128i Masked = _mm_and_si128 ( Values, _mm_set1_epi32 ( FlagMask ) );
+            return _mm_castsi128_ps ( _mm_cmpeq_epi32 ( Masked, _mm_setzero_si128 () ) );
+        }
+    };
+#endif
+
+#if defined(PE_SIMD_AVX2)
+    struct SFloat8
+    {
+        using Type = __m256;
+        static constexpr int Width = 8;
+
+        static Type Load ( const float * Source ) { return _mm256_loadu_ps ( Source ); }
+        static void Store ( float * Destination, Type Value ) { _mm256_storeu_ps ( Destination, Value ); }
+        static Type Set1 ( float Value ) { return _mm256_set1_ps ( Value ); }
+        static Type Add ( Type A, Type B ) { return _mm256_add_ps ( A, B ); }
+        static Type Sub ( Type A, Type B ) { return _mm256_sub_ps ( A, B ); }
+        static Type Mul ( Type A, Type B ) { return _mm256_mul_ps ( A, B ); }
+        static Type Div ( Type A, Type B ) { return _mm256_div_ps ( A, B ); }
+        static Type Sqrt ( Type A ) { return _mm256_sqrt_ps ( A ); }
+        static Type Min ( Type A, Type B ) { return _mm256_min_ps ( A, B ); }
+        static Type Max ( Type A, Type B ) { return _mm256_max_ps ( A, B ); }
+        static Type Greater ( Type A, Type B ) { return _mm256_cmp_ps ( A, B, _CMP_GT_OQ ); }
+        static Type LessEqual ( Type A, Type B ) { return _mm256_cmp_ps ( A, B, _CMP_LE_OQ ); }
+        static Type And ( Type A, Type B ) { return _mm256_and_ps ( A, B ); }
+        static Type Or ( Type A, Type B ) { return _mm256_or_ps ( A, B ); }
+        static Type Select ( Type Mask, Type IfTrue, Type IfFalse ) { return _mm256_blendv_ps ( IfFalse, IfTrue, Mask ); }
+        static Type Round ( Type A ) { return _mm256_round_ps ( A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC ); }
+        static int MoveMask ( Type Mask ) { return _mm256_movemask_ps ( Mask ); }
+
+        static Type Gather ( const float * Table, const uint16_t * Indices )
+        {
+            const __m256i Offsets = _mm256_cvtepu16_epi32 ( _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( Indices ) ) );
+            return _mm256_i32gather_ps ( Table, Offsets, 4 );
+        }
+
+        static Type Gather ( const float * Table, const int * Indices )
+        {
+            const __m256i Offsets = _mm256_loadu_si256 ( reinterpret_cast<const __m256i *> ( Indices ) );
+            return _mm256_i32gather_ps ( Table, Offsets, 4 );
+        }
+
+        // All-ones lanes where ( Flags & FlagMask ) == 0
+        static Type FlagsClear ( const uint8_t * Flags, uint8_t FlagMask )
+        {
+            const __m256i Values = _mm256_cvtepu8_epi32 ( _mm_loadl_epi64 ( reinterpret_cast<const __m128i *> ( Flags ) ) );
+            const __m256i Masked = _mm256_and_si256 ( Values, _mm256_set1_epi32 ( FlagMask ) );
+            return _mm256_castsi256_ps ( _mm256_cmpeq_epi32 ( Masked, _mm256_setzero_si256 () ) );
+        }
+    };
+#endif
+
+    /**
+     * Sine and cosine of every lane. Reduced by multiples of pi / 2 to [-pi / 4, pi / 4] (pi / 2 split in three parts,
+     * exact for |X| below about 1e5), then minimax polynomials of degree 7 and 8 picked and signed by the quadrant.
+     * Absolute error below 2e-7 against the exact sine / cosine of the float input for |X| up to 1e4.
+     */
+    template <typename T>
+    void SinCos ( typename T::Type X, typename T::Type & OutSin, typename T::Type & OutCos )
+    {
+        using V = typename T::Type;
+        const V Zero = T::Set1 ( 0.f );
+        const V Quadrant = T::Round ( T::Mul ( X, T::Set1 ( 0.636619772368f ) ) );
+        V Reduced = T::Sub ( X, T::Mul ( Quadrant, T::Set1 ( 1.5703125f ) ) );
+        Reduced = T::Sub ( Reduced, T::Mul ( Quadrant, T::Set1 ( 4.837512969970703125e-4f ) ) );
+        Reduced = T::Sub ( Reduced, T::Mul ( Quadrant, T::Set1 ( 7.54978995489188216e-8f ) ) );
+        const V X2 = T::Mul ( Reduced, Reduced );
+
+        V Sin = T::Set1 ( -1.9515295891e-4f );
+        Sin = T::Add ( T::Mul ( Sin, X2 ), T::Set1 ( 8.3321608736e-3f ) );
+        Sin = T::Add ( T::Mul ( Sin, X2 ), T::Set1 ( -1.6666654611e-1f ) );
+        Sin = T::Add ( T::Mul ( T::Mul ( Sin, X2 ), Reduced ), Reduced );
+
+        V Cos = T::Set1 ( 2.443315711809948e-5f );
+        Cos = T::Add ( T::Mul ( Cos, X2 ), T::Set1 ( -1.388731625493765e-3f ) );
+        Cos = T::Add ( T::Mul ( Cos, X2 ), T::Set1 ( 4.166664568298827e-2f ) );
+        Cos = T::Add ( T::Mul ( T::Mul ( Cos, X2 ), X2 ), T::Sub ( T::Set1 ( 1.f ), T::Mul ( X2, T::Set1 ( 0.5f ) ) ) );
+
+        // Quadrant modulo 4 as a float in [ -2, 2 ]: odd ones swap sine and cosine, the signs follow the quadrant
+        const V Modulo = T::Sub ( Quadrant, T::Mul ( T::Round ( T::Mul ( Quadrant, T::Set1 ( 0.25f ) ) ), T::Set1 ( 4.f ) ) );
+        const V Magnitude = T::Max ( Modulo, T::Sub ( Zero, Modulo ) );
+        const V One = T::Set1 ( 1.f );
+        const V IsOdd = T::Greater ( T::Set1 ( 0.5f ), T::Max ( T::Sub ( Magnitude, One ), T::Sub ( One, Magnitude ) ) );
+        const V IsSinNegative = T::Or ( T::Greater ( Modulo, T::Set1 ( 1.5f ) ), T::Greater ( T::Set1 ( -0.5f ), Modulo ) );
+        const V IsCosNegative = T::Or ( T::Greater ( Modulo, T::Set1 ( 0.5f ) ), T::Greater ( T::Set1 ( -1.5f ), Modulo ) );
+        const V QuadrantSin = T::Select ( IsOdd, Cos, Sin );
+        const V QuadrantCos = T::Select ( IsOdd, Sin, Cos );
+        OutSin = T::Select ( IsSinNegative, T::Sub ( Zero, QuadrantSin ), QuadrantSin );
+        OutCos = T::Select ( IsCosNegative, T::Sub ( Zero, QuadrantCos ), QuadrantCos );
+    }
+} // namespace Simd
+} // namespace PE
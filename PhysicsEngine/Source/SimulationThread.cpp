@@ -0,0 +1,159 @@
+#include "SimulationThread.hpp"
+#include "TraceRecorder.hpp"
+#include "raymath.h"
+#include <algorithm>
+#include <chrono>
+
+namespace PE
+{
+    float SRenderSnapshot::GetInterpolation( double NowMs ) const
+    {
+        if ( StepsSincePrevious <= 0 || FixedDeltaTime <= 0.f )
+        {
+            return 1.f;
+        }
+        // Real time past the current pose, in steps. Drawing one step behind keeps the blend between two known poses.
+        const double Elapsed = ( TimeAccumulator + ( NowMs - PublishMs ) * 1e-3 ) / FixedDeltaTime;
+        const float StepFraction = static_cast<float> ( std::clamp ( Elapsed, 0.0, 1.0 ) );
+        return 1.f - ( 1.f - StepFraction ) / static_cast<float> ( StepsSincePrevious );
+    }
+
+    int SRenderSnapshot::FindSlot( int Handle ) const
+    {
+        const int Slot = CBodyStorage::GetHandleSlot ( Handle );
+        return Handle >= 0 && Slot < GetNumberOfSlots() && Handles [ Slot ] == Handle ? Slot : -1;
+    }
+
+    Vector3 SRenderSnapshot::GetPosition( int Slot, float Interpolation ) const
+    {
+        return Vector3Lerp ( PreviousPositions [ Slot ], Positions [ Slot ], Interpolation );
+    }
+
+    Quaternion SRenderSnapshot::GetRotation( int Slot, float Interpolation ) const
+    {
+        return QuaternionSlerp ( PreviousRotations [ Slot ], Rotations [ Slot ], Interpolation );
+    }
+
+    CSimulationThread::CSimulationThread( CPhysicsWorld & World )
+        : m_World ( World )
+    {
+    }
+
+    CSimulationThread::~CSimulationThread()
+    {
+        Stop();
+    }
+
+    void CSimulationThread::Start()
+    {
+        if ( m_Thread . joinable() )
+        {
+            return;
+        }
+        // The world may have been restarted meanwhile, the handles of the last publish mean other bodies now
+        m_PublishedHandles . clear();
+        m_PublishedPositions . clear();
+        m_PublishedRotations . clear();
+        m_IsStopping . store ( false, std::memory_order_relaxed );
+        m_Thread = std::thread ( [ this ] { Run(); } );
+    }
+
+    void CSimulationThread::Stop()
+    {
+        if ( ! m_Thread . joinable() )
+        {
+            return;
+        }
+        m_IsStopping . store ( true, std::memory_order_release );
+        m_Thread . join();
+    }
+
+    void CSimulationThread::PublishSnapshot()
+    {
+        m_PublishedHandles . clear();
+        m_PublishedPositions . clear();
+        m_PublishedRotations . clear();
+        WriteSnapshot ( 0 );
+    }
+
+    void CSimulationThread::Run()
+    {
+        double LastMs = CProfiler::NowMs();
+        while ( ! m_IsStopping . load ( std::memory_order_acquire ) )
+        {
+            const double NowMs = CProfiler::NowMs();
+            const float DeltaTime = static_cast<float> ( ( NowMs - LastMs ) * 1e-3 );
+            LastMs = NowMs;
+            if ( ! m_IsPaused . load ( std::memory_order_relaxed ) )
+            {
+                const int NumberOfSteps = m_World . Update ( DeltaTime );
+                if ( NumberOfSteps > 0 )
+                {
+                    m_StepIndex += NumberOfSteps;
+                    WriteSnapshot ( NumberOfSteps );
+                }
+            }
+            // Sleep until the next step is due, the accumulator holds the part of it that already passed
+            const float UntilNextStep = m_World . GetFixedDeltaTime() - ( IsPaused() ? 0.f : m_World . GetTimeAccumulator() );
+            if ( UntilNextStep > 0.f )
+            {
+                std::this_thread::sleep_for ( std::chrono::duration<float> ( UntilNextStep ) );
+            }
+        }
+    }
+
+    void CSimulationThread::WriteSnapshot( int NumberOfSteps )
+    {
+        CTraceScope Trace ( "PublishSnapshot" );
+        SRenderSnapshot & Snapshot = m_Snapshots . GetWriteBuffer();
+        const CBodyStorage & Bodies = m_World . GetBodies();
+        const int NumberOfSlots = Bodies . GetNumberOfHandleSlots();
+        Snapshot . Handles . assign ( NumberOfSlots, -1 );
+        Snapshot . Positions . assign ( NumberOfSlots, Vector3 { 0.f, 0.f, 0.f } );
+        Snapshot . Rotations . assign ( NumberOfSlots, Quaternion { 0.f, 0.f, 0.f, 1.f } );
+        Snapshot . Shapes . assign ( NumberOfSlots, SShape {} );
+        Snapshot . Flags . assign ( NumberOfSlots, 0 );
+        for ( int i = 0; i < Bodies . Size(); i++ )
+        {
+            const int Handle = Bodies . GetHandle ( i );
+            const int Slot = CBodyStorage::GetHandleSlot ( Handle );
+            Snapshot . Handles [ Slot ] = Handle;
+            Snapshot . Positions [ Slot ] = Bodies . Positions . Get ( i );
+            Snapshot . Rotations [ Slot ] = Bodies . Rotations . Get ( i );
+            Snapshot . Shapes [ Slot ] = Bodies . Shapes [ i ];
+            Snapshot . Flags [ Slot ] = Bodies . Flags [ i ];
+        }
+        // A slot blends from the last publish only when it still holds the same body
+        const bool HasPrevious = ! m_PublishedHandles . empty();
+        Snapshot . PreviousPositions . assign ( Snapshot . Positions . begin(), Snapshot . Positions . end() );
+        Snapshot . PreviousRotations . assign ( Snapshot . Rotations . begin(), Snapshot . Rotations . end() );
+        const int NumberOfPublishedSlots = std::min ( NumberOfSlots, static_cast<int> ( m_PublishedHandles . size() ) );
+        for ( int Slot = 0; Slot < NumberOfPublishedSlots; Slot++ )
+        {
+            if ( Snapshot . Handles [ Slot ] >= 0 && Snapshot . Handles [ Slot ] == m_PublishedHandles [ Slot ] )
+            {
+                Snapshot . PreviousPositions [ Slot ] = m_PublishedPositions [ Slot ];
+                Snapshot . PreviousRotations [ Slot ] = m_PublishedRotations [ Slot ];
+            }
+        }
+        m_PublishedHandles . assign ( Snapshot . Handles . begin(), Snapshot . Handles . end() );
+        m_PublishedPositions . assign ( Snapshot . Positions . begin(), Snapshot . Positions . end() );
+        m_PublishedRotations . assign ( Snapshot . Rotations . begin(), Snapshot . Rotations . end() );
+
+        Snapshot . StepIndex = m_StepIndex;
+        Snapshot . StepsSincePrevious = HasPrevious ? NumberOfSteps : 0;
+        Snapshot . FixedDeltaTime = m_World . GetFixedDeltaTime();
+        Snapshot . TimeAccumulator = m_World . GetTimeAccumulator();
+        Snapshot . NumberOfBalls = m_World . GetNumberOfBalls();
+        Snapshot . NumberOfPairTests = m_World . GetNumberOfPairTests();
+        Snapshot . NumberOfAwakeBodies = m_World . GetNumberOfAwakeBodies();
+        Snapshot . NumberOfOverruns = m_World . GetNumberOfOverruns();
+        Snapshot . NumberOfDroppedSteps = m_World . GetNumberOfDroppedSteps();
+        const std::span<const SJobStats> JobStats = m_World . GetStepJobStats();
+        Snapshot . StepJobStats . assign ( JobStats . begin(), JobStats . end() );
+        Snapshot . Stats = m_World . GetStats();
+        Snapshot . PublishMs = CProfiler::NowMs();
+        Trace . AddArg ( "bodies", Bodies . Size() );
+        m_Snapshots . Publish();
+    }
+} // namespace PE
@@ -0,0 +1,180 @@
+#include "Solver.hpp"
+#include "Math.hpp"
+#include "raymath.h"
+#include <cmath>
+
+
+namespace PE
+{
+namespace Solver
+{
+namespace
+{
+    Vector3 RelativeVelocity( const CBodyStorage & Bodies, const SContact & Contact )
+    {
+        const Vector3 VA_contact = Vector3Add ( Bodies . LinearVelocities . Get ( Contact . BodyA ),
+                                                Vector3CrossProduct ( Bodies . AngularVelocities . Get ( Contact . BodyA ), Contact . OffsetA ) );
+        const Vector3 VB_contact = Vector3Add ( Bodies . LinearVelocities . Get ( Contact . BodyB ),
+                                                Vector3CrossProduct ( Bodies . AngularVelocities . Get ( Contact . BodyB ), Contact . OffsetB ) );
+        return Vector3Subtract ( VA_contact, VB_contact );
+    }
+
+    // Mean of |Offset x t|^2 over unit tangents t: ( Offset . n )^2 + |Offset tangential part|^2 / 2
+    float TangentLeverSquared( const Vector3 & Offset, const Vector3 & Normal )
+    {
+        const float AlongNormal = Vector3DotProduct ( Offset, Normal );
+        const float Tangential = Vector3LengthSqr ( Offset ) - AlongNormal * AlongNormal;
+        return AlongNormal * AlongNormal + 0.5f * Tangential;
+    }
+
+    // Apply J to A and -J to B at the contact point. Static bodies are shared by islands solved in parallel,
+    // they are never written (their zero inverse mass and inertia would leave them unchanged anyway).
+    void ApplyImpulse( CBodyStorage & Bodies, const SContact & Contact, const Vector3 & J )
+    {
+        const int IndexA = Contact . BodyA;
+        const int IndexB = Contact . BodyB;
+        if ( ! Bodies . IsStatic ( IndexA ) )
+        {
+            const Vector3 TauA = Vector3CrossProduct ( Contact . OffsetA, J );
+            Bodies . LinearVelocities . Set ( IndexA, Vector3Add ( Bodies . LinearVelocities . Get ( IndexA ), Vector3Scale ( J, Bodies . InvMasses [ IndexA ] ) ) );
+            Bodies . AngularVelocities . Set ( IndexA, Vector3Add ( Bodies . AngularVelocities . Get ( IndexA ), Vector3Scale ( TauA, Bodies . InvInertias [ IndexA ] ) ) );
+        }
+        if ( ! Bodies . IsStatic ( IndexB ) )
+        {
+            const Vector3 TauB = Vector3CrossProduct ( Contact . OffsetB, J );
+            Bodies . LinearVelocities . Set ( IndexB, Vector3Subtract ( Bodies . LinearVelocities . Get ( IndexB ), Vector3Scale ( J, Bodies . InvMasses [ IndexB ] ) ) );
+            Bodies . AngularVelocities . Set ( IndexB, Vector3Subtract ( Bodies . AngularVelocities . Get ( IndexB ), Vector3Scale ( TauB, Bodies . InvInertias [ IndexB ] ) ) );
+        }
+    }
+} // namespace
+
+    void PrepareContacts( const CBodyStorage & Bodies, std::span<SContact> Contacts, const SSimulationParameters & SimulationParameters, float DeltaTime )
+    {
+        const float InvDeltaTime = DeltaTime > 0.f ? 1.f / DeltaTime : 0.f;
+        for ( SContact & Contact : Contacts )
+        {
+            const int IndexA = Contact . BodyA;
+            const int IndexB = Contact . BodyB;
+            const Vector3 PositionA = Bodies . Positions . Get ( IndexA );
+            const Vector3 PositionB = Bodies . Positions . Get ( IndexB );
+            const float InvMassA = Bodies . InvMasses [ IndexA ];
+            const float InvMassB = Bodies . InvMasses [ IndexB ];
+            const float InvInertiaA = Bodies . InvInertias [ IndexA ];
+            const float InvInertiaB = Bodies . InvInertias [ IndexB ];
+
+            Contact . OffsetA = Vector3Subtract ( Contact . ContactPoint, PositionA );
+            Contact . OffsetB = Vector3Subtract ( Contact . ContactPoint, PositionB );
+            Contact . OffsetACrossNormal = Vector3CrossProduct ( Contact . OffsetA, Contact . Normal );
+            Contact . OffsetBCrossNormal = Vector3CrossProduct ( Contact . OffsetB, Contact . Normal );
+
+            const float SumInvMass = InvMassA + InvMassB;
+            const float NormalInvMass = SumInvMass +
+                                        InvInertiaA * Vector3DotProduct ( Contact . OffsetACrossNormal, Contact . OffsetACrossNormal ) +
+                                        InvInertiaB * Vector3DotProduct ( Contact . OffsetBCrossNormal, Contact . OffsetBCrossNormal );
+            Contact . NormalMass = NormalInvMass > 0.f ? 1.f / NormalInvMass : 0.f;
+            // |r x t|^2 averaged over the tangent directions t, exact for spheres where r is parallel to n
+            const float TangentInvMass = SumInvMass +
+                                         InvInertiaA * TangentLeverSquared ( Contact . OffsetA, Contact . Normal ) +
+                                         InvInertiaB * TangentLeverSquared ( Contact . OffsetB, Contact . Normal );
+            Contact . TangentMass = TangentInvMass > 0.f ? 1.f / TangentInvMass : 0.f;
+            Contact . BaseSeparation = Vector3DotProduct ( Vector3Subtract ( PositionA, PositionB ), Contact . Normal );
+
+            Contact . CorrectionMass = SumInvMass > 0.f ? 1.f / SumInvMass : 0.f;
+
+            const SMaterialPair & Material = Bodies . GetMaterialPair ( Bodies . MaterialIndices [ IndexA ], Bodies . MaterialIndices [ IndexB ] );
+            Contact . Friction = Material . Friction;
+
+            // Speculative contacts may close the gap within this step, touching ones bounce when approaching fast enough
+            const float VN = Vector3DotProduct ( RelativeVelocity ( Bodies, Contact ), Contact . Normal );
+            if ( Contact . Penetration < 0.f )
+            {
+                Contact . NormalVelocityTarget = Contact . Penetration * InvDeltaTime;
+            }
+            else
+            {
+                Contact . NormalVelocityTarget = VN < -SimulationParameters . RestitutionVelocityThreshold ? -Material . Restitution * VN : 0.f;
+            }
+        }
+    }
+
+    void WarmStart( CBodyStorage & Bodies, std::span<SContact> Contacts )
+    {
+        for ( SContact & Contact : Contacts )
+        {
+            // The normal may have rotated since the impulse was cached, keep only its tangential part
+            const Vector3 N = Contact . Normal;
+            Contact . TangentImpulse = Vector3Subtract ( Contact . TangentImpulse, Vector3Scale ( N, Vector3DotProduct ( Contact . TangentImpulse, N ) ) );
+            ApplyImpulse ( Bodies, Contact, Vector3Add ( Vector3Scale ( N, Contact . NormalImpulse ), Contact . TangentImpulse ) );
+        }
+    }
+
+    void SolveContact( CBodyStorage & Bodies, SContact & Contact, float Slop, float MaxCorrection )
+    {
+        const int IndexA = Contact . BodyA;
+        const int IndexB = Contact . BodyB;
+        if ( Contact . CorrectionMass <= 0.f )
+        {
+            return;
+        }
+        const float InvMassA = Bodies . InvMasses [ IndexA ];
+        const float InvMassB = Bodies . InvMasses [ IndexB ];
+        const Vector3 N = Contact . Normal;
+
+        // Positional correction. Earlier corrections this step moved the bodies along the normal,
+        // so the remaining penetration is the generated one minus the separation gained since.
+        // At most MaxCorrection is resolved per step, deep overlaps are spread over several steps.
+        const Vector3 PositionA = Bodies . Positions . Get ( IndexA );
+        const Vector3 PositionB = Bodies . Positions . Get ( IndexB );
+        const float SeparationGained = Vector3DotProduct ( Vector3Subtract ( PositionA, PositionB ), N ) - Contact . BaseSeparation;
+        const float Correction = std::fmin ( Contact . Penetration - Slop, MaxCorrection ) - SeparationGained;
+        if ( Correction > 0.f )
+        {
+            const Vector3 CorrectionImpulse = Vector3Scale ( N, Correction * Contact . CorrectionMass );
+            if ( ! Bodies . IsStatic ( IndexA ) )
+            {
+                Bodies . Positions . Set ( IndexA, Vector3Add ( PositionA, Vector3Scale ( CorrectionImpulse, InvMassA ) ) );
+            }
+            if ( ! Bodies . IsStatic ( IndexB ) )
+            {
+                Bodies . Positions . Set ( IndexB, Vector3Subtract ( PositionB, Vector3Scale ( CorrectionImpulse, InvMassB ) ) );
+            }
+        }
+
+        const Vector3 VRel = RelativeVelocity ( Bodies, Contact );
+        const float VN = Vector3DotProduct ( VRel, N );
+
+        // Normal impulse, the accumulated impulse may only push
+        const float OldNormalImpulse = Contact . NormalImpulse;
+        Contact . NormalImpulse = std::fmax ( 0.f, OldNormalImpulse + ( Contact . NormalVelocityTarget - VN ) * Contact . NormalMass );
+        const float JN = Contact . NormalImpulse - OldNormalImpulse;
+
+        // Tangential impulse (friction), accumulated impulse clamped to the Coulomb cone
+        const Vector3 VT = Vector3Subtract ( VRel, Vector3Scale ( N, VN ) );
+        const Vector3 OldTangentImpulse = Contact . TangentImpulse;
+        Vector3 TangentImpulse = Vector3Subtract ( OldTangentImpulse, Vector3Scale ( VT, Contact . TangentMass ) );
+        const float MaxJT = Contact . Friction * Contact . NormalImpulse;
+        const float TangentImpulseLength = Vector3Length ( TangentImpulse );
+        if ( TangentImpulseLength > MaxJT )
+        {
+            TangentImpulse = TangentImpulseLength > PE::Math::GKindaSmallNumber ? Vector3Scale ( TangentImpulse, MaxJT / TangentImpulseLength ) : Vector3 { 0.f, 0.f, 0.f };
+        }
+        Contact . TangentImpulse = TangentImpulse;
+        const Vector3 JT = Vector3Subtract ( TangentImpulse, OldTangentImpulse );
+
+        ApplyImpulse ( Bodies, Contact, Vector3Add ( Vector3Scale ( N, JN ), JT ) );
+    }
+
+    void SolveContacts( CBodyStorage & Bodies, std::span<SContact> Contacts, const SSimulationParameters & SimulationParameters )
+    {
+        const float Slop = SimulationParameters . Slop;
+        const float MaxCorrection = SimulationParameters . MaxPositionCorrection;
+        for ( int Iteration = 0; Iteration < SimulationParameters . NumberOfSteps; Iteration++ )
+        {
+            for ( SContact & Contact : Contacts )
+            {
+                SolveContact ( Bodies, Contact, Slop, MaxCorrection );
+            }
+        }
+    }
+} // namespace Solver
+} // namespace PE
@@ -0,0 +1,356 @@
+#include "SpatialHashGrid.hpp"
+#include "Collision.hpp"
+#include "Math.hpp"
+#include "raymath.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace PE
+{
+    CSpatialHashGrid::CSpatialHashGrid( float CellSize, float Margin )
+    {
+        SetCellSize ( CellSize );
+        SetMargin ( Margin );
+    }
+
+    void CSpatialHashGrid::SetCellSize( float CellSize )
+    {
+        m_CellSize = CellSize > PE::Math::GKindaSmallNumber ? CellSize : 1.f;
+        m_InvCellSize = 1.f / m_CellSize;
+    }
+
+    void CSpatialHashGrid::SetMargin( float Margin )
+    {
+        m_Margin = Margin > 0.f ? Margin : 0.f;
+    }
+
+    CSpatialHashGrid::SCellCoord CSpatialHashGrid::ToCell( const Vector3 & Location ) const
+    {
+        return { static_cast<int> ( std::floor ( Location . x * m_InvCellSize ) ),
+                 static_cast<int> ( std::floor ( Location . y * m_InvCellSize ) ),
+                 static_cast<int> ( std::floor ( Location . z * m_InvCellSize ) ) };
+    }
+
+    uint64_t CSpatialHashGrid::PackCell( const SCellCoord & Cell )
+    {
+        // 21 bits per axis, biased so negative coordinates stay distinct
+        constexpr uint64_t Mask = ( 1ull << 21 ) - 1;
+        constexpr int64_t Bias = 1 << 20;
+        return ( ( static_cast<uint64_t> ( Cell . X + Bias ) & Mask ) << 42 ) |
+               ( ( static_cast<uint64_t> ( Cell . Y + Bias ) & Mask ) << 21 ) |
+               ( ( static_cast<uint64_t> ( Cell . Z + Bias ) & Mask ) );
+    }
+
+    uint32_t CSpatialHashGrid::BucketOf( uint64_t CellKey ) const
+    {
+        // Fibonacci hashing, the top bits select the bucket
+        return static_cast<uint32_t> ( ( CellKey * 0x9E3779B97F4A7C15ull ) >> m_BucketShift );
+    }
+
+    void CSpatialHashGrid::Update( const CBodyStorage & Bodies )
+    {
+        const int NumberOfBodies = Bodies . Size();
+        m_Bounds . resize ( NumberOfBodies );
+        m_IsPassive . resize ( NumberOfBodies );
+        m_IsOversized . assign ( NumberOfBodies, 0 );
+        m_ScratchEntries . clear();
+        m_OversizedBodies . clear();
+        m_NumberOfGridBodies = 0;
+        m_GridBounds = { { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f } };
+
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            const BoundingBox Bounds = PE::Math::ExpandBox ( PE::Collision::GetBoundingBox ( Bodies . Shapes [ i ], Bodies . Positions . Get ( i ) ), m_Margin );
+            m_Bounds [ i ] = Bounds;
+            m_IsPassive [ i ] = Bodies . IsAwake ( i ) ? 0 : 1;
+            if ( Bodies . IsWorldBoundary ( i ) )
+            {
+                // Collided by the world boundary stage, neither in a cell nor paired as an oversized body
+                continue;
+            }
+
+            const SCellCoord MinCell = ToCell ( Bounds . min );
+            const SCellCoord MaxCell = ToCell ( Bounds . max );
+            const int64_t NumberOfCells = static_cast<int64_t> ( MaxCell . X - MinCell . X + 1 ) *
+                                          static_cast<int64_t> ( MaxCell . Y - MinCell . Y + 1 ) *
+                                          static_cast<int64_t> ( MaxCell . Z - MinCell . Z + 1 );
+            if ( NumberOfCells > GMaxCellsPerBody )
+            {
+                m_OversizedBodies . push_back ( i );
+                m_IsOversized [ i ] = 1;
+                continue;
+            }
+
+            m_GridBounds = m_NumberOfGridBodies == 0 ? Bounds : BoundingBox { Vector3Min ( m_GridBounds . min, Bounds . min ), Vector3Max ( m_GridBounds . max, Bounds . max ) };
+            m_NumberOfGridBodies++;
+            for ( int X = MinCell . X; X <= MaxCell . X; X++ )
+            {
+                for ( int Y = MinCell . Y; Y <= MaxCell . Y; Y++ )
+                {
+                    for ( int Z = MinCell . Z; Z <= MaxCell . Z; Z++ )
+                    {
+                        m_ScratchEntries . push_back ( { PackCell ( { X, Y, Z } ), i } );
+                    }
+                }
+            }
+        }
+
+        // Bucket table sized to the next power of two above twice the entry count
+        uint32_t BucketBits = 1;
+        while ( ( 1ull << BucketBits ) < 2 * m_ScratchEntries . size() && BucketBits < 31 )
+        {
+            BucketBits++;
+        }
+        m_BucketShift = 64 - BucketBits;
+        const size_t NumberOfBuckets = size_t { 1 } << BucketBits;
+
+        // Counting sort of the entries by bucket
+        m_BucketStarts . assign ( NumberOfBuckets + 1, 0 );
+        for ( const SCellEntry & Entry : m_ScratchEntries )
+        {
+            m_BucketStarts [ BucketOf ( Entry . CellKey ) + 1 ]++;
+        }
+        for ( size_t i = 1; i <= NumberOfBuckets; i++ )
+        {
+            m_BucketStarts [ i ] += m_BucketStarts [ i - 1 ];
+        }
+        m_Entries . resize ( m_ScratchEntries . size() );
+        for ( const SCellEntry & Entry : m_ScratchEntries )
+        {
+            m_Entries [ m_BucketStarts [ BucketOf ( Entry . CellKey ) ]++ ] = Entry;
+        }
+        // Scatter advanced every start to the next bucket's start, shift them back
+        for ( size_t i = NumberOfBuckets; i > 0; i-- )
+        {
+            m_BucketStarts [ i ] = m_BucketStarts [ i - 1 ];
+        }
+        m_BucketStarts [ 0 ] = 0;
+    }
+
+    void CSpatialHashGrid::FindPairs( std::vector<SBroadphasePair> & OutPairs ) const
+    {
+        const size_t FirstPair = OutPairs . size();
+        const size_t NumberOfBuckets = m_BucketStarts . empty() ? 0 : m_BucketStarts . size() - 1;
+        for ( size_t Bucket = 0; Bucket < NumberOfBuckets; Bucket++ )
+        {
+            const uint32_t Begin = m_BucketStarts [ Bucket ];
+            const uint32_t End = m_BucketStarts [ Bucket + 1 ];
+            for ( uint32_t i = Begin; i < End; i++ )
+            {
+                const SCellEntry & EntryA = m_Entries [ i ];
+                for ( uint32_t j = i + 1; j < End; j++ )
+                {
+                    const SCellEntry & EntryB = m_Entries [ j ];
+                    // Different cells hashed into the same bucket
+                    if ( EntryA . CellKey != EntryB . CellKey )
+                    {
+                        continue;
+                    }
+                    const int A = EntryA . BodyIndex;
+                    const int B = EntryB . BodyIndex;
+                    if ( ( m_IsPassive [ A ] && m_IsPassive [ B ] ) || ! PE::Math::BoxesOverlap ( m_Bounds [ A ], m_Bounds [ B ] ) )
+                    {
+                        continue;
+                    }
+                    // Report the pair only from the cell owning the minimum corner of the overlap
+                    const Vector3 OverlapMin = Vector3Max ( m_Bounds [ A ] . min, m_Bounds [ B ] . min );
+                    if ( PackCell ( ToCell ( OverlapMin ) ) != EntryA . CellKey )
+                    {
+                        continue;
+                    }
+                    OutPairs . push_back ( { std::min ( A, B ), std::max ( A, B ) } );
+                }
+            }
+        }
+
+        // Oversized bodies are paired against everything
+        const int NumberOfBodies = static_cast<int> ( m_Bounds . size() );
+        for ( const int A : m_OversizedBodies )
+        {
+            for ( int B = 0; B < NumberOfBodies; B++ )
+            {
+                if ( B == A || ( m_IsPassive [ A ] && m_IsPassive [ B ] ) )
+                {
+                    continue;
+                }
+                // Oversized-oversized pairs are visited once, from the lower index
+                if ( m_IsOversized [ B ] && B < A )
+                {
+                    continue;
+                }
+                if ( PE::Math::BoxesOverlap ( m_Bounds [ A ], m_Bounds [ B ] ) )
+                {
+                    OutPairs . push_back ( { std::min ( A, B ), std::max ( A, B ) } );
+                }
+            }
+        }
+
+        SortPairs ( OutPairs . begin() + FirstPair, OutPairs . end() );
+    }
+
+    bool CSpatialHashGrid::IsInBodyCells( const SCellCoord & Cell, int Body ) const
+    {
+        const SCellCoord MinCell = ToCell ( m_Bounds [ Body ] . min );
+        const SCellCoord MaxCell = ToCell ( m_Bounds [ Body ] . max );
+        return Cell . X >= MinCell . X && Cell . X <= MaxCell . X &&
+               Cell . Y >= MinCell . Y && Cell . Y <= MaxCell . Y &&
+               Cell . Z >= MinCell . Z && Cell . Z <= MaxCell . Z;
+    }
+
+    void CSpatialHashGrid::QueryBox( const BoundingBox & Box, CBroadphaseBoxCallback & Callback ) const
+    {
+        if ( m_NumberOfGridBodies > 0 && PE::Math::BoxesOverlap ( Box, m_GridBounds ) )
+        {
+            // Report a body only from the cell owning the minimum corner of its overlap with the box, like FindPairs
+            const auto ReportEntry = [ & ] ( const SCellEntry & Entry )
+            {
+                const int Body = Entry . BodyIndex;
+                if ( PE::Math::BoxesOverlap ( m_Bounds [ Body ], Box ) &&
+                     PackCell ( ToCell ( Vector3Max ( m_Bounds [ Body ] . min, Box . min ) ) ) == Entry . CellKey )
+                {
+                    Callback . ReportBody ( Body );
+                }
+            };
+            const SCellCoord MinCell = ToCell ( Vector3Max ( Box . min, m_GridBounds . min ) );
+            const SCellCoord MaxCell = ToCell ( Vector3Min ( Box . max, m_GridBounds . max ) );
+            const int64_t NumberOfCells = static_cast<int64_t> ( MaxCell . X - MinCell . X + 1 ) *
+                                          static_cast<int64_t> ( MaxCell . Y - MinCell . Y + 1 ) *
+                                          static_cast<int64_t> ( MaxCell . Z - MinCell . Z + 1 );
+            if ( NumberOfCells > static_cast<int64_t> ( m_Entries . size() ) )
+            {
+                for ( const SCellEntry & Entry : m_Entries )
+                {
+                    ReportEntry ( Entry );
+                }
+            }
+            else
+            {
+                for ( int X = MinCell . X; X <= MaxCell . X; X++ )
+                {
+                    for ( int Y = MinCell . Y; Y <= MaxCell . Y; Y++ )
+                    {
+                        for ( int Z = MinCell . Z; Z <= MaxCell . Z; Z++ )
+                        {
+                            const uint64_t CellKey = PackCell ( { X, Y, Z } );
+                            const uint32_t Bucket = BucketOf ( CellKey );
+                            for ( uint32_t i = m_BucketStarts [ Bucket ]; i < m_BucketStarts [ Bucket + 1 ]; i++ )
+                            {
+                                if ( m_Entries [ i ] . CellKey == CellKey )
+                                {
+                                    ReportEntry ( m_Entries [ i ] );
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        for ( const int Body : m_OversizedBodies )
+        {
+            if ( PE::Math::BoxesOverlap ( m_Bounds [ Body ], Box ) )
+            {
+                Callback . ReportBody ( Body );
+            }
+        }
+    }
+
+    void CSpatialHashGrid::QueryRay( const Vector3 & Origin, const Vector3 & Direction, float MaxDistance, CBroadphaseRayCallback & Callback ) const
+    {
+        const Vector3 InvDirection { 1.f / Direction . x, 1.f / Direction . y, 1.f / Direction . z };
+        float Reach = MaxDistance;
+        float Enter = 0.f;
+        float Exit = 0.f;
+        if ( m_NumberOfGridBodies > 0 && PE::Math::RayBoxInterval ( Origin, InvDirection, m_GridBounds, Reach, Enter, Exit ) )
+        {
+            // Step from cell to cell through the face the ray leaves by, starting where it enters the binned bodies
+            const SCellCoord FirstCell = ToCell ( Vector3Add ( Origin, Vector3Scale ( Direction, Enter ) ) );
+            const SCellCoord MinCell = ToCell ( m_GridBounds . min );
+            const SCellCoord MaxCell = ToCell ( m_GridBounds . max );
+            const float Origins [ 3 ] = { Origin . x, Origin . y, Origin . z };
+            const float Inverses [ 3 ] = { InvDirection . x, InvDirection . y, InvDirection . z };
+            const int Mins [ 3 ] = { MinCell . X, MinCell . Y, MinCell . Z };
+            const int Maxs [ 3 ] = { MaxCell . X, MaxCell . Y, MaxCell . Z };
+            int Cell [ 3 ] = { std::clamp ( FirstCell . X, Mins [ 0 ], Maxs [ 0 ] ), std::clamp ( FirstCell . Y, Mins [ 1 ], Maxs [ 1 ] ),
+                               std::clamp ( FirstCell . Z, Mins [ 2 ], Maxs [ 2 ] ) };
+            int Steps [ 3 ] = { 0, 0, 0 };
+            constexpr float Never = std::numeric_limits<float>::infinity();
+            float NextCrossings [ 3 ] = { Never, Never, Never }; // Distance where the ray crosses into the next cell along an axis
+            float CrossingIntervals [ 3 ] = { Never, Never, Never };
+            for ( int Axis = 0; Axis < 3; Axis++ )
+            {
+                if ( std::isinf ( Inverses [ Axis ] ) )
+                {
+                    continue;
+                }
+                Steps [ Axis ] = Inverses [ Axis ] > 0.f ? 1 : -1;
+                const float Boundary = static_cast<float> ( Cell [ Axis ] + ( Steps [ Axis ] > 0 ? 1 : 0 ) ) * m_CellSize;
+                NextCrossings [ Axis ] = ( Boundary - Origins [ Axis ] ) * Inverses [ Axis ];
+                CrossingIntervals [ Axis ] = m_CellSize * std::fabs ( Inverses [ Axis ] );
+            }
+            float CellEnter = Enter;
+            bool HasPrevious = false;
+            SCellCoord Previous;
+            while ( CellEnter <= std::min ( Reach, Exit ) )
+            {
+                const SCellCoord Current { Cell [ 0 ], Cell [ 1 ], Cell [ 2 ] };
+                const uint64_t CellKey = PackCell ( Current );
+                const uint32_t Bucket = BucketOf ( CellKey );
+                for ( uint32_t i = m_BucketStarts [ Bucket ]; i < m_BucketStarts [ Bucket + 1 ]; i++ )
+                {
+                    const int Body = m_Entries [ i ] . BodyIndex;
+                    // The cells on the ray a body covers are consecutive, it is reported from the first of them
+                    if ( m_Entries [ i ] . CellKey != CellKey || ( HasPrevious && IsInBodyCells ( Previous, Body ) ) )
+                    {
+                        continue;
+                    }
+                    float BodyEnter = 0.f;
+                    float BodyExit = 0.f;
+                    if ( PE::Math::RayBoxInterval ( Origin, InvDirection, m_Bounds [ Body ], Reach, BodyEnter, BodyExit ) )
+                    {
+                        Reach = Callback . ReportBody ( Body );
+                        if ( Reach < 0.f )
+                        {
+                            return;
+                        }
+                    }
+                }
+                Previous = Current;
+                HasPrevious = true;
+                const int Axis = NextCrossings [ 0 ] < NextCrossings [ 1 ] ? ( NextCrossings [ 0 ] < NextCrossings [ 2 ] ? 0 : 2 )
+                                                                           : ( NextCrossings [ 1 ] < NextCrossings [ 2 ] ? 1 : 2 );
+                CellEnter = NextCrossings [ Axis ];
+                Cell [ Axis ] += Steps [ Axis ];
+                NextCrossings [ Axis ] += CrossingIntervals [ Axis ];
+                if ( Steps [ Axis ] == 0 || Cell [ Axis ] < Mins [ Axis ] || Cell [ Axis ] > Maxs [ Axis ] )
+                {
+                    break;
+                }
+            }
+        }
+        for ( const int Body : m_OversizedBodies )
+        {
+            if ( PE::Math::RayBoxInterval ( Origin, InvDirection, m_Bounds [ Body ], Reach, Enter, Exit ) )
+            {
+                Reach = Callback . ReportBody ( Body );
+                if ( Reach < 0.f )
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    void CSpatialHashGrid::Clear()
+    {
+        m_Bounds . clear();
+        m_IsPassive . clear();
+        m_IsOversized . clear();
+        m_Entries . clear();
+        m_ScratchEntries . clear();
+        m_BucketStarts . clear();
+        m_OversizedBodies . clear();
+        m_GridBounds = { { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f } };
+        m_NumberOfGridBodies = 0;
+    }
+} // namespace PE
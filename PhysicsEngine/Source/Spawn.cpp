@@ -0,0 +1,126 @@
+#include "Spawn.hpp"
+#include "Random.hpp"
+#include "raymath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace PE
+{
+namespace Spawn
+{
+namespace
+{
+    // Free space between lattice neighbours, in radii
+    constexpr float GLatticeGap = 0.5f;
+
+    int GetCellsAlong ( float Extent, float Spacing )
+    {
+        return std::max ( 1, static_cast<int> ( std::floor ( std::max ( Extent, 0.f ) / Spacing ) ) + 1 );
+    }
+} // namespace
+
+    Vector3 GetPatternPosition( const SBallGenerationParameters & Generation, int64_t Number )
+    {
+        const Vector3 & Min = Generation . MinLocation;
+        const Vector3 & Max = Generation . MaxLocation;
+        const float Radius = Generation . MaxRadius;
+        if ( Generation . Pattern == ESpawnPattern::Lattice )
+        {
+            const float Spacing = ( 2.f + GLatticeGap ) * Radius;
+            const int64_t CellsX = GetCellsAlong ( Max . x - Min . x, Spacing );
+            const int64_t CellsZ = GetCellsAlong ( Max . z - Min . z, Spacing );
+            return { Min . x + static_cast<float> ( Number % CellsX ) * Spacing,
+                     Min . y + static_cast<float> ( Number / ( CellsX * CellsZ ) ) * Spacing,
+                     Min . z + static_cast<float> ( ( Number / CellsX ) % CellsZ ) * Spacing };
+        }
+        // Pile: square layers of touching balls, every second layer shifted by a radius into the pockets of the one below
+        // (one row and column less), which puts its centers sqrt ( 2 ) radii higher
+        const float Spacing = 2.f * Radius;
+        const float LayerHeight = std::sqrt ( 2.f ) * Radius;
+        const int64_t CellsX = GetCellsAlong ( Max . x - Min . x, Spacing );
+        const int64_t CellsZ = GetCellsAlong ( Max . z - Min . z, Spacing );
+        const int64_t InnerCellsX = std::max<int64_t> ( 1, CellsX - 1 );
+        const int64_t InnerCellsZ = std::max<int64_t> ( 1, CellsZ - 1 );
+        const int64_t LayerPair = CellsX * CellsZ + InnerCellsX * InnerCellsZ;
+        int64_t Layer = 2 * ( Number / LayerPair );
+        int64_t InLayer = Number % LayerPair;
+        int64_t RowLength = CellsX;
+        float Shift = 0.f;
+        if ( InLayer >= CellsX * CellsZ )
+        {
+            Layer++;
+            InLayer -= CellsX * CellsZ;
+            RowLength = InnerCellsX;
+            Shift = CellsX > 1 ? Radius : 0.f;
+        }
+        return { Min . x + Shift + static_cast<float> ( InLayer % RowLength ) * Spacing,
+                 Min . y + static_cast<float> ( Layer ) * LayerHeight,
+                 Min . z + ( CellsZ > 1 ? Shift : 0.f ) + static_cast<float> ( InLayer / RowLength ) * Spacing };
+    }
+
+    SPhysicsBody MakeBall( const SBallGenerationParameters & Generation, const SPhysicsBody & Template, uint64_t Seed, int64_t SequenceNumber )
+    {
+        // Three blocks per ball: radius and position, linear velocity, angular velocity
+        const CPhilox4x32 Philox ( Seed );
+        const CPhilox4x32::SBlock Shape = Philox ( static_cast<uint64_t> ( SequenceNumber ), 0 );
+        const CPhilox4x32::SBlock Linear = Philox ( static_cast<uint64_t> ( SequenceNumber ), 1 );
+        const CPhilox4x32::SBlock Angular = Philox ( static_cast<uint64_t> ( SequenceNumber ), 2 );
+
+        SPhysicsBody OutBall = Template;
+        const float Radius = CPhilox4x32::ToRange ( Shape [ 0 ], Generation . MinRadius, Generation . MaxRadius );
+        const float Mass = Radius * Generation . MassToRadius;
+        OutBall . Shape = { .Type = EShapeType::Sphere, .Sphere = { .Radius = Radius } };
+        OutBall . Rotation = QuaternionIdentity();
+        OutBall . Mass = Mass;
+        OutBall . InvMass = Mass > 0.f ? 1.f / Mass : 0.f;
+        OutBall . IsStatic = false;
+        if ( Generation . Pattern == ESpawnPattern::RandomBox )
+        {
+            OutBall . Position = { CPhilox4x32::ToRange ( Shape [ 1 ], Generation . MinLocation . x, Generation . MaxLocation . x ),
+                                   CPhilox4x32::ToRange ( Shape [ 2 ], Generation . MinLocation . y, Generation . MaxLocation . y ),
+                                   CPhilox4x32::ToRange ( Shape [ 3 ], Generation . MinLocation . z, Generation . MaxLocation . z ) };
+        }
+        else
+        {
+            OutBall . Position = GetPatternPosition ( Generation, SequenceNumber );
+        }
+        if ( Generation . Pattern == ESpawnPattern::Pile )
+        {
+            // A pile starts at rest
+            OutBall . LinearVelocity = { 0.f, 0.f, 0.f };
+            OutBall . AngularVelocity = { 0.f, 0.f, 0.f };
+            return OutBall;
+        }
+        OutBall . LinearVelocity = { CPhilox4x32::ToRange ( Linear [ 0 ], Generation . MinLinearVelocity . x, Generation . MaxLinearVelocity . x ),
+                                     CPhilox4x32::ToRange ( Linear [ 1 ], Generation . MinLinearVelocity . y, Generation . MaxLinearVelocity . y ),
+                                     CPhilox4x32::ToRange ( Linear [ 2 ], Generation . MinLinearVelocity . z, Generation . MaxLinearVelocity . z ) };
+        OutBall . AngularVelocity = { CPhilox4x32::ToRange ( Angular [ 0 ], Generation . MinAngularVelocity . x, Generation . MaxAngularVelocity . x ),
+                                      CPhilox4x32::ToRange ( Angular [ 1 ], Generation . MinAngularVelocity . y, Generation . MaxAngularVelocity . y ),
+                                      CPhilox4x32::ToRange ( Angular [ 2 ], Generation . MinAngularVelocity . z, Generation . MaxAngularVelocity . z ) };
+        return OutBall;
+    }
+
+    int SpawnBalls( CBodyStorage & Bodies, CJobSystem & JobSystem, int NumberOfBalls, const SBallGenerationParameters & Generation,
+                    const SPhysicsBody & Template, uint64_t Seed, int64_t FirstSequenceNumber )
+    {
+        // Handles and the material are assigned up front on this thread, the tasks only fill their own index ranges
+        const int FirstIndex = Bodies . Append ( NumberOfBalls, Template );
+        if ( NumberOfBalls <= 0 || FirstIndex < 0 )
+        {
+            return FirstIndex;
+        }
+        const uint16_t MaterialIndex = Bodies . MaterialIndices [ FirstIndex ];
+        const int NumberOfTasks = ( NumberOfBalls + GBallsPerTask - 1 ) / GBallsPerTask;
+        JobSystem . ParallelFor ( NumberOfTasks, [ & ] ( int Task )
+        {
+            const int Begin = Task * GBallsPerTask;
+            const int End = std::min ( Begin + GBallsPerTask, NumberOfBalls );
+            for ( int i = Begin; i < End; i++ )
+            {
+                Bodies . WriteBody ( FirstIndex + i, MakeBall ( Generation, Template, Seed, FirstSequenceNumber + i ), MaterialIndex );
+            }
+        } );
+        return FirstIndex;
+    }
+} // namespace Spawn
+} // namespace PE
@@ -0,0 +1,189 @@
+#include "TraceRecorder.hpp"
+#include <chrono>
+
+namespace PE
+{
+namespace
+{
+    // Chrome trace thread ids, handed out in order of the first event a thread records
+    std::atomic<uint32_t> g_NextTraceThreadId { 1 };
+    thread_local uint32_t t_TraceThreadId = 0;
+} // namespace
+
+    CTraceRing::CTraceRing( int Capacity )
+    {
+        uint64_t Size = 1;
+        while ( Size < static_cast<uint64_t> ( Capacity ) )
+        {
+            Size <<= 1;
+        }
+        m_Mask = Size - 1;
+        m_Slots = std::make_unique<SSlot[]> ( Size );
+        for ( uint64_t i = 0; i < Size; i++ )
+        {
+            m_Slots [ i ] . Sequence . store ( i, std::memory_order_relaxed );
+        }
+    }
+
+    bool CTraceRing::TryPush( const STraceEvent & Event )
+    {
+        // A slot is free for the push at Index when its sequence equals Index, the pop of the previous round sets that
+        uint64_t Index = m_WriteIndex . load ( std::memory_order_relaxed );
+        while ( true )
+        {
+            SSlot & Slot = m_Slots [ Index & m_Mask ];
+            const uint64_t Sequence = Slot . Sequence . load ( std::memory_order_acquire );
+            if ( Sequence == Index )
+            {
+                if ( m_WriteIndex . compare_exchange_weak ( Index, Index + 1, std::memory_order_relaxed ) )
+                {
+                    Slot . Event = Event;
+                    Slot . Sequence . store ( Index + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if ( Sequence < Index )
+            {
+                return false; // Not popped yet, the ring is full
+            }
+            else
+            {
+                Index = m_WriteIndex . load ( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    bool CTraceRing::TryPop( STraceEvent & OutEvent )
+    {
+        SSlot & Slot = m_Slots [ m_ReadIndex & m_Mask ];
+        if ( Slot . Sequence . load ( std::memory_order_acquire ) != m_ReadIndex + 1 )
+        {
+            return false; // Empty, or the push of this slot is still copying the event
+        }
+        OutEvent = Slot . Event;
+        Slot . Sequence . store ( m_ReadIndex + m_Mask + 1, std::memory_order_release );
+        m_ReadIndex++;
+        return true;
+    }
+
+    CTraceRecorder & CTraceRecorder::Get()
+    {
+        static CTraceRecorder Recorder;
+        return Recorder;
+    }
+
+    CTraceRecorder::~CTraceRecorder()
+    {
+        Stop();
+    }
+
+    int64_t CTraceRecorder::NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds> ( std::chrono::steady_clock::now() . time_since_epoch() ) . count();
+    }
+
+    bool CTraceRecorder::Start( const std::string & Path, int Capacity )
+    {
+#if PE_ENABLE_PROFILING
+        if ( m_File )
+        {
+            return false;
+        }
+        m_File = std::fopen ( Path . c_str(), "w" );
+        if ( ! m_File )
+        {
+            return false;
+        }
+        std::fputs ( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                     "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"PhysicsEngine\"}}", m_File );
+        // A scope that began before the last Stop may still push, the ring is only replaced for another capacity.
+        // Its leftovers started before m_StartNs and are skipped by Drain.
+        if ( ! m_Ring || m_Ring -> GetCapacity() < Capacity )
+        {
+            m_Ring = std::make_unique<CTraceRing> ( Capacity );
+        }
+        m_NumberOfWrittenEvents . store ( 0, std::memory_order_relaxed );
+        m_NumberOfDroppedEvents . store ( 0, std::memory_order_relaxed );
+        m_StartNs = NowNs();
+        m_IsStopping = false;
+        m_FlushThread = std::thread ( [ this ] { FlushLoop(); } );
+        s_IsRecording . store ( true, std::memory_order_release );
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void CTraceRecorder::Stop()
+    {
+        if ( ! m_File )
+        {
+            return;
+        }
+        s_IsRecording . store ( false, std::memory_order_release );
+        {
+            std::lock_guard<std::mutex> Lock ( m_FlushMutex );
+            m_IsStopping = true;
+        }
+        m_FlushCondition . notify_all();
+        m_FlushThread . join();
+        Drain();
+        std::fputs ( "\n]}\n", m_File );
+        std::fclose ( m_File );
+        m_File = nullptr;
+    }
+
+    void CTraceRecorder::Record( STraceEvent & Event )
+    {
+        if ( t_TraceThreadId == 0 )
+        {
+            t_TraceThreadId = g_NextTraceThreadId . fetch_add ( 1, std::memory_order_relaxed );
+        }
+        Event . ThreadId = t_TraceThreadId;
+        if ( ! m_Ring -> TryPush ( Event ) )
+        {
+            m_NumberOfDroppedEvents . fetch_add ( 1, std::memory_order_relaxed );
+        }
+    }
+
+    void CTraceRecorder::FlushLoop()
+    {
+        std::unique_lock<std::mutex> Lock ( m_FlushMutex );
+        while ( ! m_IsStopping )
+        {
+            m_FlushCondition . wait_for ( Lock, std::chrono::milliseconds ( GFlushIntervalMs ), [ this ] { return m_IsStopping; } );
+            Lock . unlock();
+            Drain();
+            Lock . lock();
+        }
+    }
+
+    void CTraceRecorder::Drain()
+    {
+        // Complete ("X") events, timestamps in microseconds since Start
+        STraceEvent Event;
+        int64_t NumberOfEvents = 0;
+        while ( m_Ring -> TryPop ( Event ) )
+        {
+            if ( Event . StartNs < m_StartNs )
+            {
+                continue;
+            }
+            std::fprintf ( m_File, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                           Event . Name, Event . ThreadId, static_cast<double> ( Event . StartNs - m_StartNs ) * 1e-3,
+                           static_cast<double> ( Event . DurationNs ) * 1e-3 );
+            if ( Event . ArgNames [ 0 ] )
+            {
+                std::fprintf ( m_File, ",\"args\":{\"%s\":%lld", Event . ArgNames [ 0 ], static_cast<long long> ( Event . ArgValues [ 0 ] ) );
+                if ( Event . ArgNames [ 1 ] )
+                {
+                    std::fprintf ( m_File, ",\"%s\":%lld", Event . ArgNames [ 1 ], static_cast<long long> ( Event . ArgValues [ 1 ] ) );
+                }
+                std::fputc ( '}', m_File );
+            }
+            std::fputc ( '}', m_File );
+            NumberOfEvents++;
+        }
+        m_NumberOfWrittenEvents . fetch_add ( NumberOfEvents, std::memory_order_relaxed );
+    }
+} // namespace PE
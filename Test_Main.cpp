@@ -1,6 +1,154 @@
 #include <gtest/gtest.h>
 #include "raylib.h"
+#include "raymath.h"
 #include "Collision.hpp"
+#include "ContactCache.hpp"
+#include "ContactColoring.hpp"
+#include "BodyStorage.hpp"
+#include "DynamicAABBTree.hpp"
+#include "Integration.hpp"
+#include "Island.hpp"
+#include "JobSystem.hpp"
+#include "Math.hpp"
+#include "MortonOrder.hpp"
+#include "Narrowphase.hpp"
+#include "PhysicsWorld.hpp"
+#include "Profiling.hpp"
+#include "Random.hpp"
+#include "SceneQuery.hpp"
+#include "Simd.hpp"
+#include "SimulationThread.hpp"
+#include "Solver.hpp"
+#include "SpatialHashGrid.hpp"
+#include "Spawn.hpp"
+#include "TraceRecorder.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    PE::SPhysicsBody MakeSphereBody ( const Vector3 & Position, float Radius )
+    {
+        PE::SPhysicsBody Body;
+        Body . Shape . Type = EShapeType::Sphere;
+        Body . Shape . Sphere . Radius = Radius;
+        Body . Position = Position;
+        return Body;
+    }
+
+    PE::SPhysicsBody MakeStaticBoxBody ( const Vector3 & Position, const Vector3 & HalfSize )
+    {
+        PE::SPhysicsBody Body;
+        Body . Shape . Type = EShapeType::Box;
+        Body . Shape . Box . HalfSize = HalfSize;
+        Body . Position = Position;
+        Body . IsStatic = true;
+        Body . Mass = 0.f;
+        Body . InvMass = 0.f;
+        return Body;
+    }
+
+    // Random balls inside a cube of given half extent plus the six world planes around it
+    std::vector<PE::SPhysicsBody> MakeBallScene ( int NumberOfBalls, float HalfExtent, float MinRadius, float MaxRadius, unsigned Seed )
+    {
+        std::mt19937 Generator ( Seed );
+        std::uniform_real_distribution<float> ULocation ( -HalfExtent, HalfExtent );
+        std::uniform_real_distribution<float> URadius ( MinRadius, MaxRadius );
+        std::vector<PE::SPhysicsBody> Bodies;
+        for ( int i = 0; i < NumberOfBalls; i++ )
+        {
+            const Vector3 Position { ULocation ( Generator ), ULocation ( Generator ), ULocation ( Generator ) };
+            Bodies . push_back ( MakeSphereBody ( Position, URadius ( Generator ) ) );
+        }
+        Bodies . push_back ( MakeStaticBoxBody ( { -HalfExtent, 0.f, 0.f }, { 0.f, HalfExtent, HalfExtent } ) );
+        Bodies . push_back ( MakeStaticBoxBody ( { HalfExtent, 0.f, 0.f }, { 0.f, HalfExtent, HalfExtent } ) );
+        Bodies . push_back ( MakeStaticBoxBody ( { 0.f, -HalfExtent, 0.f }, { HalfExtent, 0.f, HalfExtent } ) );
+        Bodies . push_back ( MakeStaticBoxBody ( { 0.f, HalfExtent, 0.f }, { HalfExtent, 0.f, HalfExtent } ) );
+        Bodies . push_back ( MakeStaticBoxBody ( { 0.f, 0.f, -HalfExtent }, { HalfExtent, HalfExtent, 0.f } ) );
+        Bodies . push_back ( MakeStaticBoxBody ( { 0.f, 0.f, HalfExtent }, { HalfExtent, HalfExtent, 0.f } ) );
+        return Bodies;
+    }
+
+    PE::CBodyStorage MakeStorage ( const std::vector<PE::SPhysicsBody> & Bodies )
+    {
+        PE::CBodyStorage OutStorage;
+        for ( const PE::SPhysicsBody & Body : Bodies )
+        {
+            OutStorage . Add ( Body );
+        }
+        return OutStorage;
+    }
+
+    // Random spinning balls with a few materials, some static boxes and some bodies without spin
+    PE::CBodyStorage MakeIntegrationStorage ( int NumberOfBodies, unsigned Seed )
+    {
+        std::mt19937 Generator ( Seed );
+        std::uniform_real_distribution<float> UValue ( -5.f, 5.f );
+        PE::CBodyStorage OutStorage;
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            PE::SPhysicsBody Body = i % 17 == 0
+                ? MakeStaticBoxBody ( { UValue ( Generator ), UValue ( Generator ), UValue ( Generator ) }, { 1.f, 1.f, 1.f } )
+                : MakeSphereBody ( { UValue ( Generator ), UValue ( Generator ), UValue ( Generator ) }, 0.5f );
+            Body . Rotation = { 0.f, 0.f, 0.f, 1.f };
+            Body . LinearVelocity = { UValue ( Generator ), UValue ( Generator ), UValue ( Generator ) };
+            if ( i % 5 != 0 )
+            {
+                Body . AngularVelocity = { UValue ( Generator ), UValue ( Generator ), UValue ( Generator ) };
+            }
+            Body . LinearDamping = 0.1f * static_cast<float> ( i % 3 );
+            Body . AngularDamping = 0.2f;
+            OutStorage . Add ( Body );
+        }
+        return OutStorage;
+    }
+
+    std::set<std::pair<int, int>> BruteForceHits ( const std::vector<PE::SPhysicsBody> & Bodies )
+    {
+        std::set<std::pair<int, int>> OutHits;
+        for ( size_t j = 0; j < Bodies . size(); j++ )
+        {
+            for ( size_t k = j + 1; k < Bodies . size(); k++ )
+            {
+                if ( Bodies [ j ] . IsStatic && Bodies [ k ] . IsStatic )
+                {
+                    continue;
+                }
+                if ( PE::Collision::TestCollision ( Bodies [ j ], Bodies [ k ] ) . IsHit )
+                {
+                    OutHits . insert ( { static_cast<int> ( j ), static_cast<int> ( k ) } );
+                }
+            }
+        }
+        return OutHits;
+    }
+
+    std::set<std::pair<int, int>> CandidateHits ( const std::vector<PE::SPhysicsBody> & Bodies, const std::vector<PE::SBroadphasePair> & Pairs )
+    {
+        std::set<std::pair<int, int>> OutHits;
+        for ( const PE::SBroadphasePair & Pair : Pairs )
+        {
+            if ( PE::Collision::TestCollision ( Bodies [ Pair . BodyA ], Bodies [ Pair . BodyB ] ) . IsHit )
+            {
+                OutHits . insert ( { Pair . BodyA, Pair . BodyB } );
+            }
+        }
+        return OutHits;
+    }
+}
 
 TEST ( Collision, SphereBoxNoCollisionIsHit ) 
 {
@@ -187,4 +335,2260 @@ TEST( Collision, SphereSphereContactPointAndNormal )
     EXPECT_FLOAT_EQ ( HitResult3 . ContactPoint . y, 0.75f );
     EXPECT_FLOAT_EQ ( HitResult3 . ContactPoint . z, 0.f );
 
-}
\ No newline at end of file
+}
+
+TEST ( Collision, SweepsFindTheFirstImpact )
+{
+    // Head on, the gap of 2 closes a quarter into the motion of 8
+    const PE::Collision::SSweepResult Spheres = PE::Collision::SweepSphereSphere ( { -3.f, 0.f, 0.f }, { 4.f, 0.f, 0.f }, 0.5f, { 3.f, 0.f, 0.f }, { -4.f, 0.f, 0.f }, 0.5f );
+    EXPECT_TRUE ( Spheres . IsHit );
+    EXPECT_FLOAT_EQ ( Spheres . TimeOfImpact, 0.625f );
+    EXPECT_FALSE ( PE::Collision::SweepSphereSphere ( { -3.f, 2.f, 0.f }, { 6.f, 0.f, 0.f }, 0.5f, { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, 0.5f ) . IsHit );
+    EXPECT_FALSE ( PE::Collision::SweepSphereSphere ( { -0.5f, 0.f, 0.f }, { 6.f, 0.f, 0.f }, 0.5f, { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, 0.5f ) . IsHit );
+
+    // A thin plate passed through completely within one motion
+    const BoundingBox Plate { .min = { -0.05f, -1.f, -1.f }, .max = { 0.05f, 1.f, 1.f } };
+    const PE::Collision::SSweepResult Box = PE::Collision::SweepSphereBox ( { -4.75f, 0.f, 0.f }, { 10.f, 0.f, 0.f }, 0.2f, Plate );
+    EXPECT_TRUE ( Box . IsHit );
+    EXPECT_FLOAT_EQ ( Box . TimeOfImpact, 0.45f );
+    EXPECT_FALSE ( PE::Collision::SweepSphereBox ( { -4.75f, 1.5f, 0.f }, { 10.f, 0.f, 0.f }, 0.2f, Plate ) . IsHit );
+
+    // From inside, the floor comes before the side wall; resting on the floor doesn't count
+    const BoundingBox Room { .min = { -5.f, -5.f, -5.f }, .max = { 5.f, 5.f, 5.f } };
+    const PE::Collision::SSweepResult Inside = PE::Collision::SweepSphereInsideBox ( { 0.f, 0.f, 0.f }, { 10.f, -20.f, 0.f }, 1.f, Room );
+    EXPECT_TRUE ( Inside . IsHit );
+    EXPECT_FLOAT_EQ ( Inside . TimeOfImpact, 0.2f );
+    EXPECT_FALSE ( PE::Collision::SweepSphereInsideBox ( { 0.f, -4.f, 0.f }, { 1.f, -1.f, 0.f }, 1.f, Room ) . IsHit );
+}
+
+TEST ( Collision, RayCastsFindTheSurfaceAndItsNormal )
+{
+    const PE::Collision::SRayResult Sphere = PE::Collision::RayCastSphere ( { -5.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, 10.f, { 0.f, 0.f, 0.f }, 1.f );
+    EXPECT_TRUE ( Sphere . IsHit );
+    EXPECT_FLOAT_EQ ( Sphere . Distance, 4.f );
+    EXPECT_FLOAT_EQ ( Sphere . Normal . x, -1.f );
+    EXPECT_FALSE ( PE::Collision::RayCastSphere ( { -5.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, 3.9f, { 0.f, 0.f, 0.f }, 1.f ) . IsHit );
+    EXPECT_FALSE ( PE::Collision::RayCastSphere ( { -5.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, 10.f, { 0.f, 0.f, 0.f }, 1.f ) . IsHit );
+    const PE::Collision::SRayResult Inside = PE::Collision::RayCastSphere ( { 0.5f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, 10.f, { 0.f, 0.f, 0.f }, 1.f );
+    EXPECT_TRUE ( Inside . IsHit );
+    EXPECT_FLOAT_EQ ( Inside . Distance, 0.f );
+    EXPECT_FLOAT_EQ ( Inside . Normal . y, -1.f );
+
+    // A wall of zero thickness, hit from above
+    const BoundingBox Floor { .min = { -5.f, -1.f, -5.f }, .max = { 5.f, -1.f, 5.f } };
+    const PE::Collision::SRayResult Box = PE::Collision::RayCastBox ( { 1.f, 3.f, 0.f }, Vector3Normalize ( { 1.f, -1.f, 0.f } ), 100.f, Floor );
+    EXPECT_TRUE ( Box . IsHit );
+    EXPECT_NEAR ( Box . Distance, 4.f * std::sqrt ( 2.f ), 1e-5f );
+    EXPECT_FLOAT_EQ ( Box . Normal . y, 1.f );
+    EXPECT_FALSE ( PE::Collision::RayCastBox ( { 1.f, 3.f, 0.f }, { 1.f, 0.f, 0.f }, 100.f, Floor ) . IsHit );
+}
+
+TEST ( Collision, PairTestsTakeEitherOrder )
+{
+    // Every order of two shape types lands on the same pair type, and every pair type on its own kernel
+    std::set<int> PairTypes;
+    for ( const EShapeType TypeA : { EShapeType::Box, EShapeType::Sphere } )
+    {
+        for ( const EShapeType TypeB : { EShapeType::Box, EShapeType::Sphere } )
+        {
+            const int PairType = PE::Collision::GetPairType ( TypeA, TypeB );
+            EXPECT_EQ ( PairType, PE::Collision::GetPairType ( TypeB, TypeA ) );
+            EXPECT_TRUE ( PE::Collision::IsCanonicalPair ( TypeA, TypeB ) || PE::Collision::IsCanonicalPair ( TypeB, TypeA ) );
+            const std::pair<EShapeType, EShapeType> Types = PE::Collision::GetPairShapeTypes ( PairType );
+            EXPECT_TRUE ( PE::Collision::IsCanonicalPair ( Types . first, Types . second ) );
+            PairTypes . insert ( PairType );
+        }
+    }
+    EXPECT_EQ ( static_cast<int> ( PairTypes . size () ), PE::Collision::GNumberOfPairTypes );
+
+    // Asked box first, the normal still points from B toward A
+    const PE::SPhysicsBody Sphere = MakeSphereBody ( { 0.f, 0.9f, 0.f }, 0.5f );
+    const PE::SPhysicsBody Floor = MakeStaticBoxBody ( { 0.f, 0.f, 0.f }, { 2.f, 0.5f, 2.f } );
+    const PE::Collision::SHitResult SphereFirst = PE::Collision::TestCollision ( Sphere, Floor );
+    const PE::Collision::SHitResult BoxFirst = PE::Collision::TestCollision ( Floor, Sphere );
+    ASSERT_TRUE ( SphereFirst . IsHit && BoxFirst . IsHit );
+    EXPECT_FLOAT_EQ ( SphereFirst . Normal . y, 1.f );
+    EXPECT_FLOAT_EQ ( BoxFirst . Normal . y, -1.f );
+    EXPECT_FLOAT_EQ ( BoxFirst . Penetration, SphereFirst . Penetration );
+    EXPECT_FLOAT_EQ ( BoxFirst . ContactPoint . y, SphereFirst . ContactPoint . y );
+}
+
+TEST ( Collision, ShapeQueriesDispatchOnTheShapeType )
+{
+    // A unit sphere and the cube around it, probed near the cube's edge where only the cube reaches
+    const PE::SPhysicsBody Sphere = MakeSphereBody ( { 0.f, 0.f, 0.f }, 1.f );
+    const PE::SPhysicsBody Cube = MakeStaticBoxBody ( { 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f } );
+    const BoundingBox SphereBounds = PE::Collision::GetBoundingBox ( Sphere . Shape, Sphere . Position );
+    const BoundingBox CubeBounds = PE::Collision::GetBoundingBox ( Cube . Shape, Cube . Position );
+    EXPECT_FLOAT_EQ ( SphereBounds . min . x, CubeBounds . min . x );
+    EXPECT_FLOAT_EQ ( SphereBounds . max . y, CubeBounds . max . y );
+
+    EXPECT_FALSE ( PE::Collision::OverlapsSphere ( Sphere . Shape, Sphere . Position, { 0.9f, 0.9f, 0.f }, 0.1f ) );
+    EXPECT_TRUE ( PE::Collision::OverlapsSphere ( Cube . Shape, Cube . Position, { 0.9f, 0.9f, 0.f }, 0.1f ) );
+    const BoundingBox Corner { { 0.8f, 0.8f, -0.1f }, { 1.f, 1.f, 0.1f } };
+    EXPECT_FALSE ( PE::Collision::OverlapsBox ( Sphere . Shape, Sphere . Position, Corner ) );
+    EXPECT_TRUE ( PE::Collision::OverlapsBox ( Cube . Shape, Cube . Position, Corner ) );
+
+    const PE::Collision::SRayResult SphereRay = PE::Collision::RayCast ( { 3.f, 0.9f, 0.f }, { -1.f, 0.f, 0.f }, 10.f, Sphere . Shape, Sphere . Position );
+    const PE::Collision::SRayResult CubeRay = PE::Collision::RayCast ( { 3.f, 0.9f, 0.f }, { -1.f, 0.f, 0.f }, 10.f, Cube . Shape, Cube . Position );
+    ASSERT_TRUE ( SphereRay . IsHit && CubeRay . IsHit );
+    EXPECT_NEAR ( SphereRay . Distance, 3.f - std::sqrt ( 1.f - 0.81f ), 1e-5f );
+    EXPECT_FLOAT_EQ ( CubeRay . Distance, 2.f );
+
+    const PE::Collision::SSweepResult SphereSweep = PE::Collision::SweepSphere ( { 3.f, 0.9f, 0.f }, { -4.f, 0.f, 0.f }, 0.1f, Sphere . Shape, Sphere . Position );
+    const PE::Collision::SSweepResult CubeSweep = PE::Collision::SweepSphere ( { 3.f, 0.9f, 0.f }, { -4.f, 0.f, 0.f }, 0.1f, Cube . Shape, Cube . Position );
+    ASSERT_TRUE ( SphereSweep . IsHit && CubeSweep . IsHit );
+    EXPECT_NEAR ( SphereSweep . TimeOfImpact, ( 3.f - std::sqrt ( 1.21f - 0.81f ) ) / 4.f, 1e-4f );
+    EXPECT_NEAR ( CubeSweep . TimeOfImpact, 1.9f / 4.f, 1e-3f );
+}
+
+TEST ( Collision, BoxBoxPushesOutAlongTheLeastOverlap )
+{
+    const PE::SPhysicsBody Floor = MakeStaticBoxBody ( { 0.f, 0.f, 0.f }, { 2.f, 0.5f, 2.f } );
+    const PE::SPhysicsBody Crate = MakeStaticBoxBody ( { 1.5f, 0.9f, 0.f }, { 0.5f, 0.5f, 0.5f } );
+    const PE::Collision::SHitResult Hit = PE::Collision::TestCollision ( Crate, Floor );
+    ASSERT_TRUE ( Hit . IsHit );
+    EXPECT_NEAR ( Hit . Penetration, 0.1f, 1e-5f );
+    EXPECT_FLOAT_EQ ( Hit . Normal . x, 0.f );
+    EXPECT_FLOAT_EQ ( Hit . Normal . y, 1.f );
+    EXPECT_NEAR ( Hit . ContactPoint . x, 1.5f, 1e-5f );
+    EXPECT_NEAR ( Hit . ContactPoint . y, 0.45f, 1e-5f );
+    EXPECT_FLOAT_EQ ( PE::Collision::TestCollision ( Floor, Crate ) . Normal . y, -1.f );
+
+    const PE::SPhysicsBody Apart = MakeStaticBoxBody ( { 0.f, 1.05f, 0.f }, { 0.5f, 0.5f, 0.5f } );
+    EXPECT_FALSE ( PE::Collision::TestCollision ( Apart, Floor ) . IsHit );
+    const PE::Collision::SHitResult Near = PE::Collision::TestCollision ( Apart . Shape, Apart . Position, Floor . Shape, Floor . Position, 0.1f );
+    EXPECT_TRUE ( Near . IsHit );
+    EXPECT_NEAR ( Near . Penetration, -0.05f, 1e-5f );
+}
+
+TEST ( Broadphase, SpatialHashGridMatchesBruteForce )
+{
+    const float MaxRadius = 1.f;
+    const std::vector<PE::SPhysicsBody> Bodies = MakeBallScene ( 400, 7.5f, 0.5f, MaxRadius, 1337 );
+
+    PE::CSpatialHashGrid Grid ( 2.f * MaxRadius );
+    Grid . Update ( MakeStorage ( Bodies ) );
+    std::vector<PE::SBroadphasePair> Pairs;
+    Grid . FindPairs ( Pairs );
+
+    EXPECT_EQ ( Grid . GetNumberOfOversizedBodies (), 6 );
+    EXPECT_EQ ( CandidateHits ( Bodies, Pairs ), BruteForceHits ( Bodies ) );
+}
+
+TEST ( Broadphase, SpatialHashGridReportsEachPairOnce )
+{
+    const float MaxRadius = 1.f;
+    const std::vector<PE::SPhysicsBody> Bodies = MakeBallScene ( 400, 7.5f, 0.5f, MaxRadius, 42 );
+
+    PE::CSpatialHashGrid Grid ( 2.f * MaxRadius, 0.1f );
+    Grid . Update ( MakeStorage ( Bodies ) );
+    std::vector<PE::SBroadphasePair> Pairs;
+    Grid . FindPairs ( Pairs );
+
+    std::set<std::pair<int, int>> Unique;
+    for ( const PE::SBroadphasePair & Pair : Pairs )
+    {
+        EXPECT_LT ( Pair . BodyA, Pair . BodyB );
+        EXPECT_FALSE ( Bodies [ Pair . BodyA ] . IsStatic && Bodies [ Pair . BodyB ] . IsStatic );
+        Unique . insert ( { Pair . BodyA, Pair . BodyB } );
+    }
+    EXPECT_EQ ( Unique . size(), Pairs . size() );
+}
+
+TEST ( Broadphase, SpatialHashGridPairCountIsNearLinear )
+{
+    // Sparse scene: brute force would test n * ( n - 1 ) / 2 pairs
+    const int NumberOfBalls = 5000;
+    const std::vector<PE::SPhysicsBody> Bodies = MakeBallScene ( NumberOfBalls, 60.f, 0.5f, 1.f, 7 );
+
+    PE::CSpatialHashGrid Grid ( 2.f );
+    Grid . Update ( MakeStorage ( Bodies ) );
+    std::vector<PE::SBroadphasePair> Pairs;
+    Grid . FindPairs ( Pairs );
+
+    EXPECT_EQ ( Grid . GetNumberOfGridBodies (), NumberOfBalls );
+    EXPECT_LT ( Pairs . size(), static_cast<size_t> ( 2 * NumberOfBalls ) );
+    EXPECT_EQ ( CandidateHits ( Bodies, Pairs ), BruteForceHits ( Bodies ) );
+}
+
+TEST ( Broadphase, SpatialHashGridEmpty )
+{
+    PE::CSpatialHashGrid Grid ( 2.f );
+    Grid . Update ( PE::CBodyStorage {} );
+    std::vector<PE::SBroadphasePair> Pairs;
+    Grid . FindPairs ( Pairs );
+    EXPECT_TRUE ( Pairs . empty() );
+}
+
+TEST ( Broadphase, AABBTreeStaysBalancedUnderChurn )
+{
+    std::mt19937 Generator ( 99 );
+    std::uniform_real_distribution<float> ULocation ( -50.f, 50.f );
+    std::uniform_real_distribution<float> USize ( 0.1f, 5.f );
+    auto RandomBox = [ & ] ()
+    {
+        const Vector3 Center { ULocation ( Generator ), ULocation ( Generator ), ULocation ( Generator ) };
+        const float HalfSize = USize ( Generator );
+        return BoundingBox { { Center . x - HalfSize, Center . y - HalfSize, Center . z - HalfSize }, 
+                             { Center . x + HalfSize, Center . y + HalfSize, Center . z + HalfSize } };
+    };
+
+    PE::CDynamicAABBTree Tree;
+    std::vector<int> Proxies;
+    for ( int i = 0; i < 1000; i++ )
+    {
+        Proxies . push_back ( Tree . CreateProxy ( RandomBox (), 0.1f, i ) );
+    }
+    ASSERT_TRUE ( Tree . Validate () );
+    for ( int i = 0; i < 1000; i += 2 )
+    {
+        Tree . DestroyProxy ( Proxies [ i ] );
+    }
+    for ( int i = 1; i < 1000; i += 2 )
+    {
+        Tree . MoveProxy ( Proxies [ i ], RandomBox (), 0.1f );
+    }
+    EXPECT_TRUE ( Tree . Validate () );
+    EXPECT_EQ ( Tree . GetNumberOfProxies (), 500 );
+    EXPECT_LE ( Tree . GetHeight (), 20 );
+}
+
+TEST ( Broadphase, AABBTreeMovesInsideFatBoxWithoutReinsert )
+{
+    PE::CDynamicAABBTree Tree;
+    const BoundingBox Box { { 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f } };
+    const int Proxy = Tree . CreateProxy ( Box, 0.5f, 0 );
+    EXPECT_FALSE ( Tree . MoveProxy ( Proxy, { { 0.2f, 0.2f, 0.2f }, { 1.2f, 1.2f, 1.2f } }, 0.5f ) );
+    EXPECT_TRUE ( Tree . MoveProxy ( Proxy, { { 2.f, 0.f, 0.f }, { 3.f, 1.f, 1.f } }, 0.5f ) );
+    EXPECT_FLOAT_EQ ( Tree . GetFatBox ( Proxy ) . min . x, 1.5f );
+}
+
+TEST ( Broadphase, AABBTreeMatchesBruteForceWithMixedSizes )
+{
+    // Radii span two orders of magnitude, which a uniform grid handles badly
+    std::vector<PE::SPhysicsBody> Bodies = MakeBallScene ( 300, 7.5f, 0.05f, 0.3f, 5 );
+    std::mt19937 Generator ( 6 );
+    std::uniform_real_distribution<float> ULocation ( -7.5f, 7.5f );
+    for ( int i = 0; i < 10; i++ )
+    {
+        Bodies . push_back ( MakeSphereBody ( { ULocation ( Generator ), ULocation ( Generator ), ULocation ( Generator ) }, 3.f ) );
+    }
+
+    PE::CAABBTreeBroadphase Broadphase ( 0.05f );
+    Broadphase . Update ( MakeStorage ( Bodies ) );
+    std::vector<PE::SBroadphasePair> Pairs;
+    Broadphase . FindPairs ( Pairs );
+
+    EXPECT_EQ ( Broadphase . GetStaticTree () . GetNumberOfProxies (), 6 );
+    EXPECT_TRUE ( Broadphase . GetDynamicTree () . Validate () );
+    for ( const PE::SBroadphasePair & Pair : Pairs )
+    {
+        EXPECT_LT ( Pair . BodyA, Pair . BodyB );
+        EXPECT_FALSE ( Bodies [ Pair . BodyA ] . IsStatic && Bodies [ Pair . BodyB ] . IsStatic );
+    }
+    EXPECT_EQ ( CandidateHits ( Bodies, Pairs ), BruteForceHits ( Bodies ) );
+}
+
+TEST ( Broadphase, AABBTreeRefitsMovedBodies )
+{
+    std::vector<PE::SPhysicsBody> Bodies = MakeBallScene ( 200, 7.5f, 0.5f, 1.f, 11 );
+    PE::CAABBTreeBroadphase Broadphase ( 0.1f );
+    Broadphase . Update ( MakeStorage ( Bodies ) );
+
+    // Small motion stays inside the fat boxes
+    for ( PE::SPhysicsBody & Body : Bodies )
+    {
+        if ( ! Body . IsStatic )
+        {
+            Body . Position . y -= 0.05f;
+        }
+    }
+    Broadphase . Update ( MakeStorage ( Bodies ) );
+    EXPECT_EQ ( Broadphase . GetNumberOfReinsertedProxies (), 0 );
+
+    // Large motion reinserts every dynamic body
+    for ( PE::SPhysicsBody & Body : Bodies )
+    {
+        if ( ! Body . IsStatic )
+        {
+            Body . Position . y -= 1.f;
+        }
+    }
+    Broadphase . Update ( MakeStorage ( Bodies ) );
+    EXPECT_EQ ( Broadphase . GetNumberOfReinsertedProxies (), 200 );
+
+    std::vector<PE::SBroadphasePair> Pairs;
+    Broadphase . FindPairs ( Pairs );
+    EXPECT_EQ ( CandidateHits ( Bodies, Pairs ), BruteForceHits ( Bodies ) );
+}
+
+TEST ( Broadphase, AABBTreeFollowsAddedAndRemovedBodies )
+{
+    std::vector<PE::SPhysicsBody> Scene = MakeBallScene ( 300, 7.5f, 0.3f, 0.8f, 21 );
+    PE::CBodyStorage Storage = MakeStorage ( Scene );
+    PE::CAABBTreeBroadphase Broadphase ( 0.05f );
+    Broadphase . Update ( Storage );
+
+    std::mt19937 Generator ( 8 );
+    std::uniform_real_distribution<float> ULocation ( -7.f, 7.f );
+    for ( int Round = 0; Round < 10; Round++ )
+    {
+        // Remove some, add some (a few of them removed again before the next Update)
+        for ( int i = 0; i < 40; i++ )
+        {
+            const int Index = std::uniform_int_distribution<int> ( 0, Storage . Size () - 1 ) ( Generator );
+            Broadphase . RemoveBody ( Storage, Index );
+            Storage . Remove ( Storage . GetHandle ( Index ) );
+            Storage . Add ( MakeSphereBody ( { ULocation ( Generator ), ULocation ( Generator ), ULocation ( Generator ) }, 0.5f ) );
+        }
+        Broadphase . Update ( Storage );
+        EXPECT_EQ ( Broadphase . GetNumberOfReinsertedProxies (), 0 );
+    }
+    const std::vector<PE::SPhysicsBody> Bodies = Storage . ExportBodies ();
+    std::vector<PE::SBroadphasePair> Pairs;
+    Broadphase . FindPairs ( Pairs );
+    EXPECT_EQ ( CandidateHits ( Bodies, Pairs ), BruteForceHits ( Bodies ) );
+    EXPECT_EQ ( Broadphase . GetDynamicTree () . GetNumberOfProxies () + Broadphase . GetStaticTree () . GetNumberOfProxies (), Storage . Size () );
+}
+
+TEST ( Broadphase, CreateBroadphaseHonoursType )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . BroadphaseType = PE::EBroadphaseType::DynamicAABBTree;
+    EXPECT_NE ( dynamic_cast<PE::CAABBTreeBroadphase*> ( PE::CreateBroadphase ( Parameters ) . get() ), nullptr );
+    Parameters . BroadphaseType = PE::EBroadphaseType::SpatialHashGrid;
+    EXPECT_NE ( dynamic_cast<PE::CSpatialHashGrid*> ( PE::CreateBroadphase ( Parameters ) . get() ), nullptr );
+}
+
+TEST ( BodyStorage, ImportExportRoundTrip )
+{
+    PE::SPhysicsBody Ball = MakeSphereBody ( { 1.f, 2.f, 3.f }, 0.5f );
+    Ball . LinearVelocity = { 4.f, 5.f, 6.f };
+    Ball . AngularVelocity = { 7.f, 8.f, 9.f };
+    Ball . Rotation = { 0.f, 0.f, 0.f, 1.f };
+    Ball . Mass = 5.f;
+    Ball . InvMass = 0.2f;
+    Ball . Restitution = 0.3f;
+    Ball . Friction = 0.2f;
+    const PE::SPhysicsBody Wall = MakeStaticBoxBody ( { 0.f, -5.f, 0.f }, { 5.f, 0.f, 5.f } );
+
+    PE::CBodyStorage Storage;
+    const int BallHandle = Storage . Add ( Ball );
+    const int WallHandle = Storage . Add ( Wall );
+    ASSERT_EQ ( Storage . Size (), 2 );
+    EXPECT_NE ( BallHandle, WallHandle );
+
+    const PE::SPhysicsBody Exported = Storage . GetBody ( Storage . GetIndex ( BallHandle ) );
+    EXPECT_EQ ( Exported . Id, BallHandle );
+    EXPECT_FLOAT_EQ ( Exported . Position . y, 2.f );
+    EXPECT_FLOAT_EQ ( Exported . LinearVelocity . z, 6.f );
+    EXPECT_FLOAT_EQ ( Exported . AngularVelocity . x, 7.f );
+    EXPECT_FLOAT_EQ ( Exported . Rotation . w, 1.f );
+    EXPECT_FLOAT_EQ ( Exported . Mass, 5.f );
+    EXPECT_FLOAT_EQ ( Exported . Restitution, 0.3f );
+    EXPECT_FLOAT_EQ ( Exported . Shape . Sphere . Radius, 0.5f );
+    EXPECT_FALSE ( Exported . IsStatic );
+    EXPECT_TRUE ( Storage . IsStatic ( Storage . GetIndex ( WallHandle ) ) );
+    EXPECT_EQ ( Storage . GetIndex ( 42 ), -1 );
+}
+
+TEST ( BodyStorage, RemoveSwapsInTheLastBodyAndRetiresTheHandle )
+{
+    PE::CBodyStorage Storage;
+    std::vector<int> Handles;
+    for ( int i = 0; i < 5; i++ )
+    {
+        Handles . push_back ( Storage . Add ( MakeSphereBody ( { static_cast<float> ( i ), 0.f, 0.f }, 0.5f ) ) );
+    }
+    ASSERT_TRUE ( Storage . Remove ( Handles [ 1 ] ) );
+    EXPECT_FALSE ( Storage . Remove ( Handles [ 1 ] ) );
+    ASSERT_EQ ( Storage . Size (), 4 );
+    EXPECT_EQ ( Storage . GetIndex ( Handles [ 1 ] ), -1 );
+    // The last body filled the hole, the others kept their indices
+    EXPECT_EQ ( Storage . GetIndex ( Handles [ 4 ] ), 1 );
+    EXPECT_EQ ( Storage . Positions . X [ 1 ], 4.f );
+    EXPECT_EQ ( Storage . GetIndex ( Handles [ 3 ] ), 3 );
+
+    // The freed slot comes back with a new generation, the stale handle still doesn't resolve
+    const int Reused = Storage . Add ( MakeSphereBody ( { 9.f, 0.f, 0.f }, 0.5f ) );
+    EXPECT_NE ( Reused, Handles [ 1 ] );
+    EXPECT_EQ ( PE::CBodyStorage::GetHandleSlot ( Reused ), PE::CBodyStorage::GetHandleSlot ( Handles [ 1 ] ) );
+    EXPECT_EQ ( Storage . GetNumberOfHandleSlots (), 5 );
+    EXPECT_EQ ( Storage . GetIndex ( Handles [ 1 ] ), -1 );
+    EXPECT_EQ ( Storage . Positions . X [ Storage . GetIndex ( Reused ) ], 9.f );
+    EXPECT_EQ ( Storage . GetBody ( Storage . GetIndex ( Reused ) ) . Id, Reused );
+}
+
+TEST ( BodyStorage, StaleHandlesNeverResolveToLaterBodies )
+{
+    // Freed slots come back oldest first
+    PE::CBodyStorage Storage;
+    const int First = Storage . Add ( MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f ) );
+    const int Second = Storage . Add ( MakeSphereBody ( { 1.f, 0.f, 0.f }, 0.5f ) );
+    ASSERT_TRUE ( Storage . Remove ( First ) );
+    ASSERT_TRUE ( Storage . Remove ( Second ) );
+    EXPECT_EQ ( PE::CBodyStorage::GetHandleSlot ( Storage . Add ( MakeSphereBody ( { 2.f, 0.f, 0.f }, 0.5f ) ) ), PE::CBodyStorage::GetHandleSlot ( First ) );
+    EXPECT_EQ ( PE::CBodyStorage::GetHandleSlot ( Storage . Add ( MakeSphereBody ( { 3.f, 0.f, 0.f }, 0.5f ) ) ), PE::CBodyStorage::GetHandleSlot ( Second ) );
+
+    // One body respawned over and over: its slot retires once the generations run out instead of wrapping
+    PE::CBodyStorage Churned;
+    const int Original = Churned . Add ( MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f ) );
+    int Handle = Original;
+    for ( int Cycle = 0; Cycle < 2 * ( PE::CBodyStorage::GHandleGenerationMask + 1 ); Cycle++ )
+    {
+        ASSERT_TRUE ( Churned . Remove ( Handle ) );
+        Handle = Churned . Add ( MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f ) );
+        ASSERT_NE ( Handle, Original ) << "cycle " << Cycle;
+        ASSERT_EQ ( Churned . GetIndex ( Original ), -1 ) << "cycle " << Cycle;
+    }
+    EXPECT_EQ ( Churned . GetNumberOfHandleSlots (), 3 );
+
+    // More bodies than handle slots are refused, not wrapped into the generation bits
+    EXPECT_EQ ( Churned . Append ( PE::CBodyStorage::GMaxHandleSlots, MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f ) ), -1 );
+    EXPECT_EQ ( Churned . Size (), 1 );
+}
+
+TEST ( BodyStorage, ChurnOnAWarmPoolDoesNotAllocate )
+{
+    // Projectiles fired and despawned in waves, the storage never holds more than the first wave
+    PE::CBodyStorage Storage;
+    std::vector<int> Handles;
+    for ( int i = 0; i < 1000; i++ )
+    {
+        Handles . push_back ( Storage . Add ( MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.1f ) ) );
+    }
+    const float * const Positions = Storage . Positions . X . data ();
+    const float * const Radii = Storage . Radii . data ();
+    std::mt19937 Generator ( 5 );
+    for ( int Wave = 0; Wave < 20; Wave++ )
+    {
+        std::shuffle ( Handles . begin (), Handles . end (), Generator );
+        for ( int i = 0; i < 500; i++ )
+        {
+            ASSERT_TRUE ( Storage . Remove ( Handles [ i ] ) );
+            Handles [ i ] = Storage . Add ( MakeSphereBody ( { static_cast<float> ( Wave ), 0.f, 0.f }, 0.1f ) );
+        }
+    }
+    EXPECT_EQ ( Storage . Size (), 1000 );
+    EXPECT_EQ ( Storage . GetNumberOfHandleSlots (), 1000 );
+    EXPECT_EQ ( Storage . Positions . X . data (), Positions );
+    EXPECT_EQ ( Storage . Radii . data (), Radii );
+    for ( int i = 0; i < Storage . Size (); i++ )
+    {
+        ASSERT_EQ ( Storage . GetIndex ( Storage . GetHandle ( i ) ), i );
+    }
+}
+
+TEST ( BodyStorage, CachesInverseInertiaAndSharesMaterials )
+{
+    PE::CBodyStorage Storage;
+    PE::SPhysicsBody Ball = MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f );
+    Ball . Mass = 4.f;
+    Ball . InvMass = 0.25f;
+    Storage . Add ( Ball );
+    Storage . Add ( Ball );
+    Storage . Add ( MakeStaticBoxBody ( { 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f } ) );
+
+    EXPECT_FLOAT_EQ ( Storage . InvInertias [ 0 ], 1.f / Ball . Shape . GetMomentOfInertia ( Ball . Mass ) );
+    EXPECT_FLOAT_EQ ( Storage . InvInertias [ 2 ], 0.f );
+    EXPECT_FLOAT_EQ ( Storage . InvMasses [ 2 ], 0.f );
+    EXPECT_EQ ( Storage . MaterialIndices [ 0 ], Storage . MaterialIndices [ 1 ] );
+    EXPECT_EQ ( Storage . GetNumberOfMaterials (), 1 );
+}
+
+TEST ( BodyStorage, MaterialPairTableCombinesEveryPair )
+{
+    PE::CBodyStorage Storage;
+    // More materials than the initial table width, so the table grows and recombines once
+    for ( int i = 0; i < 12; i++ )
+    {
+        PE::SMaterial Material;
+        Material . Restitution = 0.05f * static_cast<float> ( i );
+        Material . Friction = 0.6f - 0.1f * static_cast<float> ( i );
+        EXPECT_EQ ( Storage . AddMaterial ( Material ), i );
+    }
+    for ( int A = 0; A < Storage . GetNumberOfMaterials (); A++ )
+    {
+        for ( int B = 0; B < Storage . GetNumberOfMaterials (); B++ )
+        {
+            const PE::SMaterialPair & Pair = Storage . GetMaterialPair ( A, B );
+            EXPECT_EQ ( Pair . Restitution, std::fmin ( Storage . GetMaterial ( A ) . Restitution, Storage . GetMaterial ( B ) . Restitution ) );
+            EXPECT_EQ ( Pair . Friction, std::fmax ( 0.f, std::fmin ( Storage . GetMaterial ( A ) . Friction, Storage . GetMaterial ( B ) . Friction ) ) );
+            EXPECT_EQ ( Pair . Friction, Storage . GetMaterialPair ( B, A ) . Friction );
+        }
+    }
+}
+
+TEST ( BodyStorage, MaterialTableStopsAtItsLimit )
+{
+    PE::CBodyStorage Storage;
+    PE::SMaterial Material;
+    for ( int i = 0; i < PE::CBodyStorage::GMaxMaterials; i++ )
+    {
+        Material . Restitution = static_cast<float> ( i );
+        ASSERT_EQ ( Storage . AddMaterial ( Material ), i );
+    }
+    Material . Restitution = -0.f;
+    EXPECT_EQ ( Storage . AddMaterial ( Material ), 0 );
+    Material . Restitution = -1.f;
+    EXPECT_EQ ( Storage . AddMaterial ( Material ), -1 );
+
+    // A body with a new material is refused instead of getting a wrapped index, known materials still fit
+    PE::SPhysicsBody Body = MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f );
+    Body . Restitution = 2.f;
+    const int Handle = Storage . Add ( Body );
+    ASSERT_GE ( Handle, 0 );
+    EXPECT_EQ ( Storage . MaterialIndices [ 0 ], 2 );
+    Body . Restitution = -1.f;
+    EXPECT_EQ ( Storage . Add ( Body ), -1 );
+    EXPECT_EQ ( Storage . Append ( 10, Body ), -1 );
+    EXPECT_FALSE ( Storage . SetBody ( 0, Body ) );
+    EXPECT_EQ ( Storage . Size (), 1 );
+    EXPECT_EQ ( Storage . GetNumberOfMaterials (), PE::CBodyStorage::GMaxMaterials );
+}
+
+TEST ( BodyStorage, SetBodyKeepsTheWorldBoundaryFlag )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 10;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    PE::CBodyStorage & Bodies = World . GetBodies ();
+    const int Floor = Parameters . NumberOfBalls + 2;
+    ASSERT_TRUE ( Bodies . IsWorldBoundary ( Floor ) );
+    PE::SPhysicsBody Wall = Bodies . GetBody ( Floor );
+    Wall . Friction = 0.1f;
+    ASSERT_TRUE ( Bodies . SetBody ( Floor, Wall ) );
+    EXPECT_TRUE ( Bodies . IsWorldBoundary ( Floor ) );
+    EXPECT_TRUE ( Bodies . IsStatic ( Floor ) );
+    EXPECT_FLOAT_EQ ( Bodies . GetMaterial ( Bodies . MaterialIndices [ Floor ] ) . Friction, 0.1f );
+    // Ordinary bodies don't become walls
+    ASSERT_TRUE ( Bodies . SetBody ( 0, Bodies . GetBody ( 0 ) ) );
+    EXPECT_FALSE ( Bodies . IsWorldBoundary ( 0 ) );
+}
+
+TEST ( BodyStorage, SleepingIslandsWakeThroughTheirRing )
+{
+    PE::CBodyStorage Storage = MakeStorage ( MakeBallScene ( 10, 7.5f, 0.5f, 1.f, 7 ) );
+    const std::vector<int> First { 0, 3, 5, 9 };
+    const std::vector<int> Second { 1, 2 };
+    Storage . PutIslandToSleep ( First, 0 );
+    Storage . PutIslandToSleep ( Second, 1 );
+    const int Removed = Storage . GetHandle ( 3 );
+    const int Kept = Storage . GetHandle ( 5 );
+    const int Other = Storage . GetHandle ( 1 );
+
+    // Removing a member and reordering the rest keeps the ring closed
+    ASSERT_TRUE ( Storage . Remove ( Removed ) );
+    std::vector<int> NewToOld ( Storage . Size () );
+    for ( int i = 0; i < Storage . Size (); i++ )
+    {
+        NewToOld [ i ] = Storage . Size () - 1 - i;
+    }
+    Storage . Permute ( NewToOld );
+    EXPECT_EQ ( Storage . WakeIsland ( Storage . GetIndex ( Kept ) ), 3 );
+    EXPECT_EQ ( Storage . WakeIsland ( Storage . GetIndex ( Kept ) ), 0 );
+    int NumberOfSleeping = 0;
+    for ( int i = 0; i < Storage . Size (); i++ )
+    {
+        NumberOfSleeping += Storage . IsSleeping ( i ) ? 1 : 0;
+    }
+    EXPECT_EQ ( NumberOfSleeping, 2 );
+    EXPECT_TRUE ( Storage . IsSleeping ( Storage . GetIndex ( Other ) ) );
+    EXPECT_EQ ( Storage . WakeIsland ( Storage . GetIndex ( Other ) ), 2 );
+}
+
+TEST ( MortonOrder, SortsBodiesAlongTheCurve )
+{
+    EXPECT_EQ ( PE::CMortonOrder::Encode ( 1, 0, 0 ), 1u );
+    EXPECT_EQ ( PE::CMortonOrder::Encode ( 0, 1, 0 ), 2u );
+    EXPECT_EQ ( PE::CMortonOrder::Encode ( 0, 0, 1 ), 4u );
+    EXPECT_EQ ( PE::CMortonOrder::Encode ( 3, 0, 0 ), 9u );
+    EXPECT_EQ ( PE::CMortonOrder::Encode ( 1023, 1023, 1023 ), 0x3FFFFFFFu );
+
+    PE::CBodyStorage Storage = MakeStorage ( MakeBallScene ( 500, 7.5f, 0.5f, 1.f, 7 ) );
+    std::vector<Vector3> PositionsByHandle;
+    for ( int i = 0; i < Storage . Size (); i++ )
+    {
+        PositionsByHandle . push_back ( Storage . Positions . Get ( Storage . GetIndex ( i ) ) );
+    }
+    PE::CMortonOrder Order;
+    EXPECT_GT ( Order . Measure ( Storage ), 0.3f );
+    Storage . Permute ( Order . Sort () );
+
+    EXPECT_EQ ( Order . Measure ( Storage ), 0.f );
+    const std::span<const uint32_t> Codes = Order . GetCodes ();
+    EXPECT_TRUE ( std::is_sorted ( Codes . begin (), Codes . end () ) );
+    for ( int Handle = 0; Handle < Storage . Size (); Handle++ )
+    {
+        const int Index = Storage . GetIndex ( Handle );
+        EXPECT_EQ ( Storage . GetHandle ( Index ), Handle );
+        EXPECT_EQ ( Storage . Positions . X [ Index ], PositionsByHandle [ Handle ] . x );
+        EXPECT_EQ ( Storage . Positions . Z [ Index ], PositionsByHandle [ Handle ] . z );
+    }
+}
+
+TEST ( MortonOrder, AABBTreeRemapsProxiesWithoutReinserting )
+{
+    PE::CBodyStorage Storage = MakeStorage ( MakeBallScene ( 400, 7.5f, 0.5f, 1.f, 11 ) );
+    PE::CAABBTreeBroadphase Broadphase ( 0.1f );
+    Broadphase . Update ( Storage );
+
+    PE::CMortonOrder Order;
+    Order . Measure ( Storage );
+    const std::span<const int> NewToOld = Order . Sort ();
+    Storage . Permute ( NewToOld );
+    Broadphase . RemapBodies ( NewToOld );
+    Broadphase . Update ( Storage );
+    std::vector<PE::SBroadphasePair> Pairs;
+    Broadphase . FindPairs ( Pairs );
+
+    EXPECT_EQ ( Broadphase . GetNumberOfReinsertedProxies (), 0 );
+    const std::vector<PE::SPhysicsBody> Bodies = Storage . ExportBodies ();
+    EXPECT_EQ ( CandidateHits ( Bodies, Pairs ), BruteForceHits ( Bodies ) );
+}
+
+TEST ( MortonOrder, WorldSortsRandomlyGeneratedBalls )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 500;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    World . Step ( World . GetFixedDeltaTime () );
+    // Generated in random order, so the first step's check sorts them
+    EXPECT_EQ ( World . GetNumberOfBodySorts (), 1 );
+    for ( int Step = 1; Step < Parameters . BodyOrderCheckInterval; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+    }
+    EXPECT_EQ ( World . GetNumberOfBodySorts (), 1 );
+
+    World . SortBodies ();
+    EXPECT_EQ ( World . GetNumberOfBodySorts (), 2 );
+    PE::CMortonOrder Order;
+    EXPECT_EQ ( Order . Measure ( World . GetBodies () ), 0.f );
+    // The walls are found through their handles after the sort, so the boundary stage keeps the balls inside
+    World . Step ( World . GetFixedDeltaTime () );
+    const PE::CBodyStorage & Bodies = World . GetBodies ();
+    int NumberOfWalls = 0;
+    for ( int i = 0; i < Bodies . Size (); i++ )
+    {
+        NumberOfWalls += Bodies . IsWorldBoundary ( i ) ? 1 : 0;
+        EXPECT_GE ( Bodies . Positions . Y [ i ], World . GetWorldBox () . min . y - 0.01f ) << "body " << i;
+    }
+    EXPECT_EQ ( NumberOfWalls, 6 );
+}
+
+TEST ( Integration, SimdMatchesScalar )
+{
+    // Not a multiple of 8 or 4, so the scalar remainder path runs too
+    constexpr int NumberOfBodies = 203;
+    constexpr int NumberOfSteps = 120;
+    constexpr float DeltaTime = 1.f / 120.f;
+    const Vector3 Gravity { 0.f, -9.81f, 0.f };
+
+    PE::CBodyStorage Reference = MakeIntegrationStorage ( NumberOfBodies, 7 );
+    for ( int Step = 0; Step < NumberOfSteps; Step++ )
+    {
+        PE::Integration::Integrate ( Reference, DeltaTime, Gravity, PE::ESimdLevel::Scalar );
+    }
+
+    for ( PE::ESimdLevel Level : { PE::ESimdLevel::SSE2, PE::ESimdLevel::AVX2 } )
+    {
+        if ( PE::Simd::ResolveLevel ( Level ) != Level )
+        {
+            continue;
+        }
+        SCOPED_TRACE ( PE::Simd::GetLevelName ( Level ) );
+        PE::CBodyStorage Storage = MakeIntegrationStorage ( NumberOfBodies, 7 );
+        for ( int Step = 0; Step < NumberOfSteps; Step++ )
+        {
+            PE::Integration::Integrate ( Storage, DeltaTime, Gravity, Level );
+        }
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            const Vector3 Position = Storage . Positions . Get ( i );
+            const Vector3 ReferencePosition = Reference . Positions . Get ( i );
+            EXPECT_NEAR ( Position . x, ReferencePosition . x, 1e-4f );
+            EXPECT_NEAR ( Position . y, ReferencePosition . y, 1e-4f );
+            EXPECT_NEAR ( Position . z, ReferencePosition . z, 1e-4f );
+            EXPECT_NEAR ( Storage . LinearVelocities . Y [ i ], Reference . LinearVelocities . Y [ i ], 1e-4f );
+            EXPECT_NEAR ( Storage . AngularVelocities . X [ i ], Reference . AngularVelocities . X [ i ], 1e-4f );
+            // q and -q are the same rotation
+            const Quaternion Rotation = Storage . Rotations . Get ( i );
+            const Quaternion ReferenceRotation = Reference . Rotations . Get ( i );
+            const float Dot = Rotation . x * ReferenceRotation . x + Rotation . y * ReferenceRotation . y +
+                              Rotation . z * ReferenceRotation . z + Rotation . w * ReferenceRotation . w;
+            EXPECT_NEAR ( std::fabs ( Dot ), 1.f, 1e-4f );
+        }
+    }
+}
+
+TEST ( Integration, SimdRotationMatchesStdSinCos )
+{
+    // One step from the identity about x sets the rotation to ( sin ( Angle ), 0, 0, cos ( Angle ) ) with Angle = Wx * DeltaTime / 2.
+    // A multiple of 8 bodies, so every lane goes through the SIMD sine / cosine
+    constexpr int NumberOfBodies = 1024;
+    constexpr float DeltaTime = 1.f;
+    constexpr double Pi = 3.14159265358979323846;
+    for ( PE::ESimdLevel Level : { PE::ESimdLevel::SSE2, PE::ESimdLevel::AVX2 } )
+    {
+        if ( PE::Simd::ResolveLevel ( Level ) != Level )
+        {
+            continue;
+        }
+        SCOPED_TRACE ( PE::Simd::GetLevelName ( Level ) );
+        PE::CBodyStorage Storage;
+        std::vector<float> Angles;
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            const float Angle = static_cast<float> ( -Pi + 2. * Pi * i / ( NumberOfBodies - 1 ) );
+            PE::SPhysicsBody Body = MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f );
+            Body . Rotation = { 0.f, 0.f, 0.f, 1.f };
+            Body . AngularVelocity = { 2.f * Angle / DeltaTime, 0.f, 0.f };
+            Storage . Add ( Body );
+            Angles . push_back ( Angle );
+        }
+        PE::Integration::Integrate ( Storage, DeltaTime, { 0.f, 0.f, 0.f }, Level );
+        for ( int i = 0; i < NumberOfBodies; i++ )
+        {
+            const Quaternion Rotation = Storage . Rotations . Get ( i );
+            EXPECT_NEAR ( Rotation . x, std::sin ( static_cast<double> ( Angles [ i ] ) ), 5e-7 );
+            EXPECT_NEAR ( Rotation . w, std::cos ( static_cast<double> ( Angles [ i ] ) ), 5e-7 );
+        }
+    }
+}
+
+TEST ( Integration, StaticBodiesAreUntouched )
+{
+    PE::CBodyStorage Storage;
+    Storage . Add ( MakeStaticBoxBody ( { 1.f, 2.f, 3.f }, { 1.f, 1.f, 1.f } ) );
+    for ( int i = 0; i < 8; i++ )
+    {
+        Storage . Add ( MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f ) );
+    }
+    PE::Integration::Integrate ( Storage, 0.1f, { 0.f, -10.f, 0.f }, PE::ESimdLevel::AVX2 );
+
+    EXPECT_FLOAT_EQ ( Storage . Positions . Y [ 0 ], 2.f );
+    EXPECT_FLOAT_EQ ( Storage . LinearVelocities . Y [ 0 ], 0.f );
+    for ( int i = 1; i < Storage . Size (); i++ )
+    {
+        EXPECT_LT ( Storage . LinearVelocities . Y [ i ], 0.f );
+    }
+}
+
+TEST ( Narrowphase, SphereSpherePairsMatchScalar )
+{
+    // Dense random balls plus touching and coincident spheres; the pair count is not a multiple of 8
+    std::vector<PE::SPhysicsBody> Bodies = MakeBallScene ( 150, 3.f, 0.2f, 0.6f, 11 );
+    Bodies . resize ( 150 );
+    Bodies . push_back ( MakeSphereBody ( { 10.f, 0.f, 0.f }, 0.5f ) );
+    Bodies . push_back ( MakeSphereBody ( { 11.f, 0.f, 0.f }, 0.5f ) );
+    Bodies . push_back ( MakeSphereBody ( { 20.f, 0.f, 0.f }, 0.5f ) );
+    Bodies . push_back ( MakeSphereBody ( { 20.f, 0.f, 0.f }, 0.25f ) );
+    const PE::CBodyStorage Storage = MakeStorage ( Bodies );
+
+    std::vector<PE::SBroadphasePair> Pairs;
+    for ( int j = 0; j < Storage . Size (); j++ )
+    {
+        for ( int k = j + 1; k < Storage . Size (); k++ )
+        {
+            Pairs . push_back ( { j, k } );
+        }
+    }
+    ASSERT_NE ( Pairs . size () % 8, 0u );
+
+    std::vector<PE::SContact> Expected;
+    for ( const PE::SBroadphasePair & Pair : Pairs )
+    {
+        const PE::Collision::SHitResult Hit = PE::Collision::TestSphereSphere ( Bodies [ Pair . BodyA ] . Position, Bodies [ Pair . BodyA ] . Shape . Sphere . Radius,
+                                                                                Bodies [ Pair . BodyB ] . Position, Bodies [ Pair . BodyB ] . Shape . Sphere . Radius );
+        if ( Hit . IsHit )
+        {
+            Expected . push_back ( { Pair . BodyA, Pair . BodyB, Hit . ContactPoint, Hit . Normal, Hit . Penetration } );
+        }
+    }
+
+    for ( PE::ESimdLevel Level : { PE::ESimdLevel::Scalar, PE::ESimdLevel::SSE2, PE::ESimdLevel::AVX2 } )
+    {
+        if ( PE::Simd::ResolveLevel ( Level ) != Level )
+        {
+            continue;
+        }
+        SCOPED_TRACE ( PE::Simd::GetLevelName ( Level ) );
+        std::vector<PE::SContact> Contacts ( Pairs . size () );
+        const int NumberOfContacts = PE::Collision::TestSphereSpherePairs ( Storage, Pairs . data (), static_cast<int> ( Pairs . size () ), Contacts . data (), Level );
+        ASSERT_EQ ( NumberOfContacts, static_cast<int> ( Expected . size () ) );
+        for ( int i = 0; i < NumberOfContacts; i++ )
+        {
+            EXPECT_EQ ( Contacts [ i ] . BodyA, Expected [ i ] . BodyA );
+            EXPECT_EQ ( Contacts [ i ] . BodyB, Expected [ i ] . BodyB );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . Penetration, Expected [ i ] . Penetration );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . Normal . x, Expected [ i ] . Normal . x );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . Normal . y, Expected [ i ] . Normal . y );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . Normal . z, Expected [ i ] . Normal . z );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . ContactPoint . x, Expected [ i ] . ContactPoint . x );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . ContactPoint . y, Expected [ i ] . ContactPoint . y );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . ContactPoint . z, Expected [ i ] . ContactPoint . z );
+        }
+    }
+}
+
+TEST ( Narrowphase, GenerateContactsMatchesTestCollision )
+{
+    const std::vector<PE::SPhysicsBody> Bodies = MakeBallScene ( 300, 4.f, 0.3f, 0.8f, 5 );
+    const PE::CBodyStorage Storage = MakeStorage ( Bodies );
+    PE::CSpatialHashGrid Grid ( 1.6f, 0.f );
+    Grid . Update ( Storage );
+    std::vector<PE::SBroadphasePair> Pairs;
+    Grid . FindPairs ( Pairs );
+
+    PE::CNarrowphase Narrowphase;
+    std::vector<PE::SContact> Contacts;
+    Narrowphase . GenerateContacts ( Storage, Pairs, Contacts );
+
+    std::set<std::pair<int, int>> ContactPairs;
+    for ( size_t i = 0; i < Contacts . size (); i++ )
+    {
+        ContactPairs . insert ( { Contacts [ i ] . BodyA, Contacts [ i ] . BodyB } );
+        if ( i > 0 )
+        {
+            EXPECT_TRUE ( Contacts [ i - 1 ] . BodyA < Contacts [ i ] . BodyA ||
+                          ( Contacts [ i - 1 ] . BodyA == Contacts [ i ] . BodyA && Contacts [ i - 1 ] . BodyB < Contacts [ i ] . BodyB ) );
+        }
+    }
+    EXPECT_EQ ( ContactPairs . size (), Contacts . size () );
+    EXPECT_EQ ( ContactPairs, BruteForceHits ( Bodies ) );
+}
+
+TEST ( Narrowphase, ContactMarginReportsNearbyPairs )
+{
+    const std::vector<PE::SPhysicsBody> Bodies = {
+        MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f ),
+        MakeSphereBody ( { 1.01f, 0.f, 0.f }, 0.5f ),
+        MakeStaticBoxBody ( { 0.f, -0.51f, 0.f }, { 2.f, 0.f, 2.f } ),
+    };
+    const PE::CBodyStorage Storage = MakeStorage ( Bodies );
+    const std::vector<PE::SBroadphasePair> Pairs = { { 0, 1 }, { 0, 2 } };
+
+    PE::CNarrowphase Narrowphase;
+    std::vector<PE::SContact> Contacts;
+    Narrowphase . GenerateContacts ( Storage, Pairs, Contacts );
+    EXPECT_TRUE ( Contacts . empty () );
+
+    Narrowphase . SetContactMargin ( 0.02f );
+    Narrowphase . GenerateContacts ( Storage, Pairs, Contacts );
+    ASSERT_EQ ( Contacts . size (), 2u );
+    EXPECT_NEAR ( Contacts [ 0 ] . Penetration, -0.01f, 1e-5f );
+    EXPECT_NEAR ( Contacts [ 1 ] . Penetration, -0.01f, 1e-5f );
+    EXPECT_NEAR ( Contacts [ 1 ] . Normal . y, 1.f, 1e-6f );
+}
+
+TEST ( Narrowphase, SphereBoxContactsPutTheSphereFirst )
+{
+    // The box comes first by index, the contact still has the sphere as A and the normal out of the box
+    const std::vector<PE::SPhysicsBody> Bodies = {
+        MakeStaticBoxBody ( { 0.f, 0.f, 0.f }, { 2.f, 0.5f, 2.f } ),
+        MakeSphereBody ( { 0.f, 0.9f, 0.f }, 0.5f ),
+        MakeSphereBody ( { 0.f, 1.8f, 0.f }, 0.5f ),
+        MakeSphereBody ( { 1.f, 0.9f, 0.f }, 0.5f ),
+    };
+    const PE::CBodyStorage Storage = MakeStorage ( Bodies );
+    const std::vector<PE::SBroadphasePair> Pairs = { { 0, 1 }, { 0, 3 }, { 1, 2 }, { 1, 3 } };
+
+    PE::CNarrowphase Narrowphase;
+    std::vector<PE::SContact> Contacts;
+    Narrowphase . GenerateContacts ( Storage, Pairs, Contacts );
+    ASSERT_EQ ( Contacts . size (), 4u );
+    for ( size_t i = 0; i < Pairs . size (); i++ )
+    {
+        EXPECT_EQ ( std::minmax ( Contacts [ i ] . BodyA, Contacts [ i ] . BodyB ), std::minmax ( Pairs [ i ] . BodyA, Pairs [ i ] . BodyB ) );
+        const PE::Collision::SHitResult Hit = PE::Collision::TestCollision ( Bodies [ Contacts [ i ] . BodyA ], Bodies [ Contacts [ i ] . BodyB ] );
+        EXPECT_FLOAT_EQ ( Contacts [ i ] . Normal . x, Hit . Normal . x );
+        EXPECT_FLOAT_EQ ( Contacts [ i ] . Normal . y, Hit . Normal . y );
+        EXPECT_FLOAT_EQ ( Contacts [ i ] . Penetration, Hit . Penetration );
+    }
+    EXPECT_EQ ( Contacts [ 0 ] . BodyA, 1 );
+    EXPECT_EQ ( Contacts [ 0 ] . BodyB, 0 );
+    EXPECT_FLOAT_EQ ( Contacts [ 0 ] . Normal . y, 1.f );
+    EXPECT_EQ ( Contacts [ 1 ] . BodyA, 3 );
+    EXPECT_EQ ( Contacts [ 2 ] . BodyA, 1 );
+}
+
+TEST ( Narrowphase, SpheresInsideBoxMatchWallBoxes )
+{
+    // Balls crowding a small box touch its walls, the wall contacts must equal the sphere-box test against the flat wall boxes
+    constexpr int NumberOfBalls = 301;
+    std::vector<PE::SPhysicsBody> Bodies = MakeBallScene ( NumberOfBalls, 3.f, 0.2f, 0.6f, 7 );
+    // A sleeping ball on the floor gets no contact, a ball that tunneled through the floor is pushed back up
+    Bodies . insert ( Bodies . begin () + NumberOfBalls, MakeSphereBody ( { 0.f, -2.9f, 0.f }, 0.3f ) );
+    Bodies . insert ( Bodies . begin () + NumberOfBalls + 1, MakeSphereBody ( { 1.f, -3.2f, 1.f }, 0.3f ) );
+    PE::CBodyStorage Storage = MakeStorage ( Bodies );
+    Storage . Flags [ NumberOfBalls ] |= static_cast<uint8_t> ( PE::EBodyFlags::Sleeping );
+    const int FirstWall = NumberOfBalls + 2;
+    const std::array<int, 6> Walls { FirstWall, FirstWall + 1, FirstWall + 2, FirstWall + 3, FirstWall + 4, FirstWall + 5 };
+    const BoundingBox Box { { -3.f, -3.f, -3.f }, { 3.f, 3.f, 3.f } };
+
+    std::vector<PE::SContact> Expected;
+    for ( int Ball = 0; Ball < NumberOfBalls; Ball++ )
+    {
+        for ( const int Wall : Walls )
+        {
+            const PE::Collision::SHitResult Hit = PE::Collision::TestCollision ( Bodies [ Ball ] . Shape, Bodies [ Ball ] . Position, Bodies [ Wall ] . Shape, Bodies [ Wall ] . Position );
+            if ( Hit . IsHit )
+            {
+                Expected . push_back ( { Ball, Wall, Hit . ContactPoint, Hit . Normal, Hit . Penetration } );
+            }
+        }
+    }
+    ASSERT_GT ( Expected . size (), 20u );
+
+    for ( PE::ESimdLevel Level : { PE::ESimdLevel::Scalar, PE::ESimdLevel::SSE2, PE::ESimdLevel::AVX2 } )
+    {
+        if ( PE::Simd::ResolveLevel ( Level ) != Level )
+        {
+            continue;
+        }
+        SCOPED_TRACE ( PE::Simd::GetLevelName ( Level ) );
+        std::vector<PE::SContact> Contacts;
+        const int NumberOfContacts = PE::Collision::TestSpheresInsideBox ( Storage, 0, Storage . Size (), Box, Walls, Contacts, Level );
+        ASSERT_EQ ( NumberOfContacts, static_cast<int> ( Expected . size () ) + 1 );
+        for ( size_t i = 0; i < Expected . size (); i++ )
+        {
+            EXPECT_EQ ( Contacts [ i ] . BodyA, Expected [ i ] . BodyA );
+            EXPECT_EQ ( Contacts [ i ] . BodyB, Expected [ i ] . BodyB );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . Penetration, Expected [ i ] . Penetration );
+            EXPECT_NEAR ( Contacts [ i ] . Normal . x, Expected [ i ] . Normal . x, 1e-6f );
+            EXPECT_NEAR ( Contacts [ i ] . Normal . y, Expected [ i ] . Normal . y, 1e-6f );
+            EXPECT_NEAR ( Contacts [ i ] . Normal . z, Expected [ i ] . Normal . z, 1e-6f );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . ContactPoint . x, Expected [ i ] . ContactPoint . x );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . ContactPoint . y, Expected [ i ] . ContactPoint . y );
+            EXPECT_FLOAT_EQ ( Contacts [ i ] . ContactPoint . z, Expected [ i ] . ContactPoint . z );
+        }
+        const PE::SContact & Tunneled = Contacts . back ();
+        EXPECT_EQ ( Tunneled . BodyA, NumberOfBalls + 1 );
+        EXPECT_EQ ( Tunneled . BodyB, Walls [ 2 ] );
+        EXPECT_EQ ( Tunneled . Normal . y, 1.f );
+        EXPECT_FLOAT_EQ ( Tunneled . Penetration, 0.5f );
+    }
+}
+
+TEST ( PhysicsWorld, WallsStayOutOfTheBroadphase )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 200;
+    for ( const PE::EBroadphaseType Type : { PE::EBroadphaseType::SpatialHashGrid, PE::EBroadphaseType::DynamicAABBTree } )
+    {
+        Parameters . BroadphaseType = Type;
+        PE::CPhysicsWorld World ( Parameters );
+        World . Restart ();
+        int NumberOfWallContacts = 0;
+        for ( int Step = 0; Step < 240; Step++ )
+        {
+            World . Step ( World . GetFixedDeltaTime () );
+            for ( const PE::SContact & Contact : World . GetContacts () )
+            {
+                NumberOfWallContacts += World . GetBodies () . IsWorldBoundary ( Contact . BodyB ) ? 1 : 0;
+            }
+        }
+        // The balls land on the floor through the boundary stage, the broadphase never reports a wall
+        EXPECT_GT ( NumberOfWallContacts, 0 );
+        const PE::CBodyStorage & Bodies = World . GetBodies ();
+        std::unique_ptr<PE::CBroadphase> Broadphase = PE::CreateBroadphase ( Parameters );
+        Broadphase -> Update ( Bodies );
+        std::vector<PE::SBroadphasePair> Pairs;
+        Broadphase -> FindPairs ( Pairs );
+        for ( const PE::SBroadphasePair & Pair : Pairs )
+        {
+            EXPECT_FALSE ( Bodies . IsWorldBoundary ( Pair . BodyA ) || Bodies . IsWorldBoundary ( Pair . BodyB ) );
+        }
+        for ( int i = 0; i < World . GetNumberOfBalls (); i++ )
+        {
+            EXPECT_GE ( Bodies . Positions . Y [ i ] - Bodies . Radii [ i ], Parameters . WorldBoxMin . y - 0.05f );
+        }
+    }
+}
+
+TEST ( PhysicsWorld, RunsHeadlessInsideWorldBox )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 50;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    ASSERT_EQ ( World . GetNumberOfBalls (), 50 );
+    ASSERT_EQ ( World . GetBodies () . Size (), 56 );
+
+    // Two seconds of real time at the default tickrate
+    int NumberOfSteps = 0;
+    for ( int Frame = 0; Frame < 120; Frame++ )
+    {
+        NumberOfSteps += World . Update ( 1.f / 60.f );
+    }
+    EXPECT_NEAR ( NumberOfSteps, 240, 1 );
+    EXPECT_EQ ( World . GetNumberOfOverruns (), 0 );
+
+    const PE::CBodyStorage & Bodies = World . GetBodies ();
+    const BoundingBox & WorldBox = World . GetWorldBox ();
+    for ( int i = 0; i < Bodies . Size (); i++ )
+    {
+        const Vector3 Position = Bodies . Positions . Get ( i );
+        EXPECT_GE ( Position . y, WorldBox . min . y - 0.01f );
+        EXPECT_LE ( Position . y, WorldBox . max . y + 0.01f );
+        EXPECT_GE ( Position . x, WorldBox . min . x - 0.01f );
+        EXPECT_LE ( Position . x, WorldBox . max . x + 0.01f );
+    }
+}
+
+TEST ( PhysicsWorld, RemovingAWallKeepsTheOthers )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 100;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    // Restart adds the walls after the balls, -X, +X, -Y, +Y, -Z, +Z
+    const int Floor = World . GetBodies () . GetHandle ( Parameters . NumberOfBalls + 2 );
+    ASSERT_TRUE ( World . RemoveBody ( Floor ) );
+    EXPECT_EQ ( World . GetNumberOfBalls (), 100 );
+    ASSERT_TRUE ( World . RemoveBody ( World . GetBodies () . GetHandle ( 0 ) ) );
+    EXPECT_EQ ( World . GetNumberOfBalls (), 99 );
+    const int Ball = World . AddBody ( MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f ) );
+    EXPECT_EQ ( World . GetNumberOfBalls (), 100 );
+
+    for ( int Step = 0; Step < 240; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+    }
+    // Everything falls out through the floor, the side walls still hold the balls in
+    const PE::CBodyStorage & Bodies = World . GetBodies ();
+    const BoundingBox & WorldBox = World . GetWorldBox ();
+    EXPECT_LT ( Bodies . Positions . Y [ Bodies . GetIndex ( Ball ) ], WorldBox . min . y );
+    for ( int i = 0; i < Bodies . Size (); i++ )
+    {
+        if ( Bodies . IsStatic ( i ) )
+        {
+            continue;
+        }
+        EXPECT_LT ( Bodies . Positions . Y [ i ], WorldBox . min . y );
+        EXPECT_GE ( Bodies . Positions . X [ i ] - Bodies . Radii [ i ], WorldBox . min . x - 0.05f );
+        EXPECT_LE ( Bodies . Positions . X [ i ] + Bodies . Radii [ i ], WorldBox . max . x + 0.05f );
+        EXPECT_GE ( Bodies . Positions . Z [ i ] - Bodies . Radii [ i ], WorldBox . min . z - 0.05f );
+        EXPECT_LE ( Bodies . Positions . Z [ i ] + Bodies . Radii [ i ], WorldBox . max . z + 0.05f );
+    }
+}
+
+TEST ( PhysicsWorld, SpawnsAndDespawnsBodiesBetweenSteps )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 100;
+    for ( const PE::EBroadphaseType Type : { PE::EBroadphaseType::SpatialHashGrid, PE::EBroadphaseType::DynamicAABBTree } )
+    {
+        Parameters . BroadphaseType = Type;
+        PE::CPhysicsWorld World ( Parameters );
+        World . Restart ();
+        const int FirstBall = World . GetBodies () . GetHandle ( 0 );
+        std::vector<int> Projectiles;
+        std::vector<int> Despawned;
+        for ( int Step = 0; Step < 240; Step++ )
+        {
+            // Fire a few projectiles every step, each lives for 30 steps
+            for ( int i = 0; i < 4; i++ )
+            {
+                PE::SPhysicsBody Projectile = MakeSphereBody ( { -6.f + static_cast<float> ( i ), 6.f, 0.f }, 0.15f );
+                Projectile . LinearVelocity = { 20.f, -5.f, static_cast<float> ( i ) };
+                Projectiles . push_back ( World . AddBody ( Projectile ) );
+            }
+            while ( Projectiles . size () > 120 )
+            {
+                ASSERT_TRUE ( World . RemoveBody ( Projectiles . front () ) );
+                Despawned . push_back ( Projectiles . front () );
+                Projectiles . erase ( Projectiles . begin () );
+            }
+            World . Step ( World . GetFixedDeltaTime () );
+        }
+        const PE::CBodyStorage & Bodies = World . GetBodies ();
+        EXPECT_EQ ( Bodies . Size (), 100 + 6 + 120 );
+        EXPECT_LE ( Bodies . GetNumberOfHandleSlots (), 100 + 6 + 124 );
+        EXPECT_EQ ( World . GetNumberOfAwakeBodies (), std::count_if ( Bodies . Flags . begin (), Bodies . Flags . end (), [] ( uint8_t Flags ) { return ( Flags & PE::CBodyStorage::GPassiveFlags ) == 0; } ) );
+        for ( const int Handle : Despawned )
+        {
+            ASSERT_EQ ( Bodies . GetIndex ( Handle ), -1 );
+        }
+        EXPECT_GE ( Bodies . GetIndex ( FirstBall ), 0 );
+        const BoundingBox & WorldBox = World . GetWorldBox ();
+        for ( int i = 0; i < Bodies . Size (); i++ )
+        {
+            ASSERT_EQ ( Bodies . GetIndex ( Bodies . GetHandle ( i ) ), i );
+            EXPECT_GE ( Bodies . Positions . Y [ i ], WorldBox . min . y - 0.05f );
+            EXPECT_LE ( Bodies . Positions . X [ i ], WorldBox . max . x + 0.05f );
+        }
+    }
+}
+
+TEST ( PhysicsWorld, IsDeterministic )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 40;
+    PE::CPhysicsWorld WorldA ( Parameters );
+    PE::CPhysicsWorld WorldB ( Parameters );
+    WorldA . Restart ();
+    WorldB . Restart ();
+    for ( int Step = 0; Step < 200; Step++ )
+    {
+        WorldA . Step ( WorldA . GetFixedDeltaTime () );
+        WorldB . Step ( WorldB . GetFixedDeltaTime () );
+    }
+    for ( int i = 0; i < WorldA . GetBodies () . Size (); i++ )
+    {
+        EXPECT_EQ ( WorldA . GetBodies () . Positions . X [ i ], WorldB . GetBodies () . Positions . X [ i ] );
+        EXPECT_EQ ( WorldA . GetBodies () . Positions . Y [ i ], WorldB . GetBodies () . Positions . Y [ i ] );
+    }
+}
+
+TEST ( Spawn, PhiloxMatchesReferenceVectors )
+{
+    // Known answers of Philox4x32-10 from the Random123 distribution
+    const PE::CPhilox4x32::SBlock Zero = PE::CPhilox4x32 ( 0 ) ( PE::CPhilox4x32::SBlock { 0u, 0u, 0u, 0u } );
+    EXPECT_EQ ( Zero, ( PE::CPhilox4x32::SBlock { 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u } ) );
+    const PE::CPhilox4x32::SBlock Ones = PE::CPhilox4x32 ( ~0ull ) ( PE::CPhilox4x32::SBlock { ~0u, ~0u, ~0u, ~0u } );
+    EXPECT_EQ ( Ones, ( PE::CPhilox4x32::SBlock { 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu } ) );
+    const PE::CPhilox4x32::SBlock Pi = PE::CPhilox4x32 ( 0x299f31d0a4093822ull ) ( PE::CPhilox4x32::SBlock { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u } );
+    EXPECT_EQ ( Pi, ( PE::CPhilox4x32::SBlock { 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u } ) );
+}
+
+TEST ( Spawn, BallsDoNotDependOnThreadsOrSplit )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfThreads = 1;
+    PE::CPhysicsWorld Single ( Parameters );
+    Single . SpawnBalls ( 3 * PE::Spawn::GBallsPerTask + 17, Parameters . BallGenerationParameters );
+    Parameters . NumberOfThreads = 4;
+    PE::CPhysicsWorld Split ( Parameters );
+    Split . SpawnBalls ( 100, Parameters . BallGenerationParameters );
+    EXPECT_EQ ( Split . SpawnBalls ( 3 * PE::Spawn::GBallsPerTask - 83, Parameters . BallGenerationParameters ), 100 );
+    const PE::CBodyStorage & A = Single . GetBodies ();
+    const PE::CBodyStorage & B = Split . GetBodies ();
+    ASSERT_EQ ( A . Size (), B . Size () );
+    EXPECT_EQ ( Single . GetNumberOfBalls (), A . Size () );
+    EXPECT_EQ ( Split . GetNumberOfAwakeBodies (), B . Size () );
+    // Bit-identical, not just close
+    EXPECT_EQ ( A . Positions . X, B . Positions . X );
+    EXPECT_EQ ( A . Positions . Y, B . Positions . Y );
+    EXPECT_EQ ( A . Positions . Z, B . Positions . Z );
+    EXPECT_EQ ( A . LinearVelocities . X, B . LinearVelocities . X );
+    EXPECT_EQ ( A . AngularVelocities . Z, B . AngularVelocities . Z );
+    EXPECT_EQ ( A . Radii, B . Radii );
+    const PE::SBallGenerationParameters & Generation = Parameters . BallGenerationParameters;
+    for ( int i = 0; i < A . Size (); i++ )
+    {
+        ASSERT_EQ ( B . GetIndex ( B . GetHandle ( i ) ), i );
+        EXPECT_GE ( A . Radii [ i ], Generation . MinRadius );
+        EXPECT_LE ( A . Radii [ i ], Generation . MaxRadius );
+        EXPECT_GE ( A . Positions . X [ i ], Generation . MinLocation . x );
+        EXPECT_LE ( A . Positions . X [ i ], Generation . MaxLocation . x );
+        EXPECT_NEAR ( A . Masses [ i ], A . Radii [ i ] * Generation . MassToRadius, 1e-5f );
+    }
+    // Balls go on with the sequence instead of repeating the first ones, a new seed starts another
+    EXPECT_NE ( A . Positions . X [ 0 ], A . Positions . X [ 100 ] );
+    Parameters . RandomSeed++;
+    PE::CPhysicsWorld Reseeded ( Parameters );
+    Reseeded . SpawnBalls ( 1, Generation );
+    EXPECT_NE ( Reseeded . GetBodies () . Positions . X [ 0 ], A . Positions . X [ 0 ] );
+}
+
+TEST ( Spawn, LatticeAndPileDoNotOverlap )
+{
+    for ( const PE::ESpawnPattern Pattern : { PE::ESpawnPattern::Lattice, PE::ESpawnPattern::Pile } )
+    {
+        PE::SSimulationParameters Parameters;
+        Parameters . BallGenerationParameters . Pattern = Pattern;
+        Parameters . BallGenerationParameters . MinLocation = { -4.f, -9.f, -3.f };
+        Parameters . BallGenerationParameters . MaxLocation = { 4.f, -9.f, 3.f };
+        const PE::SBallGenerationParameters & Generation = Parameters . BallGenerationParameters;
+        PE::CPhysicsWorld World ( Parameters );
+        World . SpawnBalls ( 400, Generation );
+        const PE::CBodyStorage & Bodies = World . GetBodies ();
+        for ( int i = 0; i < Bodies . Size (); i++ )
+        {
+            const Vector3 Position = Bodies . Positions . Get ( i );
+            EXPECT_GE ( Position . x, Generation . MinLocation . x );
+            EXPECT_LE ( Position . x, Generation . MaxLocation . x );
+            EXPECT_GE ( Position . z, Generation . MinLocation . z );
+            EXPECT_LE ( Position . z, Generation . MaxLocation . z );
+            EXPECT_GE ( Position . y, Generation . MinLocation . y );
+            if ( Pattern == PE::ESpawnPattern::Pile )
+            {
+                ASSERT_EQ ( Vector3LengthSqr ( Bodies . LinearVelocities . Get ( i ) ), 0.f );
+                ASSERT_EQ ( Vector3LengthSqr ( Bodies . AngularVelocities . Get ( i ) ), 0.f );
+            }
+            for ( int j = i + 1; j < Bodies . Size (); j++ )
+            {
+                const float Distance = Vector3Distance ( Position, Bodies . Positions . Get ( j ) );
+                ASSERT_GE ( Distance, Bodies . Radii [ i ] + Bodies . Radii [ j ] - 1e-4f ) << i << " " << j;
+            }
+        }
+    }
+}
+
+TEST ( Spawn, PatternsGoOnAcrossSpawnCalls )
+{
+    // Ten and ten balls fill the same places as twenty at once instead of starting the pattern over
+    for ( const PE::ESpawnPattern Pattern : { PE::ESpawnPattern::Lattice, PE::ESpawnPattern::Pile } )
+    {
+        PE::SSimulationParameters Parameters;
+        Parameters . BallGenerationParameters . Pattern = Pattern;
+        PE::CPhysicsWorld Single ( Parameters );
+        Single . SpawnBalls ( 20, Parameters . BallGenerationParameters );
+        PE::CPhysicsWorld Split ( Parameters );
+        Split . SpawnBalls ( 10, Parameters . BallGenerationParameters );
+        Split . SpawnBalls ( 10, Parameters . BallGenerationParameters );
+        EXPECT_EQ ( Single . GetBodies () . Positions . X, Split . GetBodies () . Positions . X );
+        EXPECT_EQ ( Single . GetBodies () . Positions . Y, Split . GetBodies () . Positions . Y );
+        EXPECT_EQ ( Single . GetBodies () . Positions . Z, Split . GetBodies () . Positions . Z );
+        EXPECT_FALSE ( Vector3Equals ( Split . GetBodies () . Positions . Get ( 0 ), Split . GetBodies () . Positions . Get ( 10 ) ) );
+    }
+}
+
+TEST ( SceneQuery, RayCastsMatchBruteForce )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 400;
+    Parameters . BallGenerationParameters . MinLocation = { -6.f, -6.f, -6.f };
+    Parameters . BallGenerationParameters . MaxLocation = { 6.f, 6.f, 6.f };
+    Parameters . BallGenerationParameters . MinRadius = 0.1f;
+    Parameters . BallGenerationParameters . MaxRadius = 0.6f;
+    for ( const PE::EBroadphaseType Type : { PE::EBroadphaseType::SpatialHashGrid, PE::EBroadphaseType::DynamicAABBTree } )
+    {
+        Parameters . BroadphaseType = Type;
+        PE::CPhysicsWorld World ( Parameters );
+        World . Restart ();
+        for ( int Step = 0; Step < 10; Step++ )
+        {
+            World . Step ( World . GetFixedDeltaTime () );
+        }
+        const PE::CBodyStorage & Bodies = std::as_const ( World ) . GetBodies ();
+        const PE::CSceneQuery Query = World . GetSceneQuery ();
+
+        std::mt19937 Generator ( 11 );
+        std::uniform_real_distribution<float> UValue ( -7.f, 7.f );
+        std::vector<PE::SRay> Rays ( 500 );
+        for ( PE::SRay & Ray : Rays )
+        {
+            Ray . Origin = { UValue ( Generator ), UValue ( Generator ), UValue ( Generator ) };
+            Ray . Direction = { UValue ( Generator ), UValue ( Generator ), UValue ( Generator ) };
+            Ray . MaxDistance = 2.f + std::fabs ( UValue ( Generator ) );
+        }
+        std::vector<PE::SRayHit> BatchHits ( Rays . size () );
+        Query . RayCast ( Rays, BatchHits, World . GetJobSystem () );
+        std::array<PE::SRayHit, 512> AllHits;
+        int NumberOfHitRays = 0;
+        for ( size_t r = 0; r < Rays . size (); r++ )
+        {
+            const PE::SRay & Ray = Rays [ r ];
+            const Vector3 Direction = Vector3Normalize ( Ray . Direction );
+            int ExpectedHits = 0;
+            float Closest = Ray . MaxDistance;
+            int ClosestHandle = -1;
+            for ( int i = 0; i < Bodies . Size (); i++ )
+            {
+                const PE::Collision::SRayResult Result = PE::Collision::RayCast ( Ray . Origin, Direction, Ray . MaxDistance, Bodies . Shapes [ i ], Bodies . Positions . Get ( i ) );
+                if ( Result . IsHit )
+                {
+                    ExpectedHits++;
+                    if ( Result . Distance < Closest || ClosestHandle < 0 )
+                    {
+                        Closest = Result . Distance;
+                        ClosestHandle = Bodies . GetHandle ( i );
+                    }
+                }
+            }
+            PE::SRayHit Hit;
+            ASSERT_EQ ( Query . RayCast ( Ray, Hit ), ClosestHandle >= 0 ) << r;
+            EXPECT_EQ ( BatchHits [ r ] . Handle, Hit . Handle );
+            const int NumberOfHits = Query . RayCastAll ( Ray, AllHits );
+            ASSERT_EQ ( NumberOfHits, ExpectedHits ) << r;
+            if ( ClosestHandle < 0 )
+            {
+                continue;
+            }
+            NumberOfHitRays++;
+            EXPECT_FLOAT_EQ ( Hit . Distance, Closest );
+            EXPECT_FLOAT_EQ ( AllHits [ 0 ] . Distance, Closest );
+            for ( int i = 1; i < NumberOfHits; i++ )
+            {
+                EXPECT_LE ( AllHits [ i - 1 ] . Distance, AllHits [ i ] . Distance );
+            }
+            // A buffer of one keeps the nearest
+            PE::SRayHit Nearest [ 1 ];
+            EXPECT_EQ ( Query . RayCastAll ( Ray, Nearest ), 1 );
+            EXPECT_FLOAT_EQ ( Nearest [ 0 ] . Distance, Closest );
+        }
+        // Most rays end in a ball or a wall
+        EXPECT_GT ( NumberOfHitRays, 250 );
+    }
+}
+
+TEST ( SceneQuery, OverlapsMatchBruteForce )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 400;
+    Parameters . BallGenerationParameters . MinLocation = { -6.f, -6.f, -6.f };
+    Parameters . BallGenerationParameters . MaxLocation = { 6.f, 6.f, 6.f };
+    for ( const PE::EBroadphaseType Type : { PE::EBroadphaseType::SpatialHashGrid, PE::EBroadphaseType::DynamicAABBTree } )
+    {
+        Parameters . BroadphaseType = Type;
+        PE::CPhysicsWorld World ( Parameters );
+        World . Restart ();
+        World . Step ( World . GetFixedDeltaTime () );
+        const PE::CBodyStorage & Bodies = std::as_const ( World ) . GetBodies ();
+        const PE::CSceneQuery Query = World . GetSceneQuery ();
+        std::mt19937 Generator ( 5 );
+        std::uniform_real_distribution<float> UValue ( -8.f, 8.f );
+        std::array<int, 512> Handles;
+        for ( int Sample = 0; Sample < 100; Sample++ )
+        {
+            const Vector3 Center { UValue ( Generator ), UValue ( Generator ), UValue ( Generator ) };
+            const float Radius = 0.25f * std::fabs ( UValue ( Generator ) );
+            const BoundingBox Box { Center, Vector3Add ( Center, { Radius, 2.f * Radius, 0.5f * Radius } ) };
+            PE::SPhysicsBody Probe = MakeSphereBody ( Center, Radius );
+            std::set<int> ExpectedSphere;
+            std::set<int> ExpectedBox;
+            for ( int i = 0; i < Bodies . Size (); i++ )
+            {
+                const PE::SPhysicsBody Body = Bodies . GetBody ( i );
+                if ( PE::Collision::TestCollision ( Probe, Body ) . IsHit || PE::Collision::TestCollision ( Body, Probe ) . IsHit )
+                {
+                    ExpectedSphere . insert ( Bodies . GetHandle ( i ) );
+                }
+                const bool OverlapsBox = Body . Shape . Type == EShapeType::Sphere
+                    ? Vector3Distance ( Body . Position, PE::Math::ClosestPointOnBox ( Body . Position, Box ) ) <= Body . Shape . Sphere . Radius
+                    : PE::Math::BoxesOverlap ( PE::Collision::GetBoundingBox ( Body ), Box );
+                if ( OverlapsBox )
+                {
+                    ExpectedBox . insert ( Bodies . GetHandle ( i ) );
+                }
+            }
+            const int NumberInSphere = Query . OverlapSphere ( Center, Radius, Handles );
+            ASSERT_EQ ( NumberInSphere, static_cast<int> ( ExpectedSphere . size () ) ) << Sample;
+            EXPECT_EQ ( std::set<int> ( Handles . begin (), Handles . begin () + NumberInSphere ), ExpectedSphere );
+            const int NumberInBox = Query . OverlapBox ( Box, Handles );
+            ASSERT_EQ ( NumberInBox, static_cast<int> ( ExpectedBox . size () ) ) << Sample;
+            EXPECT_EQ ( std::set<int> ( Handles . begin (), Handles . begin () + NumberInBox ), ExpectedBox );
+        }
+        // A full buffer still counts every body
+        int Few [ 4 ];
+        EXPECT_EQ ( Query . OverlapBox ( World . GetWorldBox (), Few ), Bodies . Size () );
+    }
+}
+
+TEST ( SceneQuery, SeesBodiesChangedBetweenSteps )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 0;
+    Parameters . BroadphaseType = PE::EBroadphaseType::DynamicAABBTree;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    World . Step ( World . GetFixedDeltaTime () );
+    const PE::SRay Ray { .Origin = { -6.f, 0.f, 0.f }, .Direction = { 1.f, 0.f, 0.f } };
+    PE::SRayHit Hit;
+    // Only the wall ahead
+    ASSERT_TRUE ( World . GetSceneQuery () . RayCast ( Ray, Hit ) );
+    EXPECT_FLOAT_EQ ( Hit . Point . x, World . GetWorldBox () . max . x );
+
+    const int Handle = World . AddBody ( MakeSphereBody ( { 0.f, 0.f, 0.f }, 1.f ) );
+    ASSERT_TRUE ( World . GetSceneQuery () . RayCast ( Ray, Hit ) );
+    EXPECT_EQ ( Hit . Handle, Handle );
+    EXPECT_FLOAT_EQ ( Hit . Distance, 5.f );
+
+    PE::CBodyStorage & Bodies = World . GetBodies ();
+    Bodies . Positions . Set ( Bodies . GetIndex ( Handle ), { 3.f, 0.f, 0.f } );
+    ASSERT_TRUE ( World . GetSceneQuery () . RayCast ( Ray, Hit ) );
+    EXPECT_FLOAT_EQ ( Hit . Distance, 8.f );
+
+    ASSERT_TRUE ( World . RemoveBody ( Handle ) );
+    ASSERT_TRUE ( World . GetSceneQuery () . RayCast ( Ray, Hit ) );
+    EXPECT_NE ( Hit . Handle, Handle );
+    int Handles [ 8 ];
+    EXPECT_EQ ( World . GetSceneQuery () . OverlapSphere ( { 3.f, 0.f, 0.f }, 1.f, Handles ), 0 );
+}
+
+TEST ( ContinuousCollision, FastSphereDoesNotTunnelAtLowFrequency )
+{
+    // At 30 Hz the fast sphere moves 3.3 per step, over ten times its size and the plate's thickness
+    PE::SSimulationParameters Parameters;
+    Parameters . SimulationFrequency = 30;
+    Parameters . Gravity = 0.f;
+    Parameters . AllowSleeping = false;
+    for ( const bool IsContinuous : { false, true } )
+    {
+        Parameters . ContinuousCollision = IsContinuous;
+        PE::CPhysicsWorld World ( Parameters );
+        PE::SPhysicsBody PlateBullet = MakeSphereBody ( { -5.f, 0.f, 0.f }, 0.2f );
+        PlateBullet . LinearVelocity = { 100.f, 0.f, 0.f };
+        PE::SPhysicsBody BallBullet = MakeSphereBody ( { -5.f, 0.f, 5.f }, 0.2f );
+        BallBullet . LinearVelocity = { 100.f, 0.f, 0.f };
+        const int PlateBulletHandle = World . AddBody ( PlateBullet );
+        const int BallBulletHandle = World . AddBody ( BallBullet );
+        World . AddBody ( MakeStaticBoxBody ( { 0.f, 0.f, 0.f }, { 0.05f, 1.f, 1.f } ) );
+        const int TargetHandle = World . AddBody ( MakeSphereBody ( { 0.f, 0.f, 5.f }, 0.1f ) );
+        int NumberOfClampedBodies = 0;
+        for ( int Step = 0; Step < 10; Step++ )
+        {
+            World . Step ( World . GetFixedDeltaTime () );
+            NumberOfClampedBodies += World . GetNumberOfClampedBodies ();
+        }
+        const PE::CBodyStorage & Bodies = World . GetBodies ();
+        const float PlateBulletX = Bodies . Positions . X [ Bodies . GetIndex ( PlateBulletHandle ) ];
+        const float TargetX = Bodies . Positions . X [ Bodies . GetIndex ( TargetHandle ) ];
+        if ( IsContinuous )
+        {
+            EXPECT_GE ( NumberOfClampedBodies, 2 );
+            EXPECT_LT ( PlateBulletX, 0.f );
+            EXPECT_GT ( TargetX, 1.f ); // Struck and sent flying
+            EXPECT_LT ( Bodies . LinearVelocities . X [ Bodies . GetIndex ( BallBulletHandle ) ], 100.f );
+        }
+        else
+        {
+            EXPECT_EQ ( NumberOfClampedBodies, 0 );
+            EXPECT_GT ( PlateBulletX, 0.f );
+            EXPECT_EQ ( TargetX, 0.f );
+        }
+    }
+}
+
+TEST ( ContinuousCollision, FastSphereStaysInsideWorldBox )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . SimulationFrequency = 30;
+    Parameters . NumberOfBalls = 0;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    PE::SPhysicsBody Bullet = MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.25f );
+    Bullet . LinearVelocity = { 150.f, -90.f, 60.f };
+    const int Handle = World . AddBody ( Bullet );
+    const BoundingBox & WorldBox = World . GetWorldBox ();
+    for ( int Step = 0; Step < 60; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        const Vector3 Position = World . GetBodies () . Positions . Get ( World . GetBodies () . GetIndex ( Handle ) );
+        ASSERT_GE ( Position . x, WorldBox . min . x + 0.25f - 1e-3f ) << "step " << Step;
+        ASSERT_LE ( Position . x, WorldBox . max . x - 0.25f + 1e-3f ) << "step " << Step;
+        ASSERT_GE ( Position . y, WorldBox . min . y + 0.25f - 1e-3f ) << "step " << Step;
+        ASSERT_LE ( Position . y, WorldBox . max . y - 0.25f + 1e-3f ) << "step " << Step;
+        ASSERT_GE ( Position . z, WorldBox . min . z + 0.25f - 1e-3f ) << "step " << Step;
+        ASSERT_LE ( Position . z, WorldBox . max . z - 0.25f + 1e-3f ) << "step " << Step;
+    }
+}
+
+TEST ( ContinuousCollision, SphereLeavingABoxCornerIsNotClamped )
+{
+    // Inside the box grown by the radius, but clear of its rounded corner and moving away
+    const BoundingBox Box { .min = { -1.f, -1.f, -1.f }, .max = { 1.f, 1.f, 1.f } };
+    EXPECT_FALSE ( PE::Collision::SweepSphereBox ( { 1.4f, 1.4f, 0.f }, { 1.f, 0.f, 0.f }, 0.5f, Box ) . IsHit );
+    // Toward the corner the impact is where the sphere reaches the corner edge, not where it enters the grown box
+    const PE::Collision::SSweepResult Corner = PE::Collision::SweepSphereBox ( { 3.f, 3.f, 0.f }, { -3.f, -3.f, 0.f }, 0.5f, Box );
+    ASSERT_TRUE ( Corner . IsHit );
+    EXPECT_NEAR ( Corner . TimeOfImpact, ( 2.f - 0.5f / std::sqrt ( 2.f ) ) / 3.f, 1e-3f );
+    EXPECT_LE ( Corner . TimeOfImpact, ( 2.f - 0.5f / std::sqrt ( 2.f ) ) / 3.f + 1e-6f );
+
+    PE::SSimulationParameters Parameters;
+    Parameters . SimulationFrequency = 30;
+    Parameters . Gravity = 0.f;
+    Parameters . AllowSleeping = false;
+    Parameters . ContinuousCollision = true;
+    PE::CPhysicsWorld World ( Parameters );
+    PE::SPhysicsBody Ball = MakeSphereBody ( { 1.4f, 1.4f, 0.f }, 0.5f );
+    Ball . LinearVelocity = { 30.f, 0.f, 0.f };
+    const int Handle = World . AddBody ( Ball );
+    World . AddBody ( MakeStaticBoxBody ( { 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f } ) );
+    World . Step ( World . GetFixedDeltaTime () );
+    EXPECT_EQ ( World . GetNumberOfClampedBodies (), 0 );
+    EXPECT_GT ( World . GetBodies () . Positions . X [ World . GetBodies () . GetIndex ( Handle ) ], 2.f );
+}
+
+TEST ( Solver, HeadOnCollisionConservesMomentum )
+{
+    PE::SPhysicsBody BodyA = MakeSphereBody ( { -0.45f, 0.f, 0.f }, 0.5f );
+    PE::SPhysicsBody BodyB = MakeSphereBody ( { 0.45f, 0.f, 0.f }, 0.5f );
+    BodyA . LinearVelocity = { 2.f, 0.f, 0.f };
+    BodyB . LinearVelocity = { -1.f, 0.f, 0.f };
+    BodyB . Mass = 2.f;
+    BodyB . InvMass = 0.5f;
+    PE::CBodyStorage Bodies = MakeStorage ( { BodyA, BodyB } );
+
+    std::vector<PE::SContact> Contacts;
+    PE::CNarrowphase Narrowphase;
+    Narrowphase . GenerateContacts ( Bodies, { { 0, 1 } }, Contacts );
+    ASSERT_EQ ( Contacts . size (), 1u );
+    PE::SSimulationParameters Parameters;
+    Parameters . Slop = 0.f;
+    PE::Solver::PrepareContacts ( Bodies, Contacts, Parameters, 1.f / 120.f );
+    // Lever arm is parallel to the normal, so angular terms vanish from the effective mass
+    EXPECT_NEAR ( Contacts [ 0 ] . NormalMass, 1.f / 1.5f, 1e-6f );
+    PE::Solver::SolveContacts ( Bodies, Contacts, Parameters );
+
+    const float MomentumX = Bodies . LinearVelocities . X [ 0 ] + 2.f * Bodies . LinearVelocities . X [ 1 ];
+    EXPECT_NEAR ( MomentumX, 0.f, 1e-5f );
+    EXPECT_GE ( Bodies . LinearVelocities . X [ 1 ] - Bodies . LinearVelocities . X [ 0 ], 0.f );
+    EXPECT_GE ( Bodies . Positions . X [ 1 ] - Bodies . Positions . X [ 0 ], 1.f - 1e-5f );
+}
+
+TEST ( Solver, ContactsTakeMaterialPairCoefficients )
+{
+    PE::SPhysicsBody BodyA = MakeSphereBody ( { -0.45f, 0.f, 0.f }, 0.5f );
+    PE::SPhysicsBody BodyB = MakeSphereBody ( { 0.45f, 0.f, 0.f }, 0.5f );
+    BodyA . Friction = 0.2f;
+    BodyA . Restitution = 0.9f;
+    BodyB . Friction = 0.7f;
+    BodyB . Restitution = 0.3f;
+    BodyA . LinearVelocity = { 2.f, 0.f, 0.f };
+    PE::CBodyStorage Bodies = MakeStorage ( { BodyA, BodyB } );
+    ASSERT_EQ ( Bodies . GetNumberOfMaterials (), 2 );
+
+    std::vector<PE::SContact> Contacts;
+    PE::CNarrowphase Narrowphase;
+    Narrowphase . GenerateContacts ( Bodies, { { 0, 1 } }, Contacts );
+    ASSERT_EQ ( Contacts . size (), 1u );
+    PE::SSimulationParameters Parameters;
+    PE::Solver::PrepareContacts ( Bodies, Contacts, Parameters, 1.f / 120.f );
+
+    EXPECT_FLOAT_EQ ( Contacts [ 0 ] . Friction, 0.2f );
+    // Approaching at 2 m/s, the combined restitution 0.3 sets the bounce target
+    EXPECT_NEAR ( Contacts [ 0 ] . NormalVelocityTarget, 0.6f, 1e-5f );
+    EXPECT_FLOAT_EQ ( Contacts [ 0 ] . CorrectionMass, 0.5f );
+}
+
+TEST ( Solver, DetectsContactsOncePerStep )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 60;
+    Parameters . NumberOfSteps = 8;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    for ( int Step = 0; Step < 240; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        const std::vector<PE::SContact> & Contacts = World . GetContacts ();
+        EXPECT_EQ ( World . GetNumberOfContacts (), static_cast<int> ( Contacts . size () ) );
+        EXPECT_LE ( World . GetNumberOfContacts (), World . GetNumberOfPairTests () );
+        for ( const PE::SContact & Contact : Contacts )
+        {
+            EXPECT_GE ( Contact . NormalMass, 0.f );
+            EXPECT_GE ( Contact . Friction, 0.f );
+        }
+    }
+    // Balls settle on the floor instead of sinking through it
+    const PE::CBodyStorage & Bodies = World . GetBodies ();
+    for ( int i = 0; i < World . GetNumberOfBalls (); i++ )
+    {
+        EXPECT_GE ( Bodies . Positions . Y [ i ] - Bodies . Radii [ i ], Parameters . WorldBoxMin . y - 0.05f );
+    }
+}
+
+TEST ( Solver, ContactCacheRestoresImpulsesByHandle )
+{
+    const PE::CBodyStorage Bodies = MakeStorage ( { MakeSphereBody ( { 0.f, 0.f, 0.f }, 0.5f ),
+                                                    MakeSphereBody ( { 1.f, 0.f, 0.f }, 0.5f ),
+                                                    MakeSphereBody ( { 2.f, 0.f, 0.f }, 0.5f ) } );
+    PE::SContact Contact;
+    Contact . BodyA = 0;
+    Contact . BodyB = 1;
+    Contact . NormalImpulse = 2.f;
+    Contact . TangentImpulse = { 0.f, 0.5f, 0.f };
+    PE::SContact Separating = Contact;
+    Separating . BodyA = 1;
+    Separating . BodyB = 2;
+    Separating . NormalImpulse = 0.f;
+
+    PE::CContactCache Cache;
+    Cache . Store ( Bodies, { Contact, Separating } );
+    // Contacts that ended the step without pushing are not worth keeping
+    EXPECT_EQ ( Cache . GetNumberOfEntries (), 1 );
+
+    std::vector<PE::SContact> Contacts ( 3 );
+    Contacts [ 0 ] . BodyA = 1;
+    Contacts [ 0 ] . BodyB = 0;
+    Contacts [ 1 ] . BodyA = 0;
+    Contacts [ 1 ] . BodyB = 1;
+    Contacts [ 2 ] . BodyA = 1;
+    Contacts [ 2 ] . BodyB = 2;
+    Contacts [ 2 ] . NormalImpulse = 5.f;
+    EXPECT_EQ ( Cache . Restore ( Bodies, Contacts ), 2 );
+    EXPECT_FLOAT_EQ ( Contacts [ 0 ] . NormalImpulse, 2.f );
+    EXPECT_FLOAT_EQ ( Contacts [ 0 ] . TangentImpulse . y, -0.5f );
+    EXPECT_FLOAT_EQ ( Contacts [ 1 ] . NormalImpulse, 2.f );
+    EXPECT_FLOAT_EQ ( Contacts [ 1 ] . TangentImpulse . y, 0.5f );
+    EXPECT_FLOAT_EQ ( Contacts [ 2 ] . NormalImpulse, 0.f );
+}
+
+TEST ( Solver, WarmStartingHoldsRestingBall )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfSteps = 1;
+    Parameters . AllowSleeping = false;
+    PE::CPhysicsWorld World ( Parameters );
+    PE::SPhysicsBody Ball = MakeSphereBody ( { 0.f, -7.f, 0.f }, 0.5f );
+    Ball . Restitution = 0.f;
+    World . AddBody ( Ball );
+    World . AddBody ( MakeStaticBoxBody ( { 0.f, -7.5f, 0.f }, { 7.5f, 0.f, 7.5f } ) );
+    for ( int Step = 0; Step < 120; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+    }
+    ASSERT_EQ ( World . GetNumberOfContacts (), 1 );
+    EXPECT_EQ ( World . GetNumberOfWarmStartedContacts (), 1 );
+    // At rest the floor pushes back exactly the weight gained in one step
+    const float Weight = Parameters . Gravity * World . GetFixedDeltaTime ();
+    EXPECT_NEAR ( World . GetContacts () [ 0 ] . NormalImpulse, Weight, 0.05f * Weight );
+    EXPECT_NEAR ( World . GetBodies () . LinearVelocities . Y [ 0 ], 0.f, 1e-3f );
+}
+
+TEST ( Sleeping, RestingIslandsFallAsleepAndStayPut )
+{
+    PE::SSimulationParameters Parameters;
+    PE::CPhysicsWorld World ( Parameters );
+    const int Left = World . AddBody ( MakeSphereBody ( { -3.f, -6.9f, 0.f }, 0.5f ) );
+    const int Right = World . AddBody ( MakeSphereBody ( { 3.f, -6.9f, 0.f }, 0.5f ) );
+    const int Floor = World . AddBody ( MakeStaticBoxBody ( { 0.f, -7.5f, 0.f }, { 7.5f, 0.f, 7.5f } ) );
+    for ( int Step = 0; Step < 600 && World . GetNumberOfAwakeBodies () > 0; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+    }
+    ASSERT_EQ ( World . GetNumberOfAwakeBodies (), 0 );
+    const PE::CBodyStorage & Bodies = World . GetBodies ();
+    EXPECT_TRUE ( Bodies . IsSleeping ( Bodies . GetIndex ( Left ) ) );
+    EXPECT_TRUE ( Bodies . IsSleeping ( Bodies . GetIndex ( Right ) ) );
+    EXPECT_FALSE ( Bodies . IsSleeping ( Bodies . GetIndex ( Floor ) ) );
+    // Both balls only touch the static floor, which doesn't join them into one island
+    EXPECT_NE ( Bodies . SleepIslands [ Bodies . GetIndex ( Left ) ], Bodies . SleepIslands [ Bodies . GetIndex ( Right ) ] );
+
+    const Vector3 Position = Bodies . Positions . Get ( Bodies . GetIndex ( Left ) );
+    for ( int Step = 0; Step < 120; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+    }
+    EXPECT_EQ ( World . GetNumberOfAwakeBodies (), 0 );
+    EXPECT_EQ ( World . GetNumberOfContacts (), 0 );
+    EXPECT_EQ ( Bodies . Positions . Get ( Bodies . GetIndex ( Left ) ) . y, Position . y );
+}
+
+TEST ( Sleeping, WakesOnlyTouchedIslands )
+{
+    PE::SSimulationParameters Parameters;
+    PE::CPhysicsWorld World ( Parameters );
+    const int Left = World . AddBody ( MakeSphereBody ( { -3.f, -6.9f, 0.f }, 0.5f ) );
+    const int Right = World . AddBody ( MakeSphereBody ( { 3.f, -6.9f, 0.f }, 0.5f ) );
+    World . AddBody ( MakeStaticBoxBody ( { 0.f, -7.5f, 0.f }, { 7.5f, 0.f, 7.5f } ) );
+    for ( int Step = 0; Step < 600 && World . GetNumberOfAwakeBodies () > 0; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+    }
+    ASSERT_EQ ( World . GetNumberOfAwakeBodies (), 0 );
+    const PE::CBodyStorage & Bodies = World . GetBodies ();
+
+    World . WakeBody ( Left );
+    EXPECT_TRUE ( Bodies . IsAwake ( Bodies . GetIndex ( Left ) ) );
+    EXPECT_TRUE ( Bodies . IsSleeping ( Bodies . GetIndex ( Right ) ) );
+
+    // A ball dropped onto the right one wakes it on impact
+    World . AddBody ( MakeSphereBody ( { 3.f, -5.5f, 0.f }, 0.5f ) );
+    bool IsRightWoken = false;
+    for ( int Step = 0; Step < 60 && ! IsRightWoken; Step++ )
+    {
+        World . Step ( World . GetFixedDeltaTime () );
+        IsRightWoken = Bodies . IsAwake ( Bodies . GetIndex ( Right ) );
+    }
+    EXPECT_TRUE ( IsRightWoken );
+}
+
+TEST ( Islands, StaticBodiesDoNotMergeIslands )
+{
+    // 0 and 1 touch each other, 2 only touches the floor (3), which 0 touches as well
+    PE::CBodyStorage Storage = MakeStorage ( { MakeSphereBody ( { 0.f, -7.f, 0.f }, 0.5f ),
+                                               MakeSphereBody ( { 0.f, -6.f, 0.f }, 0.5f ),
+                                               MakeSphereBody ( { 3.f, -7.f, 0.f }, 0.5f ),
+                                               MakeStaticBoxBody ( { 0.f, -7.5f, 0.f }, { 7.5f, 0.f, 7.5f } ) } );
+    std::vector<PE::SContact> Contacts ( 3 );
+    Contacts [ 0 ] . BodyA = 0;
+    Contacts [ 0 ] . BodyB = 3;
+    Contacts [ 1 ] . BodyA = 2;
+    Contacts [ 1 ] . BodyB = 3;
+    Contacts [ 2 ] . BodyA = 1;
+    Contacts [ 2 ] . BodyB = 0;
+
+    PE::CIslandBuilder Islands;
+    ASSERT_EQ ( Islands . Build ( Storage, Contacts ), 2 );
+    EXPECT_EQ ( Islands . GetIsland ( 0 ), 0 );
+    EXPECT_EQ ( Islands . GetIsland ( 1 ), 0 );
+    EXPECT_EQ ( Islands . GetIsland ( 2 ), 1 );
+    EXPECT_EQ ( Islands . GetIsland ( 3 ), -1 );
+    const std::span<const int> FirstContacts = Islands . GetIslandContacts ( 0 );
+    ASSERT_EQ ( FirstContacts . size (), 2u );
+    EXPECT_EQ ( FirstContacts [ 0 ], 0 );
+    EXPECT_EQ ( FirstContacts [ 1 ], 2 );
+    ASSERT_EQ ( Islands . GetIslandContacts ( 1 ) . size (), 1u );
+    EXPECT_EQ ( Islands . GetIslandContacts ( 1 ) [ 0 ], 1 );
+    EXPECT_EQ ( Islands . GetIslandContactStart ( 1 ), 2 );
+}
+
+TEST ( Islands, ParallelSolveMatchesSingleThread )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 300;
+    Parameters . AllowSleeping = false;
+    PE::CPhysicsWorld Reference ( Parameters );
+    Reference . Restart ();
+    for ( int Step = 0; Step < 240; Step++ )
+    {
+        Reference . Step ( Reference . GetFixedDeltaTime () );
+    }
+    EXPECT_GT ( Reference . GetNumberOfIslands (), 1 );
+
+    for ( const int NumberOfThreads : { 2, 4, 8 } )
+    {
+        Parameters . NumberOfThreads = NumberOfThreads;
+        PE::CPhysicsWorld World ( Parameters );
+        World . Restart ();
+        ASSERT_EQ ( World . GetNumberOfThreads (), NumberOfThreads );
+        for ( int Step = 0; Step < 240; Step++ )
+        {
+            World . Step ( World . GetFixedDeltaTime () );
+        }
+        const PE::CBodyStorage & Bodies = World . GetBodies ();
+        const PE::CBodyStorage & ReferenceBodies = Reference . GetBodies ();
+        for ( int i = 0; i < Bodies . Size (); i++ )
+        {
+            ASSERT_EQ ( Bodies . Positions . X [ i ], ReferenceBodies . Positions . X [ i ] ) << NumberOfThreads << " threads, body " << i;
+            ASSERT_EQ ( Bodies . Positions . Y [ i ], ReferenceBodies . Positions . Y [ i ] ) << NumberOfThreads << " threads, body " << i;
+            ASSERT_EQ ( Bodies . Positions . Z [ i ], ReferenceBodies . Positions . Z [ i ] ) << NumberOfThreads << " threads, body " << i;
+            ASSERT_EQ ( Bodies . AngularVelocities . X [ i ], ReferenceBodies . AngularVelocities . X [ i ] ) << NumberOfThreads << " threads, body " << i;
+        }
+    }
+}
+
+TEST ( Solver, ContactColorsShareNoDynamicBody )
+{
+    const std::vector<PE::SPhysicsBody> Bodies = MakeBallScene ( 300, 4.f, 0.3f, 0.8f, 5 );
+    const PE::CBodyStorage Storage = MakeStorage ( Bodies );
+    PE::CSpatialHashGrid Grid ( 1.6f, 0.f );
+    Grid . Update ( Storage );
+    std::vector<PE::SBroadphasePair> Pairs;
+    Grid . FindPairs ( Pairs );
+    PE::CNarrowphase Narrowphase;
+    std::vector<PE::SContact> Contacts;
+    Narrowphase . GenerateContacts ( Storage, Pairs, Contacts );
+
+    PE::CContactColoring Coloring;
+    const int NumberOfColors = Coloring . Build ( Storage, Contacts );
+    ASSERT_GT ( NumberOfColors, 1 );
+    ASSERT_EQ ( Coloring . GetOrderedContacts () . size (), Contacts . size () );
+    std::vector<int> LastDynamicColors ( Storage . Size (), -1 );
+    for ( int Color = 0; Color < NumberOfColors; Color++ )
+    {
+        ASSERT_FALSE ( Coloring . IsSequential ( Color ) );
+        std::set<int> ColorBodies;
+        for ( const int ContactIndex : Coloring . GetColorContacts ( Color ) )
+        {
+            const PE::SContact & Contact = Contacts [ ContactIndex ];
+            for ( const int Body : { Contact . BodyA, Contact . BodyB } )
+            {
+                if ( ! Storage . IsStatic ( Body ) )
+                {
+                    EXPECT_TRUE ( ColorBodies . insert ( Body ) . second ) << "body " << Body << " twice in color " << Color;
+                }
+            }
+            const bool IsStaticContact = Storage . IsStatic ( Contact . BodyA ) || Storage . IsStatic ( Contact . BodyB );
+            const int Body = Storage . IsStatic ( Contact . BodyA ) ? Contact . BodyB : Contact . BodyA;
+            if ( IsStaticContact )
+            {
+                // Plane contacts come after every ball contact of their body
+                EXPECT_GT ( Color, LastDynamicColors [ Body ] );
+            }
+            else
+            {
+                LastDynamicColors [ Contact . BodyA ] = Color;
+                LastDynamicColors [ Contact . BodyB ] = Color;
+            }
+        }
+    }
+}
+
+TEST ( Solver, GraphColoredMatchesSequential )
+{
+    // A small pyramid resting on the floor: both orders converge to the same rest state
+    PE::SSimulationParameters Parameters;
+    Parameters . AllowSleeping = false;
+    const std::vector<PE::SPhysicsBody> Bodies = {
+        MakeSphereBody ( { -0.5f, -7.f, 0.f }, 0.5f ),
+        MakeSphereBody ( { 0.5f, -7.f, 0.f }, 0.5f ),
+        MakeSphereBody ( { 0.f, -7.f, 0.87f }, 0.5f ),
+        MakeSphereBody ( { 0.f, -6.2f, 0.29f }, 0.5f ),
+        MakeStaticBoxBody ( { 0.f, -7.5f, 0.f }, { 7.5f, 0.f, 7.5f } ) };
+    PE::CPhysicsWorld Sequential ( Parameters );
+    Parameters . SolverType = PE::ESolverType::GraphColored;
+    PE::CPhysicsWorld GraphColored ( Parameters );
+    for ( const PE::SPhysicsBody & Body : Bodies )
+    {
+        Sequential . AddBody ( Body );
+        GraphColored . AddBody ( Body );
+    }
+    for ( int Step = 0; Step < 240; Step++ )
+    {
+        Sequential . Step ( Sequential . GetFixedDeltaTime () );
+        GraphColored . Step ( GraphColored . GetFixedDeltaTime () );
+    }
+    EXPECT_GT ( GraphColored . GetNumberOfColors (), 1 );
+    for ( int i = 0; i < Sequential . GetBodies () . Size (); i++ )
+    {
+        const Vector3 Expected = Sequential . GetBodies () . Positions . Get ( i );
+        const Vector3 Actual = GraphColored . GetBodies () . Positions . Get ( i );
+        EXPECT_NEAR ( Actual . x, Expected . x, 2e-3f ) << "body " << i;
+        EXPECT_NEAR ( Actual . y, Expected . y, 2e-3f ) << "body " << i;
+        EXPECT_NEAR ( Actual . z, Expected . z, 2e-3f ) << "body " << i;
+    }
+
+    // On a random scene the colored solve is bit-identical for any thread count
+    Parameters . NumberOfBalls = 300;
+    PE::CPhysicsWorld Reference ( Parameters );
+    Parameters . NumberOfThreads = 4;
+    PE::CPhysicsWorld Threaded ( Parameters );
+    Reference . Restart ();
+    Threaded . Restart ();
+    for ( int Step = 0; Step < 120; Step++ )
+    {
+        Reference . Step ( Reference . GetFixedDeltaTime () );
+        Threaded . Step ( Threaded . GetFixedDeltaTime () );
+    }
+    for ( int i = 0; i < Reference . GetBodies () . Size (); i++ )
+    {
+        ASSERT_EQ ( Reference . GetBodies () . Positions . X [ i ], Threaded . GetBodies () . Positions . X [ i ] ) << "body " << i;
+        ASSERT_EQ ( Reference . GetBodies () . Positions . Y [ i ], Threaded . GetBodies () . Positions . Y [ i ] ) << "body " << i;
+    }
+}
+
+TEST ( Profiling, RollingWindowKeepsTheLatestSamples )
+{
+    PE::CRollingWindow Window;
+    EXPECT_EQ ( Window . Compute () . NumberOfSamples, 0 );
+    for ( int i = 1; i <= 100; i++ )
+    {
+        Window . Add ( i );
+    }
+    PE::SRollingStatistic Statistic = Window . Compute ();
+    EXPECT_EQ ( Statistic . NumberOfSamples, 100 );
+    EXPECT_EQ ( Statistic . Last, 100.0 );
+    EXPECT_EQ ( Statistic . Min, 1.0 );
+    EXPECT_EQ ( Statistic . Max, 100.0 );
+    EXPECT_DOUBLE_EQ ( Statistic . Avg, 50.5 );
+    EXPECT_EQ ( Statistic . P99, 99.0 );
+
+    // Overflowing the window drops the oldest samples
+    for ( int i = 0; i < PE::CRollingWindow::GSize; i++ )
+    {
+        Window . Add ( 1000.0 + i );
+    }
+    Statistic = Window . Compute ();
+    EXPECT_EQ ( Statistic . NumberOfSamples, PE::CRollingWindow::GSize );
+    EXPECT_EQ ( Statistic . Min, 1000.0 );
+    EXPECT_EQ ( Statistic . Last, 1000.0 + PE::CRollingWindow::GSize - 1 );
+}
+
+TEST ( Profiling, WorldReportsPhasesAndCountersPerFrame )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 200;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    for ( int Frame = 0; Frame < 30; Frame++ )
+    {
+        // Two fixed steps per frame
+        World . Update ( 2.f * World . GetFixedDeltaTime () + 1e-5f );
+    }
+    const PE::SPhysicsStats Stats = World . GetStats ();
+#if PE_ENABLE_PROFILING
+    EXPECT_EQ ( Stats . Substeps . NumberOfSamples, 30 );
+    EXPECT_EQ ( Stats . Substeps . Min, 2.0 );
+    EXPECT_EQ ( Stats . Substeps . Max, 2.0 );
+    EXPECT_EQ ( Stats . SolverIterations . Last, 2.0 * Parameters . NumberOfSteps );
+    EXPECT_GT ( Stats . PairTests . Avg, 0.0 );
+    EXPECT_GT ( Stats . Contacts . Avg, 0.0 );
+    const PE::SRollingStatistic & Step = Stats . GetPhaseMs ( PE::EProfilePhase::Step );
+    EXPECT_GT ( Step . Min, 0.0 );
+    EXPECT_LE ( Step . Min, Step . Avg );
+    EXPECT_LE ( Step . Avg, Step . Max );
+    EXPECT_LE ( Step . P99, Step . Max );
+    // Single threaded the jobs run one after another inside the step
+    double PhaseSum = 0.0;
+    for ( int Phase = 0; Phase < static_cast<int> ( PE::EProfilePhase::Step ); Phase++ )
+    {
+        PhaseSum += Stats . PhaseMs [ Phase ] . Last;
+    }
+    EXPECT_LE ( PhaseSum, Step . Last );
+
+    // A Step called directly is a frame of its own
+    World . Step ( World . GetFixedDeltaTime () );
+    EXPECT_EQ ( World . GetStats () . Substeps . Last, 1.0 );
+    World . Clear ();
+    EXPECT_EQ ( World . GetStats () . Substeps . NumberOfSamples, 0 );
+#else
+    EXPECT_EQ ( Stats . Substeps . NumberOfSamples, 0 );
+    EXPECT_EQ ( Stats . GetPhaseMs ( PE::EProfilePhase::Step ) . Max, 0.0 );
+#endif
+}
+
+TEST ( PhysicsWorld, UpdateCapsStepsAndDropsTheBacklog )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 50;
+    Parameters . MaxStepsPerUpdate = 3;
+    Parameters . UpdateBudgetMs = 0.f;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    const float FixedDeltaTime = World . GetFixedDeltaTime ();
+
+    // A long frame runs the capped steps and drops the rest instead of catching up later
+    EXPECT_EQ ( World . Update ( 10.5f * FixedDeltaTime ), 3 );
+    EXPECT_EQ ( World . GetNumberOfOverruns (), 1 );
+    EXPECT_EQ ( World . GetNumberOfDroppedSteps (), 7 );
+    EXPECT_EQ ( World . Update ( 0.6f * FixedDeltaTime ), 1 );
+    EXPECT_EQ ( World . Update ( 2.f * FixedDeltaTime ), 2 );
+    EXPECT_EQ ( World . GetNumberOfOverruns (), 1 );
+
+    World . Clear ();
+    EXPECT_EQ ( World . GetNumberOfOverruns (), 0 );
+    EXPECT_EQ ( World . GetNumberOfDroppedSteps (), 0 );
+}
+
+TEST ( PhysicsWorld, UpdateBudgetSlowsDownInsteadOfStalling )
+{
+    // No cap and a budget no step fits: every frame still advances one step, the rest of the frame is dropped
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 50;
+    Parameters . MaxStepsPerUpdate = 0;
+    Parameters . UpdateBudgetMs = 1e-6f;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    for ( int Frame = 0; Frame < 5; Frame++ )
+    {
+        EXPECT_EQ ( World . Update ( 1.f ), 1 );
+    }
+    EXPECT_EQ ( World . GetNumberOfOverruns (), 5 );
+    // The fraction of a step left after rounding is kept, it may add up to one more step
+    EXPECT_NEAR ( World . GetNumberOfDroppedSteps (), 5 * ( Parameters . SimulationFrequency - 1 ), 5 );
+
+    // Without a budget or a cap the same frame runs every step
+    Parameters . UpdateBudgetMs = 0.f;
+    World . SetSimulationParameters ( Parameters );
+    World . Restart ();
+    EXPECT_EQ ( World . Update ( 0.5f + 0.1f * World . GetFixedDeltaTime () ), Parameters . SimulationFrequency / 2 );
+    EXPECT_EQ ( World . GetNumberOfOverruns (), 0 );
+}
+
+TEST ( SimulationThread, TripleBufferHandsOverTheLatestValue )
+{
+    PE::CTripleBuffer<std::vector<int>> Buffer;
+    EXPECT_TRUE ( Buffer . AcquireLatest () . empty () );
+    Buffer . GetWriteBuffer () . assign ( 4, 1 );
+    Buffer . Publish ();
+    EXPECT_EQ ( Buffer . AcquireLatest (), std::vector<int> ( 4, 1 ) );
+    // Publishes the reader missed are skipped, reading again without a publish keeps the value
+    for ( int Value = 2; Value <= 3; Value++ )
+    {
+        Buffer . GetWriteBuffer () . assign ( 4, Value );
+        Buffer . Publish ();
+    }
+    EXPECT_EQ ( Buffer . AcquireLatest (), std::vector<int> ( 4, 3 ) );
+    EXPECT_EQ ( Buffer . AcquireLatest (), std::vector<int> ( 4, 3 ) );
+
+    // Concurrently the reader never sees a half written value nor an older one than before
+    constexpr int NumberOfPublishes = 20000;
+    std::thread Writer ( [ &Buffer ]
+    {
+        for ( int Value = 4; Value < NumberOfPublishes; Value++ )
+        {
+            Buffer . GetWriteBuffer () . assign ( 64, Value );
+            Buffer . Publish ();
+        }
+    } );
+    int LastValue = 3;
+    while ( LastValue < NumberOfPublishes - 1 )
+    {
+        const std::vector<int> & Latest = Buffer . AcquireLatest ();
+        ASSERT_EQ ( std::count ( Latest . begin (), Latest . end (), Latest . front () ), static_cast<std::ptrdiff_t> ( Latest . size () ) );
+        ASSERT_GE ( Latest . front (), LastValue );
+        LastValue = Latest . front ();
+    }
+    Writer . join ();
+}
+
+TEST ( SimulationThread, StepsInRealTimeAndPublishesSnapshots )
+{
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 50;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+    PE::CSimulationThread SimulationThread ( World );
+    EXPECT_EQ ( SimulationThread . AcquireSnapshot () . GetNumberOfSlots (), 0 );
+
+    // Before stepping the snapshot is the world as it is, nothing to blend
+    SimulationThread . PublishSnapshot ();
+    const PE::SRenderSnapshot & Initial = SimulationThread . AcquireSnapshot ();
+    ASSERT_EQ ( Initial . GetNumberOfSlots (), World . GetBodies () . Size () );
+    EXPECT_EQ ( Initial . StepIndex, 0 );
+    EXPECT_EQ ( Initial . GetInterpolation ( PE::CProfiler::NowMs () ), 1.f );
+
+    SimulationThread . Start ();
+    EXPECT_TRUE ( SimulationThread . IsRunning () );
+    std::this_thread::sleep_for ( std::chrono::milliseconds ( 100 ) );
+    SimulationThread . Stop ();
+    EXPECT_FALSE ( SimulationThread . IsRunning () );
+
+    // The last publish holds the world's state after its last step, keyed by handle
+    const PE::SRenderSnapshot & Snapshot = SimulationThread . AcquireSnapshot ();
+    const PE::CBodyStorage & Bodies = World . GetBodies ();
+    ASSERT_EQ ( Snapshot . GetNumberOfSlots (), Bodies . Size () );
+    EXPECT_GT ( Snapshot . StepIndex, 0 );
+    ASSERT_GE ( Snapshot . StepsSincePrevious, 1 );
+    bool HasMoved = false;
+    for ( int i = 0; i < Bodies . Size (); i++ )
+    {
+        const int Slot = Snapshot . FindSlot ( Bodies . GetHandle ( i ) );
+        ASSERT_GE ( Slot, 0 );
+        EXPECT_EQ ( Snapshot . Positions [ Slot ] . y, Bodies . Positions . Y [ i ] );
+        EXPECT_EQ ( Snapshot . Flags [ Slot ], Bodies . Flags [ i ] );
+        HasMoved = HasMoved || Snapshot . PreviousPositions [ Slot ] . y != Snapshot . Positions [ Slot ] . y;
+    }
+    EXPECT_TRUE ( HasMoved );
+
+    // Drawn one step behind: the current pose once a whole step of real time passed since it was simulated
+    const double StepMs = 1e3 * Snapshot . FixedDeltaTime;
+    const double CurrentPoseMs = Snapshot . PublishMs - 1e3 * Snapshot . TimeAccumulator;
+    EXPECT_NEAR ( Snapshot . GetInterpolation ( CurrentPoseMs ), 1.f - 1.f / Snapshot . StepsSincePrevious, 1e-4f );
+    EXPECT_EQ ( Snapshot . GetInterpolation ( CurrentPoseMs + StepMs ), 1.f );
+    const int Slot = Snapshot . FindSlot ( Bodies . GetHandle ( 0 ) );
+    const Vector3 Blended = Snapshot . GetPosition ( Slot, 0.5f );
+    EXPECT_NEAR ( Blended . y, 0.5f * ( Snapshot . PreviousPositions [ Slot ] . y + Snapshot . Positions [ Slot ] . y ), 1e-5f );
+}
+
+TEST ( Tracing, RingKeepsOrderAndRejectsWhenFull )
+{
+    PE::CTraceRing Ring ( 3 );
+    ASSERT_EQ ( Ring . GetCapacity (), 4 );
+    PE::STraceEvent Event;
+    for ( int i = 0; i < 4; i++ )
+    {
+        Event . StartNs = i;
+        EXPECT_TRUE ( Ring . TryPush ( Event ) );
+    }
+    EXPECT_FALSE ( Ring . TryPush ( Event ) );
+    for ( int Round = 0; Round < 3; Round++ )
+    {
+        // Every pop frees a slot for the next round
+        ASSERT_TRUE ( Ring . TryPop ( Event ) );
+        EXPECT_EQ ( Event . StartNs, Round );
+        Event . StartNs = 4 + Round;
+        EXPECT_TRUE ( Ring . TryPush ( Event ) );
+    }
+    for ( int i = 3; i < 7; i++ )
+    {
+        ASSERT_TRUE ( Ring . TryPop ( Event ) );
+        EXPECT_EQ ( Event . StartNs, i );
+    }
+    EXPECT_FALSE ( Ring . TryPop ( Event ) );
+}
+
+TEST ( Tracing, RingTakesEventsFromManyThreads )
+{
+    // Producers push while the consumer pops, every event arrives once and each thread's events in order
+    constexpr int NumberOfThreads = 4;
+    constexpr int EventsPerThread = 20000;
+    PE::CTraceRing Ring ( 256 );
+    std::vector<std::thread> Producers;
+    for ( int Thread = 0; Thread < NumberOfThreads; Thread++ )
+    {
+        Producers . emplace_back ( [ &Ring, Thread ]
+        {
+            PE::STraceEvent Event;
+            Event . ThreadId = static_cast<uint32_t> ( Thread );
+            for ( int i = 0; i < EventsPerThread; i++ )
+            {
+                Event . StartNs = i;
+                while ( ! Ring . TryPush ( Event ) )
+                {
+                    std::this_thread::yield ();
+                }
+            }
+        } );
+    }
+    std::array<int64_t, NumberOfThreads> NextStart {};
+    int NumberOfEvents = 0;
+    PE::STraceEvent Event;
+    while ( NumberOfEvents < NumberOfThreads * EventsPerThread )
+    {
+        if ( ! Ring . TryPop ( Event ) )
+        {
+            std::this_thread::yield ();
+            continue;
+        }
+        ASSERT_LT ( Event . ThreadId, static_cast<uint32_t> ( NumberOfThreads ) );
+        EXPECT_EQ ( Event . StartNs, NextStart [ Event . ThreadId ]++ );
+        NumberOfEvents++;
+    }
+    for ( std::thread & Producer : Producers )
+    {
+        Producer . join ();
+    }
+    EXPECT_FALSE ( Ring . TryPop ( Event ) );
+}
+
+TEST ( Tracing, RecorderWritesTheStepsAsChromeTraceEvents )
+{
+    const std::string Path = ( std::filesystem::temp_directory_path () / "PhysicsEngineTraceTest.json" ) . string ();
+    PE::CTraceRecorder & Recorder = PE::CTraceRecorder::Get ();
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 200;
+    Parameters . NumberOfThreads = 2;
+    PE::CPhysicsWorld World ( Parameters );
+    World . Restart ();
+#if PE_ENABLE_PROFILING
+    ASSERT_TRUE ( Recorder . Start ( Path ) );
+    EXPECT_TRUE ( PE::CTraceRecorder::IsRecording () );
+    EXPECT_FALSE ( Recorder . Start ( Path ) );
+    for ( int Frame = 0; Frame < 5; Frame++ )
+    {
+        World . Update ( World . GetFixedDeltaTime () + 1e-5f );
+    }
+    Recorder . Stop ();
+    EXPECT_FALSE ( PE::CTraceRecorder::IsRecording () );
+    EXPECT_EQ ( Recorder . GetNumberOfDroppedEvents (), 0 );
+    EXPECT_GT ( Recorder . GetNumberOfWrittenEvents (), 5 * 7 );
+
+    std::ifstream File ( Path );
+    std::stringstream Contents;
+    Contents << File . rdbuf ();
+    const std::string Json = Contents . str ();
+    EXPECT_EQ ( Json . rfind ( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0 ), 0u );
+    EXPECT_EQ ( Json . substr ( Json . size () - 4 ), "\n]}\n" );
+    EXPECT_NE ( Json . find ( "{\"name\":\"World::Update\",\"ph\":\"X\",\"pid\":1,\"tid\":" ), std::string::npos );
+    EXPECT_NE ( Json . find ( "\"args\":{\"steps\":1,\"dropped_steps\":0}" ), std::string::npos );
+    EXPECT_NE ( Json . find ( "\"args\":{\"bodies\":206,\"contacts\":" ), std::string::npos );
+    for ( const char * Stage : { "\"Integrate\"", "\"WorldBoundary\"", "\"FindPairs\"", "\"Narrowphase\"", "\"Solve\"", "\"SolveIslandBatch\"", "\"Sleeping\"" } )
+    {
+        EXPECT_NE ( Json . find ( Stage ), std::string::npos ) << Stage;
+    }
+
+    // Scopes outside a recording don't reach the next one
+    World . Update ( World . GetFixedDeltaTime () + 1e-5f );
+    ASSERT_TRUE ( Recorder . Start ( Path ) );
+    Recorder . Stop ();
+    EXPECT_EQ ( Recorder . GetNumberOfWrittenEvents (), 0 );
+    std::filesystem::remove ( Path );
+#else
+    EXPECT_FALSE ( Recorder . Start ( Path ) );
+    EXPECT_FALSE ( PE::CTraceRecorder::IsRecording () );
+#endif
+}
+
+TEST ( JobSystem, GraphRunsJobsAfterTheirPrerequisites )
+{
+    // Diamond: Fill -> ( Double, Square ) -> Sum, Square sizes itself in its setup and nests a ParallelFor
+    PE::CJobSystem JobSystem ( 4 );
+    ASSERT_EQ ( JobSystem . GetNumberOfThreads (), 4 );
+    constexpr int Count = 1000;
+    std::vector<int> Values ( Count, 0 );
+    std::vector<int> Doubled ( Count, 0 );
+    std::vector<int> Squared ( Count, 0 );
+    std::atomic<long long> Sum { 0 };
+    PE::CJobGraph Graph;
+    const int Fill = Graph . AddJob ( "Fill", Count, [ & ] ( int i ) { Values [ i ] = i; } );
+    const int Double = Graph . AddJob ( "Double", Count, [ & ] ( int i ) { Doubled [ i ] = 2 * Values [ i ]; } );
+    const int Square = Graph . AddJob ( "Square", [ & ] { return Values [ Count - 1 ] / 100 + 1; }, [ & ] ( int Chunk )
+    {
+        JobSystem . ParallelFor ( 100, [ & ] ( int i ) { Squared [ Chunk * 100 + i ] = Values [ Chunk * 100 + i ] * Values [ Chunk * 100 + i ]; } );
+    } );
+    const int Total = Graph . AddJob ( "Sum", Count, [ & ] ( int i ) { Sum += Doubled [ i ] + Squared [ i ]; } );
+    Graph . AddDependency ( Double, Fill );
+    Graph . AddDependency ( Square, Fill );
+    Graph . AddDependency ( Total, Double );
+    Graph . AddDependency ( Total, Square );
+    for ( int Run = 0; Run < 20; Run++ )
+    {
+        Sum = 0;
+        std::fill ( Values . begin (), Values . end (), 0 );
+        JobSystem . Run ( Graph );
+        ASSERT_EQ ( Sum . load (), 999000LL + 332833500LL ) << "run " << Run;
+    }
+
+    const std::span<const PE::SJobStats> Stats = Graph . GetStats ();
+    ASSERT_EQ ( Stats . size (), 4u );
+    EXPECT_EQ ( Stats [ Fill ] . Name, "Fill" );
+    EXPECT_EQ ( Stats [ Square ] . Count, 10 );
+    EXPECT_EQ ( Stats [ Total ] . Count, Count );
+    EXPECT_GE ( Stats [ Total ] . StartMs, Stats [ Double ] . EndMs );
+    EXPECT_GE ( Stats [ Total ] . StartMs, Stats [ Square ] . EndMs );
+    for ( const PE::SJobStats & Job : Stats )
+    {
+        EXPECT_GE ( Job . EndMs, Job . StartMs ) << Job . Name;
+        ASSERT_EQ ( Job . ThreadBusyMs . size (), 4u );
+    }
+}
+
+namespace
+{
+    // Runs the step stages directly on the calling thread, the reference for the job graph
+    class CSequentialWorld : public PE::CPhysicsWorld
+    {
+        public:
+        using PE::CPhysicsWorld::CPhysicsWorld;
+
+        void SequentialStep ( float DeltaTime )
+        {
+            UpdateBodyOrder ();
+            IntegrateForces ( DeltaTime );
+            ResolveCollisions ( DeltaTime );
+            UpdateSleeping ( DeltaTime );
+        }
+    };
+} // namespace
+
+TEST ( JobSystem, StepGraphMatchesSequentialStages )
+{
+    // Enough balls for several integration and narrowphase tasks
+    PE::SSimulationParameters Parameters;
+    Parameters . NumberOfBalls = 1500;
+    CSequentialWorld Reference ( Parameters );
+    Parameters . NumberOfThreads = 4;
+    PE::CPhysicsWorld World ( Parameters );
+    Reference . Restart ();
+    World . Restart ();
+    for ( int Step = 0; Step < 40; Step++ )
+    {
+        Reference . SequentialStep ( Reference . GetFixedDeltaTime () );
+        World . Step ( World . GetFixedDeltaTime () );
+    }
+    EXPECT_GT ( World . GetNumberOfPairTests (), PE::CPhysicsWorld::GPairsPerNarrowphaseTask );
+    EXPECT_EQ ( World . GetNumberOfContacts (), Reference . GetNumberOfContacts () );
+    for ( int i = 0; i < Reference . GetBodies () . Size (); i++ )
+    {
+        ASSERT_EQ ( Reference . GetBodies () . Positions . X [ i ], World . GetBodies () . Positions . X [ i ] ) << "body " << i;
+        ASSERT_EQ ( Reference . GetBodies () . Positions . Y [ i ], World . GetBodies () . Positions . Y [ i ] ) << "body " << i;
+        ASSERT_EQ ( Reference . GetBodies () . LinearVelocities . Z [ i ], World . GetBodies () . LinearVelocities . Z [ i ] ) << "body " << i;
+    }
+
+    const std::span<const PE::SJobStats> Stats = World . GetStepJobStats ();
+    std::vector<std::string> Names;
+    for ( const PE::SJobStats & Job : Stats )
+    {
+        Names . push_back ( Job . Name );
+    }
+    ASSERT_EQ ( Names, ( std::vector<std::string> { "Integrate", "ContinuousCollision", "WorldBoundary", "BroadphaseUpdate", "FindPairs", "Narrowphase", "Solve", "Sleeping" } ) );
+    EXPECT_EQ ( Stats [ 0 ] . Count, ( World . GetBodies () . Size () + PE::CPhysicsWorld::GBodiesPerTask - 1 ) / PE::CPhysicsWorld::GBodiesPerTask );
+    EXPECT_GE ( Stats [ 1 ] . StartMs, Stats [ 0 ] . EndMs );
+    EXPECT_GE ( Stats [ 2 ] . StartMs, Stats [ 1 ] . EndMs );
+    EXPECT_GE ( Stats [ 3 ] . StartMs, Stats [ 1 ] . EndMs );
+    for ( size_t Job = 4; Job < Stats . size (); Job++ )
+    {
+        EXPECT_GE ( Stats [ Job ] . StartMs, Stats [ Job - 1 ] . EndMs ) << Stats [ Job ] . Name;
+    }
+    EXPECT_GE ( Stats [ 6 ] . StartMs, Stats [ 2 ] . EndMs );
+}
@@ -4,13 +4,13 @@
 namespace PE 
 {
     /**
-     * @brief Lightweight renderable object that references a physics body by index.
+     * @brief Lightweight renderable object that references a physics body by handle.
      *
-     * Stores the index into the scene's body array and a color for drawing.
+     * Stores the stable body handle (SPhysicsBody::Id) and a color for drawing.
      */
     struct SSimulationObject 
     {
-        int PhysicsBodyIndex = 0; 
-        Color Color;
+        int PhysicsBodyHandle = -1; 
+        ::Color Color;
     };
 } // namespace PE
\ No newline at end of file
@@ -2,18 +2,26 @@
 #include "raylib.h"
 #include "Object.hpp"
 #include "Parameters.hpp"
-#include "PhysicsBody.hpp"
-#include <random> 
+#include "PhysicsWorld.hpp"
+#include "SimulationThread.hpp"
 #include <vector>
-#include <array>
 
 
 namespace PE
 {
+    /**
+     * @brief raylib viewer on top of CPhysicsWorld: window, camera, input and drawing.
+     *
+     * The world steps on a CSimulationThread, the window thread only draws its latest snapshot, interpolated
+     * between the last two published poses, so slow frames and slow steps don't hold each other up.
+     */
     class CScene
     {
         
         public:
+
+        // Chrome trace written by the T key, in the working directory
+        static constexpr const char * GTraceFileName = "PhysicsEngineTrace.json";
        
         // Construct scene with given parameters (window, camera, simulation).
         explicit CScene( const SSceneParameters & SceneParameters ); 
@@ -27,10 +35,10 @@ namespace PE
         /** Set simulation parameters (gravity, damping, world bounds, etc.). */
         void SetSimulationParameters ( const SSimulationParameters & SimulationParameters  );
 
-        /** Advance the scene by DeltaTime (drives fixed-step internal updates). */
-        void Update(float DeltaTime );
+        /** Handle input, the simulation thread advances the world on its own. */
+        void Update();
 
-        /** Render the current scene frame. */
+        /** Render the latest simulation snapshot. */
         void Draw();
 
         /** Remove all objects and reset simulation state. */
@@ -38,37 +46,30 @@ namespace PE
 
         /** Restart simulation by clearing and regenerating objects. */
         void RestartSimulation(); 
+
+        /** The world, only consistent while the simulation thread is stopped (see CSimulationThread). */
+        const CPhysicsWorld & GetWorld () const { return m_World; }
         
         
         protected: 
         
-        
-        std::vector<SPhysicsBody> GenerateBalls ( int NumberOfBalls, const SBallGenerationParameters & BallGenerationParameters );
-        SPhysicsBody GenerateBall ( const SBallGenerationParameters & BallGenerationParameters );
-        void GenerateObjects(); 
+        void CreateObjects(); 
         void Initialize( const SSceneParameters & SceneParameters  ); 
-        void DrawUI ();
-        void DrawObject ( const SSimulationObject & Ball );
+        void DrawUI ( const SRenderSnapshot & Snapshot );
+        /** Start a trace recording, or stop the running one and write it to GTraceFileName. */
+        void ToggleTrace ();
+        void DrawObject ( const SSimulationObject & Object, const SRenderSnapshot & Snapshot, float Interpolation );
         void DrawBox ( const BoundingBox & Box, const Color & Color );
         void DrawBall ( const Vector3 & Location, float Radius, const Quaternion & Rotation, const Color & InColor );
-        void SimulationStep ( float DeltaTime );
-        void IntegrateForces ( float DeltaTime );
-        void ResolveCollisions( float DeltaTime );
-        void ResolveCollisionPair ( SPhysicsBody & BodyA, SPhysicsBody & BodyB, float DeltaTime );
         
         Camera3D m_Camera;
         std::vector<SSimulationObject> m_Objects;
-        std::vector<SPhysicsBody> m_PhysicsBodies;
-        BoundingBox m_WorldBox;
+        CPhysicsWorld m_World;
         SSceneParameters m_SceneParameters; 
         
         private:
-        std::array<SPhysicsBody, 6> BoundingBoxToPlanes ( const BoundingBox & Box ) const;
-        std::mt19937 m_RandomGenerator;
-        float m_TimeAccumulator = 0.f;
-        float m_FixedDeltaTime = 0.f;
         double m_SimulationStartTime = 0.f;
-        int m_NumberOfBalls = 0;
         bool m_IsPaused = false; 
+        CSimulationThread m_SimulationThread { m_World }; // Declared after the world, stops before the world goes away
     };
-} // namespace PE
\ No newline at end of file
+} // namespace PE
@@ -0,0 +1,288 @@
+#include "Scene.hpp"
+#include "Simd.hpp"
+#include "raymath.h"
+#include "Math.hpp"
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+namespace PE 
+{
+    CScene::CScene( const SSceneParameters & SceneParameters )
+    {
+        Initialize( SceneParameters );
+    }
+
+    void CScene::Update() 
+    {
+        if ( IsKeyPressed( KEY_T ) )
+        {
+            ToggleTrace();
+        }
+
+        CTraceScope Trace ( "Scene::Update" );
+        UpdateCamera ( &m_Camera, CAMERA_FREE );
+        
+        if ( IsKeyPressed( KEY_R ) ) 
+        {
+            RestartSimulation();
+        }
+
+        if ( IsKeyPressed( KEY_P ) )
+        {
+            // Next spawn pattern, the world respawns its balls with it
+            ESpawnPattern & Pattern = m_SceneParameters . SimulationParameters . BallGenerationParameters . Pattern;
+            Pattern = static_cast<ESpawnPattern> ( ( static_cast<int> ( Pattern ) + 1 ) % 3 );
+            SetSimulationParameters ( m_SceneParameters . SimulationParameters );
+            RestartSimulation();
+        }
+
+        if ( IsKeyPressed( KEY_ENTER ) ) 
+        {
+            m_IsPaused = !m_IsPaused;
+            m_SimulationThread . SetPaused ( m_IsPaused );
+        }
+    }
+    void CScene::ToggleTrace()
+    {
+        CTraceRecorder & Recorder = CTraceRecorder::Get();
+        if ( CTraceRecorder::IsRecording() )
+        {
+            Recorder . Stop();
+            std::cout << "Trace written to " << GTraceFileName << " (" << Recorder . GetNumberOfWrittenEvents() << " events, "
+                      << Recorder . GetNumberOfDroppedEvents() << " dropped)" << std::endl;
+        }
+        else if ( ! Recorder . Start ( GTraceFileName ) )
+        {
+            std::cout << "Trace not started: can't write " << GTraceFileName << " or PE_ENABLE_PROFILING is OFF" << std::endl;
+        }
+    }
+
+    void CScene::SetWindowParameters(const SWindowParameters &WindowParameters)
+    {
+        m_SceneParameters . WindowParameters = WindowParameters;
+        SetWindowSize ( WindowParameters.ScreenWidth, WindowParameters . ScreenHeight );
+        SetTargetFPS ( WindowParameters . TargetFPS );
+    }
+    void CScene::SetCameraParameters(const SCameraParameters &CameraParameters)
+    {
+        m_SceneParameters . CameraParameters = CameraParameters;
+        m_Camera . position = CameraParameters . Position;
+        m_Camera . target = CameraParameters . Target;
+        m_Camera . up = CameraParameters . Up;
+        m_Camera . fovy = CameraParameters . FovY;
+        m_Camera . projection = CameraParameters . Projection;
+    }
+
+    void CScene::Draw()
+    {
+        CTraceScope Trace ( "Scene::Draw" );
+        const SRenderSnapshot & Snapshot = m_SimulationThread . AcquireSnapshot();
+        const float Interpolation = Snapshot . GetInterpolation ( CProfiler::NowMs() );
+        ClearBackground(RAYWHITE);
+        BeginMode3D(m_Camera);
+            for ( const auto & Object : m_Objects )
+            {
+                DrawObject ( Object, Snapshot, Interpolation );
+            }
+        EndMode3D();
+        DrawUI ( Snapshot ); 
+    }
+    void CScene::ClearSimulation()
+    {
+        m_SimulationThread . Stop();
+        m_Objects . clear();
+        m_World . Clear();
+        m_SimulationThread . PublishSnapshot();
+        m_SimulationStartTime = GetTime();
+    }
+    void CScene::Initialize(const SSceneParameters & SceneParameters)
+    {
+        m_SceneParameters = SceneParameters;
+        InitWindow ( m_SceneParameters . WindowParameters . ScreenWidth, m_SceneParameters . WindowParameters . ScreenHeight, m_SceneParameters . WindowParameters . Title . c_str());
+        SetTargetFPS ( m_SceneParameters . WindowParameters . TargetFPS );
+        SetCameraParameters ( m_SceneParameters . CameraParameters );
+        SetSimulationParameters ( m_SceneParameters . SimulationParameters);
+        m_SimulationStartTime = GetTime(); 
+        DisableCursor();
+        RestartSimulation();
+    }
+
+    void CScene::DrawUI( const SRenderSnapshot & Snapshot )
+    {
+        const int WindowWidth = m_SceneParameters . WindowParameters . ScreenWidth;
+        const double ElapsedTime = GetTime() - m_SimulationStartTime; 
+        char Buffer [96];
+        snprintf(Buffer, sizeof(Buffer), "Time: %.2f s", ElapsedTime );
+        DrawText(Buffer, 0, 0, 20, BLACK);
+        snprintf(Buffer, sizeof(Buffer), "Number of balls: %d", Snapshot . NumberOfBalls );
+        DrawText(Buffer, 0, 20, 20, BLACK);
+        snprintf(Buffer, sizeof ( Buffer ), "Frame time: %.3f ms", GetFrameTime() * 1000.f );
+        DrawText(Buffer, 0, 40, 20, BLACK);
+        snprintf(Buffer, sizeof ( Buffer ), "Pair tests per step: %d", Snapshot . NumberOfPairTests );
+        DrawText(Buffer, 0, 60, 20, BLACK);
+        snprintf(Buffer, sizeof ( Buffer ), "SIMD: %s", Simd::GetLevelName ( Simd::ResolveLevel ( m_SceneParameters . SimulationParameters . SimdLevel ) ) );
+        DrawText(Buffer, 0, 80, 20, BLACK);
+        snprintf(Buffer, sizeof ( Buffer ), "Awake bodies: %d", Snapshot . NumberOfAwakeBodies );
+        DrawText(Buffer, 0, 100, 20, BLACK);
+        // Frames that ran out of steps or budget, the simulation fell behind real time by the dropped steps
+        snprintf(Buffer, sizeof ( Buffer ), "Overruns: %d (%d steps dropped)", Snapshot . NumberOfOverruns, Snapshot . NumberOfDroppedSteps );
+        DrawText(Buffer, 0, 120, 20, Snapshot . NumberOfOverruns > 0 ? RED : BLACK);
+        // Last step's job graph: wall time of every job, the busiest thread shows load imbalance
+        int JobLine = 0;
+        for ( const SJobStats & Job : Snapshot . StepJobStats )
+        {
+            const double BusiestMs = Job . ThreadBusyMs . empty() ? 0.0 : *std::max_element ( Job . ThreadBusyMs . begin(), Job . ThreadBusyMs . end() );
+            snprintf(Buffer, sizeof ( Buffer ), "%s: %.3f ms (busiest thread %.3f ms)", Job . Name . c_str(), Job . EndMs - Job . StartMs, BusiestMs );
+            DrawText(Buffer, 0, 140 + 20 * JobLine++, 20, BLACK);
+        }
+        // Rolling per-frame breakdown of the last frames
+        const SPhysicsStats & Stats = Snapshot . Stats;
+        int StatsLine = 140 + 20 * JobLine + 10;
+        if ( Stats . Substeps . NumberOfSamples == 0 )
+        {
+            DrawText("Profiling: no samples (compiled out with PE_ENABLE_PROFILING=OFF)", 0, StatsLine, 20, BLACK);
+        }
+        else
+        {
+            DrawText("Per frame (ms): last / avg / max / p99", 0, StatsLine, 20, BLACK);
+            for ( int Phase = 0; Phase < static_cast<int> ( EProfilePhase::Count ); Phase++ )
+            {
+                const SRollingStatistic & Time = Stats . GetPhaseMs ( static_cast<EProfilePhase> ( Phase ) );
+                snprintf(Buffer, sizeof ( Buffer ), "%s: %.3f / %.3f / %.3f / %.3f", GetProfilePhaseName ( static_cast<EProfilePhase> ( Phase ) ), Time . Last, Time . Avg, Time . Max, Time . P99 );
+                DrawText(Buffer, 0, StatsLine += 20, 20, BLACK);
+            }
+            snprintf(Buffer, sizeof ( Buffer ), "Substeps %.0f, solver iterations %.0f", Stats . Substeps . Last, Stats . SolverIterations . Last );
+            DrawText(Buffer, 0, StatsLine += 20, 20, BLACK);
+            snprintf(Buffer, sizeof ( Buffer ), "Pairs %.0f (avg %.0f), hits %.0f (avg %.0f)", Stats . PairTests . Last, Stats . PairTests . Avg, Stats . Contacts . Last, Stats . Contacts . Avg );
+            DrawText(Buffer, 0, StatsLine += 20, 20, BLACK);
+        }
+        snprintf(Buffer, sizeof(Buffer), "R - restart" );
+        DrawText(Buffer, WindowWidth - 120, 0, 20, BLACK);
+        snprintf(Buffer, sizeof(Buffer), "ENTER - pause (%s)", m_IsPaused ? "paused" : "running" );
+        DrawText(Buffer, WindowWidth - 260, 20, 20, BLACK);
+        snprintf(Buffer, sizeof(Buffer), "Mouse or arrows - look" );
+        DrawText(Buffer, WindowWidth - 245, 40, 20, BLACK);
+        snprintf(Buffer, sizeof(Buffer), "WASD - move" );
+        DrawText(Buffer, WindowWidth - 135, 60, 20, BLACK);
+        snprintf(Buffer, sizeof(Buffer), "T - trace (%s)", CTraceRecorder::IsRecording() ? "recording" : "off" );
+        DrawText(Buffer, WindowWidth - 200, 80, 20, CTraceRecorder::IsRecording() ? RED : BLACK);
+    }
+
+    void CScene::DrawObject(const SSimulationObject & Object, const SRenderSnapshot & Snapshot, float Interpolation )
+    {
+        const int Slot = Snapshot . FindSlot ( Object . PhysicsBodyHandle );
+        if ( Slot < 0 )
+        {
+            return;
+        }
+        const SShape & Shape = Snapshot . Shapes [ Slot ];
+        const Vector3 Position = Snapshot . GetPosition ( Slot, Interpolation );
+        switch ( Shape . Type )
+        {
+            case EShapeType::Sphere:
+            {
+                // Sleeping balls are drawn faded toward gray
+                const bool IsSleeping = ( Snapshot . Flags [ Slot ] & static_cast<uint8_t> ( EBodyFlags::Sleeping ) ) != 0;
+                DrawBall ( Position, 
+                           Shape . Sphere . Radius, 
+                           Snapshot . GetRotation ( Slot, Interpolation ), 
+                           IsSleeping ? PE::Math::ColorLerp ( Object . Color, GRAY, 0.6f ) : Object . Color );
+                break;
+            }
+
+            case EShapeType::Box:
+            {
+                DrawBox ( { .min = Vector3Subtract ( Position, Shape . Box . HalfSize ),
+                            .max = Vector3Add ( Position, Shape . Box . HalfSize ) }, 
+                          Object . Color );
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    void CScene::SetSimulationParameters ( const SSimulationParameters &SimulationParameters)
+    {
+        const bool WasRunning = m_SimulationThread . IsRunning();
+        m_SimulationThread . Stop();
+        m_SceneParameters . SimulationParameters = SimulationParameters;
+        m_World . SetSimulationParameters ( SimulationParameters );
+        if ( WasRunning )
+        {
+            m_SimulationThread . Start();
+        }
+    }
+
+    void CScene::DrawBall( const Vector3 & Location, float Radius, const Quaternion & Rotation, const Color & InColor )
+    {  
+        DrawSphere( Location, Radius, InColor );
+
+        Vector3 localX { Radius , 0.f, 0.f };
+        Vector3 localY { 0.f, Radius, 0.f };
+        Vector3 localZ { 0.f, 0.f, Radius };
+
+        Vector3 worldX = Vector3Add(Location, Vector3RotateByQuaternion(localX, Rotation));
+        Vector3 worldY = Vector3Add(Location, Vector3RotateByQuaternion(localY, Rotation));
+        Vector3 worldZ = Vector3Add(Location, Vector3RotateByQuaternion(localZ, Rotation));
+
+        DrawLine3D(Location, worldX, RED);
+        DrawLine3D(Location, worldY, GREEN);
+        DrawLine3D(Location, worldZ, BLUE);
+
+        const float markerSize = Radius * 0.12f;
+        DrawCube(worldX, markerSize, markerSize, markerSize, RED);
+        DrawCube(worldY, markerSize, markerSize, markerSize, GREEN);
+        DrawCube(worldZ, markerSize, markerSize, markerSize, BLUE);
+
+        const int segments = 36; 
+        const float twoPi = 6.28318530718f;
+        Vector3 prev = { Radius, 0.f, 0.f };
+        prev = Vector3Add(Location, Vector3RotateByQuaternion(prev, Rotation));
+        for (int s = 1; s <= segments; ++s)
+        {
+            float t = (float)s / (float)segments;
+            float ang = t * twoPi;
+            Vector3 localP = { Radius * cosf(ang), 0.f, Radius * sinf(ang) };
+            Vector3 worldP = Vector3Add(Location, Vector3RotateByQuaternion(localP, Rotation));
+            DrawLine3D(prev, worldP, DARKGRAY);
+            prev = worldP;
+        }
+    }
+
+    void CScene::DrawBox(const BoundingBox & Box, const Color & Color)
+    {
+        const Vector3 Size = PE::Math::BoxSize ( Box );
+        const Vector3 Center = PE::Math::BoxCenter ( Box );
+        DrawCubeWires( Center, Size.x, Size.y, Size.z, Color );
+    }
+
+    void CScene::RestartSimulation()
+    {
+        ClearSimulation();
+        m_World . Restart();
+        CreateObjects();
+        m_SimulationThread . PublishSnapshot();
+        m_SimulationThread . Start();
+    }
+
+    void CScene::CreateObjects()
+    {
+        const CBodyStorage & Bodies = m_World . GetBodies();
+        const SBallGenerationParameters & BallGenerationParameters = m_SceneParameters . SimulationParameters . BallGenerationParameters;
+        const float RadiusRange = BallGenerationParameters . MaxRadius - BallGenerationParameters . MinRadius;
+        m_Objects . reserve ( Bodies . Size() );
+        for ( int i = 0; i < Bodies . Size(); i++ )
+        {
+            // Balls are colored by size, world planes are gray
+            const bool IsBall = Bodies . Shapes [ i ] . Type == EShapeType::Sphere;
+            SSimulationObject Object { 
+                .PhysicsBodyHandle = Bodies . GetHandle ( i ),
+                .Color = IsBall ? PE::Math::ColorLerp ( GREEN, RED, ( Bodies . Radii [ i ] - BallGenerationParameters . MinRadius ) / RadiusRange ) : GRAY,
+            };
+            m_Objects . push_back ( std::move ( Object ) );
+        }
+    }
+} // namespace PE